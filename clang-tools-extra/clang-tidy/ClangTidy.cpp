@@ -23,6 +23,7 @@
 #include "clang-tidy-config.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/Basic/DiagnosticIDs.h"
 #include "clang/Format/Format.h"
 #include "clang/Frontend/ASTConsumers.h"
 #include "clang/Frontend/CompilerInstance.h"
@@ -39,7 +40,10 @@
 #include "clang/Tooling/Refactoring.h"
 #include "clang/Tooling/ReplacementsYaml.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/WithColor.h"
 #include <algorithm>
 #include <utility>
 
@@ -426,9 +430,17 @@ ClangTidyASTConsumerFactory::createASTConsumer(
     PP->addPPCallbacks(std::move(ModuleExpander));
   }
 
+  ChecksWithPPCallbacks.clear();
   for (auto &Check : Checks) {
     Check->registerMatchers(&*Finder);
+    PPCallbacks *Callbacks = PP->getPPCallbacks();
+    PPCallbacks *ModuleExpanderCallbacks = ModuleExpanderPP->getPPCallbacks();
     Check->registerPPCallbacks(*SM, PP, ModuleExpanderPP);
+    if (PP->getPPCallbacks() != Callbacks ||
+        ModuleExpanderPP->getPPCallbacks() != ModuleExpanderCallbacks)
+      ChecksWithPPCallbacks.emplace_back(
+          static_cast<ast_matchers::MatchFinder::MatchCallback &>(*Check)
+              .getID());
   }
 
   std::vector<std::unique_ptr<ASTConsumer>> Consumers;
@@ -514,7 +526,7 @@ runClangTidy(clang::tidy::ClangTidyContext &Context,
              ArrayRef<std::string> InputFiles,
              llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
              bool ApplyAnyFix, bool EnableCheckProfile,
-             llvm::StringRef StoreCheckProfile) {
+             llvm::StringRef StoreCheckProfile, bool UseASTFiles) {
   ClangTool Tool(Compilations, InputFiles,
                  std::make_shared<PCHContainerOperations>(), BaseFS);
 
@@ -550,8 +562,10 @@ runClangTidy(clang::tidy::ClangTidyContext &Context,
   class ActionFactory : public FrontendActionFactory {
   public:
     ActionFactory(ClangTidyContext &Context,
-                  IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS)
-        : ConsumerFactory(Context, std::move(BaseFS)) {}
+                  IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
+                  bool UseASTFiles)
+        : Context(Context), ConsumerFactory(Context, std::move(BaseFS)),
+          UseASTFiles(UseASTFiles) {}
     std::unique_ptr<FrontendAction> create() override {
       return std::make_unique<Action>(&ConsumerFactory);
     }
@@ -562,28 +576,131 @@ runClangTidy(clang::tidy::ClangTidyContext &Context,
                        DiagnosticConsumer *DiagConsumer) override {
       // Explicitly ask to define __clang_analyzer__ macro.
       Invocation->getPreprocessorOpts().SetUpStaticAnalyzer = true;
+      if (UseASTFiles && runOnASTFile(*Invocation, Files, PCHContainerOps))
+        return true;
       return FrontendActionFactory::runInvocation(
           Invocation, Files, PCHContainerOps, DiagConsumer);
     }
 
   private:
+    /// Runs the checks on the AST that the build wrote with --emit-ast-file,
+    /// if there is one. Returns false if the file is missing or out of date.
+    bool runOnASTFile(const CompilerInvocation &Invocation, FileManager *Files,
+                      std::shared_ptr<PCHContainerOperations> PCHContainerOps) {
+      const FrontendOptions &FEOpts = Invocation.getFrontendOpts();
+      if (FEOpts.ASTOutputFile.empty() || FEOpts.Inputs.size() != 1 ||
+          !FEOpts.Inputs[0].isFile())
+        return false;
+      SmallString<256> ASTFile(FEOpts.ASTOutputFile);
+      Files->makeAbsolutePath(ASTFile);
+      if (!Files->getOptionalFileRef(ASTFile))
+        return false;
+
+      auto ASTInvocation = std::make_shared<CompilerInvocation>(Invocation);
+      FrontendOptions &ASTOpts = ASTInvocation->getFrontendOpts();
+      ASTOpts.Inputs = {FrontendInputFile(
+          ASTFile, InputKind(Language::Unknown, InputKind::Precompiled))};
+      ASTOpts.ASTOutputFile.clear();
+      ASTInvocation->getDiagnosticOpts().ShowCarets = false;
+
+      // A stale AST is rejected by the reader. Its errors are only counted, not
+      // shown, as the source file is parsed instead.
+      DiagnosticConsumer ASTDiags;
+      CompilerInstance Compiler(std::move(PCHContainerOps));
+      Compiler.setInvocation(std::move(ASTInvocation));
+      Compiler.setFileManager(Files);
+      Compiler.createDiagnostics(&ASTDiags, /*ShouldOwnClient=*/false);
+      Action ASTAction(&ConsumerFactory, FEOpts.Inputs[0].getFile());
+      bool Success = Compiler.ExecuteAction(ASTAction);
+      Files->clearStatCache();
+
+      // Checks based on preprocessor callbacks see no preprocessing in an
+      // AST, so the source is parsed for them.
+      for (const std::string &Check :
+           ConsumerFactory.getChecksWithPPCallbacks())
+        ChecksNeedingSources.insert(Check);
+      if (!Success)
+        return false;
+
+      // Compiler warnings are not reported either, as nothing is compiled.
+      // The build that wrote the AST reported them.
+      NumCompilerDiagnosticChecks = 0;
+      for (StringRef Flag : DiagnosticIDs::getDiagnosticFlags()) {
+        if (!Flag.consume_front("-W") || Flag.empty() ||
+            Flag.startswith("no-"))
+          continue;
+        ++NumCompilerDiagnosticChecks;
+        std::string Check = ("clang-diagnostic-" + Flag).str();
+        if (Context.isCheckEnabled(Check))
+          CompilerDiagnosticChecks.insert(Check);
+      }
+      return true;
+    }
+
+  public:
+    /// Lists the enabled checks that --use-ast-files affects.
+    void reportASTFileLimitations() const {
+      if (!ChecksNeedingSources.empty())
+        llvm::WithColor::warning()
+            << "--use-ast-files: parsed the sources instead of reading their "
+               "ASTs, because these checks need preprocessor callbacks: "
+            << llvm::join(sorted(ChecksNeedingSources), ", ") << "\n";
+      if (CompilerDiagnosticChecks.empty())
+        return;
+      llvm::raw_ostream &OS = llvm::WithColor::warning()
+                              << "--use-ast-files: compiler warnings are not "
+                                 "reported for sources read from ASTs, so "
+                                 "these checks found nothing in them: ";
+      // Checking all warnings is the default, and too long a list to print.
+      if (CompilerDiagnosticChecks.size() == NumCompilerDiagnosticChecks)
+        OS << "clang-diagnostic-*\n";
+      else
+        OS << llvm::join(sorted(CompilerDiagnosticChecks), ", ") << "\n";
+    }
+
+  private:
+    static std::vector<StringRef> sorted(const llvm::StringSet<> &Checks) {
+      std::vector<StringRef> Sorted(Checks.keys().begin(), Checks.keys().end());
+      llvm::sort(Sorted);
+      return Sorted;
+    }
+
     class Action : public ASTFrontendAction {
     public:
-      Action(ClangTidyASTConsumerFactory *Factory) : Factory(Factory) {}
+      Action(ClangTidyASTConsumerFactory *Factory,
+             StringRef SourceFile = StringRef())
+          : Factory(Factory), SourceFile(SourceFile) {}
       std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
                                                      StringRef File) override {
-        return Factory->createASTConsumer(Compiler, File);
+        if (SourceFile.empty())
+          return Factory->createASTConsumer(Compiler, File);
+        // When running on an AST file, diagnostics and options still belong
+        // to the source file it was built from.
+        std::unique_ptr<ASTConsumer> Consumer =
+            Factory->createASTConsumer(Compiler, SourceFile);
+        if (!Factory->getChecksWithPPCallbacks().empty())
+          return nullptr;
+        return Consumer;
       }
 
     private:
       ClangTidyASTConsumerFactory *Factory;
+      StringRef SourceFile;
     };
 
+    ClangTidyContext &Context;
     ClangTidyASTConsumerFactory ConsumerFactory;
+    bool UseASTFiles;
+    llvm::StringSet<> ChecksNeedingSources;
+    llvm::StringSet<> CompilerDiagnosticChecks;
+    /// The number of warning flags. Only used to tell whether all of them are
+    /// checked.
+    size_t NumCompilerDiagnosticChecks = 0;
   };
 
-  ActionFactory Factory(Context, std::move(BaseFS));
+  ActionFactory Factory(Context, std::move(BaseFS), UseASTFiles);
   Tool.run(&Factory);
+  Factory.reportASTFileLimitations();
   return DiagConsumer.take();
 }
 
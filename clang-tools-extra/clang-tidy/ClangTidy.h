@@ -47,10 +47,17 @@ public:
   /// Get the union of options from all checks.
   ClangTidyOptions::OptionMap getCheckOptions();
 
+  /// Returns the checks that registered preprocessor callbacks in the last
+  /// call to createASTConsumer(). They report nothing on a deserialized AST.
+  ArrayRef<std::string> getChecksWithPPCallbacks() const {
+    return ChecksWithPPCallbacks;
+  }
+
 private:
   ClangTidyContext &Context;
   IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> OverlayFS;
   std::unique_ptr<ClangTidyCheckFactories> CheckFactories;
+  std::vector<std::string> ChecksWithPPCallbacks;
 };
 
 /// Fills the list of check names that are enabled when the provided
@@ -89,7 +96,8 @@ runClangTidy(clang::tidy::ClangTidyContext &Context,
              ArrayRef<std::string> InputFiles,
              llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
              bool ApplyAnyFix, bool EnableCheckProfile = false,
-             llvm::StringRef StoreCheckProfile = StringRef());
+             llvm::StringRef StoreCheckProfile = StringRef(),
+             bool UseASTFiles = false);
 
 /// Controls what kind of fixes clang-tidy is allowed to apply.
 enum FixBehaviour {
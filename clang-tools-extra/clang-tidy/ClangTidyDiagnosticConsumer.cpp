@@ -741,8 +741,18 @@ struct EqualClangTidyError {
 };
 } // end anonymous namespace
 
+void ClangTidyDiagnosticConsumer::addTakenErrors(
+    std::vector<ClangTidyError> Taken) {
+  TakenErrors.insert(TakenErrors.end(), std::make_move_iterator(Taken.begin()),
+                     std::make_move_iterator(Taken.end()));
+}
+
 std::vector<ClangTidyError> ClangTidyDiagnosticConsumer::take() {
   finalizeLastError();
+  // The taken errors went through the filters of their own consumer already.
+  Errors.insert(Errors.end(), std::make_move_iterator(TakenErrors.begin()),
+                std::make_move_iterator(TakenErrors.end()));
+  TakenErrors.clear();
 
   llvm::stable_sort(Errors, LessClangTidyError());
   Errors.erase(std::unique(Errors.begin(), Errors.end(), EqualClangTidyError()),
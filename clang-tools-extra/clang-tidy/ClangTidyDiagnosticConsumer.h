@@ -290,6 +290,11 @@ public:
   // Retrieve the diagnostics that were captured.
   std::vector<ClangTidyError> take();
 
+  /// Adds errors taken from another consumer, e.g. one that ran on a different
+  /// thread. take() removes the duplicates among them and the errors captured
+  /// by this consumer, such as the same warning in a shared header.
+  void addTakenErrors(std::vector<ClangTidyError> Taken);
+
 private:
   void finalizeLastError();
   void removeIncompatibleErrors();
@@ -312,6 +317,7 @@ private:
   bool GetFixesFromNotes;
   bool EnableNolintBlocks;
   std::vector<ClangTidyError> Errors;
+  std::vector<ClangTidyError> TakenErrors;
   std::unique_ptr<llvm::Regex> HeaderFilter;
   bool LastErrorRelatesToUserCode;
   bool LastErrorPassesLineFilter;
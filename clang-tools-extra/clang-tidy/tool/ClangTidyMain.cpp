@@ -25,7 +25,10 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/WithColor.h"
+#include <atomic>
+#include <mutex>
 #include <optional>
 
 using namespace clang::tooling;
@@ -255,6 +258,28 @@ these per-TU profiles are instead stored as JSON.
                                               cl::value_desc("prefix"),
                                               cl::cat(ClangTidyCategory));
 
+static cl::opt<bool> UseASTFiles("use-ast-files", desc(R"(
+Run the checks on the AST files written by the
+build with --emit-ast-file=, when they are up to
+date with the sources, instead of parsing the
+source files again. Sources are still parsed
+when a check relies on preprocessor callbacks.
+Compiler warnings are not reported for sources
+read from ASTs; a warning lists the enabled
+clang-diagnostic-* checks this affects.
+)"),
+                                 cl::init(false),
+                                 cl::cat(ClangTidyCategory));
+
+static cl::opt<unsigned> Jobs("j", desc(R"(
+Number of translation units to process in
+parallel, or 0 to use all hardware threads.
+Diagnostics are reported once all files are
+processed, and diagnostics in headers shared by
+several files are reported only once.
+)"),
+                              cl::init(1), cl::cat(ClangTidyCategory));
+
 /// This option allows enabling the experimental alpha checkers from the static
 /// analyzer. This option is set to false and not visible in help, because it is
 /// highly not recommended for users.
@@ -439,6 +464,107 @@ getVfsFromFile(const std::string &OverlayFile,
   return FS;
 }
 
+namespace {
+/// The status of files looked up by the worker threads of -j. They would
+/// otherwise each search the same include directories for the same headers.
+struct SharedStatCache {
+  std::mutex Mutex;
+  llvm::StringMap<llvm::ErrorOr<vfs::Status>> Entries;
+};
+
+/// A physical file system with its own working directory, as each worker
+/// thread of -j changes it independently, which caches the status of files
+/// in a \c SharedStatCache.
+class StatCachingFileSystem : public vfs::ProxyFileSystem {
+public:
+  StatCachingFileSystem(SharedStatCache &Cache)
+      : ProxyFileSystem(vfs::createPhysicalFileSystem()), Cache(Cache) {}
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override {
+    SmallString<256> AbsolutePath;
+    Path.toVector(AbsolutePath);
+    if (makeAbsolute(AbsolutePath))
+      return ProxyFileSystem::status(Path);
+
+    std::optional<llvm::ErrorOr<vfs::Status>> Result;
+    {
+      std::lock_guard<std::mutex> Lock(Cache.Mutex);
+      auto It = Cache.Entries.find(AbsolutePath);
+      if (It != Cache.Entries.end())
+        Result = It->second;
+    }
+    if (!Result) {
+      Result = ProxyFileSystem::status(AbsolutePath);
+      std::lock_guard<std::mutex> Lock(Cache.Mutex);
+      Cache.Entries.try_emplace(AbsolutePath, *Result);
+    }
+    if (!*Result)
+      return *Result;
+    return vfs::Status::copyWithNewName(**Result, Path);
+  }
+
+private:
+  SharedStatCache &Cache;
+};
+} // namespace
+
+/// Runs clang-tidy on \p Files on a pool of -j worker threads. Each worker
+/// has its own context and file system, as neither is thread-safe, but they
+/// share a \c SharedStatCache. The diagnostics of all workers are merged and
+/// deduplicated as in a sequential run.
+static std::vector<ClangTidyError>
+runClangTidyInParallel(ClangTidyContext &Context,
+                       const CompilationDatabase &Compilations,
+                       ArrayRef<std::string> Files, StringRef ProfilePrefix,
+                       ClangTidyStats &Stats) {
+  llvm::ThreadPool Pool(llvm::hardware_concurrency(Jobs));
+  size_t NumWorkers = std::min<size_t>(Pool.getThreadCount(), Files.size());
+  SharedStatCache StatCache;
+  std::atomic<size_t> NextFile = 0;
+  std::vector<std::vector<ClangTidyError>> WorkerErrors(NumWorkers);
+  std::vector<ClangTidyStats> WorkerStats(NumWorkers);
+
+  for (size_t Worker = 0; Worker < NumWorkers; ++Worker) {
+    Pool.async([&, Worker] {
+      llvm::IntrusiveRefCntPtr<vfs::OverlayFileSystem> FS(
+          new vfs::OverlayFileSystem(
+              llvm::makeIntrusiveRefCnt<StatCachingFileSystem>(StatCache)));
+      // The overlay and the configuration were validated by clangTidyMain.
+      if (!VfsOverlay.empty())
+        if (IntrusiveRefCntPtr<vfs::FileSystem> VfsFromFile =
+                getVfsFromFile(VfsOverlay, FS))
+          FS->pushOverlay(std::move(VfsFromFile));
+      std::unique_ptr<ClangTidyOptionsProvider> OptionsProvider =
+          createOptionsProvider(FS);
+      if (!OptionsProvider)
+        return;
+
+      ClangTidyContext WorkerContext(std::move(OptionsProvider),
+                                     AllowEnablingAnalyzerAlphaCheckers,
+                                     EnableModuleHeadersParsing);
+      for (size_t I; (I = NextFile++) < Files.size();)
+        for (ClangTidyError &Error :
+             runClangTidy(WorkerContext, Compilations, Files[I], FS, FixNotes,
+                          EnableCheckProfile, ProfilePrefix, UseASTFiles))
+          WorkerErrors[Worker].push_back(std::move(Error));
+      WorkerStats[Worker] = WorkerContext.getStats();
+    });
+  }
+  Pool.wait();
+
+  ClangTidyDiagnosticConsumer Merged(Context);
+  for (size_t Worker = 0; Worker < NumWorkers; ++Worker) {
+    Merged.addTakenErrors(std::move(WorkerErrors[Worker]));
+    const ClangTidyStats &S = WorkerStats[Worker];
+    Stats.ErrorsDisplayed += S.ErrorsDisplayed;
+    Stats.ErrorsIgnoredCheckFilter += S.ErrorsIgnoredCheckFilter;
+    Stats.ErrorsIgnoredNOLINT += S.ErrorsIgnoredNOLINT;
+    Stats.ErrorsIgnoredNonUserCode += S.ErrorsIgnoredNonUserCode;
+    Stats.ErrorsIgnoredLineFilter += S.ErrorsIgnoredLineFilter;
+  }
+  return Merged.take();
+}
+
 static StringRef closest(StringRef Value, const StringSet<> &Allowed) {
   unsigned MaxEdit = 5U;
   StringRef Closest;
@@ -672,9 +798,17 @@ int clangTidyMain(int argc, const char **argv) {
   ClangTidyContext Context(std::move(OwningOptionsProvider),
                            AllowEnablingAnalyzerAlphaCheckers,
                            EnableModuleHeadersParsing);
-  std::vector<ClangTidyError> Errors =
-      runClangTidy(Context, OptionsParser->getCompilations(), PathList, BaseFS,
-                   FixNotes, EnableCheckProfile, ProfilePrefix);
+  ClangTidyStats Stats;
+  std::vector<ClangTidyError> Errors;
+  if (Jobs != 1 && PathList.size() > 1) {
+    Errors = runClangTidyInParallel(Context, OptionsParser->getCompilations(),
+                                    PathList, ProfilePrefix, Stats);
+  } else {
+    Errors = runClangTidy(Context, OptionsParser->getCompilations(), PathList,
+                          BaseFS, FixNotes, EnableCheckProfile, ProfilePrefix,
+                          UseASTFiles);
+    Stats = Context.getStats();
+  }
   bool FoundErrors = llvm::any_of(Errors, [](const ClangTidyError &E) {
     return E.DiagLevel == ClangTidyError::Error;
   });
@@ -702,7 +836,7 @@ int clangTidyMain(int argc, const char **argv) {
   }
 
   if (!Quiet) {
-    printStats(Context.getStats());
+    printStats(Stats);
     if (DisableFixes && Behaviour != FB_NoFix)
       llvm::errs()
           << "Found compiler errors, but -fix-errors was not specified.\n"
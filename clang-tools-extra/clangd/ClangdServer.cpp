@@ -213,6 +213,7 @@ ClangdServer::ClangdServer(const GlobalCompilationDatabase &CDB,
       LineFoldingOnly(Opts.LineFoldingOnly),
       PreambleParseForwardingFunctions(Opts.PreambleParseForwardingFunctions),
       ImportInsertions(Opts.ImportInsertions),
+      PreambleCacheDir(Opts.PreambleCacheDir),
       PublishInactiveRegions(Opts.PublishInactiveRegions),
       WorkspaceRoot(Opts.WorkspaceRoot),
       Transient(Opts.ImplicitCancellation ? TUScheduler::InvalidateOnUpdate
@@ -289,6 +290,7 @@ void ClangdServer::addDocument(PathRef File, llvm::StringRef Contents,
   ParseOptions Opts;
   Opts.PreambleParseForwardingFunctions = PreambleParseForwardingFunctions;
   Opts.ImportInsertions = ImportInsertions;
+  Opts.PreambleCacheDir = PreambleCacheDir;
 
   // Compile command is set asynchronously during update, as it can be slow.
   ParseInputs Inputs;
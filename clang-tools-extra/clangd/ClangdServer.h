@@ -181,6 +181,10 @@ public:
     /// instead of #include.
     bool ImportInsertions = false;
 
+    /// If not empty, preambles are shared with other clangd instances through
+    /// a cache in this directory.
+    std::string PreambleCacheDir;
+
     /// Whether to collect and publish information about inactive preprocessor
     /// regions in the document.
     bool PublishInactiveRegions = false;
@@ -491,6 +495,8 @@ private:
 
   bool ImportInsertions = false;
 
+  std::string PreambleCacheDir;
+
   bool PublishInactiveRegions = false;
 
   // GUARDED_BY(CachedCompletionFuzzyFindRequestMutex)
@@ -42,6 +42,10 @@ struct ParseOptions {
   bool PreambleParseForwardingFunctions = false;
 
   bool ImportInsertions = false;
+
+  // If not empty, the directory of a PreambleCache shared with other clangd
+  // instances.
+  std::string PreambleCacheDir;
 };
 
 /// Information required to run clang, e.g. to parse AST or do code completion.
@@ -120,12 +120,7 @@ public:
     }
     CI.getASTContext().setASTMutationListener(nullptr);
     CapturedCtx.emplace(CI);
-
-    const SourceManager &SM = CI.getSourceManager();
-    const FileEntry *MainFE = SM.getFileEntryForID(SM.getMainFileID());
-    IsMainFileIncludeGuarded =
-        CI.getPreprocessor().getHeaderSearchInfo().isFileMultipleIncludeGuarded(
-            MainFE);
+    afterPreprocess(CI);
 
     if (Stats) {
       const ASTContext &AST = CI.getASTContext();
@@ -147,6 +142,16 @@ public:
     }
   }
 
+  // Collects what is known once the preamble was preprocessed. Called on its
+  // own for a cached preamble, which is only preprocessed.
+  void afterPreprocess(CompilerInstance &CI) {
+    const SourceManager &SM = CI.getSourceManager();
+    const FileEntry *MainFE = SM.getFileEntryForID(SM.getMainFileID());
+    IsMainFileIncludeGuarded =
+        CI.getPreprocessor().getHeaderSearchInfo().isFileMultipleIncludeGuarded(
+            MainFE);
+  }
+
   void BeforeExecute(CompilerInstance &CI) override {
     LangOpts = &CI.getLangOpts();
     SourceMgr = &CI.getSourceManager();
@@ -228,6 +233,33 @@ private:
   std::optional<CapturedASTCtx> CapturedCtx;
 };
 
+/// Runs the preprocessor over the preamble section of \p Contents, so that
+/// \p Callbacks collect what they would have while building the preamble.
+/// This recovers that data for a preamble found in a PreambleCache.
+llvm::Error preprocessPreamble(const CompilerInvocation &CI, PathRef FileName,
+                               llvm::StringRef Contents, PreambleBounds Bounds,
+                               IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS,
+                               CppFilePreambleCallbacks &Callbacks) {
+  IgnoringDiagConsumer IgnoreDiags;
+  auto PreambleContents = llvm::MemoryBuffer::getMemBufferCopy(
+      Contents.take_front(Bounds.Size), FileName);
+  auto Clang = prepareCompilerInstance(
+      std::make_unique<CompilerInvocation>(CI), nullptr,
+      std::move(PreambleContents), std::move(VFS), IgnoreDiags);
+  if (!Clang || Clang->getFrontendOpts().Inputs.empty())
+    return error("failed to prepare compiler instance");
+  PreprocessOnlyAction Action;
+  if (!Action.BeginSourceFile(*Clang, Clang->getFrontendOpts().Inputs[0]))
+    return error("failed BeginSourceFile");
+  Callbacks.BeforeExecute(*Clang);
+  Clang->getPreprocessor().addPPCallbacks(Callbacks.createPPCallbacks());
+  if (llvm::Error Err = Action.Execute())
+    return Err;
+  Callbacks.afterPreprocess(*Clang);
+  Action.EndSourceFile();
+  return llvm::Error::success();
+}
+
 // Represents directives other than includes, where basic textual information is
 // enough.
 struct TextualPPDirective {
@@ -660,11 +692,71 @@ buildPreamble(PathRef FileName, CompilerInvocation CI,
 
   WallTimer PreambleTimer;
   PreambleTimer.startTimer();
+
+  // Try to reuse a preamble that another clangd instance built for the same
+  // inputs. Only the preprocessor has to run to recover its data.
+  std::optional<PreambleCache> Cache;
+  if (!Inputs.Opts.PreambleCacheDir.empty()) {
+    Cache.emplace(Inputs.Opts.PreambleCacheDir, llvm::CachePruningPolicy(),
+                  Inputs.Opts.PreambleParseForwardingFunctions
+                      ? "clangd-parse-forwarding-functions"
+                      : "clangd");
+    if (std::optional<PrecompiledPreamble> CachedPreamble = Cache->lookup(
+            CI, ContentsBuffer->getMemBufferRef(), Bounds, *VFS)) {
+      CppFilePreambleCallbacks CachedInfo(
+          FileName, /*Stats=*/nullptr,
+          Inputs.Opts.PreambleParseForwardingFunctions,
+          /*BeforeExecuteCallback=*/nullptr);
+      if (llvm::Error Err =
+              preprocessPreamble(CI, FileName, Inputs.Contents, Bounds,
+                                 Stats ? TimedFS : StatCacheFS, CachedInfo)) {
+        elog("Could not use cached preamble for file {0}: {1}", FileName,
+             std::move(Err));
+      } else {
+        PreambleTimer.stopTimer();
+        CI.getFrontendOpts().SkipFunctionBodies = false;
+        if (Stats != nullptr) {
+          Stats->TotalBuildTime = PreambleTimer.getTime();
+          Stats->FileSystemTime = TimedFS->getTime();
+          Stats->BuildSize = 0;
+          Stats->SerializedSize = CachedPreamble->getSize();
+        }
+        log("Reused cached preamble of size {0} for file {1} version {2} in {3} "
+            "seconds",
+            CachedPreamble->getSize(), FileName, Inputs.Version,
+            PreambleTimer.getTime());
+        // Cached preambles are stored without diagnostics. There is no AST to
+        // run PreambleCallback on, so the preamble's symbols only come from
+        // the background index.
+        auto Result =
+            std::make_shared<PreambleData>(std::move(*CachedPreamble));
+        Result->Version = Inputs.Version;
+        Result->CompileCommand = Inputs.CompileCommand;
+        Result->Includes = CachedInfo.takeIncludes();
+        Result->Pragmas =
+            std::make_shared<const include_cleaner::PragmaIncludes>(
+                CachedInfo.takePragmaIncludes());
+        Result->Macros = CachedInfo.takeMacros();
+        Result->Marks = CachedInfo.takeMarks();
+        Result->StatCache = StatCache;
+        Result->MainIsIncludeGuarded = CachedInfo.isMainFileIncludeGuarded();
+        return Result;
+      }
+    }
+  }
+
   auto BuiltPreamble = PrecompiledPreamble::Build(
       CI, ContentsBuffer.get(), Bounds, *PreambleDiagsEngine,
       Stats ? TimedFS : StatCacheFS, std::make_shared<PCHContainerOperations>(),
       StoreInMemory, /*StoragePath=*/"", CapturedInfo);
   PreambleTimer.stopTimer();
+  // Only share preambles without diagnostics, as that is how others get them.
+  if (Cache && BuiltPreamble && PreambleDiagsEngine->getNumWarnings() == 0 &&
+      !PreambleDiagsEngine->hasErrorOccurred()) {
+    if (llvm::Error Err = Cache->store(*BuiltPreamble, CI, *VFS))
+      elog("Could not store preamble for file {0} in the cache: {1}", FileName,
+           std::move(Err));
+  }
   // Reset references to ref-counted-ptrs before executing the callbacks, to
   // prevent resetting them concurrently.
   PreambleDiagsEngine.reset();
@@ -511,6 +511,16 @@ opt<bool> PreambleParseForwardingFunctions{
     init(ParseOptions().PreambleParseForwardingFunctions),
 };
 
+opt<std::string> PreambleCacheDir{
+    "preamble-cache-dir",
+    cat(Misc),
+    desc("Share preambles with other clangd instances through a cache in this "
+         "directory. Symbols from shared preambles are only indexed by the "
+         "background index"),
+    Hidden,
+    init(ParseOptions().PreambleCacheDir),
+};
+
 #if defined(__GLIBC__) && CLANGD_MALLOC_TRIM
 opt<bool> EnableMallocTrim{
     "malloc-trim",
@@ -949,6 +959,7 @@ clangd accepts flags on the commandline, and in the CLANGD_FLAGS environment var
   Opts.UseDirtyHeaders = UseDirtyHeaders;
   Opts.PreambleParseForwardingFunctions = PreambleParseForwardingFunctions;
   Opts.ImportInsertions = ImportInsertions;
+  Opts.PreambleCacheDir = PreambleCacheDir;
   Opts.QueryDriverGlobs = std::move(QueryDriverGlobs);
   Opts.TweakFilter = [&](const Tweak &T) {
     if (T.hidden() && !HiddenFeatures)
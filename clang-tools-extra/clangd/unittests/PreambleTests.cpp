@@ -27,6 +27,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "llvm/Support/VirtualFileSystem.h"
@@ -900,6 +901,49 @@ TEST(PreamblePatch, PatchFileEntry) {
   }
 }
 
+TEST(PreambleCache, SharedBetweenFiles) {
+  llvm::SmallString<128> CacheDir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("clangd-preamble-cache",
+                                                    CacheDir));
+  MockFS FS;
+  IgnoreDiagnostics Diags;
+  auto TU = TestTU::withCode(R"cpp(
+    #include "a.h"
+    int x = FOO;
+  )cpp");
+  TU.AdditionalFiles["a.h"] = "#define FOO 1";
+  auto PI = TU.inputs(FS);
+  PI.Opts.PreambleCacheDir = std::string(CacheDir);
+  PreambleBuildStats Stats;
+  ASSERT_TRUE(buildPreamble(TU.Filename, *buildCompilerInvocation(PI, Diags),
+                            PI, true, nullptr, &Stats));
+  EXPECT_NE(Stats.BuildSize, 0u);
+
+  // Another file with the same preamble finds it in the cache, so nothing is
+  // built.
+  TU.Filename = "other.cpp";
+  TU.Code = R"cpp(
+    #include "a.h"
+    int y = FOO;
+  )cpp";
+  PI = TU.inputs(FS);
+  PI.Opts.PreambleCacheDir = std::string(CacheDir);
+  auto Cached = buildPreamble(TU.Filename, *buildCompilerInvocation(PI, Diags),
+                              PI, true, nullptr, &Stats);
+  ASSERT_TRUE(Cached);
+  EXPECT_EQ(Stats.BuildSize, 0u);
+  EXPECT_THAT(Cached->Includes.MainFileIncludes,
+              ElementsAre(AllOf(Field(&Inclusion::Written, "\"a.h\""),
+                                Field(&Inclusion::Resolved, testPath("a.h")))));
+
+  auto AST = ParsedAST::build(testPath(TU.Filename), PI,
+                              buildCompilerInvocation(PI, Diags), {}, Cached);
+  ASSERT_TRUE(AST);
+  EXPECT_THAT(AST->getDiagnostics(), IsEmpty());
+
+  llvm::sys::fs::remove_directories(CacheDir);
+}
+
 } // namespace
 } // namespace clangd
 } // namespace clang
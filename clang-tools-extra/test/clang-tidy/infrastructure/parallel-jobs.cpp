@@ -0,0 +1,39 @@
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: sed -e "s|DIR|%/t|g" %t/cdb.json.template > %t/compile_commands.json
+
+// RUN: clang-tidy -p %t -header-filter=.* -checks='-*,modernize-use-nullptr' \
+// RUN:   -export-fixes=%t/serial.yaml %t/a.cpp %t/b.cpp 2>&1 \
+// RUN:   | FileCheck %s -DPREFIX=%/t --implicit-check-not='warning:'
+// RUN: clang-tidy -j 2 -p %t -header-filter=.* -checks='-*,modernize-use-nullptr' \
+// RUN:   -export-fixes=%t/parallel.yaml %t/a.cpp %t/b.cpp 2>&1 \
+// RUN:   | FileCheck %s -DPREFIX=%/t --implicit-check-not='warning:'
+// RUN: diff %t/serial.yaml %t/parallel.yaml
+
+// The warning in the shared header is reported once.
+// CHECK: [[PREFIX]]/a.cpp:2:19: warning: use nullptr [modernize-use-nullptr]
+// CHECK: [[PREFIX]]/b.cpp:2:19: warning: use nullptr [modernize-use-nullptr]
+// CHECK: [[PREFIX]]/header.h:1:31: warning: use nullptr [modernize-use-nullptr]
+
+//--- cdb.json.template
+[{
+  "directory": "DIR",
+  "command": "clang++ -c a.cpp",
+  "file": "DIR/a.cpp"
+},
+{
+  "directory": "DIR",
+  "command": "clang++ -c b.cpp",
+  "file": "DIR/b.cpp"
+}]
+
+//--- header.h
+inline int *shared() { return 0; }
+
+//--- a.cpp
+#include "header.h"
+int *a() { return 0; }
+
+//--- b.cpp
+#include "header.h"
+int *b() { return 0; }
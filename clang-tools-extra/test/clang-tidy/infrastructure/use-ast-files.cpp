@@ -0,0 +1,69 @@
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: sed -e "s|DIR|%/t|g" %t/cdb.json.template > %t/compile_commands.json
+// RUN: cd %t && %clang -fsyntax-only -Wunused-variable \
+// RUN:   --emit-ast-file=main.ast main.cpp 2>&1 | FileCheck %s --check-prefix=BUILD
+// BUILD: warning: unused variable 'unused'
+
+// With an up-to-date AST, the checks run on it. Diagnostics are reported in
+// the files they were written in, and compiler warnings are not reported.
+// RUN: clang-tidy -p %t --use-ast-files -header-filter=.* \
+// RUN:   -checks='-*,misc-definitions-in-headers,modernize-use-nullptr,clang-diagnostic-unused-variable' \
+// RUN:   %t/main.cpp 2>&1 | FileCheck %s -DPREFIX=%/t --check-prefix=AST \
+// RUN:   --implicit-check-not='warning:'
+// AST: warning: --use-ast-files: compiler warnings are not reported for sources read from ASTs, so these checks found nothing in them: clang-diagnostic-unused-variable{{$}}
+// AST: [[PREFIX]]/header.h:1:5: warning: function 'f' defined in a header file
+// AST: [[PREFIX]]/main.cpp:5:12: warning: use nullptr [modernize-use-nullptr]
+
+// Without --use-ast-files, the source is parsed.
+// RUN: clang-tidy -p %t -header-filter=.* \
+// RUN:   -checks='-*,misc-definitions-in-headers,modernize-use-nullptr,clang-diagnostic-unused-variable' \
+// RUN:   %t/main.cpp 2>&1 | FileCheck %s -DPREFIX=%/t --check-prefix=PARSE \
+// RUN:   --implicit-check-not='warning:'
+// PARSE: [[PREFIX]]/header.h:1:5: warning: function 'f' defined in a header file
+// PARSE: [[PREFIX]]/main.cpp:4:7: warning: unused variable 'unused' [clang-diagnostic-unused-variable]
+// PARSE: [[PREFIX]]/main.cpp:5:12: warning: use nullptr [modernize-use-nullptr]
+
+// Checks based on preprocessor callbacks would find nothing in an AST, so the
+// source is parsed for them.
+// RUN: clang-tidy -p %t --use-ast-files \
+// RUN:   -checks='-*,modernize-use-nullptr,readability-redundant-preprocessor' \
+// RUN:   %t/main.cpp 2>&1 | FileCheck %s -DPREFIX=%/t --check-prefix=PPCALLBACKS \
+// RUN:   --implicit-check-not='warning:'
+// PPCALLBACKS: warning: --use-ast-files: parsed the sources instead of reading their ASTs, because these checks need preprocessor callbacks: readability-redundant-preprocessor{{$}}
+// PPCALLBACKS: [[PREFIX]]/main.cpp:5:12: warning: use nullptr [modernize-use-nullptr]
+// PPCALLBACKS: [[PREFIX]]/main.cpp:9:2: warning: nested redundant #ifdef; consider removing it [readability-redundant-preprocessor]
+
+// Once the source changes, the AST is out of date and the source is parsed.
+// RUN: echo 'int *q = 0;' >> %t/main.cpp
+// RUN: clang-tidy -p %t --use-ast-files -header-filter=.* \
+// RUN:   -checks='-*,misc-definitions-in-headers,modernize-use-nullptr,clang-diagnostic-unused-variable' \
+// RUN:   %t/main.cpp 2>&1 | FileCheck %s -DPREFIX=%/t --check-prefix=STALE \
+// RUN:   --implicit-check-not='warning:'
+// STALE: [[PREFIX]]/header.h:1:5: warning: function 'f' defined in a header file
+// STALE: [[PREFIX]]/main.cpp:4:7: warning: unused variable 'unused' [clang-diagnostic-unused-variable]
+// STALE: [[PREFIX]]/main.cpp:5:12: warning: use nullptr [modernize-use-nullptr]
+// STALE: [[PREFIX]]/main.cpp:12:10: warning: use nullptr [modernize-use-nullptr]
+
+//--- cdb.json.template
+[{
+  "directory": "DIR",
+  "command": "clang -fsyntax-only -Wunused-variable --emit-ast-file=main.ast main.cpp",
+  "file": "DIR/main.cpp"
+}]
+
+//--- header.h
+int f() { return 0; }
+
+//--- main.cpp
+#include "header.h"
+
+void g() {
+  int unused;
+  int *p = 0;
+  (void)p;
+}
+#ifdef FOO
+#ifdef FOO
+#endif
+#endif
@@ -111,6 +111,25 @@ TEST(ClangTidyDiagnosticConsumer, InvalidSourceLocationRangesIgnored) {
   EXPECT_EQ(1ul, Errors[3].Message.Ranges.size());
 }
 
+TEST(ClangTidyDiagnosticConsumer, DeduplicatesTakenErrors) {
+  std::vector<ClangTidyError> First, Second;
+  runCheckOnCode<TestCheck>("int a;", &First);
+  runCheckOnCode<TestCheck>("int a; int b;", &Second);
+
+  ClangTidyContext Context(std::make_unique<DefaultOptionsProvider>(
+      ClangTidyGlobalOptions(), ClangTidyOptions()));
+  ClangTidyDiagnosticConsumer DiagConsumer(Context);
+  DiagConsumer.addTakenErrors(First);
+  DiagConsumer.addTakenErrors(Second);
+  std::vector<ClangTidyError> Errors = DiagConsumer.take();
+  EXPECT_EQ(5ul, Errors.size());
+  EXPECT_EQ("DiagWithNoLoc", Errors[0].Message.Message);
+  EXPECT_EQ("type specifier", Errors[1].Message.Message);
+  EXPECT_EQ("variable", Errors[2].Message.Message);
+  EXPECT_EQ("type specifier", Errors[3].Message.Message);
+  EXPECT_EQ("variable", Errors[4].Message.Message);
+}
+
 } // namespace test
 } // namespace tidy
 } // namespace clang
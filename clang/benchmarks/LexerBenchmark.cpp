@@ -0,0 +1,162 @@
+//===--- LexerBenchmark.cpp - Raw lexer benchmarks ------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Benchmarks for raw lexing of inputs dominated by one kind of token, such as
+// generated tables or large comment blocks, and optionally of a given file.
+//
+// Note: make sure to build the benchmark in Release mode.
+//
+// Usage:
+//   tools/clang/benchmarks/ClangLexerBenchmark \
+//      [--source=../clang/lib/Sema/SemaDecl.cpp]
+//
+//===----------------------------------------------------------------------===//
+
+#include "benchmark/benchmark.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Token.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using llvm::cl::desc;
+using llvm::cl::opt;
+
+static opt<std::string> Source("source", desc("Source file to lex"));
+
+namespace clang {
+namespace bench {
+namespace {
+
+std::string repeat(const std::string &Line, unsigned Count) {
+  std::string Result;
+  Result.reserve(Line.size() * Count);
+  for (unsigned I = 0; I != Count; ++I)
+    Result += Line;
+  return Result;
+}
+
+// Each input is about 1MB.
+const std::string &generatedTable() {
+  static const std::string Text =
+      repeat("  0x1234abcd, 0x00000000, 0xdeadbeef, 0x0badf00d, 0x7fffffff,\n",
+             16 * 1024);
+  return Text;
+}
+
+const std::string &lineComments() {
+  static const std::string Text = repeat(
+      "// Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do.\n",
+      16 * 1024);
+  return Text;
+}
+
+const std::string &blockComments() {
+  static const std::string Text = repeat(
+      "/* Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do\n"
+      " * eiusmod tempor incididunt ut labore et dolore magna aliqua. */\n",
+      8 * 1024);
+  return Text;
+}
+
+const std::string &longIdentifiers() {
+  static const std::string Text = repeat(
+      "some_rather_long_identifier_name = another_quite_long_name_Foo42;\n",
+      16 * 1024);
+  return Text;
+}
+
+const std::string &stringLiterals() {
+  static const std::string Text = repeat(
+      "  \"The quick brown fox jumps over the lazy dog, again and again\",\n",
+      16 * 1024);
+  return Text;
+}
+
+const std::string &indentation() {
+  static const std::string Text =
+      repeat("                                                    x;\n",
+             16 * 1024);
+  return Text;
+}
+
+void lex(benchmark::State &State, const std::string &Text) {
+  LangOptions LangOpts;
+  LangOpts.CPlusPlus = true;
+  LangOpts.CPlusPlus11 = true;
+  LangOpts.LineComment = true;
+  for (auto _ : State) {
+    Lexer L(SourceLocation(), LangOpts, Text.data(), Text.data(),
+            Text.data() + Text.size());
+    Token Tok;
+    unsigned NumTokens = 0;
+    while (!L.LexFromRawLexer(Tok))
+      ++NumTokens;
+    benchmark::DoNotOptimize(NumTokens);
+  }
+  State.SetBytesProcessed(static_cast<uint64_t>(State.iterations()) *
+                          Text.size());
+}
+
+void lexGeneratedTable(benchmark::State &State) {
+  lex(State, generatedTable());
+}
+BENCHMARK(lexGeneratedTable);
+
+void lexLineComments(benchmark::State &State) {
+  lex(State, lineComments());
+}
+BENCHMARK(lexLineComments);
+
+void lexBlockComments(benchmark::State &State) {
+  lex(State, blockComments());
+}
+BENCHMARK(lexBlockComments);
+
+void lexLongIdentifiers(benchmark::State &State) {
+  lex(State, longIdentifiers());
+}
+BENCHMARK(lexLongIdentifiers);
+
+void lexStringLiterals(benchmark::State &State) {
+  lex(State, stringLiterals());
+}
+BENCHMARK(lexStringLiterals);
+
+void lexIndentation(benchmark::State &State) {
+  lex(State, indentation());
+}
+BENCHMARK(lexIndentation);
+
+void lexSource(benchmark::State &State) {
+  if (Source.empty()) {
+    State.SkipWithError("no --source given");
+    return;
+  }
+  auto Buffer = llvm::MemoryBuffer::getFile(Source);
+  if (!Buffer) {
+    State.SkipWithError("cannot read --source");
+    return;
+  }
+  lex(State, (*Buffer)->getBuffer().str());
+}
+BENCHMARK(lexSource);
+
+} // namespace
+} // namespace bench
+} // namespace clang
+
+int main(int argc, char *argv[]) {
+  benchmark::Initialize(&argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -30,6 +30,7 @@
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/PointerUnion.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Casting.h"
@@ -779,6 +780,43 @@ class RedeclarableTemplateDecl : public TemplateDecl,
   }
 
   void anchor() override;
+public:
+  /// A specialization known only by its external declaration ID, along with
+  /// enough information to decide whether a lookup needs to load it.
+  struct LazySpecializationInfo {
+    /// The sentinel hash of specializations that any lookup needs to load.
+    static constexpr unsigned UnknownODRHash = ~0U;
+
+    uint32_t DeclID = ~0U;
+    /// The hash of the template arguments, see \c computeSpecializationHash.
+    unsigned ODRHash = UnknownODRHash;
+    /// Whether this is a partial specialization.
+    bool IsPartial = false;
+
+    LazySpecializationInfo() = default;
+    LazySpecializationInfo(uint32_t ID, unsigned Hash = UnknownODRHash,
+                           bool Partial = false)
+        : DeclID(ID), ODRHash(Hash), IsPartial(Partial) {}
+
+    bool operator<(const LazySpecializationInfo &Other) const {
+      return DeclID < Other.DeclID;
+    }
+    bool operator==(const LazySpecializationInfo &Other) const {
+      return DeclID == Other.DeclID;
+    }
+  };
+
+  /// Compute the hash that keys lazy specializations with the template
+  /// arguments \p Args. The hash is stable across translation units, so it
+  /// can be stored in AST files. Returns \c UnknownODRHash for dependent
+  /// arguments.
+  static unsigned computeSpecializationHash(const ASTContext &Context,
+                                            ArrayRef<TemplateArgument> Args);
+
+  /// Compute the hash that keys the lazy specialization \p Spec, which is a
+  /// class, variable or function template specialization.
+  static unsigned computeSpecializationHash(const Decl *Spec);
+
 protected:
   template <typename EntryType> struct SpecEntryTraits {
     using DeclType = EntryType;
@@ -819,7 +857,19 @@ protected:
     return SpecIterator<EntryType>(isEnd ? Specs.end() : Specs.begin());
   }
 
-  void loadLazySpecializationsImpl() const;
+  /// Load the lazily-loaded specializations for which \p ShouldLoad returns
+  /// true, leaving the others lazy.
+  void loadLazySpecializationsIf(
+      llvm::function_ref<bool(const LazySpecializationInfo &)> ShouldLoad)
+      const;
+
+  /// Load all lazily-loaded specializations, or only the partial ones if
+  /// \p OnlyPartial is set.
+  void loadLazySpecializationsImpl(bool OnlyPartial = false) const;
+
+  /// Load the lazily-loaded (non-partial) specializations that may have the
+  /// template arguments \p Args, leaving the others to later lookups.
+  void loadLazySpecializationsImpl(ArrayRef<TemplateArgument> Args) const;
 
   template <class EntryType, typename ...ProfileArguments>
   typename SpecEntryTraits<EntryType>::DeclType*
@@ -844,9 +894,9 @@ protected:
     /// If non-null, points to an array of specializations (including
     /// partial specializations) known only by their external declaration IDs.
     ///
-    /// The first value in the array is the number of specializations/partial
-    /// specializations that follow.
-    uint32_t *LazySpecializations = nullptr;
+    /// The \c DeclID of the first value in the array is the number of
+    /// specializations/partial specializations that follow.
+    LazySpecializationInfo *LazySpecializations = nullptr;
 
     /// The set of "injected" template arguments used within this
     /// template.
@@ -1049,6 +1099,10 @@ public:
   /// Load any lazily-loaded specializations from the external source.
   void LoadLazySpecializations() const;
 
+  /// Load the lazily-loaded specializations from the external source that may
+  /// have the template arguments \p Args.
+  void LoadLazySpecializations(ArrayRef<TemplateArgument> Args) const;
+
   /// Get the underlying function declaration of the template.
   FunctionDecl *getTemplatedDecl() const {
     return static_cast<FunctionDecl *>(TemplatedDecl);
@@ -2322,6 +2376,10 @@ public:
   /// Load any lazily-loaded specializations from the external source.
   void LoadLazySpecializations() const;
 
+  /// Load the lazily-loaded specializations from the external source that may
+  /// have the template arguments \p Args.
+  void LoadLazySpecializations(ArrayRef<TemplateArgument> Args) const;
+
   /// Get the underlying class declarations of the template.
   CXXRecordDecl *getTemplatedDecl() const {
     return static_cast<CXXRecordDecl *>(TemplatedDecl);
@@ -3156,6 +3214,10 @@ public:
   /// Load any lazily-loaded specializations from the external source.
   void LoadLazySpecializations() const;
 
+  /// Load the lazily-loaded specializations from the external source that may
+  /// have the template arguments \p Args.
+  void LoadLazySpecializations(ArrayRef<TemplateArgument> Args) const;
+
   /// Get the underlying variable declarations of the template.
   VarDecl *getTemplatedDecl() const {
     return static_cast<VarDecl *>(TemplatedDecl);
@@ -257,6 +257,11 @@ public:
   /// Output filename for the split debug info, not used in the skeleton CU.
   std::string SplitDwarfOutput;
 
+  /// Output filenames for the partitions of the module other than the first
+  /// one, which goes to the main output. If non-empty, code for all
+  /// partitions is generated in parallel.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
   /// Output filename used in the COFF debug information.
   std::string ObjectFilenameForDebug;
 
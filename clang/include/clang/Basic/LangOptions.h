@@ -479,6 +479,10 @@ public:
   /// The seed used by the randomize structure layout feature.
   std::string RandstructSeed;
 
+  /// File to which implicit instantiations that only depend on the PCH are
+  /// recorded (-fpch-instantiation-cache).
+  std::string PCHInstantiationCache;
+
   /// Indicates whether to use target's platform-specific file separator when
   /// __FILE__ macro is used and when concatenating filename with directory or
   /// to use build environment environment's platform-specific file separator.
@@ -127,6 +127,9 @@ private:
   FileSystemOptions FileSystemOpts;
   std::string PreambleStoragePath;
 
+  /// The directory of a PreambleCache shared with other processes, or empty.
+  std::string PreambleCachePath;
+
   /// The AST consumer that received information about the translation
   /// unit as it was parsed or loaded.
   std::unique_ptr<ASTConsumer> Consumer;
@@ -824,6 +827,10 @@ public:
   /// it(i.e., be an overlay over RealFileSystem). RealFileSystem will be used
   /// if \p VFS is nullptr.
   ///
+  /// \param PreambleCachePath - If not empty, the directory of a PreambleCache
+  /// to look up precompiled preambles in before building them, and to store
+  /// newly built ones in.
+  ///
   // FIXME: Move OnlyLocalDecls, UseBumpAllocator to setters on the ASTUnit, we
   // shouldn't need to specify them at construction time.
   static std::unique_ptr<ASTUnit> LoadFromCommandLine(
@@ -847,7 +854,8 @@ public:
       bool RetainExcludedConditionalBlocks = false,
       std::optional<StringRef> ModuleFormat = std::nullopt,
       std::unique_ptr<ASTUnit> *ErrAST = nullptr,
-      IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS = nullptr);
+      IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS = nullptr,
+      StringRef PreambleCachePath = StringRef());
 
   /// Reparse the source files using the same command-line options that
   /// were originally used to produce this translation unit.
@@ -113,6 +113,18 @@ public:
   bool BeginSourceFileAction(CompilerInstance &CI) override;
 };
 
+/// Runs the wrapped action and also writes the AST of the translation unit,
+/// in the format of -emit-ast, to FrontendOptions::ASTOutputFile.
+class WrappingEmitASTAction : public WrapperFrontendAction {
+protected:
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
+                                                 StringRef InFile) override;
+
+public:
+  WrappingEmitASTAction(std::unique_ptr<FrontendAction> WrappedAction)
+      : WrapperFrontendAction(std::move(WrappedAction)) {}
+};
+
 class GenerateModuleAction : public ASTFrontendAction {
   virtual std::unique_ptr<raw_pwrite_stream>
   CreateOutputFile(CompilerInstance &CI, StringRef InFile) = 0;
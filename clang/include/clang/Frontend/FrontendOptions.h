@@ -347,6 +347,10 @@ public:
   /// Whether to share the FileManager when building modules.
   unsigned ModulesShareFileManager : 1;
 
+  /// Record template instantiation and constant evaluation step counts in the
+  /// -ftime-trace output.
+  unsigned TimeTraceSteps : 1;
+
   CodeCompleteOptions CodeCompleteOpts;
 
   /// Specifies the output format of the AST.
@@ -462,6 +466,10 @@ public:
   // be dumped
   std::string SymbolGraphOutputDir;
 
+  /// File to which the AST of the translation unit is written as a side effect
+  /// of the main action (--emit-ast-file).
+  std::string ASTOutputFile;
+
   /// Args to pass to the plugins
   std::map<std::string, std::vector<std::string>> PluginArgs;
 
@@ -525,7 +533,7 @@ public:
         BuildingImplicitModuleUsesLock(true), ModulesEmbedAllFiles(false),
         IncludeTimestamps(true), UseTemporary(true),
         AllowPCMWithCompilerErrors(false), ModulesShareFileManager(true),
-        TimeTraceGranularity(500) {}
+        TimeTraceSteps(false), TimeTraceGranularity(500) {}
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
   /// extension. For example, "c" would return Language::C.
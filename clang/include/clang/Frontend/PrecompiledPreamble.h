@@ -17,9 +17,12 @@
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/MD5.h"
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <system_error>
 #include <type_traits>
 
@@ -133,6 +136,8 @@ public:
                         llvm::MemoryBuffer *MainFileBuffer) const;
 
 private:
+  friend class PreambleCache;
+
   PrecompiledPreamble(std::unique_ptr<PCHStorage> Storage,
                       std::vector<char> PreambleBytes,
                       bool PreambleEndsAtStartOfLine,
@@ -207,6 +212,66 @@ private:
   bool PreambleEndsAtStartOfLine;
 };
 
+/// An on-disk store of precompiled preambles that can be shared by several
+/// processes, e.g. multiple clangd or libclang instances working on the same
+/// sources.
+///
+/// Entries are content-addressed. A preamble is filed under a key computed
+/// from the compiler version, the compile flags, the working directory and the
+/// preamble bounds and text. The main file's name is not part of the key, so
+/// files in the same directory that start with the same preamble share it.
+/// Under that key, each entry records the contents hashes of all files the
+/// preamble depends on, and is only reused if all of them still match.
+///
+/// Each key has an index file that lists its most recent entries, so a lookup
+/// reads a handful of files rather than the whole directory. All files use the
+/// "llvmcache-" prefix, and store() evicts unused ones with
+/// \c llvm::pruneCache according to the given policy. A preamble returned by
+/// lookup() holds its own hard link to (or copy of) its PCH, so it stays
+/// usable when another process prunes the entry.
+class PreambleCache {
+public:
+  /// \param ClientKey Distinguishes preambles that clients build differently
+  /// from the same invocation, e.g. through
+  /// PreambleCallbacks::shouldSkipFunctionBody().
+  explicit PreambleCache(StringRef Directory,
+                         llvm::CachePruningPolicy Policy = {},
+                         StringRef ClientKey = StringRef())
+      : Directory(Directory), Policy(Policy), ClientKey(ClientKey) {}
+
+  /// Looks for a preamble that was stored for the same inputs as a preamble
+  /// built with \p Invocation for the first \p Bounds bytes of
+  /// \p MainFileBuffer would have, and whose dependencies are unchanged.
+  ///
+  /// \param ClientData If not null, receives the data that was passed to
+  /// store() along with the preamble.
+  std::optional<PrecompiledPreamble>
+  lookup(const CompilerInvocation &Invocation,
+         const llvm::MemoryBufferRef &MainFileBuffer, PreambleBounds Bounds,
+         llvm::vfs::FileSystem &VFS, std::string *ClientData = nullptr) const;
+
+  /// Adds \p Preamble, which was built from \p Invocation, to the cache, and
+  /// prunes the cache. Fails if one of the preamble's dependencies has changed
+  /// since it was built.
+  ///
+  /// \param ClientData Opaque data to hand back when the preamble is found
+  /// by lookup(), e.g. what the client collected in its PreambleCallbacks.
+  llvm::Error store(const PrecompiledPreamble &Preamble,
+                    const CompilerInvocation &Invocation,
+                    llvm::vfs::FileSystem &VFS,
+                    StringRef ClientData = StringRef()) const;
+
+private:
+  /// Returns the key of the entries for the given inputs.
+  std::string getKey(const CompilerInvocation &Invocation,
+                     StringRef PreambleBytes, bool PreambleEndsAtStartOfLine,
+                     llvm::vfs::FileSystem &VFS) const;
+
+  std::string Directory;
+  llvm::CachePruningPolicy Policy;
+  std::string ClientKey;
+};
+
 /// A set of callbacks to gather useful information while building a preamble.
 class PreambleCallbacks {
 public:
@@ -9976,6 +9976,11 @@ public:
   /// eagerly.
   SmallVector<PendingImplicitInstantiation, 1> LateParsedInstantiations;
 
+  /// The implicit function template instantiations performed in this
+  /// translation unit that only depend on declarations from the PCH, spelled
+  /// as explicit instantiation definitions (-fpch-instantiation-cache).
+  std::vector<std::string> CacheableInstantiations;
+
   SmallVector<SmallVector<VTableUse, 16>, 8> SavedVTableUses;
   SmallVector<std::deque<PendingImplicitInstantiation>, 8>
       SavedPendingInstantiations;
@@ -10091,6 +10096,21 @@ public:
 
   void PerformPendingInstantiations(bool LocalOnly = false);
 
+  /// Record \p Function, which was just implicitly instantiated from
+  /// \p Pattern, for -fpch-instantiation-cache if the instantiation can be
+  /// spelled using only declarations from the PCH.
+  void recordInstantiationForCache(FunctionDecl *Function,
+                                   const FunctionDecl *Pattern);
+
+  /// Add the recorded instantiations to the -fpch-instantiation-cache file,
+  /// replacing any that were recorded against a different PCH.
+  void writeInstantiationCache();
+
+  /// If this translation unit builds a PCH from an -fpch-instantiation-cache
+  /// file, diagnose that it is not chained on top of the PCH the file was
+  /// recorded against.
+  void checkInstantiationCacheBase();
+
   TypeSourceInfo *SubstType(TypeSourceInfo *T,
                             const MultiLevelTemplateArgumentList &TemplateArgs,
                             SourceLocation Loc, DeclarationName Entity,
@@ -14,6 +14,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include <mutex>
@@ -142,6 +143,48 @@ private:
   CachedFileContents *Contents;
 };
 
+/// This class is an on-disk cache of the scanned preprocessor directives of
+/// files, which lets separate clang-scan-deps invocations reuse each other's
+/// work.
+///
+/// Entries are keyed by a hash of the file contents and the compiler version.
+/// A modified file therefore never finds a stale entry, and no separate
+/// validation is required. Unused entries are evicted by \c llvm::pruneCache
+/// according to the given policy when the cache is destroyed.
+///
+/// This class is thread-safe.
+class DependencyDirectivesDiskCache {
+public:
+  DependencyDirectivesDiskCache(StringRef Path,
+                                llvm::CachePruningPolicy Policy = {})
+      : Path(Path), Policy(Policy) {}
+  ~DependencyDirectivesDiskCache();
+
+  /// \returns The key of the entry for a file with the given contents.
+  std::string getKey(StringRef Contents) const;
+
+  /// Reads the entry for \p Key of a file with the given contents.
+  ///
+  /// \returns True on a cache hit, in which case \p Tokens and \p Directives
+  /// hold the directives as if scanned by
+  /// \c scanSourceForDependencyDirectives.
+  bool lookup(StringRef Key, StringRef Contents,
+              SmallVectorImpl<dependency_directives_scan::Token> &Tokens,
+              SmallVectorImpl<dependency_directives_scan::Directive>
+                  &Directives) const;
+
+  /// Writes the entry for \p Key. Errors are ignored, as the cache only serves
+  /// to speed up later invocations.
+  void store(StringRef Key, ArrayRef<dependency_directives_scan::Token> Tokens,
+             ArrayRef<dependency_directives_scan::Directive> Directives) const;
+
+private:
+  std::string getEntryPath(StringRef Key) const;
+
+  std::string Path;
+  llvm::CachePruningPolicy Policy;
+};
+
 /// This class is a shared cache, that caches the 'stat' and 'open' calls to the
 /// underlying real file system, and the scanned preprocessor directives of
 /// files.
@@ -202,9 +245,35 @@ public:
   CacheShard &getShardForFilename(StringRef Filename) const;
   CacheShard &getShardForUID(llvm::sys::fs::UniqueID UID) const;
 
+  /// Drops the cached entries of the given files, so that the next scan stats
+  /// and reads them again. Entries are shared between all names of a file, so
+  /// this also drops the entries other filenames associate with the unique IDs
+  /// of the files, both as cached and as currently found in \p FS. Must not be
+  /// called while any worker uses this cache.
+  ///
+  /// The storage of dropped entries is only reclaimed with the cache itself.
+  void invalidate(ArrayRef<std::string> Filenames, llvm::vfs::FileSystem &FS);
+
+  /// Drops the cached failures to stat files, so that files created since are
+  /// found by the next scan. Must not be called while any worker uses this
+  /// cache.
+  void invalidateMissingFiles();
+
+  /// Sets the on-disk cache that scanned directives are read from and
+  /// written to. Must be called before any worker uses this cache.
+  void setDiskCache(std::unique_ptr<DependencyDirectivesDiskCache> Cache) {
+    DiskCache = std::move(Cache);
+  }
+
+  /// Returns the on-disk cache of scanned directives, or nullptr if none.
+  const DependencyDirectivesDiskCache *getDiskCache() const {
+    return DiskCache.get();
+  }
+
 private:
   std::unique_ptr<CacheShard[]> CacheShards;
   unsigned NumShards;
+  std::unique_ptr<DependencyDirectivesDiskCache> DiskCache;
 };
 
 /// This class is a local cache, that caches the 'stat' and 'open' calls to the
@@ -91,6 +91,12 @@ public:
   llvm::Expected<std::string>
   getDependencyFile(const std::vector<std::string> &CommandLine, StringRef CWD);
 
+  /// Like \c getDependencyFile above, but also returns the files listed in the
+  /// dependency file in \p FileDeps.
+  llvm::Expected<std::string>
+  getDependencyFile(const std::vector<std::string> &CommandLine, StringRef CWD,
+                    std::vector<std::string> &FileDeps);
+
   /// Collect the module dependency in P1689 format for C++20 named modules.
   ///
   /// \param MakeformatOutput The output parameter for dependency information
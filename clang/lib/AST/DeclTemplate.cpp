@@ -17,6 +17,7 @@
 #include "clang/AST/DeclarationName.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExternalASTSource.h"
+#include "clang/AST/ODRHash.h"
 #include "clang/AST/TemplateBase.h"
 #include "clang/AST/TemplateName.h"
 #include "clang/AST/Type.h"
@@ -331,17 +332,78 @@ RedeclarableTemplateDecl::CommonBase *RedeclarableTemplateDecl::getCommonPtr() c
   return Common;
 }
 
-void RedeclarableTemplateDecl::loadLazySpecializationsImpl() const {
+unsigned RedeclarableTemplateDecl::computeSpecializationHash(
+    const ASTContext &Context, ArrayRef<TemplateArgument> Args) {
+  ODRHash Hasher;
+  for (const TemplateArgument &Arg : Args) {
+    // Profiling dependent arguments isn't stable enough to rely on finding
+    // their specializations by hash.
+    if (Arg.isDependent())
+      return LazySpecializationInfo::UnknownODRHash;
+    Hasher.AddTemplateArgument(Context.getCanonicalTemplateArgument(Arg));
+  }
+  return Hasher.CalculateHash();
+}
+
+unsigned RedeclarableTemplateDecl::computeSpecializationHash(const Decl *Spec) {
+  ArrayRef<TemplateArgument> Args;
+  if (const auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(Spec))
+    Args = CTSD->getTemplateArgs().asArray();
+  else if (const auto *VTSD = dyn_cast<VarTemplateSpecializationDecl>(Spec))
+    Args = VTSD->getTemplateArgs().asArray();
+  else if (const auto *FD = dyn_cast<FunctionDecl>(Spec))
+    Args = FD->getTemplateSpecializationArgs()->asArray();
+  else
+    llvm_unreachable("unexpected kind of specialization");
+  return computeSpecializationHash(Spec->getASTContext(), Args);
+}
+
+void RedeclarableTemplateDecl::loadLazySpecializationsIf(
+    llvm::function_ref<bool(const LazySpecializationInfo &)> ShouldLoad) const {
   // Grab the most recent declaration to ensure we've loaded any lazy
   // redeclarations of this template.
   CommonBase *CommonBasePtr = getMostRecentDecl()->getCommonPtr();
-  if (CommonBasePtr->LazySpecializations) {
-    ASTContext &Context = getASTContext();
-    uint32_t *Specs = CommonBasePtr->LazySpecializations;
-    CommonBasePtr->LazySpecializations = nullptr;
-    for (uint32_t I = 0, N = *Specs++; I != N; ++I)
-      (void)Context.getExternalSource()->GetExternalDecl(Specs[I]);
+  LazySpecializationInfo *Specs = CommonBasePtr->LazySpecializations;
+  if (!Specs)
+    return;
+
+  // Compact the specializations that stay lazy before loading any, since
+  // loading may add further lazy specializations to the template.
+  SmallVector<uint32_t, 8> IDs;
+  uint32_t NumKept = 0;
+  for (uint32_t I = 1, N = Specs[0].DeclID; I <= N; ++I) {
+    if (ShouldLoad(Specs[I]))
+      IDs.push_back(Specs[I].DeclID);
+    else
+      Specs[++NumKept] = Specs[I];
   }
+  Specs[0].DeclID = NumKept;
+  if (!NumKept)
+    CommonBasePtr->LazySpecializations = nullptr;
+
+  ASTContext &Context = getASTContext();
+  for (uint32_t ID : IDs)
+    (void)Context.getExternalSource()->GetExternalDecl(ID);
+}
+
+void RedeclarableTemplateDecl::loadLazySpecializationsImpl(
+    bool OnlyPartial) const {
+  loadLazySpecializationsIf([&](const LazySpecializationInfo &Info) {
+    return !OnlyPartial || Info.IsPartial;
+  });
+}
+
+void RedeclarableTemplateDecl::loadLazySpecializationsImpl(
+    ArrayRef<TemplateArgument> Args) const {
+  if (!getMostRecentDecl()->getCommonPtr()->LazySpecializations)
+    return;
+  unsigned Hash = computeSpecializationHash(getASTContext(), Args);
+  loadLazySpecializationsIf([&](const LazySpecializationInfo &Info) {
+    return !Info.IsPartial &&
+           (Hash == LazySpecializationInfo::UnknownODRHash ||
+            Info.ODRHash == LazySpecializationInfo::UnknownODRHash ||
+            Info.ODRHash == Hash);
+  });
 }
 
 template<class EntryType, typename... ProfileArguments>
@@ -434,6 +496,11 @@ void FunctionTemplateDecl::LoadLazySpecializations() const {
   loadLazySpecializationsImpl();
 }
 
+void FunctionTemplateDecl::LoadLazySpecializations(
+    ArrayRef<TemplateArgument> Args) const {
+  loadLazySpecializationsImpl(Args);
+}
+
 llvm::FoldingSetVector<FunctionTemplateSpecializationInfo> &
 FunctionTemplateDecl::getSpecializations() const {
   LoadLazySpecializations();
@@ -443,13 +510,19 @@ FunctionTemplateDecl::getSpecializations() const {
 FunctionDecl *
 FunctionTemplateDecl::findSpecialization(ArrayRef<TemplateArgument> Args,
                                          void *&InsertPos) {
-  return findSpecializationImpl(getSpecializations(), InsertPos, Args);
+  LoadLazySpecializations(Args);
+  return findSpecializationImpl(getCommonPtr()->Specializations, InsertPos,
+                                Args);
 }
 
 void FunctionTemplateDecl::addSpecialization(
       FunctionTemplateSpecializationInfo *Info, void *InsertPos) {
-  addSpecializationImpl<FunctionTemplateDecl>(getSpecializations(), Info,
-                                              InsertPos);
+  // Without an insert position from findSpecialization(), a matching lazy
+  // specialization may not have been loaded yet.
+  if (!InsertPos)
+    LoadLazySpecializations(Info->TemplateArguments->asArray());
+  addSpecializationImpl<FunctionTemplateDecl>(getCommonPtr()->Specializations,
+                                              Info, InsertPos);
 }
 
 void FunctionTemplateDecl::mergePrevDecl(FunctionTemplateDecl *Prev) {
@@ -512,6 +585,11 @@ void ClassTemplateDecl::LoadLazySpecializations() const {
   loadLazySpecializationsImpl();
 }
 
+void ClassTemplateDecl::LoadLazySpecializations(
+    ArrayRef<TemplateArgument> Args) const {
+  loadLazySpecializationsImpl(Args);
+}
+
 llvm::FoldingSetVector<ClassTemplateSpecializationDecl> &
 ClassTemplateDecl::getSpecializations() const {
   LoadLazySpecializations();
@@ -520,7 +598,7 @@ ClassTemplateDecl::getSpecializations() const {
 
 llvm::FoldingSetVector<ClassTemplatePartialSpecializationDecl> &
 ClassTemplateDecl::getPartialSpecializations() const {
-  LoadLazySpecializations();
+  loadLazySpecializationsImpl(/*OnlyPartial=*/true);
   return getCommonPtr()->PartialSpecializations;
 }
 
@@ -534,12 +612,19 @@ ClassTemplateDecl::newCommon(ASTContext &C) const {
 ClassTemplateSpecializationDecl *
 ClassTemplateDecl::findSpecialization(ArrayRef<TemplateArgument> Args,
                                       void *&InsertPos) {
-  return findSpecializationImpl(getSpecializations(), InsertPos, Args);
+  LoadLazySpecializations(Args);
+  return findSpecializationImpl(getCommonPtr()->Specializations, InsertPos,
+                                Args);
 }
 
 void ClassTemplateDecl::AddSpecialization(ClassTemplateSpecializationDecl *D,
                                           void *InsertPos) {
-  addSpecializationImpl<ClassTemplateDecl>(getSpecializations(), D, InsertPos);
+  // Without an insert position from findSpecialization(), a matching lazy
+  // specialization may not have been loaded yet.
+  if (!InsertPos)
+    LoadLazySpecializations(D->getTemplateArgs().asArray());
+  addSpecializationImpl<ClassTemplateDecl>(getCommonPtr()->Specializations, D,
+                                           InsertPos);
 }
 
 ClassTemplatePartialSpecializationDecl *
@@ -1245,6 +1330,11 @@ void VarTemplateDecl::LoadLazySpecializations() const {
   loadLazySpecializationsImpl();
 }
 
+void VarTemplateDecl::LoadLazySpecializations(
+    ArrayRef<TemplateArgument> Args) const {
+  loadLazySpecializationsImpl(Args);
+}
+
 llvm::FoldingSetVector<VarTemplateSpecializationDecl> &
 VarTemplateDecl::getSpecializations() const {
   LoadLazySpecializations();
@@ -1253,7 +1343,7 @@ VarTemplateDecl::getSpecializations() const {
 
 llvm::FoldingSetVector<VarTemplatePartialSpecializationDecl> &
 VarTemplateDecl::getPartialSpecializations() const {
-  LoadLazySpecializations();
+  loadLazySpecializationsImpl(/*OnlyPartial=*/true);
   return getCommonPtr()->PartialSpecializations;
 }
 
@@ -1267,12 +1357,19 @@ VarTemplateDecl::newCommon(ASTContext &C) const {
 VarTemplateSpecializationDecl *
 VarTemplateDecl::findSpecialization(ArrayRef<TemplateArgument> Args,
                                     void *&InsertPos) {
-  return findSpecializationImpl(getSpecializations(), InsertPos, Args);
+  LoadLazySpecializations(Args);
+  return findSpecializationImpl(getCommonPtr()->Specializations, InsertPos,
+                                Args);
 }
 
 void VarTemplateDecl::AddSpecialization(VarTemplateSpecializationDecl *D,
                                         void *InsertPos) {
-  addSpecializationImpl<VarTemplateDecl>(getSpecializations(), D, InsertPos);
+  // Without an insert position from findSpecialization(), a matching lazy
+  // specialization may not have been loaded yet.
+  if (!InsertPos)
+    LoadLazySpecializations(D->getTemplateArgs().asArray());
+  addSpecializationImpl<VarTemplateDecl>(getCommonPtr()->Specializations, D,
+                                         InsertPos);
 }
 
 VarTemplatePartialSpecializationDecl *
@@ -991,6 +991,8 @@ namespace {
 
     ~EvalInfo() {
       discardCleanups();
+      if (unsigned Steps = Ctx.getLangOpts().ConstexprStepLimit - StepsLeft)
+        llvm::timeTraceAddCount("constexpr steps", Steps);
     }
 
     ASTContext &getCtx() const override { return Ctx; }
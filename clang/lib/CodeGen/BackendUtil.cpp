@@ -16,6 +16,7 @@
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/GlobalsModRef.h"
@@ -29,6 +30,7 @@
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
@@ -46,6 +48,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -80,7 +83,9 @@
 #include "llvm/Transforms/Utils/Debugify.h"
 #include "llvm/Transforms/Utils/EntryExitInstrumenter.h"
 #include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include <memory>
+#include <mutex>
 #include <optional>
 using namespace clang;
 using namespace llvm;
@@ -137,10 +142,20 @@ class EmitAssemblyHelper {
   /// the requested target.
   void CreateTargetMachine(bool MustCreateTM);
 
+  /// Creates a new TargetMachine for the module's triple and the current
+  /// options, or returns null (after reporting an error if MustCreateTM is
+  /// set) if that is not possible.
+  std::unique_ptr<TargetMachine> createTargetMachine(bool MustCreateTM);
+
   /// Add passes necessary to emit assembly or LLVM IR.
   ///
   /// \return True on success.
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
+                     raw_pwrite_stream &OS, raw_pwrite_stream *DwoOS) {
+    return AddEmitPasses(CodeGenPasses, *TM, Action, OS, DwoOS);
+  }
+  bool AddEmitPasses(legacy::PassManager &CodeGenPasses,
+                     TargetMachine &CodeGenTM, BackendAction Action,
                      raw_pwrite_stream &OS, raw_pwrite_stream *DwoOS);
 
   std::unique_ptr<llvm::ToolOutputFile> openOutputFile(StringRef Path) {
@@ -162,6 +177,36 @@ class EmitAssemblyHelper {
                           std::unique_ptr<raw_pwrite_stream> &OS,
                           std::unique_ptr<llvm::ToolOutputFile> &DwoOS);
 
+  /// Split the module into one partition per output (the main output and
+  /// each of CodeGenOpts.ParallelCodeGenOutputs) and generate an object file
+  /// for each partition on a thread of its own.
+  void RunParallelCodegenPipeline(BackendAction Action, raw_pwrite_stream &OS);
+
+  /// The part of the per-module optimization pipeline that
+  /// RunOptimizationPipeline runs. With -fparallel-codegen, the module
+  /// optimization pipeline can run on each partition of the module instead of
+  /// on the whole module.
+  enum class PipelinePart { All, PreSplit, PostSplit };
+  PipelinePart Part = PipelinePart::All;
+
+  /// Whether the module optimization pipeline can run on the partitions of
+  /// -fparallel-codegen. Instrumentation that adds per-module state, such as
+  /// the sanitizers or the lowering of profile counters, has to see the whole
+  /// module, and so do LTO pipelines.
+  bool canOptimizePartitions() const {
+    return !CodeGenOpts.DisableLLVMPasses &&
+           CodeGenOpts.OptimizationLevel != 0 && !CodeGenOpts.PrepareForLTO &&
+           !CodeGenOpts.PrepareForThinLTO && !CodeGenOpts.FatLTO &&
+           CodeGenOpts.ThinLTOIndexFile.empty() &&
+           !CodeGenOpts.hasProfileClangInstr() &&
+           !CodeGenOpts.hasProfileIRInstr() &&
+           !CodeGenOpts.hasProfileCSIRInstr() &&
+           CodeGenOpts.MemoryProfileOutput.empty() &&
+           CodeGenOpts.PassPlugins.empty() && LangOpts.Sanitize.empty() &&
+           !CodeGenOpts.hasSanitizeCoverage() &&
+           !CodeGenOpts.hasSanitizeBinaryMetadata();
+  }
+
   /// Check whether we should emit a module summary for regular LTO.
   /// The module summary should be emitted by default for regular LTO
   /// except for ld64 targets.
@@ -546,6 +591,12 @@ static void setCommandLineOpts(const CodeGenOptions &CodeGenOpts) {
 }
 
 void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
+  if (std::unique_ptr<TargetMachine> NewTM = createTargetMachine(MustCreateTM))
+    TM = std::move(NewTM);
+}
+
+std::unique_ptr<TargetMachine>
+EmitAssemblyHelper::createTargetMachine(bool MustCreateTM) {
   // Create the TargetMachine for generating code.
   std::string Error;
   std::string Triple = TheModule->getTargetTriple();
@@ -553,7 +604,7 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
   if (!TheTarget) {
     if (MustCreateTM)
       Diags.Report(diag::err_fe_unable_to_create_target) << Error;
-    return;
+    return nullptr;
   }
 
   std::optional<llvm::CodeModel::Model> CM = getCodeModel(CodeGenOpts);
@@ -568,12 +619,13 @@ void EmitAssemblyHelper::CreateTargetMachine(bool MustCreateTM) {
   llvm::TargetOptions Options;
   if (!initTargetOptions(Diags, Options, CodeGenOpts, TargetOpts, LangOpts,
                          HSOpts))
-    return;
-  TM.reset(TheTarget->createTargetMachine(Triple, TargetOpts.CPU, FeaturesStr,
-                                          Options, RM, CM, OptLevel));
+    return nullptr;
+  return std::unique_ptr<TargetMachine>(TheTarget->createTargetMachine(
+      Triple, TargetOpts.CPU, FeaturesStr, Options, RM, CM, OptLevel));
 }
 
 bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
+                                       TargetMachine &CodeGenTM,
                                        BackendAction Action,
                                        raw_pwrite_stream &OS,
                                        raw_pwrite_stream *DwoOS) {
@@ -592,8 +644,9 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   if (CodeGenOpts.OptimizationLevel > 0)
     CodeGenPasses.add(createObjCARCContractPass());
 
-  if (TM->addPassesToEmitFile(CodeGenPasses, OS, DwoOS, CGFT,
-                              /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
+  if (CodeGenTM.addPassesToEmitFile(
+          CodeGenPasses, OS, DwoOS, CGFT,
+          /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
     Diags.Report(diag::err_fe_unable_to_interface_with_target);
     return false;
   }
@@ -1025,6 +1078,10 @@ void EmitAssemblyHelper::RunOptimizationPipeline(
       MPM = PB.buildThinLTOPreLinkDefaultPipeline(Level);
     } else if (IsLTO) {
       MPM = PB.buildLTOPreLinkDefaultPipeline(Level);
+    } else if (Part == PipelinePart::PreSplit) {
+      MPM = PB.buildPerModulePreSplitPipeline(Level);
+    } else if (Part == PipelinePart::PostSplit) {
+      MPM = PB.buildPerModulePostSplitPipeline(Level);
     } else {
       MPM = PB.buildPerModuleDefaultPipeline(Level);
     }
@@ -1114,6 +1171,11 @@ void EmitAssemblyHelper::RunCodegenPipeline(
   case Backend_EmitAssembly:
   case Backend_EmitMCNull:
   case Backend_EmitObj:
+    if (Action == Backend_EmitObj &&
+        !CodeGenOpts.ParallelCodeGenOutputs.empty()) {
+      RunParallelCodegenPipeline(Action, *OS);
+      return;
+    }
     CodeGenPasses.add(
         createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
     if (!CodeGenOpts.SplitDwarfOutput.empty()) {
@@ -1137,6 +1199,170 @@ void EmitAssemblyHelper::RunCodegenPipeline(
   }
 }
 
+namespace {
+/// Passes the diagnostics of a module partition's context on to the handler of
+/// the context the partition was split from. Partitions are compiled
+/// concurrently, so all of them serialize on a shared mutex.
+struct PartitionDiagnosticHandler : public llvm::DiagnosticHandler {
+  LLVMContext &MainContext;
+  std::mutex &Lock;
+
+  PartitionDiagnosticHandler(LLVMContext &MainContext, std::mutex &Lock)
+      : MainContext(MainContext), Lock(Lock) {}
+
+  bool handleDiagnostics(const DiagnosticInfo &DI) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    MainContext.diagnose(DI);
+    return true;
+  }
+  bool isAnalysisRemarkEnabled(StringRef PassName) const override {
+    return MainContext.getDiagHandlerPtr()->isAnalysisRemarkEnabled(PassName);
+  }
+  bool isMissedOptRemarkEnabled(StringRef PassName) const override {
+    return MainContext.getDiagHandlerPtr()->isMissedOptRemarkEnabled(PassName);
+  }
+  bool isPassedOptRemarkEnabled(StringRef PassName) const override {
+    return MainContext.getDiagHandlerPtr()->isPassedOptRemarkEnabled(PassName);
+  }
+  bool isAnyRemarkEnabled() const override {
+    return MainContext.getDiagHandlerPtr()->isAnyRemarkEnabled();
+  }
+};
+} // namespace
+
+/// The optimization pipeline of a partition ends with GlobalDCE, which would
+/// delete linkonce definitions that are only used by other partitions.
+static void
+keepDefinitionsUsedByOtherPartitions(ArrayRef<std::unique_ptr<Module>> Parts) {
+  StringSet<> Declared;
+  for (const std::unique_ptr<Module> &MPart : Parts)
+    for (const GlobalValue &GV : MPart->global_values())
+      if (GV.isDeclaration() && GV.hasName())
+        Declared.insert(GV.getName());
+
+  for (const std::unique_ptr<Module> &MPart : Parts) {
+    SmallVector<GlobalValue *, 0> UsedElsewhere;
+    for (GlobalValue &GV : MPart->global_values())
+      if (GV.hasLinkOnceLinkage() && !GV.isDeclaration() &&
+          Declared.contains(GV.getName()))
+        UsedElsewhere.push_back(&GV);
+    appendToCompilerUsed(*MPart, UsedElsewhere);
+  }
+}
+
+void EmitAssemblyHelper::RunParallelCodegenPipeline(BackendAction Action,
+                                                    raw_pwrite_stream &OS) {
+  // The first partition goes to the main output. The driver combines it with
+  // the others into the requested object file.
+  SmallVector<std::unique_ptr<llvm::ToolOutputFile>, 8> PartitionFiles;
+  SmallVector<raw_pwrite_stream *, 8> PartitionOSs = {&OS};
+  for (const std::string &Path : CodeGenOpts.ParallelCodeGenOutputs) {
+    PartitionFiles.push_back(openOutputFile(Path));
+    if (!PartitionFiles.back())
+      return;
+    PartitionOSs.push_back(&PartitionFiles.back()->os());
+  }
+  unsigned NumPartitions = PartitionOSs.size();
+
+  // Build the pipelines on this thread, where errors can be reported. Each
+  // partition gets a TargetMachine of its own, since code generation keeps
+  // per-module state in it.
+  SmallVector<std::unique_ptr<TargetMachine>, 8> PartitionTMs;
+  SmallVector<std::unique_ptr<legacy::PassManager>, 8> PartitionPasses;
+  for (unsigned I = 0; I != NumPartitions; ++I) {
+    std::unique_ptr<TargetMachine> PartitionTM =
+        createTargetMachine(/*MustCreateTM=*/true);
+    if (!PartitionTM)
+      return;
+    auto Passes = std::make_unique<legacy::PassManager>();
+    Passes->add(createTargetTransformInfoWrapperPass(
+        PartitionTM->getTargetIRAnalysis()));
+    if (!AddEmitPasses(*Passes, *PartitionTM, Action, *PartitionOSs[I],
+                       /*DwoOS=*/nullptr))
+      return;
+    PartitionTMs.push_back(std::move(PartitionTM));
+    PartitionPasses.push_back(std::move(Passes));
+  }
+
+  // Hand the partitions to the workers as bitcode so that each one is read
+  // into a context of its own. Locals stay in the partition that references
+  // them rather than being externalized, so the partial objects link
+  // together without exposing any new symbols.
+  SmallVector<SmallString<0>, 8> PartitionBitcode;
+  {
+    llvm::TimeTraceScope TimeScope("SplitModule");
+    SmallVector<std::unique_ptr<Module>, 8> Partitions;
+    SplitModule(
+        *TheModule, NumPartitions,
+        [&](std::unique_ptr<Module> MPart) {
+          Partitions.push_back(std::move(MPart));
+        },
+        /*PreserveLocals=*/true);
+    if (Part == PipelinePart::PreSplit)
+      keepDefinitionsUsedByOtherPartitions(Partitions);
+    for (const std::unique_ptr<Module> &MPart : Partitions) {
+      raw_svector_ostream BCOS(PartitionBitcode.emplace_back());
+      WriteBitcodeToFile(*MPart, BCOS);
+    }
+  }
+
+  PrettyStackTraceString CrashInfo("Code generation");
+  llvm::TimeTraceScope TimeScope("CodeGenPasses");
+  LLVMContext &MainContext = TheModule->getContext();
+  std::mutex DiagnosticsLock;
+  // Errors are reported once all workers are done, since Diags is not
+  // thread-safe.
+  SmallVector<std::string, 8> PartitionErrors(NumPartitions);
+  ThreadPool Pool(hardware_concurrency(NumPartitions));
+  for (unsigned I = 0; I != NumPartitions; ++I) {
+    Pool.async([&, I] {
+      LLVMContext Context;
+      Context.setDiagnosticHandler(std::make_unique<PartitionDiagnosticHandler>(
+          MainContext, DiagnosticsLock));
+      Expected<std::unique_ptr<Module>> MPartOrErr = parseBitcodeFile(
+          MemoryBufferRef(PartitionBitcode[I], "<split-module>"), Context);
+      if (!MPartOrErr) {
+        PartitionErrors[I] = "failed to read module partition: " +
+                             toString(MPartOrErr.takeError());
+        return;
+      }
+      Module &MPart = **MPartOrErr;
+
+      // Finish optimizing the partition, with its own pass builder and
+      // TargetMachine. The helper takes ownership of the latter and so has to
+      // outlive the code generation pipeline.
+      std::optional<EmitAssemblyHelper> PartitionHelper;
+      if (Part == PipelinePart::PreSplit) {
+        PartitionHelper.emplace(Diags, HSOpts, CodeGenOpts, TargetOpts,
+                                LangOpts, &MPart, VFS);
+        PartitionHelper->Part = PipelinePart::PostSplit;
+        PartitionHelper->TM = std::move(PartitionTMs[I]);
+        std::unique_ptr<raw_pwrite_stream> NoOS;
+        std::unique_ptr<llvm::ToolOutputFile> NoThinLinkOS;
+        PartitionHelper->RunOptimizationPipeline(Action, NoOS, NoThinLinkOS);
+      }
+
+      PartitionPasses[I]->run(MPart);
+      // The pipeline refers to the partition; release it with the context.
+      PartitionPasses[I].reset();
+    });
+  }
+  Pool.wait();
+
+  bool HadError = false;
+  for (const std::string &Error : PartitionErrors) {
+    if (Error.empty())
+      continue;
+    Diags.Report(diag::err_fe_error_backend) << Error;
+    HadError = true;
+  }
+  if (HadError)
+    return;
+
+  for (std::unique_ptr<llvm::ToolOutputFile> &File : PartitionFiles)
+    File->keep();
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(CodeGenOpts.TimePasses ? &CodeGenerationTime : nullptr);
@@ -1153,6 +1379,12 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   // Before executing passes, print the final values of the LLVM options.
   cl::PrintOptionValues();
 
+  // Leave the module optimization pipeline to the partitions if the module is
+  // going to be split anyway.
+  if (Action == Backend_EmitObj &&
+      !CodeGenOpts.ParallelCodeGenOutputs.empty() && canOptimizePartitions())
+    Part = PipelinePart::PreSplit;
+
   std::unique_ptr<llvm::ToolOutputFile> ThinLinkOS, DwoOS;
   RunOptimizationPipeline(Action, OS, ThinLinkOS);
   RunCodegenPipeline(Action, OS, DwoOS);
@@ -4087,6 +4087,18 @@ void Driver::BuildActions(Compilation &C, DerivedArgList &Args,
     }
   }
 
+  // Diagnose misuse of --emit-ast-file=.
+  if (Arg *A = Args.getLastArg(options::OPT_emit_ast_file_EQ)) {
+    // Every compile job would write its AST to the same file.
+    if (llvm::count_if(Inputs, [](const InputTy &I) {
+          return types::isDerivedFromC(I.first);
+        }) > 1) {
+      Diag(clang::diag::err_drv_out_file_argument_with_multiple_sources)
+          << A->getSpelling() << A->getValue();
+      Args.eraseArg(options::OPT_emit_ast_file_EQ);
+    }
+  }
+
   // Diagnose misuse of /o.
   if (Arg *A = Args.getLastArg(options::OPT__SLASH_o)) {
     if (A->getValue()[0] == '\0') {
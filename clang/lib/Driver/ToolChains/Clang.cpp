@@ -6453,9 +6453,16 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_malign_double);
   Args.AddLastArg(CmdArgs, options::OPT_fno_temp_file);
 
+  // Only the job that parses the source for the host writes the AST. Device
+  // compilations of the same source would overwrite it.
+  if (!IsDeviceOffloadAction && !isa<PreprocessJobAction>(JA) &&
+      types::isDerivedFromC(Input.getType()))
+    Args.AddLastArg(CmdArgs, options::OPT_emit_ast_file_EQ);
+
   if (const char *Name = C.getTimeTraceFile(&JA)) {
     CmdArgs.push_back(Args.MakeArgString("-ftime-trace=" + Twine(Name)));
     Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_granularity_EQ);
+    Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_steps);
   }
 
   if (Arg *A = Args.getLastArg(options::OPT_ftrapv_handler_EQ)) {
@@ -6825,6 +6832,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   if (Args.hasFlag(options::OPT_fpch_instantiate_templates,
                    options::OPT_fno_pch_instantiate_templates, false))
     CmdArgs.push_back("-fpch-instantiate-templates");
+  Args.AddLastArg(CmdArgs, options::OPT_fpch_instantiation_cache_EQ);
   if (Args.hasFlag(options::OPT_fpch_codegen, options::OPT_fno_pch_codegen,
                    false))
     CmdArgs.push_back("-fmodules-codegen");
@@ -7518,6 +7526,37 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(Args.MakeArgString(Str));
   }
 
+  // With -fparallel-codegen=N, the backend writes N partial objects, which a
+  // relocatable link combines into the requested object file.
+  SmallVector<const char *, 8> PartialObjects;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    StringRef Value = A->getValue();
+    unsigned NumPartitions;
+    if (Value.getAsInteger(10, NumPartitions) || NumPartitions == 0)
+      D.Diag(diag::err_drv_invalid_int_value) << A->getAsString(Args) << Value;
+    else if (NumPartitions > 1 && Output.isFilename() &&
+             Output.getType() == types::TY_Object &&
+             (isa<AssembleJobAction>(JA) || isa<CompileJobAction>(JA) ||
+              isa<BackendJobAction>(JA))) {
+      if (!Triple.isOSBinFormatELF() && !Triple.isOSBinFormatMachO())
+        D.Diag(diag::err_drv_unsupported_opt_for_target)
+            << A->getAsString(Args) << TripleStr;
+      else if (SplitDWARF)
+        D.Diag(diag::err_drv_argument_not_allowed_with)
+            << A->getAsString(Args) << "-gsplit-dwarf";
+      else {
+        StringRef Stem = llvm::sys::path::stem(Output.getFilename());
+        for (unsigned I = 0; I != NumPartitions; ++I)
+          PartialObjects.push_back(C.addTempFile(
+              C.getArgs().MakeArgString(D.GetTemporaryPath(Stem, "o"))));
+        for (const char *PartialObject : llvm::drop_begin(PartialObjects)) {
+          CmdArgs.push_back("-parallel-codegen-output");
+          CmdArgs.push_back(PartialObject);
+        }
+      }
+    }
+  }
+
   // Add the output path to the object file for CodeView debug infos.
   if (EmitCodeView && Output.isFilename())
     addDebugObjectName(Args, CmdArgs, DebugCompilationDir,
@@ -7536,7 +7575,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       CmdArgs.push_back(Args.MakeArgString(OutputFilename));
     } else {
       CmdArgs.push_back("-o");
-      CmdArgs.push_back(Output.getFilename());
+      CmdArgs.push_back(PartialObjects.empty() ? Output.getFilename()
+                                               : PartialObjects.front());
     }
   } else {
     assert(Output.isNothing() && "Invalid output.");
@@ -7575,6 +7615,17 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     C.getJobs().getJobs().back()->PrintInputFilenames = true;
   }
 
+  if (!PartialObjects.empty()) {
+    ArgStringList LinkArgs;
+    LinkArgs.push_back("-r");
+    LinkArgs.push_back("-o");
+    LinkArgs.push_back(Output.getFilename());
+    LinkArgs.append(PartialObjects.begin(), PartialObjects.end());
+    C.addCommand(std::make_unique<Command>(
+        JA, *this, ResponseFileSupport::None(),
+        Args.MakeArgString(TC.GetLinkerPath()), LinkArgs, Inputs, Output));
+  }
+
   if (Arg *A = Args.getLastArg(options::OPT_pg))
     if (FPKeepKind == CodeGenOptions::FramePointerKind::None &&
         !Args.hasArg(options::OPT_mfentry))
@@ -79,6 +79,8 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/DJB.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
@@ -1056,6 +1058,10 @@ public:
     return std::move(TopLevelDeclIDs);
   }
 
+  ArrayRef<serialization::DeclID> getTopLevelDeclIDs() const {
+    return TopLevelDeclIDs;
+  }
+
   void AfterPCHEmitted(ASTWriter &Writer) override {
     TopLevelDeclIDs.reserve(TopLevelDecls.size());
     for (const auto *D : TopLevelDecls) {
@@ -1092,6 +1098,33 @@ private:
 
 } // namespace
 
+/// Encodes what ASTUnit needs to reuse a preamble from a PreambleCache without
+/// having built it: the hash of its top-level entities and the IDs of its
+/// top-level declarations.
+static std::string
+writePreambleCacheData(unsigned TopLevelHash,
+                       ArrayRef<serialization::DeclID> TopLevelDeclIDs) {
+  std::string Data;
+  llvm::raw_string_ostream OS(Data);
+  llvm::support::endian::Writer W(OS, llvm::support::little);
+  W.write<uint32_t>(TopLevelHash);
+  for (serialization::DeclID ID : TopLevelDeclIDs)
+    W.write<uint32_t>(ID);
+  return Data;
+}
+
+static bool
+readPreambleCacheData(StringRef Data, unsigned &TopLevelHash,
+                      std::vector<serialization::DeclID> &TopLevelDeclIDs) {
+  if (Data.size() < sizeof(uint32_t) || Data.size() % sizeof(uint32_t))
+    return false;
+  TopLevelHash = llvm::support::endian::read32le(Data.data());
+  TopLevelDeclIDs.clear();
+  for (size_t I = sizeof(uint32_t); I != Data.size(); I += sizeof(uint32_t))
+    TopLevelDeclIDs.push_back(llvm::support::endian::read32le(Data.data() + I));
+  return true;
+}
+
 static bool isNonDriverDiag(const StoredDiagnostic &StoredDiag) {
   return StoredDiag.getLocation().isValid();
 }
@@ -1375,6 +1408,48 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   if (!AllowRebuild)
     return nullptr;
 
+  const bool PreviousSkipFunctionBodies =
+      PreambleInvocationIn.getFrontendOpts().SkipFunctionBodies;
+  if (SkipFunctionBodies == SkipFunctionBodiesScope::Preamble)
+    PreambleInvocationIn.getFrontendOpts().SkipFunctionBodies = true;
+  auto RestoreSkipFunctionBodies = llvm::make_scope_exit([&] {
+    PreambleInvocationIn.getFrontendOpts().SkipFunctionBodies =
+        PreviousSkipFunctionBodies;
+  });
+
+  // Another process may have built the same preamble already. Only preambles
+  // without diagnostics are cached, so there are none to replay.
+  std::optional<PreambleCache> Cache;
+  if (!PreambleCachePath.empty()) {
+    Cache.emplace(PreambleCachePath);
+    std::string CacheData;
+    std::optional<PrecompiledPreamble> CachedPreamble = Cache->lookup(
+        PreambleInvocationIn, *MainFileBuffer, Bounds, *VFS, &CacheData);
+    unsigned TopLevelHash;
+    std::vector<serialization::DeclID> TopLevelDeclIDs;
+    if (CachedPreamble &&
+        readPreambleCacheData(CacheData, TopLevelHash, TopLevelDeclIDs)) {
+      Preamble = std::move(*CachedPreamble);
+      PreambleRebuildCountdown = 1;
+
+      getDiagnostics().Reset();
+      ProcessWarningOptions(getDiagnostics(),
+                            PreambleInvocationIn.getDiagnosticOpts());
+      NumWarningsInPreamble = 0;
+      StoredDiagnostics.clear();
+      PreambleDiagnostics.clear();
+
+      TopLevelDecls.clear();
+      TopLevelDeclsInPreamble = std::move(TopLevelDeclIDs);
+      PreambleTopLevelHashValue = TopLevelHash;
+      if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+        CompletionCacheTopLevelHashValue = 0;
+        PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+      }
+      return MainFileBuffer;
+    }
+  }
+
   ++PreambleCounter;
 
   SmallVector<StandaloneDiagnostic, 4> NewPreambleDiagsStandalone;
@@ -1390,22 +1465,22 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     SimpleTimer PreambleTimer(WantTiming);
     PreambleTimer.setOutput("Precompiling preamble");
 
-    const bool PreviousSkipFunctionBodies =
-        PreambleInvocationIn.getFrontendOpts().SkipFunctionBodies;
-    if (SkipFunctionBodies == SkipFunctionBodiesScope::Preamble)
-      PreambleInvocationIn.getFrontendOpts().SkipFunctionBodies = true;
-
     llvm::ErrorOr<PrecompiledPreamble> NewPreamble = PrecompiledPreamble::Build(
         PreambleInvocationIn, MainFileBuffer.get(), Bounds, *Diagnostics, VFS,
         PCHContainerOps, StorePreamblesInMemory, PreambleStoragePath,
         Callbacks);
 
-    PreambleInvocationIn.getFrontendOpts().SkipFunctionBodies =
-        PreviousSkipFunctionBodies;
-
     if (NewPreamble) {
       Preamble = std::move(*NewPreamble);
       PreambleRebuildCountdown = 1;
+      // Failing to share the preamble is not an error for this unit.
+      if (Cache && NewPreambleDiags.empty() &&
+          !getDiagnostics().hasErrorOccurred() &&
+          getDiagnostics().getNumWarnings() == 0)
+        llvm::consumeError(Cache->store(
+            *Preamble, PreambleInvocationIn, *VFS,
+            writePreambleCacheData(Callbacks.getHash(),
+                                   Callbacks.getTopLevelDeclIDs())));
     } else {
       switch (static_cast<BuildPreambleError>(NewPreamble.getError().value())) {
       case BuildPreambleError::CouldntCreateTempFile:
@@ -1751,7 +1826,8 @@ std::unique_ptr<ASTUnit> ASTUnit::LoadFromCommandLine(
     bool SingleFileParse, bool UserFilesAreVolatile, bool ForSerialization,
     bool RetainExcludedConditionalBlocks, std::optional<StringRef> ModuleFormat,
     std::unique_ptr<ASTUnit> *ErrAST,
-    IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS) {
+    IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS,
+    StringRef PreambleCachePath) {
   assert(Diags.get() && "no DiagnosticsEngine was provided");
 
   // If no VFS was provided, create one that tracks the physical file system.
@@ -1809,6 +1885,7 @@ std::unique_ptr<ASTUnit> ASTUnit::LoadFromCommandLine(
   AST->FileMgr = new FileManager(AST->FileSystemOpts, VFS);
   AST->StorePreamblesInMemory = StorePreamblesInMemory;
   AST->PreambleStoragePath = PreambleStoragePath;
+  AST->PreambleCachePath = PreambleCachePath;
   AST->ModuleCache = new InMemoryModuleCache;
   AST->OnlyLocalDecls = OnlyLocalDecls;
   AST->CaptureDiagnostics = CaptureDiagnostics;
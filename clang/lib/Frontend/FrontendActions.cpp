@@ -148,6 +148,44 @@ GeneratePCHAction::CreateASTConsumer(CompilerInstance &CI, StringRef InFile) {
   return std::make_unique<MultiplexConsumer>(std::move(Consumers));
 }
 
+std::unique_ptr<ASTConsumer>
+WrappingEmitASTAction::CreateASTConsumer(CompilerInstance &CI,
+                                         StringRef InFile) {
+  std::unique_ptr<ASTConsumer> WrappedConsumer =
+      WrapperFrontendAction::CreateASTConsumer(CI, InFile);
+  if (!WrappedConsumer)
+    return nullptr;
+
+  std::string Sysroot;
+  if (!GeneratePCHAction::ComputeASTConsumerArguments(CI, /*ref*/ Sysroot))
+    return nullptr;
+  if (!CI.getFrontendOpts().RelocatablePCH)
+    Sysroot.clear();
+
+  const auto &FrontendOpts = CI.getFrontendOpts();
+  const std::string &OutputFile = FrontendOpts.ASTOutputFile;
+  std::unique_ptr<raw_pwrite_stream> OS =
+      CI.createOutputFile(OutputFile, /*Binary=*/true,
+                          /*RemoveFileOnSignal=*/true, /*UseTemporary=*/true);
+  if (!OS)
+    return nullptr;
+
+  // The AST has to be written before the wrapped consumer sees the end of the
+  // translation unit, as code generation may clear it.
+  auto Buffer = std::make_shared<PCHBuffer>();
+  std::vector<std::unique_ptr<ASTConsumer>> Consumers;
+  Consumers.push_back(std::make_unique<PCHGenerator>(
+      CI.getPreprocessor(), CI.getModuleCache(), OutputFile, Sysroot, Buffer,
+      FrontendOpts.ModuleFileExtensions,
+      CI.getPreprocessorOpts().AllowPCHWithCompilerErrors,
+      FrontendOpts.IncludeTimestamps));
+  Consumers.push_back(CI.getPCHContainerWriter().CreatePCHContainerGenerator(
+      CI, std::string(InFile), OutputFile, std::move(OS), Buffer));
+  Consumers.push_back(std::move(WrappedConsumer));
+
+  return std::make_unique<MultiplexConsumer>(std::move(Consumers));
+}
+
 bool GeneratePCHAction::ComputeASTConsumerArguments(CompilerInstance &CI,
                                                     std::string &Sysroot) {
   Sysroot = CI.getHeaderSearchOpts().Sysroot;
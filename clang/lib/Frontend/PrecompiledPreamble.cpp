@@ -13,6 +13,7 @@
 #include "clang/Frontend/PrecompiledPreamble.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/LangStandard.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendActions.h"
@@ -23,14 +24,17 @@
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Serialization/ASTWriter.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
 #include <limits>
 #include <mutex>
 #include <utility>
@@ -821,6 +825,402 @@ void PrecompiledPreamble::setupPreambleStorage(
   }
 }
 
+/// Returns the hash of the contents \p Path has in a compilation with
+/// \p PPOpts, taking remapped files into account.
+static std::optional<llvm::MD5::MD5Result>
+hashFileContents(StringRef Path, const PreprocessorOptions &PPOpts,
+                 llvm::vfs::FileSystem &VFS) {
+  for (const auto &RB : PPOpts.RemappedFileBuffers)
+    if (RB.first == Path)
+      return llvm::MD5::hash(
+          llvm::arrayRefFromStringRef(RB.second->getBuffer()));
+
+  StringRef ContentsPath = Path;
+  for (const auto &R : PPOpts.RemappedFiles)
+    if (R.first == Path)
+      ContentsPath = R.second;
+  auto Buffer = VFS.getBufferForFile(ContentsPath);
+  if (!Buffer)
+    return std::nullopt;
+  return llvm::MD5::hash(llvm::arrayRefFromStringRef((*Buffer)->getBuffer()));
+}
+
+namespace {
+/// The dependencies of a preamble in a PreambleCache, along with the client's
+/// data. Stored next to the PCH as
+///
+///   "CPCE" <files> <missing files> <client data>
+///
+/// where files are (path, MD5 of the contents) pairs, and each list and
+/// string is prefixed with its little-endian 32-bit size.
+struct PreambleCacheEntry {
+  std::vector<std::pair<std::string, llvm::MD5::MD5Result>> Files;
+  std::vector<std::string> MissingFiles;
+  std::string ClientData;
+
+  static constexpr StringRef Magic = "CPCE";
+
+  void write(raw_ostream &OS) const {
+    llvm::support::endian::Writer W(OS, llvm::support::little);
+    auto WriteString = [&](StringRef Str) {
+      W.write<uint32_t>(Str.size());
+      OS << Str;
+    };
+    OS << Magic;
+    W.write<uint32_t>(Files.size());
+    for (const auto &[Path, Hash] : Files) {
+      WriteString(Path);
+      OS << llvm::toStringRef(Hash);
+    }
+    W.write<uint32_t>(MissingFiles.size());
+    for (const std::string &Path : MissingFiles)
+      WriteString(Path);
+    WriteString(ClientData);
+  }
+
+  static std::optional<PreambleCacheEntry> read(StringRef Data) {
+    if (!Data.consume_front(Magic))
+      return std::nullopt;
+    auto ReadInt = [&](uint32_t &Value) {
+      if (Data.size() < sizeof(uint32_t))
+        return false;
+      Value = llvm::support::endian::read32le(Data.data());
+      Data = Data.drop_front(sizeof(uint32_t));
+      return true;
+    };
+    auto ReadBytes = [&](size_t Size, StringRef &Bytes) {
+      if (Data.size() < Size)
+        return false;
+      Bytes = Data.take_front(Size);
+      Data = Data.drop_front(Size);
+      return true;
+    };
+    auto ReadString = [&](std::string &Str) {
+      uint32_t Size;
+      StringRef Bytes;
+      if (!ReadInt(Size) || !ReadBytes(Size, Bytes))
+        return false;
+      Str = Bytes.str();
+      return true;
+    };
+
+    PreambleCacheEntry Entry;
+    uint32_t NumFiles, NumMissingFiles;
+    if (!ReadInt(NumFiles))
+      return std::nullopt;
+    for (uint32_t I = 0; I != NumFiles; ++I) {
+      auto &[Path, Hash] = Entry.Files.emplace_back();
+      StringRef HashBytes;
+      if (!ReadString(Path) || !ReadBytes(sizeof(Hash), HashBytes))
+        return std::nullopt;
+      std::copy(HashBytes.begin(), HashBytes.end(), Hash.begin());
+    }
+    if (!ReadInt(NumMissingFiles))
+      return std::nullopt;
+    for (uint32_t I = 0; I != NumMissingFiles; ++I)
+      if (!ReadString(Entry.MissingFiles.emplace_back()))
+        return std::nullopt;
+    if (!ReadString(Entry.ClientData) || !Data.empty())
+      return std::nullopt;
+    return Entry;
+  }
+
+  /// The name of the entry among those with the same key.
+  std::string getName() const {
+    llvm::MD5 Hash;
+    for (const auto &[Path, FileHash] : Files) {
+      Hash.update(Path);
+      Hash.update(FileHash);
+    }
+    Hash.update(StringRef("\0", 1));
+    for (const std::string &Path : MissingFiles) {
+      Hash.update(Path);
+      Hash.update(StringRef("\0", 1));
+    }
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    return std::string(Result.digest());
+  }
+};
+} // namespace
+
+std::string PreambleCache::getKey(const CompilerInvocation &Invocation,
+                                  StringRef PreambleBytes,
+                                  bool PreambleEndsAtStartOfLine,
+                                  llvm::vfs::FileSystem &VFS) const {
+  // Leave the main file's name out of the key, so that files that start with
+  // the same preamble share it. The ASTReader reads a preamble as the start of
+  // whichever main file it is used with. Only the main file's directory
+  // matters, because quoted #includes are looked up there.
+  CompilerInvocation Normalized(Invocation);
+  FrontendOptions &FrontendOpts = Normalized.getFrontendOpts();
+  for (FrontendInputFile &Input : FrontendOpts.Inputs) {
+    if (!Input.isFile())
+      continue;
+    SmallString<128> MainFileDir = llvm::sys::path::parent_path(Input.getFile());
+    llvm::sys::path::append(MainFileDir, "<main file>");
+    Input = FrontendInputFile(MainFileDir, Input.getKind(), Input.isSystem());
+  }
+  FrontendOpts.OutputFile.clear();
+  Normalized.getCodeGenOpts().MainFileName.clear();
+  Normalized.getCodeGenOpts().CoverageDataFile.clear();
+  Normalized.getCodeGenOpts().CoverageNotesFile.clear();
+  Normalized.getDependencyOutputOpts() = DependencyOutputOptions();
+
+  llvm::MD5 Hash;
+  auto AddString = [&](StringRef Str) {
+    Hash.update(Str);
+    Hash.update(StringRef("\0", 1));
+  };
+  AddString(getClangFullRepositoryVersion());
+  for (const std::string &Arg : Normalized.getCC1CommandLine())
+    AddString(Arg);
+  // Options that only exist in the API and change the PCH.
+  AddString(Invocation.getPreprocessorOpts().WriteCommentListToPCH ? "1" : "0");
+  AddString(ClientKey);
+  if (llvm::ErrorOr<std::string> CWD = VFS.getCurrentWorkingDirectory())
+    AddString(*CWD);
+  AddString(PreambleBytes);
+  Hash.update(PreambleEndsAtStartOfLine ? "1" : "0");
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  return std::string(Result.digest().str());
+}
+
+/// The number of entries that the index of a key lists. Older entries are no
+/// longer looked up, and eventually get pruned.
+static constexpr size_t MaxEntriesPerKey = 8;
+
+/// Returns the path of a file in the cache. All of them have the "llvmcache-"
+/// prefix, so that they are subject to pruning.
+static SmallString<128> getCacheFilePath(StringRef Directory, StringRef Key,
+                                         const Twine &Suffix) {
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, "llvmcache-preamble-" + Key + Suffix);
+  return Path;
+}
+
+/// Opens \p Path so that its access time is updated, which keeps
+/// llvm::pruneCache from evicting it for a while.
+static void touchCacheFile(const Twine &Path) {
+  llvm::Expected<llvm::sys::fs::file_t> FD =
+      llvm::sys::fs::openNativeFileForRead(Path, llvm::sys::fs::OF_UpdateAtime);
+  if (!FD) {
+    llvm::consumeError(FD.takeError());
+    return;
+  }
+  llvm::sys::fs::closeFile(*FD);
+}
+
+/// Gives this process its own name for the PCH at \p PCHPath, so that another
+/// process pruning the cache cannot delete the file while it is in use. The
+/// name is a hard link in \p Directory if possible, and a copy otherwise.
+static std::unique_ptr<TempPCHFile> pinCachedPCH(const Twine &PCHPath,
+                                                 StringRef Directory) {
+  std::unique_ptr<TempPCHFile> File = TempPCHFile::create(Directory);
+  if (!File)
+    return nullptr;
+  // create() made an empty file, which create_hard_link() won't replace.
+  llvm::sys::fs::remove(File->getFilePath());
+  if (llvm::sys::fs::create_hard_link(PCHPath, File->getFilePath()) &&
+      llvm::sys::fs::copy_file(PCHPath, File->getFilePath()))
+    return nullptr;
+  return File;
+}
+
+std::optional<PrecompiledPreamble>
+PreambleCache::lookup(const CompilerInvocation &Invocation,
+                      const llvm::MemoryBufferRef &MainFileBuffer,
+                      PreambleBounds Bounds, llvm::vfs::FileSystem &VFS,
+                      std::string *ClientData) const {
+  assert(
+      Bounds.Size <= MainFileBuffer.getBufferSize() &&
+      "Buffer is too large. Bounds were calculated from a different buffer?");
+  StringRef PreambleBytes = MainFileBuffer.getBuffer().take_front(Bounds.Size);
+  std::string Key =
+      getKey(Invocation, PreambleBytes, Bounds.PreambleEndsAtStartOfLine, VFS);
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+
+  SmallString<128> IndexPath = getCacheFilePath(Directory, Key, ".index");
+  auto IndexBuffer = llvm::MemoryBuffer::getFile(IndexPath);
+  if (!IndexBuffer)
+    return std::nullopt;
+  SmallVector<StringRef, MaxEntriesPerKey> EntryNames;
+  (*IndexBuffer)
+      ->getBuffer()
+      .split(EntryNames, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+
+  // Missing files may be provided by a remapping.
+  llvm::StringSet<> RemappedAbsPaths;
+  auto AddRemappedPath = [&](StringRef Path) {
+    llvm::SmallString<128> AbsPath(Path);
+    if (!VFS.makeAbsolute(AbsPath))
+      RemappedAbsPaths.insert(AbsPath);
+  };
+  for (const auto &R : PPOpts.RemappedFiles)
+    AddRemappedPath(R.first);
+  for (const auto &RB : PPOpts.RemappedFileBuffers)
+    AddRemappedPath(RB.first);
+
+  for (StringRef EntryName : EntryNames) {
+    SmallString<128> EntryPath =
+        getCacheFilePath(Directory, Key, "-" + EntryName + ".deps");
+    auto EntryBuffer = llvm::MemoryBuffer::getFile(EntryPath);
+    if (!EntryBuffer)
+      continue;
+    std::optional<PreambleCacheEntry> Entry =
+        PreambleCacheEntry::read((*EntryBuffer)->getBuffer());
+    if (!Entry)
+      continue;
+
+    // The entry is only valid if all dependencies still have the contents it
+    // was built from. Record them the way Build() would, so that CanReuse()
+    // works on the result.
+    llvm::StringMap<PrecompiledPreamble::PreambleFileHash> FilesInPreamble;
+    bool Valid = true;
+    for (const auto &[Path, Hash] : Entry->Files) {
+      std::optional<llvm::MD5::MD5Result> CurrentHash =
+          hashFileContents(Path, PPOpts, VFS);
+      if (!CurrentHash || *CurrentHash != Hash) {
+        Valid = false;
+        break;
+      }
+      auto RB = llvm::find_if(PPOpts.RemappedFileBuffers,
+                              [&](const auto &RB) { return RB.first == Path; });
+      llvm::vfs::Status Status;
+      if (RB != PPOpts.RemappedFileBuffers.end())
+        FilesInPreamble[Path] =
+            PrecompiledPreamble::PreambleFileHash::createForMemoryBuffer(
+                RB->second->getMemBufferRef());
+      else if (moveOnNoError(VFS.status(Path), Status))
+        FilesInPreamble[Path] =
+            PrecompiledPreamble::PreambleFileHash::createForFile(
+                Status.getSize(),
+                llvm::sys::toTimeT(Status.getLastModificationTime()));
+      else
+        Valid = false;
+    }
+    llvm::StringSet<> MissingFiles;
+    for (const std::string &Path : Entry->MissingFiles) {
+      if (!Valid)
+        break;
+      auto Status = VFS.status(Path);
+      if (RemappedAbsPaths.count(Path) || (Status && Status->isRegularFile()))
+        Valid = false;
+      MissingFiles.insert(Path);
+    }
+    if (!Valid)
+      continue;
+
+    SmallString<128> PCHPath(EntryPath);
+    llvm::sys::path::replace_extension(PCHPath, "pch");
+    std::unique_ptr<TempPCHFile> PCHFile = pinCachedPCH(PCHPath, Directory);
+    if (!PCHFile)
+      continue;
+    touchCacheFile(IndexPath);
+    touchCacheFile(EntryPath);
+    touchCacheFile(PCHPath);
+
+    if (ClientData)
+      *ClientData = std::move(Entry->ClientData);
+    return PrecompiledPreamble(
+        PrecompiledPreamble::PCHStorage::file(std::move(PCHFile)),
+        std::vector<char>(PreambleBytes.begin(), PreambleBytes.end()),
+        Bounds.PreambleEndsAtStartOfLine, std::move(FilesInPreamble),
+        std::move(MissingFiles));
+  }
+  return std::nullopt;
+}
+
+llvm::Error PreambleCache::store(const PrecompiledPreamble &Preamble,
+                                 const CompilerInvocation &Invocation,
+                                 llvm::vfs::FileSystem &VFS,
+                                 StringRef ClientData) const {
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  PreambleCacheEntry Entry;
+  Entry.ClientData = std::string(ClientData);
+  for (const auto &F : Preamble.FilesInPreamble) {
+    std::optional<llvm::MD5::MD5Result> Hash =
+        hashFileContents(F.first(), PPOpts, VFS);
+    // Make sure the contents we hashed are the ones the preamble was built
+    // from, as far as Build() could tell.
+    llvm::vfs::Status Status;
+    if (!Hash || (F.second.ModTime &&
+                  (!moveOnNoError(VFS.status(F.first()), Status) ||
+                   Status.getSize() != uint64_t(F.second.Size) ||
+                   llvm::sys::toTimeT(Status.getLastModificationTime()) !=
+                       F.second.ModTime)))
+      return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                     "'" + F.first() +
+                                         "' changed since the preamble was "
+                                         "built");
+    Entry.Files.emplace_back(F.first().str(), *Hash);
+  }
+  for (const auto &F : Preamble.MissingFiles)
+    Entry.MissingFiles.push_back(F.getKey().str());
+  llvm::sort(Entry.Files);
+  llvm::sort(Entry.MissingFiles);
+
+  std::string Key = getKey(Invocation, Preamble.getContents(),
+                           Preamble.PreambleEndsAtStartOfLine, VFS);
+  std::string EntryName = Entry.getName();
+  if (std::error_code EC = llvm::sys::fs::create_directories(Directory))
+    return llvm::errorCodeToError(EC);
+
+  StringRef PCHContents;
+  std::unique_ptr<llvm::MemoryBuffer> PCHFile;
+  const PrecompiledPreamble::PCHStorage &Storage = *Preamble.Storage;
+  if (Storage.getKind() == PrecompiledPreamble::PCHStorage::Kind::InMemory) {
+    PCHContents = Storage.memoryContents();
+  } else {
+    auto BufferOrErr = llvm::MemoryBuffer::getFile(Storage.filePath());
+    if (!BufferOrErr)
+      return llvm::errorCodeToError(BufferOrErr.getError());
+    PCHFile = std::move(*BufferOrErr);
+    PCHContents = PCHFile->getBuffer();
+  }
+
+  // Both files are written to a temporary and renamed into place. The PCH
+  // goes first, so that whoever sees the entry also finds its PCH.
+  SmallString<128> EntryPath =
+      getCacheFilePath(Directory, Key, "-" + EntryName + ".pch");
+  if (llvm::Error Err = llvm::writeToOutput(EntryPath, [&](raw_ostream &OS) {
+        OS << PCHContents;
+        return llvm::Error::success();
+      }))
+    return Err;
+  llvm::sys::path::replace_extension(EntryPath, "deps");
+  if (llvm::Error Err = llvm::writeToOutput(EntryPath, [&](raw_ostream &OS) {
+        Entry.write(OS);
+        return llvm::Error::success();
+      }))
+    return Err;
+
+  // List the new entry first in the index of its key. Two processes storing
+  // under the same key at once may drop each other's entry from the index;
+  // such an entry is just not found, and expires.
+  SmallString<128> IndexPath = getCacheFilePath(Directory, Key, ".index");
+  SmallVector<std::string, MaxEntriesPerKey> EntryNames{EntryName};
+  if (auto IndexBuffer = llvm::MemoryBuffer::getFile(IndexPath)) {
+    SmallVector<StringRef, MaxEntriesPerKey> OldEntryNames;
+    (*IndexBuffer)
+        ->getBuffer()
+        .split(OldEntryNames, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    for (StringRef Name : OldEntryNames)
+      if (Name != EntryName && EntryNames.size() < MaxEntriesPerKey)
+        EntryNames.push_back(Name.str());
+  }
+  if (llvm::Error Err = llvm::writeToOutput(IndexPath, [&](raw_ostream &OS) {
+        for (const std::string &Name : EntryNames)
+          OS << Name << '\n';
+        return llvm::Error::success();
+      }))
+    return Err;
+
+  llvm::pruneCache(Directory, Policy);
+  return llvm::Error::success();
+}
+
 void PreambleCallbacks::BeforeExecute(CompilerInstance &CI) {}
 void PreambleCallbacks::AfterExecute(CompilerInstance &CI) {}
 void PreambleCallbacks::AfterPCHEmitted(ASTWriter &Writer) {}
@@ -186,6 +186,11 @@ CreateFrontendAction(CompilerInstance &CI) {
     Act = std::make_unique<WrappingExtractAPIAction>(std::move(Act));
   }
 
+  // Serialize the AST as a byproduct of compilation, so that tools can load it
+  // instead of parsing the file again.
+  if (!FEOpts.ASTOutputFile.empty())
+    Act = std::make_unique<WrappingEmitASTAction>(std::move(Act));
+
   // If there are any AST files to merge, create a frontend action
   // adaptor to perform the merge.
   if (!FEOpts.ASTMergeFiles.empty())
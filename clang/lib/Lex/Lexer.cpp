@@ -47,8 +47,122 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
+//===----------------------------------------------------------------------===//
+// Character Scanning
+//===----------------------------------------------------------------------===//
+
+// The helpers below skip runs of characters that need no further attention
+// and return a pointer to the first character that does. They rely on the
+// buffer being null-terminated: '\0' is never skipped, so the scalar loops
+// stop at the end of the buffer, and the vector loops only look at 16 bytes
+// at a time while they are all before End.
+
+#ifdef __SSE2__
+/// Scan the input 16 bytes at a time until \p Stop, which returns 0xFF for
+/// each byte that should not be skipped, matches a byte.
+template <typename StopFn>
+static inline const char *scanVector(const char *Ptr, const char *End,
+                                     StopFn Stop) {
+  while (End - Ptr >= 16) {
+    __m128i V = _mm_loadu_si128((const __m128i *)Ptr);
+    if (unsigned Mask = _mm_movemask_epi8(Stop(V)))
+      return Ptr + llvm::countr_zero(Mask);
+    Ptr += 16;
+  }
+  return Ptr;
+}
+
+/// Returns 0xFF for each byte of \p V in the range [Lo, Hi].
+static inline __m128i inCharRange(__m128i V, char Lo, char Hi) {
+  // V - Lo <= Hi - Lo as unsigned bytes, i.e. the saturating difference is 0.
+  __m128i Offset = _mm_sub_epi8(V, _mm_set1_epi8(Lo));
+  return _mm_cmpeq_epi8(_mm_subs_epu8(Offset, _mm_set1_epi8(Hi - Lo)),
+                        _mm_setzero_si128());
+}
+
+static inline __m128i isChar(__m128i V, char C) {
+  return _mm_cmpeq_epi8(V, _mm_set1_epi8(C));
+}
+#endif
+
+/// Skip [_A-Za-z0-9]*.
+static inline const char *skipAsciiIdentifierContinue(const char *Ptr,
+                                                      const char *End) {
+#ifdef __SSE2__
+  Ptr = scanVector(Ptr, End, [](__m128i V) {
+    __m128i Lower = _mm_or_si128(V, _mm_set1_epi8(0x20));
+    __m128i Ident =
+        _mm_or_si128(_mm_or_si128(inCharRange(V, '0', '9'),
+                                  inCharRange(Lower, 'a', 'z')),
+                     isChar(V, '_'));
+    return _mm_xor_si128(Ident, _mm_set1_epi8(-1));
+  });
+#endif
+  while (isAsciiIdentifierContinue(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
+/// Skip ASCII characters up to the newline or end of buffer that ends a line
+/// comment.
+static inline const char *skipLineCommentBody(const char *Ptr,
+                                              const char *End) {
+#ifdef __SSE2__
+  Ptr = scanVector(Ptr, End, [](__m128i V) {
+    // Non-ASCII bytes have their top bit set already.
+    return _mm_or_si128(_mm_or_si128(V, isChar(V, 0)),
+                        _mm_or_si128(isChar(V, '\n'), isChar(V, '\r')));
+  });
+#endif
+  while (isASCII(*Ptr) && *Ptr != 0 && *Ptr != '\n' && *Ptr != '\r')
+    ++Ptr;
+  return Ptr;
+}
+
+/// Skip the characters of a string or character literal body that are lexed
+/// as themselves: anything but the closing \p Quote, the start of an escape,
+/// trigraph or escaped newline, a newline or the end of the buffer.
+static inline const char *skipLiteralBody(const char *Ptr, const char *End,
+                                          char Quote) {
+#ifdef __SSE2__
+  Ptr = scanVector(Ptr, End, [Quote](__m128i V) {
+    return _mm_or_si128(
+        _mm_or_si128(_mm_or_si128(isChar(V, Quote), isChar(V, '\\')),
+                     _mm_or_si128(isChar(V, '?'), isChar(V, 0))),
+        _mm_or_si128(isChar(V, '\n'), isChar(V, '\r')));
+  });
+#endif
+  while (*Ptr != Quote && *Ptr != '\\' && *Ptr != '?' && *Ptr != 0 &&
+         *Ptr != '\n' && *Ptr != '\r')
+    ++Ptr;
+  return Ptr;
+}
+
+/// Skip horizontal whitespace.
+static inline const char *skipHorizontalWhitespace(const char *Ptr,
+                                                   const char *End) {
+#ifdef __SSE2__
+  Ptr = scanVector(Ptr, End, [](__m128i V) {
+    __m128i Space =
+        _mm_or_si128(_mm_or_si128(isChar(V, ' '), isChar(V, '\t')),
+                     _mm_or_si128(isChar(V, '\f'), isChar(V, '\v')));
+    return _mm_xor_si128(Space, _mm_set1_epi8(-1));
+  });
+#endif
+  while (isHorizontalWhitespace(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
 //===----------------------------------------------------------------------===//
 // Token Class Implementation
 //===----------------------------------------------------------------------===//
@@ -1823,16 +1937,12 @@ bool Lexer::LexUnicodeIdentifierStart(Token &Result, uint32_t C,
 bool Lexer::LexIdentifierContinue(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched an identifier start.
   while (true) {
-    unsigned char C = *CurPtr;
     // Fast path.
-    if (isAsciiIdentifierContinue(C)) {
-      ++CurPtr;
-      continue;
-    }
+    CurPtr = skipAsciiIdentifierContinue(CurPtr, BufferEnd);
 
     unsigned Size;
     // Slow path: handle trigraph, unicode codepoints, UCNs.
-    C = getCharAndSize(CurPtr, Size);
+    unsigned char C = getCharAndSize(CurPtr, Size);
     if (isAsciiIdentifierContinue(C)) {
       CurPtr = ConsumeChar(CurPtr, Size, Result);
       continue;
@@ -2086,6 +2196,7 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
     Diag(BufferPtr, LangOpts.CPlusPlus ? diag::warn_cxx98_compat_unicode_literal
                                        : diag::warn_c99_compat_unicode_literal);
 
+  CurPtr = skipLiteralBody(CurPtr, BufferEnd, '"');
   char C = getAndAdvanceChar(CurPtr, Result);
   while (C != '"') {
     // Skip escaped characters.  Escaped newlines will already be processed by
@@ -2114,6 +2225,7 @@ bool Lexer::LexStringLiteral(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipLiteralBody(CurPtr, BufferEnd, '"');
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -2336,6 +2448,7 @@ bool Lexer::LexCharConstant(Token &Result, const char *CurPtr,
 
       NulCharacter = CurPtr-1;
     }
+    CurPtr = skipLiteralBody(CurPtr, BufferEnd, '\'');
     C = getAndAdvanceChar(CurPtr, Result);
   }
 
@@ -2377,8 +2490,8 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Skip consecutive spaces efficiently.
   while (true) {
     // Skip horizontal whitespace very aggressively.
-    while (isHorizontalWhitespace(Char))
-      Char = *++CurPtr;
+    CurPtr = skipHorizontalWhitespace(CurPtr, BufferEnd);
+    Char = *CurPtr;
 
     // Otherwise if we have something other than whitespace, we're done.
     if (!isVerticalWhitespace(Char))
@@ -2462,13 +2575,13 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
 
   char C;
   while (true) {
-    C = *CurPtr;
-    // Skip over characters in the fast loop.
-    while (isASCII(C) && C != 0 &&   // Potentially EOF.
-           C != '\n' && C != '\r') { // Newline or DOS-style newline.
-      C = *++CurPtr;
+    // Skip over characters in the fast loop. This stops at non-ASCII
+    // characters, potential EOF, newlines and DOS-style newlines.
+    const char *SkippedTo = skipLineCommentBody(CurPtr, BufferEnd);
+    if (SkippedTo != CurPtr)
       UnicodeDecodingAlreadyDiagnosed = false;
-    }
+    CurPtr = SkippedTo;
+    C = *CurPtr;
 
     if (!isASCII(C)) {
       unsigned Length = llvm::getUTF8SequenceSize(
@@ -2700,13 +2813,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr, Lexer *L,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
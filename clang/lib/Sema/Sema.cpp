@@ -1165,12 +1165,18 @@ void Sema::ActOnEndOfTranslationUnit() {
       UnusedFileScopedDecls.end());
 
   if (TUKind == TU_Prefix) {
+    checkInstantiationCacheBase();
+
     // Translation unit prefixes don't need any of the checking below.
     if (!PP.isIncrementalProcessingEnabled())
       TUScope = nullptr;
     return;
   }
 
+  if (!getLangOpts().PCHInstantiationCache.empty() &&
+      !Diags.hasErrorOccurred())
+    writeInstantiationCache();
+
   // Check for #pragma weak identifiers that were never declared
   LoadExternalWeakUndeclaredIdentifiers();
   for (const auto &WeakIDs : WeakUndeclaredIdentifiers) {
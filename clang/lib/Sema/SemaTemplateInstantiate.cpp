@@ -643,6 +643,9 @@ void Sema::pushCodeSynthesisContext(CodeSynthesisContext Ctx) {
   if (!Ctx.isInstantiationRecord())
     ++NonInstantiationEntries;
 
+  // Attribute the work to the innermost -ftime-trace section.
+  llvm::timeTraceAddCount("instantiation steps", 1);
+
   // Check to see if we're low on stack space. We can't do anything about this
   // from here, but we can at least warn the user.
   if (isStackNearlyExhausted())
@@ -3166,11 +3169,17 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
     return true;
 
   llvm::TimeTraceScope TimeScope("InstantiateClass", [&]() {
-    std::string Name;
-    llvm::raw_string_ostream OS(Name);
+    llvm::TimeTraceMetadata M;
+    llvm::raw_string_ostream OS(M.Detail);
     Instantiation->getNameForDiagnostic(OS, getPrintingPolicy(),
                                         /*Qualified=*/true);
-    return Name;
+    OS.flush();
+    PresumedLoc PLoc = SourceMgr.getPresumedLoc(PatternDef->getLocation());
+    if (PLoc.isValid()) {
+      M.File = PLoc.getFilename();
+      M.Line = PLoc.getLine();
+    }
+    return M;
   });
 
   Pattern = PatternDef;
@@ -4919,11 +4919,17 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
   }
 
   llvm::TimeTraceScope TimeScope("InstantiateFunction", [&]() {
-    std::string Name;
-    llvm::raw_string_ostream OS(Name);
+    llvm::TimeTraceMetadata M;
+    llvm::raw_string_ostream OS(M.Detail);
     Function->getNameForDiagnostic(OS, getPrintingPolicy(),
                                    /*Qualified=*/true);
-    return Name;
+    OS.flush();
+    PresumedLoc PLoc = SourceMgr.getPresumedLoc(PatternDecl->getLocation());
+    if (PLoc.isValid()) {
+      M.File = PLoc.getFilename();
+      M.Line = PLoc.getLine();
+    }
+    return M;
   });
 
   // If we're performing recursive template instantiation, create our own
@@ -5134,6 +5140,10 @@ void Sema::InstantiateFunctionDefinition(SourceLocation PointOfInstantiation,
     savedContext.pop();
   }
 
+  if (!getLangOpts().PCHInstantiationCache.empty() &&
+      TSK == TSK_ImplicitInstantiation && !Function->isInvalidDecl())
+    recordInstantiationForCache(Function, PatternDecl);
+
   DeclGroupRef DG(Function);
   Consumer.HandleTopLevelDecl(DG);
 
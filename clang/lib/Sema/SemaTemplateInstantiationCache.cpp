@@ -0,0 +1,310 @@
+//===--- SemaTemplateInstantiationCache.cpp - PCH instantiation cache -----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements -fpch-instantiation-cache, which records the implicit
+//  function template instantiations of a translation unit that only depend on
+//  declarations from the PCH. They are written as explicit instantiation
+//  definitions to a file shared by all users of the PCH.
+//
+//  The first line of the file is a comment holding a hash of the PCH the
+//  instantiations were recorded against. The rest are the instantiations,
+//  sorted and without duplicates, so the file only depends on which ones were
+//  recorded and not on the order the users of the PCH were compiled in. When
+//  the PCH changes, for example because one of its headers did, the recorded
+//  instantiations are dropped and recording starts over.
+//
+//  The file is used by building it as a PCH chained on top of the original
+//  one, once the users of the PCH were compiled:
+//
+//    clang -cc1 -emit-pch -o base.pch base.h
+//    clang -cc1 -include-pch base.pch -fpch-instantiation-cache=inst.h ...
+//    clang -cc1 -x c++-header -include-pch base.pch -emit-pch -o inst.pch \
+//      inst.h
+//
+//  Later translation units that include inst.pch instead of base.pch then
+//  deserialize these instantiations instead of performing them again; build
+//  inst.pch with -fpch-codegen to emit their code only once. Building the
+//  chained PCH on top of any other PCH than the recorded one is an error.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/SemaDiagnostic.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace clang;
+
+/// Starts the first line of a cache file, followed by the hash of its PCH.
+static constexpr llvm::StringLiteral CacheHeader =
+    "// clang-pch-instantiation-cache: ";
+
+static bool isCacheableDecl(const NamedDecl *D);
+static bool isCacheableType(QualType T);
+
+/// Whether \p D was deserialized from a PCH, as opposed to a module. Only
+/// declarations from the PCH can be named by the cache file.
+static bool isFromPCH(const Decl *D) {
+  return D->isFromASTFile() && !D->getOwningModule();
+}
+
+static bool areCacheableArgs(ArrayRef<TemplateArgument> Args) {
+  return llvm::all_of(Args, [](const TemplateArgument &Arg) {
+    switch (Arg.getKind()) {
+    case TemplateArgument::Type:
+      return isCacheableType(Arg.getAsType());
+    case TemplateArgument::Integral:
+      return isCacheableType(Arg.getIntegralType());
+    case TemplateArgument::NullPtr:
+      return isCacheableType(Arg.getNullPtrType());
+    case TemplateArgument::Template:
+      if (TemplateDecl *TD = Arg.getAsTemplate().getAsTemplateDecl())
+        return isCacheableDecl(TD);
+      return false;
+    case TemplateArgument::Pack:
+      return areCacheableArgs(Arg.pack_elements());
+    default:
+      // Declarations and expressions are not reliably spelled the same way in
+      // every translation unit.
+      return false;
+    }
+  });
+}
+
+static bool isCacheableContext(const DeclContext *DC) {
+  for (; !DC->isTranslationUnit(); DC = DC->getParent()) {
+    if (isa<NamespaceDecl, LinkageSpecDecl, ExportDecl>(DC))
+      continue;
+    if (const auto *RD = dyn_cast<CXXRecordDecl>(DC))
+      return isCacheableDecl(RD);
+    return false;
+  }
+  return true;
+}
+
+/// Whether \p D can be named from the cache file.
+static bool isCacheableDecl(const NamedDecl *D) {
+  if (const auto *Spec = dyn_cast<ClassTemplateSpecializationDecl>(D)) {
+    // The specialization itself is likely created by this translation unit;
+    // it can be named as long as its template and arguments can.
+    return !isa<ClassTemplatePartialSpecializationDecl>(Spec) &&
+           isCacheableDecl(Spec->getSpecializedTemplate()) &&
+           areCacheableArgs(Spec->getTemplateArgs().asArray());
+  }
+
+  const NamedDecl *Pattern = D;
+  if (const auto *RD = dyn_cast<CXXRecordDecl>(D)) {
+    if (const CXXRecordDecl *Member = RD->getInstantiatedFromMemberClass())
+      Pattern = Member;
+  } else if (const auto *ED = dyn_cast<EnumDecl>(D)) {
+    if (const EnumDecl *Member = ED->getInstantiatedFromMemberEnum())
+      Pattern = Member;
+  }
+  if (!isFromPCH(Pattern) || !D->getIdentifier() ||
+      D->isInAnonymousNamespace())
+    return false;
+  return isCacheableContext(D->getDeclContext());
+}
+
+static bool isCacheableType(QualType T) {
+  const Type *Ty = T.getCanonicalType().getTypePtr();
+  if (isa<BuiltinType>(Ty))
+    return true;
+  if (const auto *PT = dyn_cast<PointerType>(Ty))
+    return isCacheableType(PT->getPointeeType());
+  if (const auto *RT = dyn_cast<ReferenceType>(Ty))
+    return isCacheableType(RT->getPointeeType());
+  if (const auto *MPT = dyn_cast<MemberPointerType>(Ty))
+    return isCacheableType(MPT->getPointeeType()) &&
+           isCacheableType(QualType(MPT->getClass(), 0));
+  if (isa<ConstantArrayType, IncompleteArrayType>(Ty))
+    return isCacheableType(cast<ArrayType>(Ty)->getElementType());
+  if (const auto *FPT = dyn_cast<FunctionProtoType>(Ty))
+    return isCacheableType(FPT->getReturnType()) &&
+           llvm::all_of(FPT->getParamTypes(), isCacheableType);
+  if (const auto *TT = dyn_cast<TagType>(Ty))
+    return isCacheableDecl(TT->getDecl());
+  return false;
+}
+
+void Sema::recordInstantiationForCache(FunctionDecl *Function,
+                                       const FunctionDecl *Pattern) {
+  // Only instantiations in users of the PCH are interesting; the PCH itself
+  // keeps its instantiations anyway.
+  if (TUKind != TU_Complete || !isFromPCH(Pattern) ||
+      Pattern->getFriendObjectKind() || !Function->isExternallyVisible())
+    return;
+
+  // An explicit instantiation of a function with a deduced return type would
+  // have to spell the undeduced type, and conversion function templates cannot
+  // be named with explicit template arguments.
+  if (Pattern->getDeclaredReturnType()->getContainedDeducedType() ||
+      (isa<CXXConversionDecl>(Function) && Function->getPrimaryTemplate()))
+    return;
+
+  const auto *FPT = Function->getType()->getAs<FunctionProtoType>();
+  if (!FPT || !isCacheableContext(Function->getDeclContext()) ||
+      !isCacheableType(FPT->getReturnType()) ||
+      !llvm::all_of(FPT->getParamTypes(), isCacheableType))
+    return;
+  const TemplateArgumentList *Args = Function->getTemplateSpecializationArgs();
+  if (Args && !areCacheableArgs(Args->asArray()))
+    return;
+
+  PrintingPolicy Policy = getPrintingPolicy();
+  Policy.PrintCanonicalTypes = true;
+
+  std::string Name;
+  llvm::raw_string_ostream NameOS(Name);
+  Function->printQualifiedName(NameOS, Policy);
+  if (Args) {
+    // Avoid forming a different token, as in 'operator<<<int>'.
+    if (Function->getDeclName().getNameKind() ==
+        DeclarationName::CXXOperatorName)
+      NameOS << ' ';
+    printTemplateArgumentList(NameOS, Args->asArray(), Policy);
+  }
+  NameOS.flush();
+
+  std::string Spelling;
+  llvm::raw_string_ostream OS(Spelling);
+  OS << "template ";
+  if (isa<CXXConstructorDecl, CXXDestructorDecl, CXXConversionDecl>(Function)) {
+    OS << Name << '(';
+    llvm::interleaveComma(FPT->getParamTypes(), OS,
+                          [&](QualType T) { T.print(OS, Policy); });
+    if (FPT->isVariadic())
+      OS << (FPT->getNumParams() ? ", ..." : "...");
+    OS << ')';
+    if (FPT->isConst())
+      OS << " const";
+    if (FPT->isVolatile())
+      OS << " volatile";
+    if (FPT->getRefQualifier() == RQ_LValue)
+      OS << " &";
+    else if (FPT->getRefQualifier() == RQ_RValue)
+      OS << " &&";
+  } else {
+    // The exception specification may not have been instantiated yet, and is
+    // not needed to identify the function.
+    FunctionProtoType::ExtProtoInfo EPI = FPT->getExtProtoInfo();
+    EPI.ExceptionSpec = FunctionProtoType::ExceptionSpecInfo();
+    Context.getFunctionType(FPT->getReturnType(), FPT->getParamTypes(), EPI)
+        .print(OS, Policy, Name);
+  }
+  OS << ';';
+  CacheableInstantiations.push_back(std::move(OS.str()));
+}
+
+/// Hash the contents of the PCH included by this translation unit. The PCH
+/// records the headers it was built from, so the hash also changes when they
+/// do.
+static llvm::ErrorOr<std::string> getPCHHash(Sema &S) {
+  StringRef PCH = S.getPreprocessor().getPreprocessorOpts().ImplicitPCHInclude;
+  if (PCH.empty())
+    return std::make_error_code(std::errc::no_such_file_or_directory);
+  auto Buffer = S.getSourceManager().getFileManager().getBufferForFile(PCH);
+  if (!Buffer)
+    return Buffer.getError();
+  std::string Hash;
+  llvm::raw_string_ostream(Hash)
+      << llvm::format_hex_no_prefix(llvm::xxh3_64bits((*Buffer)->getBuffer()),
+                                    16);
+  return Hash;
+}
+
+void Sema::writeInstantiationCache() {
+  if (CacheableInstantiations.empty())
+    return;
+
+  StringRef Path = getLangOpts().PCHInstantiationCache;
+  auto Report = [&](std::error_code EC) {
+    Diag(SourceLocation(), diag::warn_pch_instantiation_cache_failed)
+        << Path << EC.message();
+  };
+
+  llvm::ErrorOr<std::string> PCHHash = getPCHHash(*this);
+  if (!PCHHash)
+    return Report(PCHHash.getError());
+
+  int FD;
+  if (std::error_code EC = llvm::sys::fs::openFileForReadWrite(
+          Path, FD, llvm::sys::fs::CD_OpenAlways, llvm::sys::fs::OF_None))
+    return Report(EC);
+  llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+
+  // Every user of the PCH may update the cache at the same time.
+  if (std::error_code EC = llvm::sys::fs::lockFile(FD))
+    return Report(EC);
+  auto Existing = llvm::MemoryBuffer::getOpenFile(
+      llvm::sys::fs::convertFDToNativeFile(FD), Path, /*FileSize=*/-1,
+      /*RequiresNullTerminator=*/false, /*IsVolatile=*/true);
+  if (!Existing) {
+    llvm::sys::fs::unlockFile(FD);
+    return Report(Existing.getError());
+  }
+
+  // Instantiations recorded against another PCH may not even be valid for
+  // this one; start over without them.
+  auto [Header, Body] = (*Existing)->getBuffer().split('\n');
+  bool IsCurrent = Header.consume_front(CacheHeader) && Header == *PCHHash;
+  SmallVector<StringRef, 0> Lines;
+  if (IsCurrent)
+    Body.split(Lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  size_t NumExisting = Lines.size();
+
+  Lines.append(CacheableInstantiations.begin(), CacheableInstantiations.end());
+  llvm::sort(Lines);
+  Lines.erase(std::unique(Lines.begin(), Lines.end()), Lines.end());
+
+  // Leave the file alone if there is nothing new, so that the chained PCH
+  // built from it stays up to date.
+  if (!IsCurrent || Lines.size() != NumExisting) {
+    if (std::error_code EC = llvm::sys::fs::resize_file(FD, 0)) {
+      llvm::sys::fs::unlockFile(FD);
+      return Report(EC);
+    }
+    OS.seek(0);
+    OS << CacheHeader << *PCHHash << '\n';
+    for (StringRef Line : Lines)
+      OS << Line << '\n';
+    OS.flush();
+  }
+  llvm::sys::fs::unlockFile(FD);
+
+  if (std::error_code EC = OS.error()) {
+    OS.clear_error();
+    Report(EC);
+  }
+}
+
+void Sema::checkInstantiationCacheBase() {
+  FileID MainFileID = SourceMgr.getMainFileID();
+  if (MainFileID.isInvalid())
+    return;
+  StringRef Contents = SourceMgr.getBufferData(MainFileID);
+  if (!Contents.consume_front(CacheHeader))
+    return;
+
+  StringRef RecordedHash = Contents.split('\n').first.rtrim();
+  StringRef PCH = PP.getPreprocessorOpts().ImplicitPCHInclude;
+  llvm::ErrorOr<std::string> PCHHash = getPCHHash(*this);
+  if (!PCHHash || *PCHHash != RecordedHash)
+    Diag(SourceMgr.getLocForStartOfFile(MainFileID),
+         diag::err_pch_instantiation_cache_mismatch)
+        << PCH.empty() << PCH;
+}
@@ -2424,8 +2424,19 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   // For standard C++ modules, we don't need to check the inputs.
   bool SkipChecks = F.StandardCXXModule;
 
-  OptionalFileEntryRefDegradesToFileEntryPtr File = OptionalFileEntryRef(
-      expectedToOptional(FileMgr.getFileRef(Filename, /*OpenFile=*/false)));
+  OptionalFileEntryRefDegradesToFileEntryPtr File;
+
+  // A preamble stands for the start of the main file being parsed, which need
+  // not be the file it was built from: a PreambleCache shares preambles
+  // between files with the same preamble.
+  SourceManager &SM = getSourceManager();
+  if (F.Kind == MK_Preamble && Overridden &&
+      Filename == F.OriginalSourceFileName && SM.getMainFileID().isValid())
+    File = SM.getFileEntryRefForID(SM.getMainFileID());
+
+  if (!File)
+    File = OptionalFileEntryRef(
+        expectedToOptional(FileMgr.getFileRef(Filename, /*OpenFile=*/false)));
 
   // For an overridden file, create a virtual file with the stored
   // size/timestamp.
@@ -2450,7 +2461,6 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   // that was part of the precompiled header. Overriding such a file
   // can lead to problems when lexing using the source locations from the
   // PCH.
-  SourceManager &SM = getSourceManager();
   // FIXME: Reject if the overrides are different.
   if ((!Overridden && !Transient) && !SkipChecks && SM.isFileOverridden(File)) {
     if (Complain)
@@ -7412,13 +7422,26 @@ void ASTReader::CompleteRedeclChain(const Decl *D) {
     }
   }
 
-  if (auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(D))
-    CTSD->getSpecializedTemplate()->LoadLazySpecializations();
-  if (auto *VTSD = dyn_cast<VarTemplateSpecializationDecl>(D))
-    VTSD->getSpecializedTemplate()->LoadLazySpecializations();
+  // Only the lazy specializations with the same template arguments can be
+  // redeclarations of D.
+  if (auto *CTSD = dyn_cast<ClassTemplateSpecializationDecl>(D)) {
+    if (isa<ClassTemplatePartialSpecializationDecl>(CTSD))
+      CTSD->getSpecializedTemplate()->LoadLazySpecializations();
+    else
+      CTSD->getSpecializedTemplate()->LoadLazySpecializations(
+          CTSD->getTemplateArgs().asArray());
+  }
+  if (auto *VTSD = dyn_cast<VarTemplateSpecializationDecl>(D)) {
+    if (isa<VarTemplatePartialSpecializationDecl>(VTSD))
+      VTSD->getSpecializedTemplate()->LoadLazySpecializations();
+    else
+      VTSD->getSpecializedTemplate()->LoadLazySpecializations(
+          VTSD->getTemplateArgs().asArray());
+  }
   if (auto *FD = dyn_cast<FunctionDecl>(D)) {
     if (auto *Template = FD->getPrimaryTemplate())
-      Template->LoadLazySpecializations();
+      Template->LoadLazySpecializations(
+          FD->getTemplateSpecializationArgs()->asArray());
   }
 }
 
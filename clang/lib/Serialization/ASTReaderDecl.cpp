@@ -138,6 +138,21 @@ namespace clang {
         IDs.push_back(readDeclID());
     }
 
+    RedeclarableTemplateDecl::LazySpecializationInfo
+    readLazySpecializationInfo() {
+      DeclID ID = readDeclID();
+      unsigned Hash = Record.readInt();
+      bool IsPartial = Record.readInt();
+      return {ID, Hash, IsPartial};
+    }
+
+    void readLazySpecializationInfoList(
+        SmallVectorImpl<RedeclarableTemplateDecl::LazySpecializationInfo>
+            &Infos) {
+      for (unsigned I = 0, Size = Record.readInt(); I != Size; ++I)
+        Infos.push_back(readLazySpecializationInfo());
+    }
+
     Decl *readDecl() {
       return Record.readDecl();
     }
@@ -264,10 +279,12 @@ namespace clang {
         : Reader(Reader), Record(Record), Loc(Loc), ThisDeclID(thisDeclID),
           ThisDeclLoc(ThisDeclLoc) {}
 
-    template <typename T> static
-    void AddLazySpecializations(T *D,
-                                SmallVectorImpl<serialization::DeclID>& IDs) {
-      if (IDs.empty())
+    template <typename T>
+    static void AddLazySpecializations(
+        T *D,
+        SmallVectorImpl<RedeclarableTemplateDecl::LazySpecializationInfo>
+            &Infos) {
+      if (Infos.empty())
         return;
 
       // FIXME: We should avoid this pattern of getting the ASTContext.
@@ -276,14 +293,15 @@ namespace clang {
       auto *&LazySpecializations = D->getCommonPtr()->LazySpecializations;
 
       if (auto &Old = LazySpecializations) {
-        IDs.insert(IDs.end(), Old + 1, Old + 1 + Old[0]);
-        llvm::sort(IDs);
-        IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
+        Infos.insert(Infos.end(), Old + 1, Old + 1 + Old[0].DeclID);
+        llvm::sort(Infos);
+        Infos.erase(std::unique(Infos.begin(), Infos.end()), Infos.end());
       }
 
-      auto *Result = new (C) serialization::DeclID[1 + IDs.size()];
-      *Result = IDs.size();
-      std::copy(IDs.begin(), IDs.end(), Result + 1);
+      auto *Result = new (C)
+          RedeclarableTemplateDecl::LazySpecializationInfo[1 + Infos.size()];
+      Result->DeclID = Infos.size();
+      std::copy(Infos.begin(), Infos.end(), Result + 1);
 
       LazySpecializations = Result;
     }
@@ -319,7 +337,9 @@ namespace clang {
     void ReadFunctionDefinition(FunctionDecl *FD);
     void Visit(Decl *D);
 
-    void UpdateDecl(Decl *D, SmallVectorImpl<serialization::DeclID> &);
+    void UpdateDecl(
+        Decl *D,
+        SmallVectorImpl<RedeclarableTemplateDecl::LazySpecializationInfo> &);
 
     static void setNextObjCCategory(ObjCCategoryDecl *Cat,
                                     ObjCCategoryDecl *Next) {
@@ -2395,9 +2415,9 @@ void ASTDeclReader::VisitClassTemplateDecl(ClassTemplateDecl *D) {
   if (ThisDeclID == Redecl.getFirstID()) {
     // This ClassTemplateDecl owns a CommonPtr; read it to keep track of all of
     // the specializations.
-    SmallVector<serialization::DeclID, 32> SpecIDs;
-    readDeclIDList(SpecIDs);
-    ASTDeclReader::AddLazySpecializations(D, SpecIDs);
+    SmallVector<RedeclarableTemplateDecl::LazySpecializationInfo, 32> SpecInfos;
+    readLazySpecializationInfoList(SpecInfos);
+    ASTDeclReader::AddLazySpecializations(D, SpecInfos);
   }
 
   if (D->getTemplatedDecl()->TemplateOrInstantiation) {
@@ -2423,9 +2443,9 @@ void ASTDeclReader::VisitVarTemplateDecl(VarTemplateDecl *D) {
   if (ThisDeclID == Redecl.getFirstID()) {
     // This VarTemplateDecl owns a CommonPtr; read it to keep track of all of
     // the specializations.
-    SmallVector<serialization::DeclID, 32> SpecIDs;
-    readDeclIDList(SpecIDs);
-    ASTDeclReader::AddLazySpecializations(D, SpecIDs);
+    SmallVector<RedeclarableTemplateDecl::LazySpecializationInfo, 32> SpecInfos;
+    readLazySpecializationInfoList(SpecInfos);
+    ASTDeclReader::AddLazySpecializations(D, SpecInfos);
   }
 }
 
@@ -2533,9 +2553,9 @@ void ASTDeclReader::VisitFunctionTemplateDecl(FunctionTemplateDecl *D) {
 
   if (ThisDeclID == Redecl.getFirstID()) {
     // This FunctionTemplateDecl owns a CommonPtr; read it.
-    SmallVector<serialization::DeclID, 32> SpecIDs;
-    readDeclIDList(SpecIDs);
-    ASTDeclReader::AddLazySpecializations(D, SpecIDs);
+    SmallVector<RedeclarableTemplateDecl::LazySpecializationInfo, 32> SpecInfos;
+    readLazySpecializationInfoList(SpecInfos);
+    ASTDeclReader::AddLazySpecializations(D, SpecInfos);
   }
 }
 
@@ -4145,7 +4165,8 @@ void ASTReader::loadDeclUpdateRecords(PendingUpdateRecord &Record) {
   ProcessingUpdatesRAIIObj ProcessingUpdates(*this);
   DeclUpdateOffsetsMap::iterator UpdI = DeclUpdateOffsets.find(ID);
 
-  SmallVector<serialization::DeclID, 8> PendingLazySpecializationIDs;
+  SmallVector<RedeclarableTemplateDecl::LazySpecializationInfo, 8>
+      PendingLazySpecializationIDs;
 
   if (UpdI != DeclUpdateOffsets.end()) {
     auto UpdateOffsets = std::move(UpdI->second);
@@ -4414,8 +4435,10 @@ static void forAllLaterRedecls(DeclT *D, Fn F) {
   }
 }
 
-void ASTDeclReader::UpdateDecl(Decl *D,
-   llvm::SmallVectorImpl<serialization::DeclID> &PendingLazySpecializationIDs) {
+void ASTDeclReader::UpdateDecl(
+    Decl *D,
+    llvm::SmallVectorImpl<RedeclarableTemplateDecl::LazySpecializationInfo>
+        &PendingLazySpecializationIDs) {
   while (Record.getIdx() < Record.size()) {
     switch ((DeclUpdateKind)Record.readInt()) {
     case UPD_CXX_ADDED_IMPLICIT_MEMBER: {
@@ -4428,7 +4451,7 @@ void ASTDeclReader::UpdateDecl(Decl *D,
 
     case UPD_CXX_ADDED_TEMPLATE_SPECIALIZATION:
       // It will be added to the template's lazy specialization set.
-      PendingLazySpecializationIDs.push_back(readDeclID());
+      PendingLazySpecializationIDs.push_back(readLazySpecializationInfo());
       break;
 
     case UPD_CXX_ADDED_ANONYMOUS_NAMESPACE: {
@@ -180,7 +180,8 @@ namespace clang {
     /// Add to the record the first declaration from each module file that
     /// provides a declaration of D. The intent is to provide a sufficient
     /// set such that reloading this set will load all current redeclarations.
-    void AddFirstDeclFromEachModule(const Decl *D, bool IncludeLocal) {
+    llvm::MapVector<ModuleFile *, const Decl *>
+    CollectFirstDeclFromEachModule(const Decl *D, bool IncludeLocal) {
       llvm::MapVector<ModuleFile*, const Decl*> Firsts;
       // FIXME: We can skip entries that we know are implied by others.
       for (const Decl *R = D->getMostRecentDecl(); R; R = R->getPreviousDecl()) {
@@ -189,7 +190,11 @@ namespace clang {
         else if (IncludeLocal)
           Firsts[nullptr] = R;
       }
-      for (const auto &F : Firsts)
+      return Firsts;
+    }
+
+    void AddFirstDeclFromEachModule(const Decl *D, bool IncludeLocal) {
+      for (const auto &F : CollectFirstDeclFromEachModule(D, IncludeLocal))
         Record.AddDeclRef(F.second);
     }
 
@@ -222,13 +227,16 @@ namespace clang {
         assert(!Common->LazySpecializations);
       }
 
-      ArrayRef<DeclID> LazySpecializations;
+      using LazySpecializationInfo =
+          RedeclarableTemplateDecl::LazySpecializationInfo;
+      ArrayRef<LazySpecializationInfo> LazySpecializations;
       if (auto *LS = Common->LazySpecializations)
-        LazySpecializations = llvm::ArrayRef(LS + 1, LS[0]);
+        LazySpecializations = llvm::ArrayRef(LS + 1, LS[0].DeclID);
 
       // Add a slot to the record for the number of specializations.
       unsigned I = Record.size();
       Record.push_back(0);
+      unsigned NumSpecializations = 0;
 
       // AddFirstDeclFromEachModule might trigger deserialization, invalidating
       // *Specializations iterators.
@@ -238,14 +246,30 @@ namespace clang {
       for (auto &Entry : getPartialSpecializations(Common))
         Specs.push_back(getSpecializationDecl(Entry));
 
+      // Each specialization is written with the hash of its template arguments
+      // so that lookups only need to load the ones that may match.
       for (auto *D : Specs) {
         assert(D->isCanonicalDecl() && "non-canonical decl in set");
-        AddFirstDeclFromEachModule(D, /*IncludeLocal*/true);
+        unsigned Hash = RedeclarableTemplateDecl::computeSpecializationHash(D);
+        bool IsPartial = isa<ClassTemplatePartialSpecializationDecl,
+                             VarTemplatePartialSpecializationDecl>(D);
+        for (const auto &F :
+             CollectFirstDeclFromEachModule(D, /*IncludeLocal*/ true)) {
+          Record.AddDeclRef(F.second);
+          Record.push_back(Hash);
+          Record.push_back(IsPartial);
+          ++NumSpecializations;
+        }
+      }
+      for (const LazySpecializationInfo &Info : LazySpecializations) {
+        Record.push_back(Info.DeclID);
+        Record.push_back(Info.ODRHash);
+        Record.push_back(Info.IsPartial);
+        ++NumSpecializations;
       }
-      Record.append(LazySpecializations.begin(), LazySpecializations.end());
 
       // Update the size entry we added earlier.
-      Record[I] = Record.size() - I - 1;
+      Record[I] = NumSpecializations;
     }
 
     /// Ensure that this template specialization is associated with the specified
@@ -7,7 +7,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
+#include "clang/Basic/TokenKinds.h"
+#include "clang/Basic/Version.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/BLAKE3.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/Threading.h"
 #include <optional>
@@ -61,10 +68,25 @@ EntryRef DependencyScanningWorkerFilesystem::scanForDirectivesIfNecessary(
     return EntryRef(Filename, Entry);
 
   SmallVector<dependency_directives_scan::Directive, 64> Directives;
+  StringRef Buffer = Contents->Original->getBuffer();
+  // Reuse the directives scanned by an earlier invocation, if available.
+  const DependencyDirectivesDiskCache *DiskCache = SharedCache.getDiskCache();
+  std::string DiskCacheKey;
+  if (DiskCache) {
+    DiskCacheKey = DiskCache->getKey(Buffer);
+    if (DiskCache->lookup(DiskCacheKey, Buffer, Contents->DepDirectiveTokens,
+                          Directives)) {
+      Contents->DepDirectives.store(
+          new std::optional<DependencyDirectivesTy>(std::move(Directives)));
+      return EntryRef(Filename, Entry);
+    }
+    Contents->DepDirectiveTokens.clear();
+    Directives.clear();
+  }
+
   // Scan the file for preprocessor directives that might affect the
   // dependencies.
-  if (scanSourceForDependencyDirectives(Contents->Original->getBuffer(),
-                                        Contents->DepDirectiveTokens,
+  if (scanSourceForDependencyDirectives(Buffer, Contents->DepDirectiveTokens,
                                         Directives)) {
     Contents->DepDirectiveTokens.clear();
     // FIXME: Propagate the diagnostic if desired by the client.
@@ -72,6 +94,9 @@ EntryRef DependencyScanningWorkerFilesystem::scanForDirectivesIfNecessary(
     return EntryRef(Filename, Entry);
   }
 
+  if (DiskCache)
+    DiskCache->store(DiskCacheKey, Contents->DepDirectiveTokens, Directives);
+
   // This function performed double-checked locking using `DepDirectives`.
   // Assigning it must be the last thing this function does, otherwise other
   // threads may skip the
@@ -81,6 +106,125 @@ EntryRef DependencyScanningWorkerFilesystem::scanForDirectivesIfNecessary(
   return EntryRef(Filename, Entry);
 }
 
+// The on-disk format of a DependencyDirectivesDiskCache entry, with all
+// integers in little-endian byte order:
+//
+//   char[8]  Magic
+//   uint32_t NumTokens
+//   uint32_t NumDirectives
+//   NumTokens x {uint32_t Offset, uint32_t Length, uint16_t Kind,
+//                uint16_t Flags}
+//   NumDirectives x {uint32_t FirstToken, uint32_t NumTokens, uint8_t Kind}
+static constexpr StringLiteral DirectivesCacheMagic = "CLDDTOK1";
+static constexpr size_t DirectivesCacheTokenSize = 12;
+static constexpr size_t DirectivesCacheDirectiveSize = 9;
+
+DependencyDirectivesDiskCache::~DependencyDirectivesDiskCache() {
+  llvm::pruneCache(Path, Policy);
+}
+
+std::string DependencyDirectivesDiskCache::getKey(StringRef Contents) const {
+  // Token kinds and the scanner itself may change between compiler versions.
+  static const std::string Version = getClangFullRepositoryVersion();
+  llvm::BLAKE3 Hasher;
+  Hasher.update(Version);
+  Hasher.update(StringRef("\0", 1));
+  Hasher.update(Contents);
+  return llvm::toHex(Hasher.final<16>(), /*LowerCase=*/true);
+}
+
+std::string DependencyDirectivesDiskCache::getEntryPath(StringRef Key) const {
+  // Use the "llvmcache-" prefix so that the entries are subject to pruning.
+  SmallString<256> EntryPath(Path);
+  llvm::sys::path::append(EntryPath, "llvmcache-scandeps-" + Key);
+  return std::string(EntryPath);
+}
+
+bool DependencyDirectivesDiskCache::lookup(
+    StringRef Key, StringRef Contents,
+    SmallVectorImpl<dependency_directives_scan::Token> &Tokens,
+    SmallVectorImpl<dependency_directives_scan::Directive> &Directives) const {
+  using namespace llvm::support;
+  auto MaybeBuffer = llvm::MemoryBuffer::getFile(
+      getEntryPath(Key), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!MaybeBuffer)
+    return false;
+  StringRef Data = (*MaybeBuffer)->getBuffer();
+
+  // Validate the entry before using it, as it may have been truncated or
+  // written by an incompatible version.
+  size_t HeaderSize = DirectivesCacheMagic.size() + 8;
+  if (Data.size() < HeaderSize || !Data.startswith(DirectivesCacheMagic))
+    return false;
+  const char *P = Data.data() + DirectivesCacheMagic.size();
+  uint32_t NumTokens = endian::readNext<uint32_t, little, unaligned>(P);
+  uint32_t NumDirectives = endian::readNext<uint32_t, little, unaligned>(P);
+  uint64_t ExpectedSize =
+      HeaderSize + uint64_t(NumTokens) * DirectivesCacheTokenSize +
+      uint64_t(NumDirectives) * DirectivesCacheDirectiveSize;
+  if (Data.size() != ExpectedSize)
+    return false;
+
+  Tokens.clear();
+  Tokens.reserve(NumTokens);
+  for (uint32_t I = 0; I != NumTokens; ++I) {
+    uint32_t Offset = endian::readNext<uint32_t, little, unaligned>(P);
+    uint32_t Length = endian::readNext<uint32_t, little, unaligned>(P);
+    uint16_t Kind = endian::readNext<uint16_t, little, unaligned>(P);
+    uint16_t Flags = endian::readNext<uint16_t, little, unaligned>(P);
+    if (uint64_t(Offset) + Length > Contents.size() || Kind >= tok::NUM_TOKENS)
+      return false;
+    Tokens.emplace_back(Offset, Length, static_cast<tok::TokenKind>(Kind),
+                        Flags);
+  }
+
+  Directives.clear();
+  Directives.reserve(NumDirectives);
+  for (uint32_t I = 0; I != NumDirectives; ++I) {
+    uint32_t First = endian::readNext<uint32_t, little, unaligned>(P);
+    uint32_t Count = endian::readNext<uint32_t, little, unaligned>(P);
+    uint8_t Kind = endian::readNext<uint8_t, little, unaligned>(P);
+    if (uint64_t(First) + Count > NumTokens ||
+        Kind > dependency_directives_scan::pp_eof)
+      return false;
+    Directives.emplace_back(
+        static_cast<dependency_directives_scan::DirectiveKind>(Kind),
+        ArrayRef<dependency_directives_scan::Token>(Tokens).slice(First,
+                                                                  Count));
+  }
+  return true;
+}
+
+void DependencyDirectivesDiskCache::store(
+    StringRef Key, ArrayRef<dependency_directives_scan::Token> Tokens,
+    ArrayRef<dependency_directives_scan::Directive> Directives) const {
+  if (llvm::sys::fs::create_directories(Path))
+    return;
+  // llvm::writeToOutput writes to a temporary file and renames it, so
+  // concurrent invocations never observe a partially written entry.
+  llvm::Error Err =
+      llvm::writeToOutput(getEntryPath(Key), [&](raw_ostream &OS) {
+        llvm::support::endian::Writer W(OS, llvm::support::little);
+        OS << DirectivesCacheMagic;
+        W.write<uint32_t>(Tokens.size());
+        W.write<uint32_t>(Directives.size());
+        for (const dependency_directives_scan::Token &T : Tokens) {
+          W.write<uint32_t>(T.Offset);
+          W.write<uint32_t>(T.Length);
+          W.write<uint16_t>(T.Kind);
+          W.write<uint16_t>(T.Flags);
+        }
+        for (const dependency_directives_scan::Directive &D : Directives) {
+          W.write<uint32_t>(D.Tokens.empty() ? 0
+                                             : D.Tokens.data() - Tokens.data());
+          W.write<uint32_t>(D.Tokens.size());
+          W.write<uint8_t>(D.Kind);
+        }
+        return llvm::Error::success();
+      });
+  llvm::consumeError(std::move(Err));
+}
+
 DependencyScanningFilesystemSharedCache::
     DependencyScanningFilesystemSharedCache() {
   // This heuristic was chosen using a empirical testing on a
@@ -106,6 +250,53 @@ DependencyScanningFilesystemSharedCache::getShardForUID(
   return CacheShards[Hash % NumShards];
 }
 
+void DependencyScanningFilesystemSharedCache::invalidate(
+    ArrayRef<std::string> Filenames, llvm::vfs::FileSystem &FS) {
+  llvm::StringSet<> StaleFilenames;
+  llvm::DenseSet<llvm::sys::fs::UniqueID> StaleUIDs;
+  for (const std::string &Filename : Filenames) {
+    StaleFilenames.insert(Filename);
+    // An in-place modification keeps the unique ID of the file while replacing
+    // it with a new file changes it, so look at both.
+    if (const auto *Entry = getShardForFilename(Filename).findEntryByFilename(
+            Filename))
+      if (!Entry->isError())
+        StaleUIDs.insert(Entry->getUniqueID());
+    if (llvm::ErrorOr<llvm::vfs::Status> Stat = FS.status(Filename))
+      StaleUIDs.insert(Stat->getUniqueID());
+  }
+
+  for (unsigned I = 0; I < NumShards; ++I) {
+    CacheShard &Shard = CacheShards[I];
+    std::lock_guard<std::mutex> LockGuard(Shard.CacheLock);
+    for (llvm::sys::fs::UniqueID UID : StaleUIDs)
+      Shard.EntriesByUID.erase(UID);
+    for (auto It = Shard.EntriesByFilename.begin(),
+              End = Shard.EntriesByFilename.end();
+         It != End;) {
+      auto Current = It++;
+      const CachedFileSystemEntry *Entry = Current->getValue();
+      if (StaleFilenames.contains(Current->getKey()) ||
+          (!Entry->isError() && StaleUIDs.contains(Entry->getUniqueID())))
+        Shard.EntriesByFilename.erase(Current);
+    }
+  }
+}
+
+void DependencyScanningFilesystemSharedCache::invalidateMissingFiles() {
+  for (unsigned I = 0; I < NumShards; ++I) {
+    CacheShard &Shard = CacheShards[I];
+    std::lock_guard<std::mutex> LockGuard(Shard.CacheLock);
+    for (auto It = Shard.EntriesByFilename.begin(),
+              End = Shard.EntriesByFilename.end();
+         It != End;) {
+      auto Current = It++;
+      if (Current->getValue()->isError())
+        Shard.EntriesByFilename.erase(Current);
+    }
+  }
+}
+
 const CachedFileSystemEntry *
 DependencyScanningFilesystemSharedCache::CacheShard::findEntryByFilename(
     StringRef Filename) const {
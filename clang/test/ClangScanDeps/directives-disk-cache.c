@@ -0,0 +1,64 @@
+// Check that --directives-cache-path persists the scanned directives of every
+// file across invocations, that a changed file is scanned again, and that
+// --directives-cache-policy prunes the cache.
+
+// RUN: rm -rf %t && split-file %s %t
+// RUN: sed -e "s|DIR|%/t|g" %t/cdb.json.template > %t/cdb.json
+
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -format make \
+// RUN:   --directives-cache-path=%t/cache | FileCheck %s -DPREFIX=%/t
+// RUN: ls %t/cache | grep llvmcache-scandeps- | count 2
+
+// CHECK:      [[PREFIX]]/main.o:
+// CHECK-NEXT:   [[PREFIX]]/main.c
+// CHECK-NEXT:   [[PREFIX]]/a.h
+// CHECK-NOT:    b.h
+
+// A second invocation reuses the entries and produces the same result.
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -format make \
+// RUN:   --directives-cache-path=%t/cache | FileCheck %s -DPREFIX=%/t
+// RUN: ls %t/cache | grep llvmcache-scandeps- | count 2
+
+// A changed header gets a new entry and its new include is found.
+// RUN: cp %t/a2.h %t/a.h
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -format make \
+// RUN:   --directives-cache-path=%t/cache \
+// RUN:   | FileCheck %s --check-prefix=CHANGED -DPREFIX=%/t
+// RUN: ls %t/cache | grep llvmcache-scandeps- | count 4
+
+// CHANGED:      [[PREFIX]]/main.o:
+// CHANGED-NEXT:   [[PREFIX]]/main.c
+// CHANGED-NEXT:   [[PREFIX]]/a.h
+// CHANGED-NEXT:   [[PREFIX]]/b.h
+
+// The policy is applied at the end of the invocation.
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -format make \
+// RUN:   --directives-cache-path=%t/cache \
+// RUN:   --directives-cache-policy=prune_interval=0s:cache_size_files=1 \
+// RUN:   | FileCheck %s --check-prefix=CHANGED -DPREFIX=%/t
+// RUN: ls %t/cache | grep llvmcache-scandeps- | count 1
+
+// An invalid policy is rejected.
+// RUN: not clang-scan-deps -compilation-database %t/cdb.json -format make \
+// RUN:   --directives-cache-path=%t/cache --directives-cache-policy=bogus 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=POLICY
+// POLICY: for the --directives-cache-policy option:
+
+//--- cdb.json.template
+[{
+  "directory": "DIR",
+  "command": "clang -c DIR/main.c -o DIR/main.o",
+  "file": "DIR/main.c"
+}]
+
+//--- main.c
+#include "a.h"
+
+//--- a.h
+#define A 1
+
+//--- a2.h
+#include "b.h"
+
+//--- b.h
+#define B 1
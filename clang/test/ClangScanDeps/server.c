@@ -0,0 +1,95 @@
+// Check that --server keeps scanning results across requests, that a file
+// reported with --changed-file is scanned again even if its size and
+// modification time did not change, and that --shutdown-server stops the
+// server.
+
+// REQUIRES: shell
+// UNSUPPORTED: system-windows
+
+// RUN: rm -rf %t && split-file %s %t
+// RUN: sed -e "s|DIR|%/t|g" %t/cdb.json.template > %t/cdb.json
+
+// The socket is created relative to the test directory to keep its path short.
+// RUN: cd %t
+// RUN: sh %t/start-server.sh sock clang-scan-deps \
+// RUN:   -compilation-database %t/cdb.json -format make --server=sock
+
+// RUN: clang-scan-deps --connect=sock | FileCheck %s -DPREFIX=%/t
+// CHECK:      [[PREFIX]]/main.o:
+// CHECK-NEXT:   [[PREFIX]]/main.c
+// CHECK-NEXT:   [[PREFIX]]/a.h
+// CHECK-NEXT:   [[PREFIX]]/c.h
+// CHECK-NOT:    b.h
+
+// Replace the header without changing its size or modification time. The
+// server does not notice until it is told about the change.
+// RUN: touch -r %t/a.h %t/stamp
+// RUN: cp %t/a2.h %t/a.h
+// RUN: touch -r %t/stamp %t/a.h
+// RUN: clang-scan-deps --connect=sock | FileCheck %s -DPREFIX=%/t
+
+// RUN: clang-scan-deps --connect=sock --changed-file=a.h \
+// RUN:   | FileCheck %s --check-prefix=CHANGED -DPREFIX=%/t
+// CHANGED:      [[PREFIX]]/main.o:
+// CHANGED-NEXT:   [[PREFIX]]/main.c
+// CHANGED-NEXT:   [[PREFIX]]/a.h
+// CHANGED-NEXT:   [[PREFIX]]/b.h
+// CHANGED-NOT:    c.h
+
+// The new result is kept for later requests.
+// RUN: clang-scan-deps --connect=sock \
+// RUN:   | FileCheck %s --check-prefix=CHANGED -DPREFIX=%/t
+
+// The server exits and removes its socket when asked to shut down.
+// RUN: clang-scan-deps --connect=sock --shutdown-server | count 0
+// RUN: sh %t/wait-for-exit.sh sock
+// RUN: not clang-scan-deps --connect=sock 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=STOPPED
+// STOPPED: failed to connect to sock
+
+//--- start-server.sh
+# Starts the server in the background and waits for its socket to appear.
+socket=$1
+shift
+"$@" > server.log 2>&1 &
+i=0
+while [ ! -S "$socket" ]; do
+  i=$((i + 1))
+  if [ $i -gt 300 ]; then
+    cat server.log >&2
+    exit 1
+  fi
+  sleep 0.1
+done
+
+//--- wait-for-exit.sh
+# Waits for the server to remove its socket on exit.
+i=0
+while [ -e "$1" ]; do
+  i=$((i + 1))
+  [ $i -gt 300 ] && exit 1
+  sleep 0.1
+done
+exit 0
+
+//--- cdb.json.template
+[{
+  "directory": "DIR",
+  "command": "clang -c DIR/main.c -o DIR/main.o",
+  "file": "DIR/main.c"
+}]
+
+//--- main.c
+#include "a.h"
+
+//--- a.h
+#include "c.h"
+
+//--- a2.h
+#include "b.h"
+
+//--- b.h
+#define B 1
+
+//--- c.h
+#define C 1
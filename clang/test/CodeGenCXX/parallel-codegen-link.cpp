@@ -0,0 +1,22 @@
+// Check that the partial objects of an optimized -parallel-codegen-output
+// compile link, when a linkonce function is only used by another partition.
+
+// REQUIRES: x86-registered-target, lld
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O2 -emit-obj \
+// RUN:   -parallel-codegen-output %t/part1.o -o %t/part0.o %s
+// RUN: llvm-nm -A %t/part0.o %t/part1.o > %t/symbols.txt
+// RUN: FileCheck %s --input-file=%t/symbols.txt
+// RUN: grep ' W twice$' %t/symbols.txt | count 1
+// RUN: ld.lld -e use %t/part0.o %t/part1.o -o %t/out
+
+// SplitModule puts the two functions into different partitions, so the
+// partition that defines twice has no users of it.
+// CHECK:      [[FILE:[^ ]+]]: {{ +}}U twice
+// CHECK-NEXT: [[FILE]]: {{[0-9a-f]+}} T use
+
+extern "C" {
+__attribute__((noinline)) inline int twice(int x) { return 2 * x; }
+
+int use(int x) { return twice(x) + 1; }
+}
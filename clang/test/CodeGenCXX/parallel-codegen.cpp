@@ -0,0 +1,45 @@
+// Check that -parallel-codegen-output splits the object file into partial
+// objects that keep locals next to their users and define each linkonce
+// function, with its comdat, only once.
+
+// REQUIRES: x86-registered-target
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj \
+// RUN:   -parallel-codegen-output %t/part1.o -o %t/part0.o %s
+// RUN: llvm-nm -A --defined-only %t/part0.o %t/part1.o > %t/defined.txt
+// RUN: FileCheck %s --input-file=%t/defined.txt
+
+// The local stays in the partition of the functions that use it, so llvm-nm
+// lists all three in the same file.
+// CHECK:      [[FILE:[^ ]+]]: {{[0-9a-f]+}} b _ZL7counter
+// CHECK:      [[FILE]]: {{[0-9a-f]+}} T use_a
+// CHECK-NEXT: [[FILE]]: {{[0-9a-f]+}} T use_b
+
+// RUN: grep ' _ZL7counter$' %t/defined.txt | count 1
+// RUN: grep ' twice$' %t/defined.txt | count 1
+// RUN: grep ' W twice$' %t/defined.txt | count 1
+// RUN: llvm-readelf -g %t/part0.o %t/part1.o | grep '\[twice\]' | count 1
+
+// No partition exposes the local.
+// RUN: llvm-nm -A %t/part0.o %t/part1.o \
+// RUN:   | FileCheck %s --check-prefix=GLOBAL
+// GLOBAL-NOT: {{[A-Z]}} _ZL7counter
+
+static int counter;
+
+extern "C" {
+inline int twice(int x) { return 2 * x; }
+
+int use_a() { return twice(++counter); }
+int use_b() { return twice(--counter); }
+
+// Independent functions that SplitModule can put into either partition.
+int f0(int x) { return twice(x) + 0; }
+int f1(int x) { return twice(x) + 1; }
+int f2(int x) { return x + 2; }
+int f3(int x) { return x + 3; }
+int f4(int x) { return x + 4; }
+int f5(int x) { return x + 5; }
+int f6(int x) { return x + 6; }
+int f7(int x) { return x + 7; }
+}
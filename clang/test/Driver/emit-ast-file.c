@@ -0,0 +1,29 @@
+// RUN: %clang -### -c %s --emit-ast-file=%t.ast 2>&1 | FileCheck %s
+// CHECK: "-cc1"
+// CHECK-SAME: "--emit-ast-file={{.*}}.ast"
+
+// Only the compile job is given the file when preprocessed output is kept.
+// RUN: %clang -### -c %s -save-temps --emit-ast-file=%t.ast 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=SAVE-TEMPS
+// SAVE-TEMPS: "-cc1"
+// SAVE-TEMPS-SAME: "-E"
+// SAVE-TEMPS-NOT: "--emit-ast-file
+// SAVE-TEMPS: "-cc1"
+// SAVE-TEMPS-SAME: "--emit-ast-file={{.*}}.ast"
+// SAVE-TEMPS-SAME: "-x" "cpp-output"
+// SAVE-TEMPS-NOT: "--emit-ast-file
+
+// Every compile job would write the same file.
+// RUN: not %clang -### -c %s %s --emit-ast-file=%t.ast 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=MULTIPLE
+// MULTIPLE: error: cannot specify '--emit-ast-file={{.*}}.ast' when compiling multiple source files
+// MULTIPLE-NOT: "--emit-ast-file
+
+// Device compilations of the same source do not write the AST.
+// RUN: %clang -### --target=x86_64-unknown-linux-gnu -x cuda -nocudainc \
+// RUN:   -nocudalib --cuda-gpu-arch=sm_70 -c %s --emit-ast-file=%t.ast 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CUDA
+// CUDA: "-cc1" "-triple" "nvptx64-nvidia-cuda"
+// CUDA-NOT: "--emit-ast-file
+// CUDA: "-cc1" "-triple" "x86_64-unknown-linux-gnu"
+// CUDA-SAME: "--emit-ast-file={{.*}}.ast"
@@ -37,6 +37,9 @@
 // RUN: %clang -### -c -ftime-trace -ftime-trace-granularity=0 -fintegrated-as d/a.cpp -o e/a.o 2>&1 | FileCheck %s --check-prefix=COMPILE1
 // COMPILE1: -cc1{{.*}} "-ftime-trace=e/a.json" "-ftime-trace-granularity=0"
 
+// RUN: %clang -### -c -ftime-trace -ftime-trace-steps d/a.cpp -o e/a.o 2>&1 | FileCheck %s --check-prefix=STEPS
+// STEPS: -cc1{{.*}} "-ftime-trace=e/a.json" "-ftime-trace-steps"
+
 // RUN: %clang -### -c -ftime-trace -ftime-trace-granularity=0 d/a.cpp d/b.c -dumpdir f/ 2>&1 | FileCheck %s --check-prefix=COMPILE2
 // COMPILE2: -cc1{{.*}} "-ftime-trace=f/a.json" "-ftime-trace-granularity=0"
 // COMPILE2: -cc1{{.*}} "-ftime-trace=f/b.json" "-ftime-trace-granularity=0"
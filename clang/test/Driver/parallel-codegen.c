@@ -0,0 +1,23 @@
+// RUN: %clang -### --target=x86_64-unknown-linux -c -fparallel-codegen=3 %s -o %t.o 2>&1 | FileCheck %s
+// RUN: %clang -### --target=x86_64-apple-macos -c -fparallel-codegen=2 %s -o %t.o 2>&1 | FileCheck --check-prefix=DARWIN %s
+// RUN: %clang -### --target=x86_64-unknown-linux -c -fparallel-codegen=1 %s -o %t.o 2>&1 | FileCheck --check-prefix=SERIAL %s
+// RUN: %clang -### --target=x86_64-unknown-linux -S -fparallel-codegen=2 %s -o %t.s 2>&1 | FileCheck --check-prefix=SERIAL %s
+// RUN: not %clang -### --target=x86_64-pc-win32 -c -fparallel-codegen=2 %s 2>&1 | FileCheck --check-prefix=COFF %s
+// RUN: not %clang -### --target=x86_64-unknown-linux -c -gsplit-dwarf -fparallel-codegen=2 %s 2>&1 | FileCheck --check-prefix=SPLIT-DWARF %s
+// RUN: not %clang -### --target=x86_64-unknown-linux -c -fparallel-codegen=x %s 2>&1 | FileCheck --check-prefix=INVALID %s
+
+// CHECK: "-cc1"
+// CHECK-SAME: "-parallel-codegen-output" "[[PART1:[^"]+\.o]]" "-parallel-codegen-output" "[[PART2:[^"]+\.o]]"
+// CHECK-SAME: "-o" "[[PART0:[^"]+\.o]]"
+// CHECK-NEXT: "-r" "-o" "{{.*}}.o" "[[PART0]]" "[[PART1]]" "[[PART2]]"
+
+// DARWIN: "-cc1"
+// DARWIN-SAME: "-parallel-codegen-output"
+// DARWIN-NEXT: "-r" "-o"
+
+// SERIAL-NOT: "-parallel-codegen-output"
+// SERIAL-NOT: "-r"
+
+// COFF: error: unsupported option '-fparallel-codegen=2' for target 'x86_64-pc-windows-msvc'
+// SPLIT-DWARF: error: invalid argument '-fparallel-codegen=2' not allowed with '-gsplit-dwarf'
+// INVALID: error: invalid integral value 'x' in '-fparallel-codegen=x'
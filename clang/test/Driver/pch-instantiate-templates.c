@@ -11,3 +11,7 @@
 
 // GCC_DEFAULT-NOT: "-fpch-instantiate-templates"
 // GCC_DEFAULT_ENABLE: "-fpch-instantiate-templates"
+
+// RUN: %clang -### -c %s -fpch-instantiation-cache=%t/inst.h 2>&1 | FileCheck -check-prefix=CACHE %s
+
+// CACHE: "-fpch-instantiation-cache={{.*}}inst.h"
@@ -0,0 +1,11 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -emit-llvm -o %t/a.ll --emit-ast-file=%t/a.ast %s
+// RUN: FileCheck --check-prefix=IR %s < %t/a.ll
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -ast-print -x ast %t/a.ast | FileCheck %s
+
+// IR: define{{.*}} i32 @f(
+// CHECK: int f(int x) {
+// CHECK-NEXT: return x + 1;
+int f(int x) {
+  return x + 1;
+}
@@ -0,0 +1,39 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %clang_cc1 -std=c++17 -fsyntax-only -ftime-trace=%t/steps.json \
+// RUN:   -ftime-trace-granularity=0 -ftime-trace-steps %s
+// RUN: %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   < %t/steps.json | FileCheck %s
+
+// Without -ftime-trace-steps, no counts are recorded.
+// RUN: %clang_cc1 -std=c++17 -fsyntax-only -ftime-trace=%t/nosteps.json \
+// RUN:   -ftime-trace-granularity=0 %s
+// RUN: %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   < %t/nosteps.json | FileCheck %s --check-prefix=NOSTEPS
+// NOSTEPS-NOT: steps
+
+template <int N> struct Fact {
+  static constexpr int value = N * Fact<N - 1>::value;
+};
+template <> struct Fact<0> { static constexpr int value = 1; };
+static_assert(Fact<5>::value == 120);
+
+// The instantiation of a class template counts at least its own step, and
+// records where its pattern is.
+// CHECK:        "detail": "Fact<1>",
+// CHECK-NEXT:   "file": "{{.*}}ftime-trace-steps.cpp",
+// CHECK-NEXT:   "instantiation steps": {{[1-9][0-9]*}},
+// CHECK-NEXT:   "line": [[#@LINE-11]]
+// CHECK-NEXT: },
+// CHECK-NEXT: "dur":
+// CHECK-NEXT: "name": "InstantiateClass",
+
+// The loop takes more than a hundred constant evaluation steps.
+// CHECK:      "constexpr steps": {{[1-9][0-9][0-9]+}}
+
+constexpr int sum(int N) {
+  int S = 0;
+  for (int I = 0; I < N; ++I)
+    S += I;
+  return S;
+}
+static_assert(sum(100) == 4950);
@@ -0,0 +1,103 @@
+// Check that specializations of templates from modules are found when they
+// are loaded lazily by the hash of their template arguments, including when
+// the same specialization comes from two modules, for partial
+// specializations, and for class-scope specializations with dependent
+// template arguments.
+//
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: %clang_cc1 -std=c++17 -fmodules -fimplicit-module-maps \
+// RUN:   -fmodules-cache-path=%t/cache -I%t -fsyntax-only -verify %t/use.cpp
+
+//--- module.modulemap
+module templates { header "templates.h" export * }
+module a { header "a.h" export * }
+module b { header "b.h" export * }
+
+//--- templates.h
+#ifndef TEMPLATES_H
+#define TEMPLATES_H
+// The primary templates are not usable, so a specialization that is not
+// found makes the lookup fail instead of silently instantiating them.
+template <typename T> struct S;
+template <typename T> constexpr int f() { return T::missing; }
+template <typename T> constexpr int v = T::missing;
+
+template <typename T> struct Box {
+  T Value;
+  constexpr T get() const { return Value; }
+};
+
+// The class-scope specialization has dependent template arguments, so it is
+// recorded with an unknown hash that every lookup loads.
+template <typename U> struct Outer {
+  template <typename T> struct In { static constexpr int value = 0; };
+  template <> struct In<U> { static constexpr int value = 1; };
+};
+#endif
+
+//--- a.h
+#ifndef A_H
+#define A_H
+#include "templates.h"
+template <> struct S<int> { static constexpr int value = 1; };
+template <typename T> struct S<T *> { static constexpr int value = 2; };
+template <> constexpr int f<int>() { return 1; }
+template <> constexpr int v<int> = 1;
+// Unrelated specializations that lookups of the ones above can skip.
+template <> struct S<char> { static constexpr int value = 4; };
+template <> constexpr int f<char>() { return 4; }
+template <> constexpr int v<char> = 4;
+constexpr int useBoxA() { return Box<int>{1}.get(); }
+#endif
+
+//--- b.h
+#ifndef B_H
+#define B_H
+#include "templates.h"
+template <> struct S<int> { static constexpr int value = 1; };
+template <typename T> struct S<T *> { static constexpr int value = 2; };
+template <> constexpr int f<int>() { return 1; }
+template <> constexpr int v<int> = 1;
+template <> struct S<long> { static constexpr int value = 3; };
+template <> constexpr int f<long>() { return 3; }
+template <> constexpr int v<long> = 3;
+// Only ever looked up by redeclaring them.
+template <> struct S<short> { static constexpr int value = 5; };
+template <> constexpr int f<short>() { return 5; }
+template <> constexpr int v<short> = 5;
+constexpr int useBoxB() { return Box<int>{2}.get(); }
+#endif
+
+//--- use.cpp
+#include "a.h"
+#include "b.h"
+
+// Specializations that both modules provide are merged.
+static_assert(S<int>::value == 1);
+static_assert(f<int>() == 1);
+static_assert(v<int> == 1);
+static_assert(useBoxA() + useBoxB() == 3);
+static_assert(Box<int>{3}.get() == 3);
+
+// Specializations that only one of the modules provides.
+static_assert(S<char>::value == 4);
+static_assert(f<char>() == 4);
+static_assert(v<char> == 4);
+static_assert(S<long>::value == 3);
+static_assert(f<long>() == 3);
+static_assert(v<long> == 3);
+
+// Partial specializations are found without looking up a specialization.
+static_assert(S<int *>::value == 2);
+static_assert(S<long *>::value == 2);
+
+static_assert(Outer<int>::In<int>::value == 1);
+static_assert(Outer<int>::In<long>::value == 0);
+
+// Nothing has loaded these specializations yet, so declaring them again only
+// finds the ones from the module through the lookup by hash.
+template <> struct S<short> { static constexpr int value = 5; }; // expected-error {{redefinition}} expected-note@b.h:* {{previous}}
+template <> constexpr int f<short>() { return 5; } // expected-error {{redefinition}} expected-note@b.h:* {{previous}}
+template <> constexpr int v<short> = 5; // expected-error {{redefinition}} expected-note@b.h:* {{previous}}
+template <typename T> struct S<T *> { static constexpr int value = 2; }; // expected-error {{redefinition}} expected-note@* {{previous}}
@@ -0,0 +1,64 @@
+// Check that specializations a chained PCH adds to templates from the PCH it
+// is chained on are found when they are loaded lazily by the hash of their
+// template arguments.
+//
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: %clang_cc1 -std=c++17 -x c++-header -emit-pch -o %t/base.pch \
+// RUN:   %t/base.h
+// RUN: %clang_cc1 -std=c++17 -x c++-header -include-pch %t/base.pch \
+// RUN:   -emit-pch -o %t/chain.pch %t/chain.h
+// RUN: %clang_cc1 -std=c++17 -include-pch %t/chain.pch -I%t -fsyntax-only \
+// RUN:   -verify %t/use.cpp
+
+//--- base.h
+// The primary templates are not usable, so a specialization that is not
+// found makes the lookup fail instead of silently instantiating them.
+template <typename T> struct S;
+template <typename T> constexpr int f() { return T::missing; }
+template <typename T> constexpr int v = T::missing;
+
+template <typename T> struct Box {
+  T Value;
+  constexpr T get() const { return Value; }
+};
+
+template <> struct S<int> { static constexpr int value = 1; };
+template <> constexpr int f<int>() { return 1; }
+template <> constexpr int v<int> = 1;
+template <typename T> struct S<T *> { static constexpr int value = 2; };
+
+//--- chain.h
+// These are recorded as UPD_CXX_ADDED_TEMPLATE_SPECIALIZATION updates of the
+// templates in base.pch.
+template <> struct S<long> { static constexpr int value = 3; };
+template <> constexpr int f<long>() { return 3; }
+template <> constexpr int v<long> = 3;
+template <typename T> struct S<T &> { static constexpr int value = 4; };
+constexpr int useBox() { return Box<char>{1}.get(); }
+
+// Only ever looked up by redeclaring them.
+template <> struct S<short> { static constexpr int value = 5; };
+template <> constexpr int f<short>() { return 5; }
+template <> constexpr int v<short> = 5;
+
+//--- use.cpp
+static_assert(S<int>::value == 1);
+static_assert(f<int>() == 1);
+static_assert(v<int> == 1);
+static_assert(S<long>::value == 3);
+static_assert(f<long>() == 3);
+static_assert(v<long> == 3);
+static_assert(useBox() == 1);
+static_assert(Box<char>{2}.get() == 2);
+
+// Partial specializations from both files are found.
+static_assert(S<int *>::value == 2);
+static_assert(S<int &>::value == 4);
+
+// Nothing has loaded these specializations yet, so declaring them again only
+// finds the ones from the PCH through the lookup by hash.
+template <> struct S<short> { static constexpr int value = 5; }; // expected-error {{redefinition}} expected-note@chain.h:* {{previous}}
+template <> constexpr int f<short>() { return 5; } // expected-error {{redefinition}} expected-note@chain.h:* {{previous}}
+template <> constexpr int v<short> = 5; // expected-error {{redefinition}} expected-note@chain.h:* {{previous}}
+template <typename T> struct S<T &> { static constexpr int value = 4; }; // expected-error {{redefinition}} expected-note@chain.h:* {{previous}}
@@ -0,0 +1,77 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %clang_cc1 -std=c++17 -emit-pch -o %t/base.pch %s
+// RUN: %clang_cc1 -std=c++17 -include-pch %t/base.pch \
+// RUN:   -fpch-instantiation-cache=%t/inst.h -fsyntax-only %s
+// RUN: FileCheck --input-file=%t/inst.h --implicit-check-not=Local %s
+
+// A second user of the PCH does not add duplicates.
+// RUN: %clang_cc1 -std=c++17 -include-pch %t/base.pch \
+// RUN:   -fpch-instantiation-cache=%t/inst.h -fsyntax-only %s
+// RUN: FileCheck --input-file=%t/inst.h --implicit-check-not=Local %s
+
+// Users of a PCH chained on top of the cache find the instantiations there
+// and have nothing left to record.
+// RUN: %clang_cc1 -std=c++17 -x c++-header -include-pch %t/base.pch \
+// RUN:   -emit-pch -o %t/inst.pch %t/inst.h
+// RUN: %clang_cc1 -std=c++17 -include-pch %t/inst.pch \
+// RUN:   -fpch-instantiation-cache=%t/inst2.h -fsyntax-only %s
+// RUN: not ls %t/inst2.h
+
+// Instantiations recorded against a different PCH are dropped, and the
+// cache cannot be chained on top of any other PCH than its own.
+// RUN: %clang_cc1 -std=c++17 -DOTHER -emit-pch -o %t/other.pch %s
+// RUN: cp %t/inst.h %t/other.h
+// RUN: echo 'template int ns::twice<long>(long);' >> %t/other.h
+// RUN: %clang_cc1 -std=c++17 -DOTHER -include-pch %t/other.pch \
+// RUN:   -fpch-instantiation-cache=%t/other.h -fsyntax-only %s
+// RUN: FileCheck --input-file=%t/other.h --implicit-check-not=Local \
+// RUN:   --implicit-check-not=long %s
+// RUN: not diff %t/inst.h %t/other.h
+// RUN: not %clang_cc1 -std=c++17 -DOTHER -x c++-header \
+// RUN:   -include-pch %t/other.pch -emit-pch -o %t/bad.pch %t/inst.h 2>&1 \
+// RUN:   | FileCheck --check-prefix=MISMATCH %s
+// RUN: not %clang_cc1 -std=c++17 -x c++-header -emit-pch -o %t/bad.pch \
+// RUN:   %t/inst.h 2>&1 | FileCheck --check-prefix=NO-PCH %s
+
+#ifndef HEADER
+#define HEADER
+
+namespace ns {
+struct Foo { int X; };
+
+template <typename T> struct Box {
+  T Value;
+  Box(T V) : Value(V) {}
+  T get() const { return Value; }
+};
+
+template <typename T> T twice(T V) { return V + V; }
+} // namespace ns
+
+#ifdef OTHER
+struct Other {};
+#endif
+
+#else
+
+namespace {
+struct Local { int X; };
+} // namespace
+
+int use() {
+  ns::Box<ns::Foo> B(ns::Foo{1});
+  ns::Box<Local> L(Local{2});
+  return B.get().X + ns::twice(3) + L.get().X;
+}
+
+// The recorded instantiations follow the hash of the PCH, sorted.
+// CHECK:      // clang-pch-instantiation-cache: {{[0-9a-f]{16}$}}
+// CHECK-NEXT: template int ns::twice<int>(int);
+// CHECK-NEXT: template ns::Box<ns::Foo>::Box(ns::Foo);
+// CHECK-NEXT: template ns::Foo ns::Box<ns::Foo>::get() const;
+// CHECK-EMPTY:
+
+// MISMATCH: inst.h:1:1: error: template instantiation cache was recorded against a different PCH than '{{.*}}other.pch'
+// NO-PCH: inst.h:1:1: error: template instantiation cache must be built on top of the PCH it was recorded against
+
+#endif
@@ -16,8 +16,12 @@
 #include "clang/Tooling/DependencyScanning/DependencyScanningWorker.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Errno.h"
 #include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
@@ -33,6 +37,13 @@
 #include <optional>
 #include <thread>
 
+#ifdef LLVM_ON_UNIX
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #include "Opts.inc"
 
 using namespace clang;
@@ -78,6 +89,12 @@ static ScanningOutputFormat Format = ScanningOutputFormat::Make;
 static std::string ModuleFilesDir;
 static bool OptimizeArgs;
 static bool EagerLoadModules;
+static std::string DirectivesCachePath;
+static llvm::CachePruningPolicy DirectivesCachePolicy;
+static std::string ServerSocketPath;
+static std::string ConnectSocketPath;
+static std::vector<std::string> ChangedFiles;
+static bool ShutdownServer;
 static unsigned NumThreads = 0;
 static std::string CompilationDB;
 static std::string ModuleName;
@@ -154,6 +171,28 @@ static void ParseArgs(int argc, char **argv) {
   OptimizeArgs = Args.hasArg(OPT_optimize_args);
   EagerLoadModules = Args.hasArg(OPT_eager_load_pcm);
 
+  if (const llvm::opt::Arg *A = Args.getLastArg(OPT_directives_cache_path_EQ))
+    DirectivesCachePath = A->getValue();
+
+  if (const llvm::opt::Arg *A =
+          Args.getLastArg(OPT_directives_cache_policy_EQ)) {
+    auto Policy = llvm::parseCachePruningPolicy(A->getValue());
+    if (!Policy) {
+      llvm::errs() << ToolName << ": for the --directives-cache-policy option: "
+                   << llvm::toString(Policy.takeError()) << "\n";
+      std::exit(1);
+    }
+    DirectivesCachePolicy = *Policy;
+  }
+
+  if (const llvm::opt::Arg *A = Args.getLastArg(OPT_server_EQ))
+    ServerSocketPath = A->getValue();
+  if (const llvm::opt::Arg *A = Args.getLastArg(OPT_connect_EQ))
+    ConnectSocketPath = A->getValue();
+  for (const llvm::opt::Arg *A : Args.filtered(OPT_changed_file_EQ))
+    ChangedFiles.emplace_back(A->getValue());
+  ShutdownServer = Args.hasArg(OPT_shutdown_server);
+
   if (const llvm::opt::Arg *A = Args.getLastArg(OPT_j)) {
     StringRef S{A->getValue()};
     if (!llvm::to_integer(S, NumThreads, 0)) {
@@ -165,7 +204,8 @@ static void ParseArgs(int argc, char **argv) {
 
   if (const llvm::opt::Arg *A = Args.getLastArg(OPT_compilation_database_EQ)) {
     CompilationDB = A->getValue();
-  } else if (Format != ScanningOutputFormat::P1689) {
+  } else if (Format != ScanningOutputFormat::P1689 &&
+             ConnectSocketPath.empty()) {
     llvm::errs() << ToolName
                  << ": for the --compiilation-database option: must be "
                     "specified at least once!";
@@ -175,6 +215,16 @@ static void ParseArgs(int argc, char **argv) {
   if (const llvm::opt::Arg *A = Args.getLastArg(OPT_module_name_EQ))
     ModuleName = A->getValue();
 
+  if (!ServerSocketPath.empty() &&
+      (CompilationDB.empty() || Format == ScanningOutputFormat::P1689 ||
+       !ModuleName.empty())) {
+    llvm::errs() << ToolName
+                 << ": the --server option requires --compilation-database "
+                    "and supports neither the p1689 format nor "
+                    "--module-name\n";
+    std::exit(1);
+  }
+
   for (const llvm::opt::Arg *A : Args.filtered(OPT_dependency_target_EQ))
     ModuleDepTargets.emplace_back(A->getValue());
 
@@ -668,9 +718,6 @@ static std::string getModuleCachePath(ArrayRef<std::string> Args) {
 // form specified command line after the positional parameter "--".
 static std::unique_ptr<tooling::CompilationDatabase>
 getCompilationDataBase(int argc, char **argv, std::string &ErrorMessage) {
-  llvm::InitLLVM X(argc, argv);
-  ParseArgs(argc, argv);
-
   if (!CompilationDB.empty())
     return tooling::JSONCompilationDatabase::loadFromFile(
         CompilationDB, ErrorMessage,
@@ -756,22 +803,14 @@ getCompilationDataBase(int argc, char **argv, std::string &ErrorMessage) {
       FEOpts.Inputs[0].getFile(), OutputFile, CommandLine);
 }
 
-int clang_scan_deps_main(int argc, char **argv, const llvm::ToolContext &) {
-  std::string ErrorMessage;
-  std::unique_ptr<tooling::CompilationDatabase> Compilations =
-      getCompilationDataBase(argc, argv, ErrorMessage);
-  if (!Compilations) {
-    llvm::errs() << ErrorMessage << "\n";
-    return 1;
-  }
-
-  llvm::cl::PrintOptionValues();
-
-  // The command options are rewritten to run Clang in preprocessor only mode.
+/// Rewrites the command lines of \p Compilations to run Clang in preprocessor
+/// only mode. \p ResourceDirCache must outlive the result.
+static std::unique_ptr<tooling::ArgumentsAdjustingCompilations>
+adjustCompilations(std::unique_ptr<tooling::CompilationDatabase> Compilations,
+                   ResourceDirectoryCache &ResourceDirCache) {
   auto AdjustingCompilations =
       std::make_unique<tooling::ArgumentsAdjustingCompilations>(
           std::move(Compilations));
-  ResourceDirectoryCache ResourceDirCache;
 
   AdjustingCompilations->appendArgumentsAdjuster(
       [&ResourceDirCache](const tooling::CommandLineArguments &Args,
@@ -831,6 +870,477 @@ int clang_scan_deps_main(int argc, char **argv, const llvm::ToolContext &) {
         AdjustedArgs.insert(AdjustedArgs.end(), FlagsEnd, Args.end());
         return AdjustedArgs;
       });
+  return AdjustingCompilations;
+}
+
+namespace {
+/// The result of scanning one compile command, kept by the server to answer
+/// later requests without scanning the command again.
+struct CachedScanResult {
+  /// The dependency file, for the make format.
+  std::string MakeOutput;
+  /// The dependencies, for the full format.
+  std::optional<TranslationUnitDeps> TUDeps;
+  /// The diagnostics if the scan failed.
+  std::string Errors;
+  /// The absolute paths of all files the result was computed from.
+  std::vector<std::string> Inputs;
+};
+
+/// The state of an input on disk when it was last scanned.
+struct InputStamp {
+  llvm::sys::TimePoint<> ModificationTime;
+  uint64_t Size = 0;
+  bool Exists = false;
+
+  static InputStamp get(StringRef Path) {
+    InputStamp Stamp;
+    llvm::sys::fs::file_status Status;
+    if (!llvm::sys::fs::status(Path, Status)) {
+      Stamp.ModificationTime = Status.getLastModificationTime();
+      Stamp.Size = Status.getSize();
+      Stamp.Exists = true;
+    }
+    return Stamp;
+  }
+
+  bool operator!=(const InputStamp &Other) const {
+    return std::tie(ModificationTime, Size, Exists) !=
+           std::tie(Other.ModificationTime, Other.Size, Other.Exists);
+  }
+};
+
+/// Answers the scan requests of a server. The service, its shared file system
+/// cache and the results of previous scans stay warm across requests, and only
+/// the compile commands whose inputs changed since are scanned again.
+class ScanServer {
+public:
+  ScanServer(DependencyScanningService &Service,
+             ResourceDirectoryCache &ResourceDirCache)
+      : Service(Service), ResourceDirCache(ResourceDirCache),
+        Pool(llvm::hardware_concurrency(NumThreads)) {}
+
+  /// Reloads the compilation database, rescans what is out of date and returns
+  /// the response to \p Request.
+  llvm::json::Object handleRequest(const llvm::json::Object &Request);
+
+private:
+  static std::string getCommandKey(const tooling::CompileCommand &Cmd) {
+    std::string Key = Cmd.Directory;
+    Key += '\0';
+    Key += Cmd.Filename;
+    for (const std::string &Arg : Cmd.CommandLine) {
+      Key += '\0';
+      Key += Arg;
+    }
+    return Key;
+  }
+
+  static std::string makeAbsolute(StringRef Path, StringRef CWD) {
+    SmallString<256> AbsPath(Path);
+    llvm::sys::fs::make_absolute(CWD, AbsPath);
+    llvm::sys::path::remove_dots(AbsPath, /*remove_dot_dot=*/true);
+    return std::string(AbsPath);
+  }
+
+  static CachedScanResult scan(DependencyScanningTool &Tool,
+                               const tooling::CompileCommand &Cmd);
+
+  DependencyScanningService &Service;
+  ResourceDirectoryCache &ResourceDirCache;
+  llvm::ThreadPool Pool;
+  /// The results of the last scan of each compile command.
+  llvm::StringMap<CachedScanResult> Results;
+  /// The state of every input of \c Results when it was scanned.
+  llvm::StringMap<InputStamp> Stamps;
+};
+} // end anonymous namespace
+
+CachedScanResult ScanServer::scan(DependencyScanningTool &Tool,
+                                  const tooling::CompileCommand &Cmd) {
+  CachedScanResult Result;
+  auto SetErrors = [&](llvm::Error E) {
+    llvm::raw_string_ostream OS(Result.Errors);
+    OS << "Error while scanning dependencies for " << Cmd.Filename << ":\n";
+    OS << llvm::toString(std::move(E));
+  };
+
+  if (Format == ScanningOutputFormat::Make) {
+    std::vector<std::string> FileDeps;
+    auto MaybeFile =
+        Tool.getDependencyFile(Cmd.CommandLine, Cmd.Directory, FileDeps);
+    if (!MaybeFile) {
+      SetErrors(MaybeFile.takeError());
+      return Result;
+    }
+    Result.MakeOutput = std::move(*MaybeFile);
+    for (const std::string &Dep : FileDeps)
+      Result.Inputs.push_back(makeAbsolute(Dep, Cmd.Directory));
+    return Result;
+  }
+
+  std::string OutputDir(ModuleFilesDir);
+  if (OutputDir.empty())
+    OutputDir = getModuleCachePath(Cmd.CommandLine);
+  auto LookupOutput = [&](const ModuleID &MID, ModuleOutputKind MOK) {
+    return ::lookupModuleOutput(MID, MOK, OutputDir);
+  };
+  // Every result carries its whole module graph, so that it can be reused
+  // independently of the results it was scanned together with.
+  llvm::DenseSet<ModuleID> AlreadySeenModules;
+  auto MaybeTUDeps = Tool.getTranslationUnitDependencies(
+      Cmd.CommandLine, Cmd.Directory, AlreadySeenModules, LookupOutput);
+  if (!MaybeTUDeps) {
+    SetErrors(MaybeTUDeps.takeError());
+    return Result;
+  }
+  for (const std::string &Dep : MaybeTUDeps->FileDeps)
+    Result.Inputs.push_back(makeAbsolute(Dep, Cmd.Directory));
+  for (const ModuleDeps &MD : MaybeTUDeps->ModuleGraph) {
+    for (const auto &Dep : MD.FileDeps)
+      Result.Inputs.push_back(makeAbsolute(Dep.getKey(), Cmd.Directory));
+    for (const std::string &Dep : MD.ModuleMapFileDeps)
+      Result.Inputs.push_back(makeAbsolute(Dep, Cmd.Directory));
+  }
+  Result.TUDeps = std::move(*MaybeTUDeps);
+  return Result;
+}
+
+llvm::json::Object
+ScanServer::handleRequest(const llvm::json::Object &Request) {
+  std::string ErrorMessage;
+  std::unique_ptr<tooling::CompilationDatabase> Compilations =
+      tooling::JSONCompilationDatabase::loadFromFile(
+          CompilationDB, ErrorMessage,
+          tooling::JSONCommandLineSyntax::AutoDetect);
+  if (!Compilations)
+    return llvm::json::Object{{"errors", ErrorMessage + "\n"}, {"status", 1}};
+  std::vector<tooling::CompileCommand> Inputs =
+      adjustCompilations(std::move(Compilations), ResourceDirCache)
+          ->getAllCompileCommands();
+
+  llvm::Timer T;
+  T.startTimer();
+
+  // Find the inputs that changed since the last request, both the ones the
+  // client reports and the ones whose state on disk differs.
+  llvm::StringSet<> Changed;
+  bool ChangedUnknownFile = false;
+  for (const auto &Entry : Stamps)
+    if (InputStamp::get(Entry.getKey()) != Entry.getValue())
+      Changed.insert(Entry.getKey());
+  if (const llvm::json::Array *Files = Request.getArray("changed-files")) {
+    for (const llvm::json::Value &File : *Files) {
+      std::optional<StringRef> Path = File.getAsString();
+      if (!Path)
+        continue;
+      Changed.insert(*Path);
+      // A file no result depends on may be a new file that shadows an input
+      // of any command, so everything needs to be scanned again.
+      if (!Stamps.count(*Path))
+        ChangedUnknownFile = true;
+    }
+  }
+
+  std::vector<std::string> StaleFiles;
+  for (const auto &Entry : Changed)
+    StaleFiles.push_back(Entry.getKey().str());
+  Service.getSharedCache().invalidate(StaleFiles,
+                                      *llvm::vfs::getRealFileSystem());
+  if (ChangedUnknownFile)
+    Service.getSharedCache().invalidateMissingFiles();
+
+  std::vector<std::string> Keys;
+  std::vector<size_t> ToScan;
+  for (size_t I = 0, E = Inputs.size(); I != E; ++I) {
+    Keys.push_back(getCommandKey(Inputs[I]));
+    auto It = Results.find(Keys.back());
+    if (ChangedUnknownFile || It == Results.end() ||
+        !It->second.Errors.empty() ||
+        llvm::any_of(It->second.Inputs, [&](const std::string &Input) {
+          return Changed.contains(Input);
+        }))
+      ToScan.push_back(I);
+  }
+
+  // Fresh workers start with empty local caches, which could otherwise hold
+  // entries that were just invalidated.
+  std::vector<std::unique_ptr<DependencyScanningTool>> WorkerTools;
+  for (unsigned I = 0; I < Pool.getThreadCount(); ++I)
+    WorkerTools.push_back(std::make_unique<DependencyScanningTool>(Service));
+
+  std::vector<CachedScanResult> NewResults(ToScan.size());
+  std::atomic<size_t> Index(0);
+  for (unsigned I = 0; I < Pool.getThreadCount(); ++I) {
+    Pool.async([&, I]() {
+      for (size_t LocalIndex = Index++; LocalIndex < ToScan.size();
+           LocalIndex = Index++)
+        NewResults[LocalIndex] =
+            scan(*WorkerTools[I], Inputs[ToScan[LocalIndex]]);
+    });
+  }
+  Pool.wait();
+
+  llvm::StringMap<CachedScanResult> OldResults = std::move(Results);
+  Results.clear();
+  for (size_t I = 0, E = ToScan.size(); I != E; ++I)
+    Results[Keys[ToScan[I]]] = std::move(NewResults[I]);
+  for (const std::string &Key : Keys)
+    if (!Results.count(Key))
+      Results[Key] = std::move(OldResults[Key]);
+
+  llvm::StringMap<InputStamp> OldStamps = std::move(Stamps);
+  Stamps.clear();
+  for (const auto &Entry : Results) {
+    for (const std::string &Input : Entry.getValue().Inputs) {
+      if (Stamps.count(Input))
+        continue;
+      auto It = OldStamps.find(Input);
+      Stamps[Input] = It != OldStamps.end() && !Changed.contains(Input)
+                          ? It->second
+                          : InputStamp::get(Input);
+    }
+  }
+
+  std::string Output;
+  std::string Errors;
+  llvm::raw_string_ostream OS(Output);
+  llvm::raw_string_ostream ErrOS(Errors);
+  bool HadErrors = false;
+  std::optional<FullDeps> FD;
+  if (Format == ScanningOutputFormat::Full)
+    FD.emplace(Inputs.size());
+  for (size_t I = 0, E = Inputs.size(); I != E; ++I) {
+    const CachedScanResult &Result = Results[Keys[I]];
+    if (!Result.Errors.empty()) {
+      ErrOS << Result.Errors;
+      HadErrors = true;
+    } else if (FD) {
+      FD->mergeDeps(Inputs[I].Filename, *Result.TUDeps, I);
+    } else {
+      OS << Result.MakeOutput;
+    }
+  }
+  if (FD) {
+    if (RoundTripArgs && FD->roundTripCommands(ErrOS))
+      HadErrors = true;
+    FD->printFullOutput(OS);
+  }
+
+  T.stopTimer();
+  if (Verbose)
+    llvm::errs() << "clang-scan-deps server: rescanned " << ToScan.size()
+                 << " of " << Inputs.size() << " files\n";
+  if (PrintTiming)
+    llvm::errs() << llvm::format(
+        "clang-scan-deps timing: %0.2fs wall, %0.2fs process\n",
+        T.getTotalTime().getWallTime(), T.getTotalTime().getProcessTime());
+
+  OS.flush();
+  ErrOS.flush();
+  return llvm::json::Object{{"output", std::move(Output)},
+                            {"errors", std::move(Errors)},
+                            {"status", HadErrors ? 1 : 0},
+                            {"rescanned", static_cast<int64_t>(ToScan.size())}};
+}
+
+#ifdef LLVM_ON_UNIX
+static bool readAll(int FD, std::string &Data) {
+  char Buffer[4096];
+  while (true) {
+    ssize_t BytesRead =
+        llvm::sys::RetryAfterSignal(-1, ::read, FD, Buffer, sizeof(Buffer));
+    if (BytesRead < 0)
+      return false;
+    if (BytesRead == 0)
+      return true;
+    Data.append(Buffer, BytesRead);
+  }
+}
+
+static bool writeAll(int FD, StringRef Data) {
+  while (!Data.empty()) {
+    ssize_t BytesWritten = llvm::sys::RetryAfterSignal(
+        -1, ::write, FD, Data.data(), Data.size());
+    if (BytesWritten < 0)
+      return false;
+    Data = Data.drop_front(BytesWritten);
+  }
+  return true;
+}
+
+static bool getSocketAddress(StringRef Path, sockaddr_un &Addr) {
+  if (Path.size() >= sizeof(Addr.sun_path)) {
+    llvm::errs() << "socket path is too long: " << Path << "\n";
+    return false;
+  }
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  return true;
+}
+#endif
+
+/// Runs the server on \c ServerSocketPath until a client asks it to exit. A
+/// request is a JSON object whose optional "changed-files" array lists files
+/// the client knows changed and whose optional "shutdown" member asks the
+/// server to exit. It is answered with a JSON object carrying the "output",
+/// "errors" and exit "status" of the scan. Requests are served one at a time.
+static int runServer(DependencyScanningService &Service,
+                     ResourceDirectoryCache &ResourceDirCache) {
+#ifdef LLVM_ON_UNIX
+  sockaddr_un Addr;
+  if (!getSocketAddress(ServerSocketPath, Addr))
+    return 1;
+  int ListenFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (ListenFD < 0) {
+    llvm::errs() << "failed to create socket: "
+                 << llvm::sys::StrError(errno) << "\n";
+    return 1;
+  }
+  // Replace the socket a previous server left behind.
+  ::unlink(ServerSocketPath.c_str());
+  if (::bind(ListenFD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) ||
+      ::listen(ListenFD, SOMAXCONN)) {
+    llvm::errs() << "failed to listen on " << ServerSocketPath << ": "
+                 << llvm::sys::StrError(errno) << "\n";
+    ::close(ListenFD);
+    return 1;
+  }
+  // Don't die when a client goes away before reading its response.
+  ::signal(SIGPIPE, SIG_IGN);
+
+  ScanServer Server(Service, ResourceDirCache);
+  bool Shutdown = false;
+  int Status = 0;
+  while (!Shutdown) {
+    int FD = llvm::sys::RetryAfterSignal(-1, ::accept, ListenFD, nullptr,
+                                         nullptr);
+    if (FD < 0) {
+      llvm::errs() << "failed to accept a connection: "
+                   << llvm::sys::StrError(errno) << "\n";
+      Status = 1;
+      break;
+    }
+
+    std::string RequestText;
+    llvm::json::Object Response;
+    if (!readAll(FD, RequestText)) {
+      ::close(FD);
+      continue;
+    }
+    llvm::Expected<llvm::json::Value> Request =
+        llvm::json::parse(RequestText);
+    if (!Request) {
+      Response = llvm::json::Object{
+          {"errors", llvm::toString(Request.takeError()) + "\n"},
+          {"status", 1}};
+    } else if (const llvm::json::Object *Obj = Request->getAsObject()) {
+      Shutdown = Obj->getBoolean("shutdown").value_or(false);
+      Response = Shutdown ? llvm::json::Object{{"status", 0}}
+                          : Server.handleRequest(*Obj);
+    } else {
+      Response = llvm::json::Object{{"errors", "expected a JSON object\n"},
+                                    {"status", 1}};
+    }
+    writeAll(FD, llvm::formatv("{0}", llvm::json::Value(std::move(Response)))
+                     .str());
+    ::close(FD);
+  }
+
+  ::close(ListenFD);
+  ::unlink(ServerSocketPath.c_str());
+  return Status;
+#else
+  llvm::errs() << "the --server option is not supported on this platform\n";
+  return 1;
+#endif
+}
+
+/// Sends a request to the server on \c ConnectSocketPath and prints its
+/// response as if the scan had happened in this process.
+static int connectToServer() {
+#ifdef LLVM_ON_UNIX
+  sockaddr_un Addr;
+  if (!getSocketAddress(ConnectSocketPath, Addr))
+    return 1;
+  int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (FD < 0 || ::connect(FD, reinterpret_cast<sockaddr *>(&Addr),
+                          sizeof(Addr))) {
+    llvm::errs() << "failed to connect to " << ConnectSocketPath << ": "
+                 << llvm::sys::StrError(errno) << "\n";
+    if (FD >= 0)
+      ::close(FD);
+    return 1;
+  }
+
+  // The server identifies inputs by their absolute paths.
+  llvm::json::Array Files;
+  for (const std::string &File : ChangedFiles) {
+    SmallString<256> Path(File);
+    llvm::sys::fs::make_absolute(Path);
+    llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+    Files.push_back(std::string(Path));
+  }
+  llvm::json::Object Request{{"changed-files", std::move(Files)}};
+  if (ShutdownServer)
+    Request["shutdown"] = true;
+
+  std::string ResponseText;
+  bool Sent = writeAll(FD, llvm::formatv("{0}", llvm::json::Value(
+                                                    std::move(Request)))
+                               .str());
+  // Signal the end of the request to the server.
+  ::shutdown(FD, SHUT_WR);
+  bool Received = Sent && readAll(FD, ResponseText);
+  ::close(FD);
+  if (!Received) {
+    llvm::errs() << "failed to communicate with the server on "
+                 << ConnectSocketPath << "\n";
+    return 1;
+  }
+
+  llvm::Expected<llvm::json::Value> Response = llvm::json::parse(ResponseText);
+  const llvm::json::Object *Obj = Response ? Response->getAsObject() : nullptr;
+  if (!Obj) {
+    if (!Response)
+      llvm::consumeError(Response.takeError());
+    llvm::errs() << "malformed response from the server on "
+                 << ConnectSocketPath << "\n";
+    return 1;
+  }
+  if (std::optional<StringRef> Output = Obj->getString("output"))
+    llvm::outs() << *Output;
+  if (std::optional<StringRef> Errors = Obj->getString("errors"))
+    llvm::errs() << *Errors;
+  return Obj->getInteger("status").value_or(1) != 0;
+#else
+  llvm::errs() << "the --connect option is not supported on this platform\n";
+  return 1;
+#endif
+}
+
+int clang_scan_deps_main(int argc, char **argv, const llvm::ToolContext &) {
+  llvm::InitLLVM X(argc, argv);
+  ParseArgs(argc, argv);
+
+  if (!ConnectSocketPath.empty())
+    return connectToServer();
+
+  std::string ErrorMessage;
+  std::unique_ptr<tooling::CompilationDatabase> Compilations =
+      getCompilationDataBase(argc, argv, ErrorMessage);
+  if (!Compilations) {
+    llvm::errs() << ErrorMessage << "\n";
+    return 1;
+  }
+
+  llvm::cl::PrintOptionValues();
+
+  // The command options are rewritten to run Clang in preprocessor only mode.
+  ResourceDirectoryCache ResourceDirCache;
+  auto AdjustingCompilations =
+      adjustCompilations(std::move(Compilations), ResourceDirCache);
 
   SharedStream Errs(llvm::errs());
   // Print out the dependency results to STDOUT by default.
@@ -838,6 +1348,14 @@ int clang_scan_deps_main(int argc, char **argv, const llvm::ToolContext &) {
 
   DependencyScanningService Service(ScanMode, Format, OptimizeArgs,
                                     EagerLoadModules);
+  if (!DirectivesCachePath.empty())
+    Service.getSharedCache().setDiskCache(
+        std::make_unique<DependencyDirectivesDiskCache>(DirectivesCachePath,
+                                                        DirectivesCachePolicy));
+
+  if (!ServerSocketPath.empty())
+    return runServer(Service, ResourceDirCache);
+
   llvm::ThreadPool Pool(llvm::hardware_concurrency(NumThreads));
   std::vector<std::unique_ptr<DependencyScanningTool>> WorkerTools;
   for (unsigned I = 0; I < Pool.getThreadCount(); ++I)
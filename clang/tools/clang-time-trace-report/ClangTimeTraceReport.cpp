@@ -0,0 +1,373 @@
+//===-- clang-time-trace-report/ClangTimeTraceReport.cpp ------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool aggregates the -ftime-trace output of every translation unit of a
+// build. Time is attributed to what each event describes (e.g. the qualified
+// name of an instantiated template and its source location) rather than to the
+// translation unit, so the cost of a header-heavy template that is
+// instantiated in many translation units shows up as a single entry.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Version.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/WithColor.h"
+
+using namespace llvm;
+
+static cl::opt<bool> Help("h", cl::desc("Alias for -help"), cl::Hidden);
+
+static cl::OptionCategory
+    TimeTraceReportCategory("clang-time-trace-report options");
+
+static cl::list<std::string>
+    InputPaths(cl::Positional, cl::OneOrMore,
+               cl::desc("<time trace file or directory...>"),
+               cl::cat(TimeTraceReportCategory));
+
+static cl::list<std::string>
+    EventNames("event",
+               cl::desc("Only report events with this name, e.g. "
+                        "'InstantiateFunction'. May be repeated."),
+               cl::value_desc("name"), cl::cat(TimeTraceReportCategory));
+
+static cl::opt<unsigned> Top("top",
+                             cl::desc("Number of entries to report (0 for "
+                                      "all)"),
+                             cl::init(20), cl::cat(TimeTraceReportCategory));
+
+enum SortKind { SK_Self, SK_Total, SK_Count };
+static cl::opt<SortKind> SortBy(
+    "sort", cl::desc("Order entries by"), cl::init(SK_Self),
+    cl::values(clEnumValN(SK_Self, "self", "Time excluding nested events"),
+               clEnumValN(SK_Total, "total", "Time including nested events"),
+               clEnumValN(SK_Count, "count", "Number of occurrences")),
+    cl::cat(TimeTraceReportCategory));
+
+static cl::opt<bool> EmitJSON("json", cl::desc("Write the report as JSON"),
+                              cl::cat(TimeTraceReportCategory));
+
+static StringRef ToolName;
+
+static void PrintVersion(raw_ostream &OS) {
+  OS << clang::getClangToolFullVersion("clang-time-trace-report") << '\n';
+}
+
+namespace {
+
+/// A complete ("ph":"X") event read from a trace file.
+struct TraceEvent {
+  StringRef Name;
+  StringRef Detail;
+  StringRef File;
+  int64_t Line = 0;
+  int64_t Tid = 0;
+  int64_t Start = 0;
+  int64_t Dur = 0;
+  // Step counters recorded with -ftime-trace-steps.
+  SmallVector<std::pair<StringRef, uint64_t>, 2> Counts;
+};
+
+/// The aggregated cost of everything matching one (name, detail) pair.
+struct ReportEntry {
+  std::string Name;
+  std::string Detail;
+  std::string File;
+  int64_t Line = 0;
+  uint64_t Count = 0;
+  uint64_t NumTUs = 0;
+  int64_t SelfUs = 0;
+  int64_t TotalUs = 0;
+  StringMap<uint64_t> Counts;
+};
+
+/// Entries in the order of their first occurrence, with an index by name and
+/// detail.
+struct Report {
+  std::vector<ReportEntry> Entries;
+  StringMap<size_t> Index;
+
+  /// Returns the entry for \p Name and \p Detail, creating it if needed.
+  ReportEntry &getEntry(StringRef Name, StringRef Detail) {
+    std::string Key = Name.str();
+    Key += '\0';
+    Key += Detail;
+    auto [It, Inserted] = Index.try_emplace(Key, Entries.size());
+    if (Inserted) {
+      Entries.emplace_back();
+      Entries.back().Name = Name.str();
+      Entries.back().Detail = Detail.str();
+    }
+    return Entries[It->second];
+  }
+
+  /// Adds the entries of the report of another translation unit.
+  void merge(Report &&Other) {
+    for (ReportEntry &From : Other.Entries) {
+      ReportEntry &R = getEntry(From.Name, From.Detail);
+      if (R.File.empty() && !From.File.empty()) {
+        R.File = std::move(From.File);
+        R.Line = From.Line;
+      }
+      R.Count += From.Count;
+      R.NumTUs += From.NumTUs;
+      R.SelfUs += From.SelfUs;
+      R.TotalUs += From.TotalUs;
+      for (const auto &Count : From.Counts)
+        R.Counts[Count.getKey()] += Count.getValue();
+    }
+  }
+};
+
+} // namespace
+
+static bool isSelected(StringRef Name) {
+  return EventNames.empty() || llvm::is_contained(EventNames, Name);
+}
+
+/// Reads the trace file \p Path and aggregates its events into \p TU. Only
+/// the aggregated entries outlive this function, so the memory for the parsed
+/// file is released as soon as it has been summarized.
+static Error readTrace(StringRef Path, Report &TU) {
+  auto BufferOrErr = MemoryBuffer::getFile(Path);
+  if (!BufferOrErr)
+    return createFileError(Path, BufferOrErr.getError());
+
+  Expected<json::Value> Root = json::parse((*BufferOrErr)->getBuffer());
+  if (!Root)
+    return createFileError(Path, Root.takeError());
+
+  const json::Object *Obj = Root->getAsObject();
+  const json::Array *TraceEvents =
+      Obj ? Obj->getArray("traceEvents") : nullptr;
+  if (!TraceEvents)
+    return createFileError(Path, createStringError(inconvertibleErrorCode(),
+                                                   "not a time trace file"));
+
+  std::vector<TraceEvent> Events;
+  for (const json::Value &V : *TraceEvents) {
+    const json::Object *E = V.getAsObject();
+    if (!E || E->getString("ph") != StringRef("X"))
+      continue;
+    TraceEvent Event;
+    Event.Name = E->getString("name").value_or("");
+    Event.Tid = E->getInteger("tid").value_or(0);
+    Event.Start = E->getInteger("ts").value_or(0);
+    Event.Dur = E->getInteger("dur").value_or(0);
+    // The "Total" events are per-name summaries written by the profiler.
+    if (Event.Name.startswith("Total "))
+      continue;
+    if (const json::Object *Args = E->getObject("args")) {
+      for (const auto &[Key, Arg] : *Args) {
+        if (Key == "detail")
+          Event.Detail = Arg.getAsString().value_or("");
+        else if (Key == "file")
+          Event.File = Arg.getAsString().value_or("");
+        else if (Key == "line")
+          Event.Line = Arg.getAsInteger().value_or(0);
+        else if (std::optional<int64_t> N = Arg.getAsInteger())
+          Event.Counts.emplace_back(Key, *N);
+      }
+    }
+    Events.push_back(std::move(Event));
+  }
+
+  // Compute self times from the nesting of the events on each thread. Events
+  // are sorted so that a parent comes before the events nested in it.
+  llvm::stable_sort(Events, [](const TraceEvent &A, const TraceEvent &B) {
+    return std::make_tuple(A.Tid, A.Start, -A.Dur) <
+           std::make_tuple(B.Tid, B.Start, -B.Dur);
+  });
+  std::vector<int64_t> SelfUs(Events.size());
+  // Whether an event is nested in another event with the same key; such
+  // events do not add to the total time to avoid counting it twice.
+  std::vector<bool> Recursive(Events.size());
+  SmallVector<size_t, 32> Stack;
+  for (size_t I = 0, E = Events.size(); I != E; ++I) {
+    const TraceEvent &Event = Events[I];
+    while (!Stack.empty()) {
+      const TraceEvent &Top = Events[Stack.back()];
+      if (Top.Tid == Event.Tid && Event.Start < Top.Start + Top.Dur)
+        break;
+      Stack.pop_back();
+    }
+    SelfUs[I] = Event.Dur;
+    if (!Stack.empty())
+      SelfUs[Stack.back()] -= Event.Dur;
+    Recursive[I] = llvm::any_of(Stack, [&](size_t Parent) {
+      return Events[Parent].Name == Event.Name &&
+             Events[Parent].Detail == Event.Detail;
+    });
+    Stack.push_back(I);
+  }
+
+  for (size_t I = 0, E = Events.size(); I != E; ++I) {
+    const TraceEvent &Event = Events[I];
+    if (!isSelected(Event.Name))
+      continue;
+    ReportEntry &R = TU.getEntry(Event.Name, Event.Detail);
+    if (R.File.empty() && !Event.File.empty()) {
+      R.File = Event.File.str();
+      R.Line = Event.Line;
+    }
+    ++R.Count;
+    R.NumTUs = 1;
+    R.SelfUs += SelfUs[I];
+    if (!Recursive[I])
+      R.TotalUs += Event.Dur;
+    for (const auto &[Name, N] : Event.Counts)
+      R.Counts[Name] += N;
+  }
+  return Error::success();
+}
+
+static Error collectInputs(std::vector<std::string> &Files) {
+  for (const std::string &Path : InputPaths) {
+    if (!sys::fs::is_directory(Path)) {
+      Files.push_back(Path);
+      continue;
+    }
+    std::error_code EC;
+    size_t NumFiles = Files.size();
+    for (sys::fs::recursive_directory_iterator It(Path, EC), End;
+         It != End && !EC; It.increment(EC))
+      if (sys::path::extension(It->path()) == ".json" &&
+          It->type() != sys::fs::file_type::directory_file)
+        Files.push_back(It->path());
+    if (EC)
+      return createFileError(Path, EC);
+    // Directory order is arbitrary, but the report should not be.
+    llvm::sort(Files.begin() + NumFiles, Files.end());
+  }
+  return Error::success();
+}
+
+static void sortEntries(std::vector<ReportEntry> &Entries) {
+  auto Key = [](const ReportEntry &R) -> int64_t {
+    switch (SortBy) {
+    case SK_Self:
+      return R.SelfUs;
+    case SK_Total:
+      return R.TotalUs;
+    case SK_Count:
+      return R.Count;
+    }
+    llvm_unreachable("unknown sort kind");
+  };
+  llvm::stable_sort(Entries, [&](const ReportEntry &A, const ReportEntry &B) {
+    return Key(A) > Key(B);
+  });
+  if (Top && Entries.size() > Top)
+    Entries.resize(Top);
+}
+
+static void printText(raw_ostream &OS, ArrayRef<ReportEntry> Entries,
+                      size_t NumTUs) {
+  OS << "Aggregated " << NumTUs << " time trace file(s)\n\n";
+  OS << format("%10s %10s %8s %6s  %s\n", "Self(ms)", "Total(ms)", "Count",
+               "TUs", "Event");
+  for (const ReportEntry &R : Entries) {
+    OS << format("%10.1f %10.1f %8llu %6llu  ", R.SelfUs / 1000.0,
+                 R.TotalUs / 1000.0, (unsigned long long)R.Count,
+                 (unsigned long long)R.NumTUs)
+       << R.Name;
+    if (!R.Detail.empty())
+      OS << " " << R.Detail;
+    if (!R.File.empty())
+      OS << " (" << R.File << ":" << R.Line << ")";
+    OS << "\n";
+    for (const auto &Count : R.Counts)
+      OS << format("%38s", "") << Count.getKey() << ": " << Count.getValue()
+         << "\n";
+  }
+}
+
+static void printJSON(raw_ostream &OS, ArrayRef<ReportEntry> Entries,
+                      size_t NumTUs) {
+  json::OStream J(OS, /*IndentSize=*/2);
+  J.object([&] {
+    J.attribute("files", int64_t(NumTUs));
+    J.attributeArray("entries", [&] {
+      for (const ReportEntry &R : Entries) {
+        J.object([&] {
+          J.attribute("name", R.Name);
+          if (!R.Detail.empty())
+            J.attribute("detail", R.Detail);
+          if (!R.File.empty()) {
+            J.attribute("file", R.File);
+            J.attribute("line", R.Line);
+          }
+          J.attribute("count", int64_t(R.Count));
+          J.attribute("tus", int64_t(R.NumTUs));
+          J.attribute("self_us", R.SelfUs);
+          J.attribute("total_us", R.TotalUs);
+          for (const auto &Count : R.Counts)
+            J.attribute(Count.getKey(), int64_t(Count.getValue()));
+        });
+      }
+    });
+  });
+  OS << "\n";
+}
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  cl::HideUnrelatedOptions(TimeTraceReportCategory);
+  cl::SetVersionPrinter(PrintVersion);
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "A utility for aggregating the -ftime-trace output of a whole build.\n"
+      "Time is attributed to the entities the events describe, such as\n"
+      "template instantiations, across all translation units.\n");
+
+  if (Help) {
+    cl::PrintHelpMessage();
+    return EXIT_SUCCESS;
+  }
+
+  ToolName = argv[0];
+  auto reportError = [](Error E) {
+    logAllUnhandledErrors(std::move(E), WithColor::error(errs(), ToolName));
+    return EXIT_FAILURE;
+  };
+
+  std::vector<std::string> Files;
+  if (Error Err = collectInputs(Files))
+    return reportError(std::move(Err));
+
+  // Parsing dominates the run time for large builds, so read and summarize
+  // the traces in parallel. The summaries are merged in the order of the
+  // files so that the result does not depend on the scheduling.
+  std::vector<Report> TUs(Files.size());
+  if (Error Err = parallelForEachError(
+          llvm::seq<size_t>(0, Files.size()),
+          [&](size_t I) { return readTrace(Files[I], TUs[I]); }))
+    return reportError(std::move(Err));
+
+  Report Total;
+  for (Report &TU : TUs)
+    Total.merge(std::move(TU));
+  std::vector<ReportEntry> &Entries = Total.Entries;
+  sortEntries(Entries);
+  if (EmitJSON)
+    printJSON(outs(), Entries, Files.size());
+  else
+    printText(outs(), Entries, Files.size());
+  return EXIT_SUCCESS;
+}
@@ -3745,6 +3745,9 @@ static CIndexer *clang_createIndex_Impl(
     CIdxr->setOnlyLocalDecls();
   if (displayDiagnostics)
     CIdxr->setDisplayDiagnostics();
+  // Share precompiled preambles with other processes using the same cache.
+  if (const char *PreambleCachePath = getenv("LIBCLANG_PREAMBLE_CACHE_PATH"))
+    CIdxr->setPreambleCachePath(PreambleCachePath);
 
   unsigned GlobalOptions = CIdxr->getCXGlobalOptFlags();
   const auto updateGlobalOption =
@@ -4037,7 +4040,7 @@ clang_parseTranslationUnit_Impl(CXIndex CIdx, const char *source_filename,
       /*AllowPCHWithCompilerErrors=*/true, SkipFunctionBodies, SingleFileParse,
       /*UserFilesAreVolatile=*/true, ForSerialization, RetainExcludedCB,
       CXXIdx->getPCHContainerOperations()->getRawReader().getFormats().front(),
-      &ErrUnit);
+      &ErrUnit, /*VFS=*/nullptr, CXXIdx->getPreambleCachePath());
 
   // Early failures in LoadFromCommandLine may return with ErrUnit unset.
   if (!Unit && !ErrUnit)
@@ -43,6 +43,7 @@ class CIndexer {
   std::string ToolchainPath;
 
   std::string PreambleStoragePath;
+  std::string PreambleCachePath;
   std::string InvocationEmissionPath;
 
 public:
@@ -90,6 +91,10 @@ public:
 
   StringRef getPreambleStoragePath() const { return PreambleStoragePath; }
 
+  void setPreambleCachePath(StringRef Str) { PreambleCachePath = Str.str(); }
+
+  StringRef getPreambleCachePath() const { return PreambleCachePath; }
+
   void setInvocationEmissionPath(StringRef Str) {
     InvocationEmissionPath = std::string(Str);
   }
@@ -0,0 +1,221 @@
+//===- unittests/Frontend/PreambleCacheTest.cpp - PreambleCache tests -----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/PCHContainerOperations.h"
+#include "clang/Frontend/PrecompiledPreamble.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+class PreambleCacheTest : public ::testing::Test {
+protected:
+  SmallString<128> CacheDir;
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> VFS;
+  std::shared_ptr<CompilerInvocation> CI;
+
+  void SetUp() override {
+    ASSERT_FALSE(
+        sys::fs::createUniqueDirectory("preamble-cache-test", CacheDir));
+    ResetVFS();
+    CI = std::make_shared<CompilerInvocation>();
+    CI->getFrontendOpts().Inputs.push_back(
+        FrontendInputFile("//./main.cpp", Language::CXX));
+    CI->getTargetOpts().Triple = "i386-unknown-linux-gnu";
+  }
+
+  void TearDown() override { sys::fs::remove_directories(CacheDir); }
+
+  void ResetVFS() {
+    VFS = new vfs::InMemoryFileSystem();
+    VFS->setCurrentWorkingDirectory("//./");
+  }
+
+  void AddFile(StringRef Filename, StringRef Contents) {
+    VFS->addFile(Filename, /*ModificationTime=*/1,
+                 MemoryBuffer::getMemBufferCopy(Contents, Filename));
+  }
+
+  PreambleBounds getBounds(const MemoryBuffer &MainFile) {
+    return ComputePreambleBounds(*CI->getLangOpts(),
+                                 MainFile.getMemBufferRef(), 0);
+  }
+
+  std::optional<PrecompiledPreamble> Build(const MemoryBuffer &MainFile) {
+    IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
+        CompilerInstance::createDiagnostics(new DiagnosticOptions,
+                                            new DiagnosticConsumer));
+    PreambleCallbacks Callbacks;
+    llvm::ErrorOr<PrecompiledPreamble> Preamble = PrecompiledPreamble::Build(
+        *CI, &MainFile, getBounds(MainFile), *Diags, VFS,
+        std::make_shared<PCHContainerOperations>(), /*StoreInMemory=*/true,
+        /*StoragePath=*/"", Callbacks);
+    if (!Preamble)
+      return std::nullopt;
+    return std::move(*Preamble);
+  }
+
+  unsigned CountCacheFiles() {
+    unsigned Count = 0;
+    std::error_code EC;
+    for (sys::fs::directory_iterator I(CacheDir, EC), E; I != E && !EC;
+         I.increment(EC))
+      if (sys::path::filename(I->path()).startswith("llvmcache-preamble-"))
+        ++Count;
+    return Count;
+  }
+};
+
+TEST_F(PreambleCacheTest, StoredPreambleIsFound) {
+  AddFile("//./header.h", "#define ZERO 0\n");
+  auto MainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint main() { return ZERO; }\n");
+  std::optional<PrecompiledPreamble> Preamble = Build(*MainFile);
+  ASSERT_TRUE(Preamble);
+
+  PreambleCache Cache(CacheDir);
+  ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS, "client data")));
+
+  std::string ClientData;
+  std::optional<PrecompiledPreamble> Cached = Cache.lookup(
+      *CI, MainFile->getMemBufferRef(), getBounds(*MainFile), *VFS,
+      &ClientData);
+  ASSERT_TRUE(Cached);
+  EXPECT_EQ(ClientData, "client data");
+  EXPECT_EQ(Cached->getBounds().Size, Preamble->getBounds().Size);
+  EXPECT_EQ(Cached->getSize(), Preamble->getSize());
+  EXPECT_TRUE(Cached->CanReuse(*CI, MainFile->getMemBufferRef(),
+                               getBounds(*MainFile), *VFS));
+}
+
+TEST_F(PreambleCacheTest, ChangedDependencyInvalidatesEntry) {
+  AddFile("//./header.h", "#define ZERO 0\n");
+  auto MainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint main() { return ZERO; }\n");
+  std::optional<PrecompiledPreamble> Preamble = Build(*MainFile);
+  ASSERT_TRUE(Preamble);
+
+  PreambleCache Cache(CacheDir);
+  ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS)));
+
+  ResetVFS();
+  AddFile("//./header.h", "#define ZERO 1\n");
+  EXPECT_FALSE(Cache.lookup(*CI, MainFile->getMemBufferRef(),
+                            getBounds(*MainFile), *VFS));
+}
+
+TEST_F(PreambleCacheTest, DifferentPreambleIsNotFound) {
+  AddFile("//./header.h", "#define ZERO 0\n");
+  AddFile("//./other.h", "#define ZERO 0\n");
+  auto MainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint main() { return ZERO; }\n");
+  std::optional<PrecompiledPreamble> Preamble = Build(*MainFile);
+  ASSERT_TRUE(Preamble);
+
+  PreambleCache Cache(CacheDir);
+  ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS)));
+
+  auto OtherMainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./other.h\"\nint main() { return ZERO; }\n");
+  EXPECT_FALSE(Cache.lookup(*CI, OtherMainFile->getMemBufferRef(),
+                            getBounds(*OtherMainFile), *VFS));
+}
+
+TEST_F(PreambleCacheTest, StoreEvictsEntriesByPolicy) {
+  AddFile("//./header.h", "#define ZERO 0\n");
+  AddFile("//./other.h", "#define ZERO 0\n");
+  auto MainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint main() { return ZERO; }\n");
+  auto OtherMainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./other.h\"\nint main() { return ZERO; }\n");
+  std::optional<PrecompiledPreamble> Preamble = Build(*MainFile);
+  ASSERT_TRUE(Preamble);
+  std::optional<PrecompiledPreamble> OtherPreamble = Build(*OtherMainFile);
+  ASSERT_TRUE(OtherPreamble);
+
+  // The default policy keeps recent entries. Each key has an index, and each
+  // entry is made of a PCH and a dependency file.
+  {
+    PreambleCache Cache(CacheDir);
+    ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS)));
+    ASSERT_FALSE(errorToBool(Cache.store(*OtherPreamble, *CI, *VFS)));
+  }
+  EXPECT_EQ(CountCacheFiles(), 6u);
+
+  Expected<CachePruningPolicy> Policy =
+      parseCachePruningPolicy("prune_interval=0s:cache_size_files=3");
+  ASSERT_FALSE(errorToBool(Policy.takeError()));
+  PreambleCache Cache(CacheDir, *Policy);
+  ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS)));
+  EXPECT_EQ(CountCacheFiles(), 3u);
+}
+
+TEST_F(PreambleCacheTest, PreambleIsSharedByMainFiles) {
+  AddFile("//./header.h", "#define ZERO 0\n");
+  auto MainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint main() { return ZERO; }\n");
+  std::optional<PrecompiledPreamble> Preamble = Build(*MainFile);
+  ASSERT_TRUE(Preamble);
+
+  PreambleCache Cache(CacheDir);
+  ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS)));
+
+  auto OtherCI = std::make_shared<CompilerInvocation>(*CI);
+  OtherCI->getFrontendOpts().Inputs[0] =
+      FrontendInputFile("//./other.cpp", Language::CXX);
+  auto OtherMainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint other() { return ZERO; }\n");
+  EXPECT_TRUE(Cache.lookup(*OtherCI, OtherMainFile->getMemBufferRef(),
+                           getBounds(*OtherMainFile), *VFS));
+
+  // Quoted includes are looked up next to the main file, so its directory
+  // still matters.
+  OtherCI->getFrontendOpts().Inputs[0] =
+      FrontendInputFile("//./dir/other.cpp", Language::CXX);
+  EXPECT_FALSE(Cache.lookup(*OtherCI, OtherMainFile->getMemBufferRef(),
+                            getBounds(*OtherMainFile), *VFS));
+
+  PreambleCache OtherClientCache(CacheDir, {}, "other client");
+  EXPECT_FALSE(OtherClientCache.lookup(*CI, MainFile->getMemBufferRef(),
+                                       getBounds(*MainFile), *VFS));
+}
+
+TEST_F(PreambleCacheTest, FoundPreambleSurvivesPruning) {
+  AddFile("//./header.h", "#define ZERO 0\n");
+  auto MainFile = MemoryBuffer::getMemBuffer(
+      "#include \"//./header.h\"\nint main() { return ZERO; }\n");
+  std::optional<PrecompiledPreamble> Preamble = Build(*MainFile);
+  ASSERT_TRUE(Preamble);
+
+  PreambleCache Cache(CacheDir);
+  ASSERT_FALSE(errorToBool(Cache.store(*Preamble, *CI, *VFS)));
+  std::optional<PrecompiledPreamble> Cached = Cache.lookup(
+      *CI, MainFile->getMemBufferRef(), getBounds(*MainFile), *VFS);
+  ASSERT_TRUE(Cached);
+
+  // Another process may evict the entry while the preamble is in use.
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(CacheDir, EC), E; I != E && !EC;
+       I.increment(EC))
+    if (sys::path::filename(I->path()).startswith("llvmcache-preamble-"))
+      ASSERT_FALSE(sys::fs::remove(I->path()));
+  EXPECT_EQ(CountCacheFiles(), 0u);
+  EXPECT_EQ(Cached->getSize(), Preamble->getSize());
+}
+
+} // anonymous namespace
@@ -660,4 +660,25 @@ TEST_F(LexerTest, RawAndNormalLexSameForLineComments) {
   }
   EXPECT_TRUE(ToksView.empty());
 }
+
+TEST_F(LexerTest, LongRunsOfSimpleCharacters) {
+  // Exercise the vectorized scanning, including stopping characters at every
+  // position of a 16-byte block and runs reaching the end of the buffer.
+  for (unsigned Len = 1; Len != 40; ++Len) {
+    std::string Run(Len, 'a');
+    std::string Source = Run + "$ " + std::string(Len, ' ') + "\"" + Run +
+                         "\\\"" + Run + "\" '" + Run.substr(0, 1) + "' // " +
+                         Run + "\xc3\xa9" + Run + "\n" + Run;
+    LangOpts.DollarIdents = false;
+    std::vector<Token> Toks =
+        CheckLex(Source, {tok::identifier, tok::unknown, tok::string_literal,
+                          tok::char_constant, tok::identifier});
+    if (Toks.size() != 5)
+      continue;
+    EXPECT_EQ(Len, Toks[0].getLength());
+    EXPECT_EQ(2 * Len + 4, Toks[2].getLength());
+    EXPECT_TRUE(Toks[4].isAtStartOfLine());
+    EXPECT_EQ(Len, Toks[4].getLength());
+  }
+}
 } // anonymous namespace
@@ -13,11 +13,15 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/DependencyDirectivesScanner.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
 #include "clang/Tooling/DependencyScanning/DependencyScanningTool.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetSelect.h"
@@ -301,3 +305,286 @@ TEST(DependencyScanner, ScanDepsWithModuleLookup) {
               InterceptFS->StatPaths.end());
   EXPECT_EQ(InterceptFS->ReadFiles, std::vector<std::string>{"test.m"});
 }
+
+namespace {
+/// A temporary directory for a DependencyDirectivesDiskCache, removed again
+/// when the test is done.
+struct TempCacheDir {
+  SmallString<128> Path;
+
+  TempCacheDir() {
+    EXPECT_FALSE(
+        llvm::sys::fs::createUniqueDirectory("scandeps-directives", Path));
+  }
+  ~TempCacheDir() { llvm::sys::fs::remove_directories(Path); }
+
+  std::string getEntryPath(StringRef Key) const {
+    SmallString<128> EntryPath(Path);
+    llvm::sys::path::append(EntryPath, "llvmcache-scandeps-" + Key);
+    return std::string(EntryPath);
+  }
+
+  unsigned countEntries() const {
+    unsigned Count = 0;
+    std::error_code EC;
+    for (llvm::sys::fs::directory_iterator I(Path, EC), E; I != E && !EC;
+         I.increment(EC))
+      if (llvm::sys::path::filename(I->path())
+              .startswith("llvmcache-scandeps-"))
+        ++Count;
+    return Count;
+  }
+};
+
+// The directives refer to the tokens, so the tokens are kept out of line to
+// keep them in place when this is moved.
+struct ScannedDirectives {
+  SmallVector<dependency_directives_scan::Token, 0> Tokens;
+  SmallVector<dependency_directives_scan::Directive, 0> Directives;
+};
+} // namespace
+
+static ScannedDirectives scanDirectives(StringRef Source) {
+  ScannedDirectives Scanned;
+  EXPECT_FALSE(scanSourceForDependencyDirectives(Source, Scanned.Tokens,
+                                                 Scanned.Directives));
+  return Scanned;
+}
+
+static void expectSameDirectives(const ScannedDirectives &Expected,
+                                 const ScannedDirectives &Actual) {
+  ASSERT_EQ(Expected.Tokens.size(), Actual.Tokens.size());
+  for (size_t I = 0, E = Expected.Tokens.size(); I != E; ++I) {
+    EXPECT_EQ(Expected.Tokens[I].Offset, Actual.Tokens[I].Offset);
+    EXPECT_EQ(Expected.Tokens[I].Length, Actual.Tokens[I].Length);
+    EXPECT_EQ(Expected.Tokens[I].Kind, Actual.Tokens[I].Kind);
+    EXPECT_EQ(Expected.Tokens[I].Flags, Actual.Tokens[I].Flags);
+  }
+  ASSERT_EQ(Expected.Directives.size(), Actual.Directives.size());
+  for (size_t I = 0, E = Expected.Directives.size(); I != E; ++I) {
+    EXPECT_EQ(Expected.Directives[I].Kind, Actual.Directives[I].Kind);
+    ASSERT_EQ(Expected.Directives[I].Tokens.size(),
+              Actual.Directives[I].Tokens.size());
+    // The directives must refer to the tokens read from the cache.
+    if (!Actual.Directives[I].Tokens.empty())
+      EXPECT_EQ(Actual.Directives[I].Tokens.data() - Actual.Tokens.data(),
+                Expected.Directives[I].Tokens.data() - Expected.Tokens.data());
+  }
+}
+
+TEST(DependencyDirectivesDiskCache, Hit) {
+  TempCacheDir Dir;
+  StringRef Source =
+      "#include \"a.h\"\n#define X 1\nint x;\n#if X\n#endif\n";
+  ScannedDirectives Scanned = scanDirectives(Source);
+
+  {
+    DependencyDirectivesDiskCache Cache(Dir.Path);
+    std::string Key = Cache.getKey(Source);
+    ScannedDirectives Cached;
+    EXPECT_FALSE(Cache.lookup(Key, Source, Cached.Tokens, Cached.Directives));
+    Cache.store(Key, Scanned.Tokens, Scanned.Directives);
+  }
+  EXPECT_EQ(Dir.countEntries(), 1u);
+
+  // A separate cache instance, as in a later invocation, finds the entry.
+  DependencyDirectivesDiskCache Cache(Dir.Path);
+  ScannedDirectives Cached;
+  ASSERT_TRUE(Cache.lookup(Cache.getKey(Source), Source, Cached.Tokens,
+                           Cached.Directives));
+  expectSameDirectives(Scanned, Cached);
+}
+
+TEST(DependencyDirectivesDiskCache, ChangedFile) {
+  TempCacheDir Dir;
+  StringRef Source = "#include \"a.h\"\n";
+  StringRef Changed = "#include \"b.h\"\n#include \"c.h\"\n";
+  ScannedDirectives Scanned = scanDirectives(Source);
+
+  DependencyDirectivesDiskCache Cache(Dir.Path);
+  Cache.store(Cache.getKey(Source), Scanned.Tokens, Scanned.Directives);
+
+  // The key depends on the contents, so the changed file misses the entry of
+  // the original one.
+  EXPECT_NE(Cache.getKey(Source), Cache.getKey(Changed));
+  ScannedDirectives Cached;
+  EXPECT_FALSE(Cache.lookup(Cache.getKey(Changed), Changed, Cached.Tokens,
+                            Cached.Directives));
+
+  ScannedDirectives ScannedChanged = scanDirectives(Changed);
+  Cache.store(Cache.getKey(Changed), ScannedChanged.Tokens,
+              ScannedChanged.Directives);
+  EXPECT_EQ(Dir.countEntries(), 2u);
+  ASSERT_TRUE(Cache.lookup(Cache.getKey(Changed), Changed, Cached.Tokens,
+                           Cached.Directives));
+  expectSameDirectives(ScannedChanged, Cached);
+}
+
+TEST(DependencyDirectivesDiskCache, CorruptEntry) {
+  TempCacheDir Dir;
+  StringRef Source = "#include \"a.h\"\n#define X 1\n";
+  ScannedDirectives Scanned = scanDirectives(Source);
+
+  DependencyDirectivesDiskCache Cache(Dir.Path);
+  std::string Key = Cache.getKey(Source);
+  Cache.store(Key, Scanned.Tokens, Scanned.Directives);
+
+  auto Overwrite = [&](StringRef Data) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Dir.getEntryPath(Key), EC);
+    ASSERT_FALSE(EC);
+    OS << Data;
+  };
+  auto ReadEntry = [&] {
+    auto Buffer = llvm::MemoryBuffer::getFile(Dir.getEntryPath(Key));
+    EXPECT_TRUE(Buffer);
+    return Buffer ? (*Buffer)->getBuffer().str() : std::string();
+  };
+  std::string Entry = ReadEntry();
+  ScannedDirectives Cached;
+
+  // A truncated entry.
+  Overwrite(StringRef(Entry).drop_back());
+  EXPECT_FALSE(Cache.lookup(Key, Source, Cached.Tokens, Cached.Directives));
+
+  // An entry with a bad magic.
+  std::string BadMagic = Entry;
+  BadMagic[0] = 'X';
+  Overwrite(BadMagic);
+  EXPECT_FALSE(Cache.lookup(Key, Source, Cached.Tokens, Cached.Directives));
+
+  // Garbage.
+  Overwrite("garbage");
+  EXPECT_FALSE(Cache.lookup(Key, Source, Cached.Tokens, Cached.Directives));
+
+  // A well-formed entry whose tokens lie outside of the file.
+  Overwrite(Entry);
+  EXPECT_FALSE(Cache.lookup(Key, Source.take_front(4), Cached.Tokens,
+                            Cached.Directives));
+
+  // The intact entry is still usable.
+  ASSERT_TRUE(Cache.lookup(Key, Source, Cached.Tokens, Cached.Directives));
+  expectSameDirectives(Scanned, Cached);
+}
+
+TEST(DependencyDirectivesDiskCache, Pruning) {
+  TempCacheDir Dir;
+  StringRef Sources[] = {"#include \"a.h\"\n", "#include \"b.h\"\n",
+                         "#include \"c.h\"\n"};
+
+  // The default policy keeps recent entries.
+  {
+    DependencyDirectivesDiskCache Cache(Dir.Path);
+    for (StringRef Source : Sources) {
+      ScannedDirectives Scanned = scanDirectives(Source);
+      Cache.store(Cache.getKey(Source), Scanned.Tokens, Scanned.Directives);
+    }
+  }
+  EXPECT_EQ(Dir.countEntries(), 3u);
+
+  // Entries are pruned according to the policy when the cache is destroyed.
+  llvm::Expected<llvm::CachePruningPolicy> Policy =
+      llvm::parseCachePruningPolicy("prune_interval=0s:cache_size_files=1");
+  ASSERT_THAT_EXPECTED(Policy, llvm::Succeeded());
+  { DependencyDirectivesDiskCache Cache(Dir.Path, *Policy); }
+  EXPECT_EQ(Dir.countEntries(), 1u);
+}
+
+static std::string readThrough(llvm::vfs::FileSystem &FS, StringRef Path) {
+  auto File = FS.openFileForRead(Path);
+  if (!File)
+    return "<error>";
+  auto Buffer = (*File)->getBuffer(Path);
+  if (!Buffer)
+    return "<error>";
+  return (*Buffer)->getBuffer().str();
+}
+
+static llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem>
+createHeaderFS(StringRef AContents, StringRef BContents) {
+  auto FS = llvm::makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+  FS->addFile("/a.h", 0, llvm::MemoryBuffer::getMemBuffer(AContents));
+  FS->addFile("/b.h", 0, llvm::MemoryBuffer::getMemBuffer(BContents));
+  FS->addHardLink("/link.h", "/a.h");
+  return FS;
+}
+
+TEST(DependencyScanningFilesystemSharedCache, Invalidate) {
+  DependencyScanningFilesystemSharedCache SharedCache;
+  auto OldFS = createHeaderFS("// a1\n", "// b1\n");
+  auto NewFS = createHeaderFS("// a2\n", "// b2\n");
+
+  {
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, OldFS);
+    EXPECT_EQ(readThrough(DepFS, "/a.h"), "// a1\n");
+    EXPECT_EQ(readThrough(DepFS, "/link.h"), "// a1\n");
+    EXPECT_EQ(readThrough(DepFS, "/b.h"), "// b1\n");
+  }
+
+  // The shared cache keeps serving the contents it read first.
+  {
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, NewFS);
+    EXPECT_EQ(readThrough(DepFS, "/a.h"), "// a1\n");
+    EXPECT_EQ(readThrough(DepFS, "/link.h"), "// a1\n");
+  }
+
+  llvm::ErrorOr<llvm::vfs::Status> OldStat = OldFS->status("/a.h");
+  llvm::ErrorOr<llvm::vfs::Status> NewStat = NewFS->status("/a.h");
+  ASSERT_TRUE(OldStat && NewStat);
+  SharedCache.invalidate({"/a.h"}, *NewFS);
+
+  // The other name of the file is dropped along with it, and so are the
+  // entries for both the cached and the current unique ID of the file.
+  EXPECT_EQ(SharedCache.getShardForFilename("/a.h").findEntryByFilename("/a.h"),
+            nullptr);
+  EXPECT_EQ(
+      SharedCache.getShardForFilename("/link.h").findEntryByFilename("/link.h"),
+      nullptr);
+  EXPECT_EQ(SharedCache.getShardForUID(OldStat->getUniqueID())
+                .findEntryByUID(OldStat->getUniqueID()),
+            nullptr);
+  EXPECT_EQ(SharedCache.getShardForUID(NewStat->getUniqueID())
+                .findEntryByUID(NewStat->getUniqueID()),
+            nullptr);
+  EXPECT_NE(SharedCache.getShardForFilename("/b.h").findEntryByFilename("/b.h"),
+            nullptr);
+
+  {
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, NewFS);
+    EXPECT_EQ(readThrough(DepFS, "/a.h"), "// a2\n");
+    EXPECT_EQ(readThrough(DepFS, "/link.h"), "// a2\n");
+    // Files that were not invalidated are still served from the cache.
+    EXPECT_EQ(readThrough(DepFS, "/b.h"), "// b1\n");
+  }
+}
+
+TEST(DependencyScanningFilesystemSharedCache, InvalidateMissingFiles) {
+  DependencyScanningFilesystemSharedCache SharedCache;
+  auto OldFS = createHeaderFS("// a1\n", "// b1\n");
+  auto NewFS = createHeaderFS("// a1\n", "// b1\n");
+  NewFS->addFile("/c.h", 0, llvm::MemoryBuffer::getMemBuffer("// c\n"));
+
+  {
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, OldFS);
+    EXPECT_FALSE(DepFS.status("/c.h"));
+    EXPECT_TRUE(DepFS.status("/a.h"));
+  }
+
+  // The failure to stat the file is cached.
+  {
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, NewFS);
+    EXPECT_FALSE(DepFS.status("/c.h"));
+  }
+
+  SharedCache.invalidateMissingFiles();
+  EXPECT_EQ(SharedCache.getShardForFilename("/c.h").findEntryByFilename("/c.h"),
+            nullptr);
+  EXPECT_NE(SharedCache.getShardForFilename("/a.h").findEntryByFilename("/a.h"),
+            nullptr);
+
+  {
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, NewFS);
+    EXPECT_TRUE(DepFS.status("/c.h"));
+    EXPECT_EQ(readThrough(DepFS, "/c.h"), "// c\n");
+  }
+}
@@ -25,6 +25,7 @@
 #include "Driver.h"
 #include "Config.h"
 #include "ICF.h"
+#include "IncrementalLink.h"
 #include "InputFiles.h"
 #include "InputSection.h"
 #include "LTO.h"
@@ -355,6 +356,9 @@ static void checkOptions() {
   if (config->emachine == EM_MIPS && config->gnuHash)
     error("the .gnu.hash section is not compatible with the MIPS target");
 
+  if (config->incremental && config->outputFile == "-")
+    error("--incremental may not be used when writing the output to stdout");
+
   if (config->emachine == EM_ARM) {
     if (!config->cmseImplib) {
       if (!config->cmseInputLib.empty())
@@ -658,7 +662,22 @@ void LinkerDriver::linkerMain(ArrayRef<const char *> argsArr) {
     if (errorCount())
       return;
 
-    link(args);
+    // With --incremental, skip the link if nothing that affects the output
+    // changed since the last successful link.
+    std::string digest;
+    bool upToDate = false;
+    if (config->incremental) {
+      digest = computeLinkDigest(args);
+      upToDate = isOutputUpToDate(args, digest);
+    }
+
+    if (upToDate) {
+      log(config->outputFile + " is up to date");
+    } else {
+      link(args);
+      if (config->incremental && !errorCount())
+        writeIncrementalState(digest);
+    }
   }
 
   if (config->timeTraceEnabled) {
@@ -1200,6 +1219,8 @@ static void readConfigs(opt::InputArgList &args) {
       args.hasArg(OPT_ignore_data_address_equality);
   config->ignoreFunctionAddressEquality =
       args.hasArg(OPT_ignore_function_address_equality);
+  config->incremental =
+      args.hasFlag(OPT_incremental, OPT_no_incremental, false);
   config->init = args.getLastArgValue(OPT_init, "_init");
   config->ltoAAPipeline = args.getLastArgValue(OPT_lto_aa_pipeline);
   config->ltoCSProfileGenerate = args.hasArg(OPT_lto_cs_profile_generate);
@@ -2659,6 +2680,14 @@ void LinkerDriver::link(opt::InputArgList &args) {
   // symbols that we need to the symbol table. This process might
   // add files to the link, via autolinking, these files are always
   // appended to the Files vector.
+  //
+  // Symbol resolution must be serial to keep archive member extraction and
+  // symbol order deterministic, but reading and hashing the symbol names does
+  // not touch the symbol table, so do it for all files in parallel first.
+  {
+    llvm::TimeTraceScope timeScope("Hash symbol names");
+    parallelForEach(files, hashGlobalSymbolNames);
+  }
   {
     llvm::TimeTraceScope timeScope("Parse input files");
     for (size_t i = 0; i < files.size(); ++i) {
@@ -0,0 +1,266 @@
+//===- IncrementalLink.cpp ------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the --incremental option. After a successful link we
+// record a digest of the linker version, the command line, the working
+// directory and the contents of every file that was read, together with the
+// size and modification time of the output, in <output>.incremental. When
+// the next link computes the same digest and the output has not been touched,
+// the link is skipped.
+//
+// The digest is computed once all input files have been opened, so a change
+// in library search results (e.g. a new libfoo.so earlier in the search path)
+// changes the digest as well. Hashing is done in parallel and only reads
+// memory-mapped inputs, which is much cheaper than resolving symbols, laying
+// out sections and writing a large output again.
+//
+// Some files are only read later in the link, such as the call graph ordering
+// file or LTO profiles. They cannot be part of the digest, so their contents
+// are hashed after the link and recorded separately in the state file. The
+// next link reads and hashes them again before deciding to skip.
+//
+// Links that produce outputs other than the output file (a map file, a
+// dependency file, diagnostics printed to stdout, ...) are never skipped,
+// since those outputs would not be produced. Neither is a link after one that
+// reported warnings, which would otherwise be lost.
+//
+// Only whole links are skipped. A link in which any input changed is done
+// from scratch.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IncrementalLink.h"
+#include "Config.h"
+#include "Driver.h"
+#include "InputFiles.h"
+#include "lld/Common/ErrorHandler.h"
+#include "lld/Common/Version.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Option/ArgList.h"
+#include "llvm/Support/BLAKE3.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+
+using namespace llvm;
+using namespace lld;
+using namespace lld::elf;
+
+static constexpr StringLiteral stateMagic = "lld-incremental-v2";
+
+// The number of buffers in ctx.memoryBuffers covered by the digest. Buffers
+// read after that are recorded as late inputs.
+static size_t numDigestedBuffers = 0;
+
+static std::string getStatePath() {
+  return (config->outputFile + ".incremental").str();
+}
+
+// Returns the size and modification time of a file as a string, or an empty
+// string if the file does not exist.
+static std::string getFileStamp(StringRef path) {
+  sys::fs::file_status st;
+  if (path.empty() || sys::fs::status(path, st) ||
+      !sys::fs::is_regular_file(st))
+    return "";
+  return std::to_string(st.getSize()) + ":" +
+         std::to_string(
+             st.getLastModificationTime().time_since_epoch().count());
+}
+
+static std::string hashContents(StringRef data) {
+  return toHex(BLAKE3::hash(arrayRefFromStringRef(data)), /*LowerCase=*/true);
+}
+
+// Returns the name of an option that makes the link produce output besides
+// the output file, or an empty string if there is none. Skipping such a link
+// would not produce that output.
+static StringRef getSideOutputOption(const opt::InputArgList &args) {
+  // The archive is written as the inputs are read, so a skipped link would
+  // leave it without the files that are read late in the link.
+  if (tar)
+    return "--reproduce";
+  if (!config->mapFile.empty())
+    return "--Map";
+  if (!config->dependencyFile.empty())
+    return "--dependency-file";
+  if (!config->whyExtract.empty())
+    return "--why-extract";
+  if (!config->printArchiveStats.empty())
+    return "--print-archive-stats";
+  if (!config->printSymbolOrder.empty())
+    return "--print-symbol-order";
+  if (!config->optRemarksFilename.empty())
+    return "--opt-remarks-filename";
+  if (!config->cmseOutputLib.empty())
+    return "--out-implib";
+  if (!config->ltoObjPath.empty())
+    return "--lto-obj-path";
+  if (config->ltoCSProfileGenerate)
+    return "--lto-cs-profile-generate";
+  if (!config->thinLTOCacheDir.empty())
+    return "--thinlto-cache-dir";
+  if (config->thinLTOIndexOnly || config->thinLTOEmitIndexFiles ||
+      config->thinLTOEmitImportsFiles)
+    return "--thinlto-index-only";
+  if (!config->saveTempsArgs.empty())
+    return "--save-temps";
+  if (config->cref)
+    return "--cref";
+  if (config->trace)
+    return "--trace";
+  if (args.hasArg(OPT_trace_symbol))
+    return "--trace-symbol";
+  if (config->printGcSections)
+    return "--print-gc-sections";
+  if (config->printIcfSections)
+    return "--print-icf-sections";
+  if (config->printMemoryUsage)
+    return "--print-memory-usage";
+  return "";
+}
+
+// Returns the files that are read during the link without going through
+// readFile(), so they are not in ctx.memoryBuffers.
+static SmallVector<StringRef, 0> getUnbufferedInputs() {
+  SmallVector<StringRef, 0> paths;
+  if (!config->ltoSampleProfile.empty())
+    paths.push_back(config->ltoSampleProfile);
+  if (!config->ltoCSProfileFile.empty())
+    paths.push_back(config->ltoCSProfileFile);
+  StringRef bbSections = config->ltoBasicBlockSections;
+  if (!bbSections.empty() && bbSections != "all" && bbSections != "labels" &&
+      bbSections != "none")
+    paths.push_back(bbSections);
+  return paths;
+}
+
+std::string elf::computeLinkDigest(const opt::InputArgList &args) {
+  // Hash the inputs in parallel. They are all mapped already, so this is
+  // bound by memory bandwidth.
+  ArrayRef<std::unique_ptr<MemoryBuffer>> buffers = ctx.memoryBuffers;
+  numDigestedBuffers = buffers.size();
+  std::vector<BLAKE3Result<>> contentHashes(buffers.size());
+  parallelFor(0, buffers.size(), [&](size_t i) {
+    contentHashes[i] =
+        BLAKE3::hash(arrayRefFromStringRef(buffers[i]->getBuffer()));
+  });
+
+  BLAKE3 hasher;
+  auto add = [&](StringRef s) {
+    hasher.update(s);
+    hasher.update(StringRef("\0", 1));
+  };
+  add(getLLDVersion());
+  SmallString<128> cwd;
+  if (!sys::fs::current_path(cwd))
+    add(cwd);
+  for (const opt::Arg *arg : args)
+    add(arg->getAsString(args));
+  for (size_t i = 0, e = buffers.size(); i != e; ++i) {
+    add(buffers[i]->getBufferIdentifier());
+    hasher.update(contentHashes[i]);
+  }
+  return toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+bool elf::isOutputUpToDate(const opt::InputArgList &args, StringRef digest) {
+  StringRef sideOutput = getSideOutputOption(args);
+  if (!sideOutput.empty()) {
+    log("--incremental: not skipping the link because of " + sideOutput);
+    return false;
+  }
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+      MemoryBuffer::getFile(getStatePath(), /*IsText=*/true);
+  if (!mbOrErr)
+    return false;
+
+  SmallVector<StringRef, 0> lines;
+  (*mbOrErr)->getBuffer().split(lines, '\n', /*MaxSplit=*/-1,
+                                /*KeepEmpty=*/false);
+  if (lines.empty() || lines[0] != stateMagic)
+    return false;
+
+  // Each following line is a key and a value separated by a space. The output
+  // recorded in the state must still carry the recorded stamp, and every late
+  // input must still have the recorded contents.
+  bool digestMatches = false;
+  bool outputMatches = false;
+  SmallVector<std::pair<StringRef, StringRef>, 0> lateInputs;
+  for (StringRef line : ArrayRef<StringRef>(lines).drop_front()) {
+    auto [key, value] = line.split(' ');
+    if (key == "digest") {
+      digestMatches = value == digest;
+    } else if (key == "file") {
+      auto [stamp, path] = value.split(' ');
+      if (stamp != getFileStamp(path))
+        return false;
+      outputMatches |= path == config->outputFile;
+    } else if (key == "input") {
+      lateInputs.push_back(value.split(' '));
+    }
+  }
+  if (!digestMatches || !outputMatches)
+    return false;
+
+  std::atomic<bool> inputsMatch = true;
+  parallelFor(0, lateInputs.size(), [&](size_t i) {
+    auto [hash, path] = lateInputs[i];
+    ErrorOr<std::unique_ptr<MemoryBuffer>> inputOrErr =
+        MemoryBuffer::getFile(path, /*IsText=*/false,
+                              /*RequiresNullTerminator=*/false);
+    if (!inputOrErr || hashContents((*inputOrErr)->getBuffer()) != hash)
+      inputsMatch = false;
+  });
+  return inputsMatch;
+}
+
+void elf::writeIncrementalState(StringRef digest) {
+  // A skipped link would not report the warnings of this link again, so do
+  // not let the next link be skipped.
+  std::string statePath = getStatePath();
+  if (errorHandler().warningCount) {
+    log("--incremental: not recording the link because it reported warnings");
+    sys::fs::remove(statePath);
+    return;
+  }
+
+  // Hash the files that were read after the digest was computed.
+  SmallVector<std::pair<std::string, std::string>, 0> lateInputs;
+  for (const std::unique_ptr<MemoryBuffer> &mb :
+       ArrayRef(ctx.memoryBuffers).drop_front(numDigestedBuffers))
+    lateInputs.emplace_back(hashContents(mb->getBuffer()),
+                            mb->getBufferIdentifier().str());
+  for (StringRef path : getUnbufferedInputs()) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+        MemoryBuffer::getFile(path, /*IsText=*/false,
+                              /*RequiresNullTerminator=*/false);
+    // If the file cannot be read, the link did not depend on it.
+    if (mbOrErr)
+      lateInputs.emplace_back(hashContents((*mbOrErr)->getBuffer()),
+                              path.str());
+  }
+
+  std::error_code ec;
+  raw_fd_ostream os(statePath, ec, sys::fs::OF_Text);
+  if (ec) {
+    warn("cannot open " + statePath + ": " + ec.message());
+    return;
+  }
+
+  os << stateMagic << '\n';
+  os << "digest " << digest << '\n';
+  for (const auto &[hash, path] : lateInputs)
+    os << "input " << hash << ' ' << path << '\n';
+  std::string stamp = getFileStamp(config->outputFile);
+  if (!stamp.empty())
+    os << "file " << stamp << ' ' << config->outputFile << '\n';
+}
@@ -0,0 +1,36 @@
+//===- IncrementalLink.h ----------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_INCREMENTAL_LINK_H
+#define LLD_ELF_INCREMENTAL_LINK_H
+
+#include "lld/Common/LLVM.h"
+#include <string>
+
+namespace llvm::opt {
+class InputArgList;
+}
+
+namespace lld::elf {
+// Returns a digest of everything that determines the output of this link.
+// Must be called after all input files have been read.
+std::string computeLinkDigest(const llvm::opt::InputArgList &args);
+
+// Returns true if the output was produced by a previous link with the same
+// digest and the same late-read inputs, and has not been modified since.
+// Always returns false if the link would produce other outputs as well.
+bool isOutputUpToDate(const llvm::opt::InputArgList &args, StringRef digest);
+
+// Records the digest of a successful link, and the contents of the files read
+// after the digest was computed, next to the output file. If the link reported
+// warnings, removes any recorded state instead, so that the next link is not
+// skipped.
+void writeIncrementalState(StringRef digest);
+} // namespace lld::elf
+
+#endif
@@ -326,6 +326,18 @@ template <class ELFT> static void doParseFile(InputFile *file) {
 // Add symbols in File to the symbol table.
 void elf::parseFile(InputFile *file) { invokeELFT(doParseFile, file); }
 
+template <class ELFT> static void doHashGlobalSymbolNames(InputFile *file) {
+  if (file->ekind == config->ekind)
+    if (auto *f = dyn_cast<ObjFile<ELFT>>(file))
+      f->hashGlobalSymbolNames();
+}
+
+// Precompute the hashes of the global symbol names in File. This is safe to
+// call for different files concurrently.
+void elf::hashGlobalSymbolNames(InputFile *file) {
+  invokeELFT(doHashGlobalSymbolNames, file);
+}
+
 template <class ELFT> static void doParseArmCMSEImportLib(InputFile *file) {
   cast<ObjFile<ELFT>>(file)->importCmseSymbols();
 }
@@ -1048,6 +1060,27 @@ InputSectionBase *ObjFile<ELFT>::createInputSection(uint32_t idx,
   return makeThreadLocal<InputSection>(*this, sec, name);
 }
 
+template <class ELFT> void ObjFile<ELFT>::hashGlobalSymbolNames() {
+  ArrayRef<Elf_Sym> eSyms = this->getELFSyms<ELFT>();
+  hashedGlobalNames.reserve(eSyms.size() - firstGlobal);
+  for (size_t i = firstGlobal, end = eSyms.size(); i != end; ++i) {
+    // A lazy file only inserts its defined symbols (see parseLazy()), and is
+    // usually never extracted, so don't hash names that won't be inserted.
+    if (lazy && eSyms[i].st_shndx == SHN_UNDEF) {
+      hashedGlobalNames.push_back({});
+      continue;
+    }
+    Expected<StringRef> name = eSyms[i].getName(stringTable);
+    if (!name) {
+      // Leave the error to be reported by the serial symbol resolution.
+      consumeError(name.takeError());
+      hashedGlobalNames.clear();
+      return;
+    }
+    hashedGlobalNames.push_back(SymbolTable::hashName(*name));
+  }
+}
+
 // Initialize symbols. symbols is a parallel array to the corresponding ELF
 // symbol table.
 template <class ELFT>
@@ -1059,9 +1092,16 @@ void ObjFile<ELFT>::initializeSymbols(const object::ELFFile<ELFT> &obj) {
   }
 
   // Some entries have been filled by LazyObjFile.
-  for (size_t i = firstGlobal, end = eSyms.size(); i != end; ++i)
-    if (!symbols[i])
-      symbols[i] = symtab.insert(CHECK(eSyms[i].getName(stringTable), this));
+  if (!hashedGlobalNames.empty()) {
+    for (size_t i = firstGlobal, end = eSyms.size(); i != end; ++i)
+      if (!symbols[i])
+        symbols[i] = symtab.insert(hashedGlobalNames[i - firstGlobal]);
+    hashedGlobalNames = SmallVector<HashedSymbolName, 0>();
+  } else {
+    for (size_t i = firstGlobal, end = eSyms.size(); i != end; ++i)
+      if (!symbols[i])
+        symbols[i] = symtab.insert(CHECK(eSyms[i].getName(stringTable), this));
+  }
 
   // Perform symbol resolution on non-local symbols.
   SmallVector<unsigned, 32> undefineds;
@@ -1796,13 +1836,23 @@ template <class ELFT> void ObjFile<ELFT>::parseLazy() {
   numSymbols = eSyms.size();
   symbols = std::make_unique<Symbol *[]>(numSymbols);
 
+  // Only the defined symbols were hashed. Take the hashes before resolve() can
+  // extract this file, so that initializeSymbols() reads the names of the
+  // undefined symbols from the string table. Most lazy files are never
+  // extracted, so don't keep the hashes around either way.
+  SmallVector<HashedSymbolName, 0> hashedNames = std::move(hashedGlobalNames);
+  hashedGlobalNames.clear();
+
   // resolve() may trigger this->extract() if an existing symbol is an undefined
   // symbol. If that happens, this function has served its purpose, and we can
   // exit from the loop early.
   for (size_t i = firstGlobal, end = eSyms.size(); i != end; ++i) {
     if (eSyms[i].st_shndx == SHN_UNDEF)
       continue;
-    symbols[i] = symtab.insert(CHECK(eSyms[i].getName(stringTable), this));
+    if (!hashedNames.empty())
+      symbols[i] = symtab.insert(hashedNames[i - firstGlobal]);
+    else
+      symbols[i] = symtab.insert(CHECK(eSyms[i].getName(stringTable), this));
     symbols[i]->resolve(LazyObject{*this});
     if (!lazy)
       break;
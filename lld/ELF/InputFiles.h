@@ -10,6 +10,7 @@
 #define LLD_ELF_INPUT_FILES_H
 
 #include "Config.h"
+#include "SymbolTable.h"
 #include "Symbols.h"
 #include "lld/Common/ErrorHandler.h"
 #include "lld/Common/LLVM.h"
@@ -47,6 +48,7 @@ std::optional<MemoryBufferRef> readFile(StringRef path);
 
 // Add symbols in File to the symbol table.
 void parseFile(InputFile *file);
+void hashGlobalSymbolNames(InputFile *file);
 
 void parseArmCMSEImportLib(InputFile *file);
 
@@ -287,6 +289,7 @@ public:
   DWARFCache *getDwarf();
 
   void initSectionsAndLocalSyms(bool ignoreComdats);
+  void hashGlobalSymbolNames();
   void postParse();
   void importCmseSymbols();
   void redirectCmseSymbols();
@@ -324,6 +327,11 @@ private:
   // parse it only once for each object file we link.
   std::unique_ptr<DWARFCache> dwarf;
   llvm::once_flag initDwarf;
+
+  // The names of the global symbols, hashed in parallel by
+  // hashGlobalSymbolNames() before the serial symbol resolution. Empty if the
+  // names have not been hashed or have already been inserted.
+  SmallVector<HashedSymbolName, 0> hashedGlobalNames;
 };
 
 class BitcodeFile : public InputFile {
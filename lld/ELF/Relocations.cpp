@@ -1126,9 +1126,17 @@ void RelocationScanner::processAux(RelExpr expr, RelType type, uint64_t offset,
     } else if (rel != 0) {
       if (config->emachine == EM_MIPS && rel == target->symbolicRel)
         rel = target->relativeRel;
-      std::lock_guard<std::mutex> lock(relocMutex);
-      sec->getPartition().relaDyn->addSymbolReloc(rel, *sec, offset, sym,
-                                                  addend, type);
+      // With -z combreloc, the dynamic relocations are sorted after scanning,
+      // so they can be added to per-thread buffers without locking.
+      // Otherwise, keep them in scanning order.
+      if (config->zCombreloc) {
+        sec->getPartition().relaDyn->addSymbolReloc<true>(rel, *sec, offset,
+                                                          sym, addend, type);
+      } else {
+        std::lock_guard<std::mutex> lock(relocMutex);
+        sec->getPartition().relaDyn->addSymbolReloc(rel, *sec, offset, sym,
+                                                    addend, type);
+      }
 
       // MIPS ABI turns using of GOT and dynamic relocations inside out.
       // While regular ABI uses dynamic relocations to fill up GOT entries
@@ -1145,8 +1153,10 @@ void RelocationScanner::processAux(RelExpr expr, RelType type, uint64_t offset,
       // to the GOT entry and reads the GOT entry when it needs to perform
       // a dynamic relocation.
       // ftp://www.linux-mips.org/pub/linux/mips/doc/ABI/mipsabi.pdf p.4-19
-      if (config->emachine == EM_MIPS)
+      if (config->emachine == EM_MIPS) {
+        std::lock_guard<std::mutex> lock(relocMutex);
         in.mipsGot->addEntry(*sec->file, sym, addend, expr);
+      }
       return;
     }
   }
@@ -1551,17 +1561,41 @@ template <class ELFT> void elf::scanRelocations() {
   bool serial = !config->zCombreloc || config->emachine == EM_MIPS ||
                 config->emachine == EM_PPC64;
   parallel::TaskGroup tg;
+  auto spawn = [&](SmallVector<InputSectionBase *, 0> &sections) {
+    tg.spawn(
+        [sections = std::move(sections)]() {
+          RelocationScanner scanner;
+          for (InputSectionBase *s : sections)
+            scanner.template scanSection<ELFT>(*s);
+        },
+        serial);
+    sections.clear();
+  };
+
+  // Sections are scanned in batches of roughly scanBatchSize relocations.
+  // Most object files fit in one batch, while large ones (e.g. the output of
+  // LTO) are split so that a single file does not bound the scanning time.
+  // Scanning different sections of one file concurrently is fine, as all
+  // shared state is either atomic, sharded by thread or guarded by relocMutex.
+  constexpr size_t scanBatchSize = 1 << 14;
   for (ELFFileBase *f : ctx.objectFiles) {
-    auto fn = [f]() {
-      RelocationScanner scanner;
-      for (InputSectionBase *s : f->getSections()) {
-        if (s && s->kind() == SectionBase::Regular && s->isLive() &&
-            (s->flags & SHF_ALLOC) &&
-            !(s->type == SHT_ARM_EXIDX && config->emachine == EM_ARM))
-          scanner.template scanSection<ELFT>(*s);
+    SmallVector<InputSectionBase *, 0> sections;
+    size_t numRelocs = 0;
+    for (InputSectionBase *s : f->getSections()) {
+      if (!s || s->kind() != SectionBase::Regular || !s->isLive() ||
+          !(s->flags & SHF_ALLOC) ||
+          (s->type == SHT_ARM_EXIDX && config->emachine == EM_ARM))
+        continue;
+      const RelsOrRelas<ELFT> rels = s->template relsOrRelas<ELFT>();
+      numRelocs += rels.rels.size() + rels.relas.size();
+      sections.push_back(s);
+      if (numRelocs >= scanBatchSize) {
+        spawn(sections);
+        numRelocs = 0;
       }
-    };
-    tg.spawn(fn, serial);
+    }
+    if (!sections.empty())
+      spawn(sections);
   }
 
   tg.spawn([] {
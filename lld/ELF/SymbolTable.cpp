@@ -62,8 +62,7 @@ void SymbolTable::wrap(Symbol *sym, Symbol *real, Symbol *wrap) {
   real->isUsedInRegularObj = false;
 }
 
-// Find an existing symbol or create a new one.
-Symbol *SymbolTable::insert(StringRef name) {
+HashedSymbolName SymbolTable::hashName(StringRef name) {
   // <name>@@<version> means the symbol is the default version. In that
   // case <name>@@<version> will be used to resolve references to <name>.
   //
@@ -74,8 +73,16 @@ Symbol *SymbolTable::insert(StringRef name) {
   size_t pos = name.find('@');
   if (pos != StringRef::npos && pos + 1 < name.size() && name[pos + 1] == '@')
     stem = name.take_front(pos);
+  return {name, static_cast<uint32_t>(stem.size()),
+          CachedHashStringRef(stem).hash(), pos != StringRef::npos};
+}
 
-  auto p = symMap.insert({CachedHashStringRef(stem), (int)symVector.size()});
+// Find an existing symbol or create a new one.
+Symbol *SymbolTable::insert(const HashedSymbolName &hashed) {
+  StringRef name = hashed.name;
+  StringRef stem = name.take_front(hashed.stemSize);
+  auto p = symMap.insert(
+      {CachedHashStringRef(stem, hashed.stemHash), (int)symVector.size()});
   if (!p.second) {
     Symbol *sym = symVector[p.first->second];
     if (stem.size() != name.size()) {
@@ -94,7 +101,7 @@ Symbol *SymbolTable::insert(StringRef name) {
   sym->partition = 1;
   sym->verdefIndex = -1;
   sym->versionId = VER_NDX_GLOBAL;
-  if (pos != StringRef::npos)
+  if (hashed.hasVersion)
     sym->hasVersionSuffix = true;
   return sym;
 }
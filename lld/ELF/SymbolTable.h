@@ -24,6 +24,17 @@ struct ArmCmseEntryFunction {
   Symbol *sym;
 };
 
+// A symbol name with the hash of its stem (the name without a "@@<version>"
+// suffix) computed ahead of time. Computing these does not access the symbol
+// table, so it can be done for many files in parallel before their symbols
+// are inserted.
+struct HashedSymbolName {
+  StringRef name;
+  uint32_t stemSize;
+  uint32_t stemHash;
+  bool hasVersion;
+};
+
 // SymbolTable is a bucket of all known symbols, including defined,
 // undefined, or lazy symbols (the last one is symbols in archive
 // files whose archive members are not yet loaded).
@@ -42,7 +53,9 @@ public:
 
   void wrap(Symbol *sym, Symbol *real, Symbol *wrap);
 
-  Symbol *insert(StringRef name);
+  static HashedSymbolName hashName(StringRef name);
+  Symbol *insert(StringRef name) { return insert(hashName(name)); }
+  Symbol *insert(const HashedSymbolName &name);
 
   template <typename T> Symbol *addSymbol(const T &newSym) {
     Symbol *sym = insert(newSym.getName());
@@ -1610,13 +1610,22 @@ RelocationBaseSection::RelocationBaseSection(StringRef name, uint32_t type,
       dynamicTag(dynamicTag), sizeDynamicTag(sizeDynamicTag),
       relocsVec(concurrency), combreloc(combreloc) {}
 
+template <bool shard>
 void RelocationBaseSection::addSymbolReloc(
     RelType dynType, InputSectionBase &isec, uint64_t offsetInSec, Symbol &sym,
     int64_t addend, std::optional<RelType> addendRelType) {
-  addReloc(DynamicReloc::AgainstSymbol, dynType, isec, offsetInSec, sym, addend,
-           R_ADDEND, addendRelType ? *addendRelType : target->noneRel);
+  addReloc<shard>(DynamicReloc::AgainstSymbol, dynType, isec, offsetInSec, sym,
+                  addend, R_ADDEND,
+                  addendRelType ? *addendRelType : target->noneRel);
 }
 
+template void RelocationBaseSection::addSymbolReloc<false>(
+    RelType, InputSectionBase &, uint64_t, Symbol &, int64_t,
+    std::optional<RelType>);
+template void RelocationBaseSection::addSymbolReloc<true>(
+    RelType, InputSectionBase &, uint64_t, Symbol &, int64_t,
+    std::optional<RelType>);
+
 void RelocationBaseSection::addAddendOnlyRelocIfNonPreemptible(
     RelType dynType, GotSection &sec, uint64_t offsetInSec, Symbol &sym,
     RelType addendRelType) {
@@ -1683,13 +1692,17 @@ void RelocationBaseSection::computeRels() {
   // Sort by (!IsRelative,SymIndex,r_offset). DT_REL[A]COUNT requires us to
   // place R_*_RELATIVE first. SymIndex is to improve locality, while r_offset
   // is to make results easier to read.
+  //
+  // Symbolic relocations may have been added from several threads, so their
+  // order before sorting is not deterministic. Break the remaining ties on
+  // type and addend so that the output does not depend on it either.
   if (combreloc) {
     auto nonRelative = relocs.begin() + numRelativeRelocs;
     parallelSort(relocs.begin(), nonRelative,
                  [&](auto &a, auto &b) { return a.r_offset < b.r_offset; });
-    // Non-relative relocations are few, so don't bother with parallelSort.
-    llvm::sort(nonRelative, relocs.end(), [&](auto &a, auto &b) {
-      return std::tie(a.r_sym, a.r_offset) < std::tie(b.r_sym, b.r_offset);
+    parallelSort(nonRelative, relocs.end(), [&](auto &a, auto &b) {
+      return std::tie(a.r_sym, a.r_offset, a.type, a.addend) <
+             std::tie(b.r_sym, b.r_offset, b.type, b.addend);
     });
   }
 }
@@ -41,6 +41,9 @@ struct ARM64 : ARM64Common {
                             uint64_t selectorIndex, uint64_t gotAddr,
                             uint64_t msgSendIndex) const override;
   void populateThunk(InputSection *thunk, Symbol *funcSym) override;
+  void initICFSafeThunkBody(InputSection *thunk,
+                            Symbol *targetSym) const override;
+  uint32_t getICFSafeThunkSize() const override;
   void applyOptimizationHints(uint8_t *, const ObjFile &) const override;
 };
 
@@ -149,6 +152,27 @@ void ARM64::populateThunk(InputSection *thunk, Symbol *funcSym) {
                              /*referent=*/funcSym);
 }
 
+// An --icf=safe_thunks thunk keeps the address of an address-significant
+// function while its body is shared with an identical function.
+static constexpr uint32_t icfSafeThunkCode[] = {
+    0x14000000, // 00: b  target
+};
+
+void ARM64::initICFSafeThunkBody(InputSection *thunk,
+                                 Symbol *targetSym) const {
+  thunk->data = {reinterpret_cast<const uint8_t *>(icfSafeThunkCode),
+                 sizeof(icfSafeThunkCode)};
+  thunk->relocs.clear();
+  thunk->relocs.emplace_back(/*type=*/ARM64_RELOC_BRANCH26,
+                             /*pcrel=*/true, /*length=*/2,
+                             /*offset=*/0, /*addend=*/0,
+                             /*referent=*/targetSym);
+}
+
+uint32_t ARM64::getICFSafeThunkSize() const {
+  return sizeof(icfSafeThunkCode);
+}
+
 ARM64::ARM64() : ARM64Common(LP64()) {
   cpuType = CPU_TYPE_ARM64;
   cpuSubtype = CPU_SUBTYPE_ARM64_ALL;
@@ -40,6 +40,7 @@ public:
   void forEachClassRange(size_t begin, size_t end,
                          llvm::function_ref<void(size_t, size_t)> func);
   void forEachClass(llvm::function_ref<void(size_t, size_t)> func);
+  void applySafeThunksToRange(size_t begin, size_t end);
 
   bool equalsConstant(const ConcatInputSection *ia,
                       const ConcatInputSection *ib);
@@ -310,10 +311,16 @@ void ICF::run() {
     });
   }
 
-  llvm::stable_sort(
-      icfInputs, [](const ConcatInputSection *a, const ConcatInputSection *b) {
-        return a->icfEqClass[0] < b->icfEqClass[0];
-      });
+  // Group sections by hash. icfEqClass[1] is free until the first
+  // segregation pass, so use it to hold the input order, which keeps the sort
+  // deterministic without a stable sort or a separate index array.
+  parallelFor(0, icfInputs.size(),
+              [&](size_t i) { icfInputs[i]->icfEqClass[1] = i; });
+  parallelSort(icfInputs, [](const ConcatInputSection *a,
+                             const ConcatInputSection *b) {
+    return std::tie(a->icfEqClass[0], a->icfEqClass[1]) <
+           std::tie(b->icfEqClass[0], b->icfEqClass[1]);
+  });
   forEachClass([&](size_t begin, size_t end) {
     segregate(begin, end, &ICF::equalsConstant);
   });
@@ -331,16 +338,77 @@ void ICF::run() {
     log("equalsVariable() called " + Twine(equalsVariableCount) + " times");
   }
 
-  // Fold sections within equivalence classes
+  // Turning sections into thunks touches the unwind entries of other classes,
+  // so it is done serially before the parallel folding below.
+  const bool useSafeThunks = config->icfLevel == ICFLevel::safe_thunks;
+  if (useSafeThunks)
+    forEachClassRange(0, icfInputs.size(), [&](size_t begin, size_t end) {
+      applySafeThunksToRange(begin, end);
+    });
+
+  // Fold sections within equivalence classes. With safe_thunks, sections that
+  // are address-significant keep their address, either as the surviving body
+  // or as a thunk, and the discarded unwind entries of thunks are skipped.
   forEachClass([&](size_t begin, size_t end) {
     if (end - begin < 2)
       return;
+    auto isFoldable = [&](const ConcatInputSection *isec) {
+      return isec->live && !(useSafeThunks && isec->keepUnique);
+    };
+    while (begin < end && !icfInputs[begin]->live)
+      ++begin;
+    if (begin == end)
+      return;
     ConcatInputSection *beginIsec = icfInputs[begin];
     for (size_t i = begin + 1; i < end; ++i)
-      beginIsec->foldIdentical(icfInputs[i]);
+      if (isFoldable(icfInputs[i]))
+        beginIsec->foldIdentical(icfInputs[i]);
   });
 }
 
+// With --icf=safe_thunks, functions whose address is significant cannot be
+// folded away. Instead, one of them keeps the shared body, and the rest have
+// their bodies replaced by a branch to it. Each function thus keeps a distinct
+// address while only one copy of the code remains.
+void ICF::applySafeThunksToRange(size_t begin, size_t end) {
+  if (end - begin < 2 || !isCodeSection(icfInputs[begin]))
+    return;
+  auto first = icfInputs.begin() + begin;
+  auto last = icfInputs.begin() + end;
+  auto isKeepUnique = [](const ConcatInputSection *isec) {
+    return isec->keepUnique;
+  };
+  if (std::none_of(first, last, isKeepUnique))
+    return;
+
+  // Move the address-significant sections to the front, so that the body is
+  // kept by one of them and it needs no thunk.
+  std::stable_partition(first, last, isKeepUnique);
+
+  // A thunk no smaller than the function itself would not save anything.
+  ConcatInputSection *masterIsec = icfInputs[begin];
+  if (masterIsec->data.size() <= target->getICFSafeThunkSize() ||
+      masterIsec->symbols.empty())
+    return;
+  Symbol *targetSym = masterIsec->symbols.front();
+
+  for (size_t i = begin + 1; i < end && icfInputs[i]->keepUnique; ++i) {
+    ConcatInputSection *isec = icfInputs[i];
+    target->initICFSafeThunkBody(isec, targetSym);
+    for (Defined *d : isec->symbols) {
+      d->size = isec->data.size();
+      // The unwind info of the original body does not describe the thunk.
+      // Its entry is identical to the one of the surviving body, so drop it
+      // and keep it from being chosen as the survivor of its own class.
+      if (d->unwindEntry) {
+        d->unwindEntry->live = false;
+        d->unwindEntry->keepUnique = true;
+        d->unwindEntry = nullptr;
+      }
+    }
+  }
+}
+
 // Split an equivalence class into smaller classes.
 void ICF::segregate(size_t begin, size_t end, EqualsFn equals) {
   while (begin < end) {
@@ -412,6 +480,8 @@ void macho::foldIdenticalSections(bool onlyCfStrings) {
   // someone keep the numbers straight in case we ever need to debug the
   // ICF::segregate()
   std::vector<ConcatInputSection *> foldable;
+  std::vector<ConcatInputSection *> addendsRemoved;
+  const bool useSafeThunks = config->icfLevel == ICFLevel::safe_thunks;
   uint64_t icfUniqueID = inputSections.size();
   for (ConcatInputSection *isec : inputSections) {
     bool isFoldableWithAddendsRemoved = isCfStringSection(isec) ||
@@ -421,12 +491,16 @@ void macho::foldIdenticalSections(bool onlyCfStrings) {
     // can still fold it.
     bool hasFoldableFlags = (isSelRefsSection(isec) ||
                              sectionType(isec->getFlags()) == MachO::S_REGULAR);
+    // With safe_thunks, address-significant code is still folded, but through
+    // a thunk that preserves its address (see ICF::applySafeThunksToRange).
+    bool canFoldKeepUnique = useSafeThunks && isCodeSection(isec);
     // FIXME: consider non-code __text sections as foldable?
     bool isFoldable = (!onlyCfStrings || isCfStringSection(isec)) &&
                       (isCodeSection(isec) || isFoldableWithAddendsRemoved ||
                        isGccExceptTabSection(isec)) &&
-                      !isec->keepUnique && !isec->hasAltEntry &&
-                      !isec->shouldOmitFromOutput() && hasFoldableFlags;
+                      (!isec->keepUnique || canFoldKeepUnique) &&
+                      !isec->hasAltEntry && !isec->shouldOmitFromOutput() &&
+                      hasFoldableFlags;
     if (isFoldable) {
       foldable.push_back(isec);
       for (Defined *d : isec->symbols)
@@ -438,21 +512,32 @@ void macho::foldIdenticalSections(bool onlyCfStrings) {
       // information gets recorded in our Reloc structs.) We therefore create a
       // mutable copy of the section data and zero out the embedded addends
       // before performing any hashing / equality checks.
-      if (isFoldableWithAddendsRemoved) {
-        // We have to do this copying serially as the BumpPtrAllocator is not
-        // thread-safe. FIXME: Make a thread-safe allocator.
-        MutableArrayRef<uint8_t> copy = isec->data.copy(bAlloc());
-        for (const Reloc &r : isec->relocs)
-          target->relocateOne(copy.data() + r.offset, r, /*va=*/0,
-                              /*relocVA=*/0);
-        isec->data = copy;
-      }
+      if (isFoldableWithAddendsRemoved)
+        addendsRemoved.push_back(isec);
     } else if (!isEhFrameSection(isec)) {
       // EH frames are gathered as foldables from unwindEntry above; give a
       // unique ID to everything else.
       isec->icfEqClass[0] = ++icfUniqueID;
     }
   }
+  // We have to allocate the copies serially as the BumpPtrAllocator is not
+  // thread-safe, but they can be filled in in parallel.
+  // FIXME: Make a thread-safe allocator.
+  std::vector<MutableArrayRef<uint8_t>> copies;
+  copies.reserve(addendsRemoved.size());
+  for (ConcatInputSection *isec : addendsRemoved)
+    copies.emplace_back(bAlloc().Allocate<uint8_t>(isec->data.size()),
+                        isec->data.size());
+  parallelFor(0, addendsRemoved.size(), [&](size_t i) {
+    ConcatInputSection *isec = addendsRemoved[i];
+    MutableArrayRef<uint8_t> copy = copies[i];
+    llvm::copy(isec->data, copy.begin());
+    for (const Reloc &r : isec->relocs)
+      target->relocateOne(copy.data() + r.offset, r, /*va=*/0,
+                          /*relocVA=*/0);
+    isec->data = copy;
+  });
+
   parallelForEach(foldable, [](ConcatInputSection *isec) {
     assert(isec->icfEqClass[0] == 0); // don't overwrite a unique ID!
     // Turn-on the top bit to guarantee that valid hashes have no collisions
@@ -88,6 +88,16 @@ public:
     llvm_unreachable("target does not use thunks");
   }
 
+  // Replace the body of an address-significant function folded by
+  // --icf=safe_thunks with a branch to the identical function \p targetSym.
+  virtual void initICFSafeThunkBody(InputSection *thunk,
+                                    Symbol *targetSym) const {
+    llvm_unreachable("target does not support --icf=safe_thunks");
+  }
+
+  // Returns 0 if the target does not support --icf=safe_thunks.
+  virtual uint32_t getICFSafeThunkSize() const { return 0; }
+
   const RelocAttrs &getRelocAttrs(uint8_t type) const {
     assert(type < relocAttrs.size() && "invalid relocation type");
     if (type >= relocAttrs.size())
@@ -0,0 +1,80 @@
+# REQUIRES: x86
+## Symbol names are hashed in parallel before symbol resolution. For lazy
+## files only the defined symbols are hashed. Check that symbols of extracted
+## members, including their undefined and versioned symbols, are still
+## resolved correctly, and that members that are not needed are not extracted.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=x86_64 a.s -o a.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 b.s -o b.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 c.s -o c.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 d.s -o d.o
+# RUN: llvm-ar rc lib.a b.o c.o d.o
+
+# RUN: ld.lld -shared --version-script=ver a.o lib.a -o out.so
+# RUN: llvm-readelf --dyn-syms out.so | FileCheck %s \
+# RUN:   --implicit-check-not=baz --implicit-check-not=qux
+# RUN: ld.lld -shared --version-script=ver a.o --start-lib b.o c.o d.o \
+# RUN:   --end-lib -o out2.so
+# RUN: llvm-readelf --dyn-syms out2.so | FileCheck %s \
+# RUN:   --implicit-check-not=baz --implicit-check-not=qux
+
+# CHECK-DAG: {{ }}bar{{$}}
+# CHECK-DAG: {{ }}foo@@V1{{$}}
+# CHECK-DAG: {{ }}start{{$}}
+
+## The undefined symbols of a member that is extracted while its defined
+## symbols are inserted must keep their names. An executable may not have
+## undefined symbols, so a member's undefined symbol that lost its name would
+## fail the link.
+# RUN: llvm-mc -filetype=obj -triple=x86_64 e.s -o e.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 f.s -o f.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 g.s -o g.o
+# RUN: llvm-ar rc lib2.a f.o g.o
+# RUN: ld.lld e.o lib2.a -o exe
+# RUN: llvm-nm exe | FileCheck %s --check-prefix=EXE
+# RUN: ld.lld e.o --start-lib f.o g.o --end-lib -o exe2
+# RUN: llvm-nm exe2 | FileCheck %s --check-prefix=EXE
+
+# EXE:      T _start
+# EXE-NEXT: T f
+# EXE-NEXT: T g
+
+#--- ver
+V1 { global: *; };
+
+#--- a.s
+.globl start
+start:
+  call foo@plt
+
+#--- b.s
+.globl foo_impl
+.symver foo_impl, foo@@V1
+foo_impl:
+  call bar@plt
+
+#--- c.s
+.globl bar
+bar:
+  ret
+
+#--- d.s
+.globl baz
+baz:
+  call qux@plt
+
+#--- e.s
+.globl _start
+_start:
+  call f
+
+#--- f.s
+.globl f
+f:
+  call g
+
+#--- g.s
+.globl g
+g:
+  ret
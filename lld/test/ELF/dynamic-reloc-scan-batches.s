@@ -0,0 +1,37 @@
+# REQUIRES: x86
+## Relocations are scanned in batches of 1<<14 relocations and symbolic
+## dynamic relocations are collected per thread. Check that a file with more
+## relocations than one batch links to the same output regardless of the
+## number of threads.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld -shared --threads=1 %t.o -o %t1.so
+# RUN: ld.lld -shared --threads=4 %t.o -o %t4.so
+# RUN: cmp %t1.so %t4.so
+# RUN: llvm-readelf -r %t4.so | FileCheck %s
+
+## 2 sections * 12000 * (2 symbolic + 1 relative) relocations.
+# CHECK:      Relocation section '.rela.dyn' at offset {{.*}} contains 72000 entries:
+# CHECK-NEXT: Offset {{.*}} Type {{.*}}
+# CHECK-NEXT: {{.*}} R_X86_64_RELATIVE {{.*}}
+
+.globl foo, bar
+.hidden local
+foo:
+bar:
+local:
+  ret
+
+.section .data.a,"aw"
+.rept 12000
+.quad foo
+.quad bar + 8
+.quad local
+.endr
+
+.section .data.b,"aw"
+.rept 12000
+.quad bar
+.quad foo - 8
+.quad local + 16
+.endr
@@ -0,0 +1,107 @@
+# REQUIRES: x86
+## Test that --incremental skips a link only if neither the inputs, the
+## options nor the output changed since the last link.
+
+# RUN: rm -rf %t && split-file %s %t && cd %t
+# RUN: llvm-mc -filetype=obj -triple=x86_64 a.s -o a.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 b.s -o b.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 b2.s -o b2.o
+
+# RUN: ld.lld --incremental a.o b.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=LINK
+# RUN: ld.lld --incremental a.o b.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SKIP
+
+# LINK-NOT: is up to date
+# SKIP: out is up to date
+
+## An input changed.
+# RUN: cp b2.o b.o
+# RUN: ld.lld --incremental a.o b.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=LINK
+# RUN: llvm-nm out | FileCheck %s --check-prefix=B2
+# RUN: ld.lld --incremental a.o b.o -o out --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SKIP
+
+# B2: b2
+
+## An option changed.
+# RUN: ld.lld --incremental a.o b.o -o out --gc-sections --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=LINK
+# RUN: ld.lld --incremental a.o b.o -o out --gc-sections --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SKIP
+
+## The output was modified.
+# RUN: echo >> out
+# RUN: ld.lld --incremental a.o b.o -o out --gc-sections --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=LINK
+# RUN: ld.lld --incremental a.o b.o -o out --gc-sections --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SKIP
+
+## A file that is only read late in the link changed.
+# RUN: echo "_start b 1" > cg.txt
+# RUN: ld.lld --incremental a.o b.o -o out --call-graph-ordering-file=cg.txt \
+# RUN:   --verbose 2>&1 | FileCheck %s --check-prefix=LINK
+# RUN: ld.lld --incremental a.o b.o -o out --call-graph-ordering-file=cg.txt \
+# RUN:   --verbose 2>&1 | FileCheck %s --check-prefix=SKIP
+# RUN: echo "_start b 2" > cg.txt
+# RUN: ld.lld --incremental a.o b.o -o out --call-graph-ordering-file=cg.txt \
+# RUN:   --verbose 2>&1 | FileCheck %s --check-prefix=LINK
+
+## Links with other outputs are never skipped.
+# RUN: ld.lld --incremental a.o b.o -o out -Map=out.map --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=LINK
+# RUN: rm out.map
+# RUN: ld.lld --incremental a.o b.o -o out -Map=out.map --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=SIDE \
+# RUN:   --implicit-check-not='is up to date'
+# RUN: ls out.map
+
+# SIDE: --incremental: not skipping the link because of --Map
+
+# RUN: ld.lld --incremental a.o b.o -o out --reproduce=repro.tar --verbose \
+# RUN:   2>&1 | FileCheck %s --check-prefix=REPRO \
+# RUN:   --implicit-check-not='is up to date'
+# RUN: ld.lld --incremental a.o b.o -o out --reproduce=repro.tar --verbose \
+# RUN:   2>&1 | FileCheck %s --check-prefix=REPRO \
+# RUN:   --implicit-check-not='is up to date'
+
+# REPRO: --incremental: not skipping the link because of --reproduce
+
+## A link that reported warnings is not skipped the next time, so the warnings
+## are reported again.
+# RUN: ld.lld --incremental a.o b.o -o out -z unknown --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=WARN \
+# RUN:   --implicit-check-not='is up to date'
+# RUN: ld.lld --incremental a.o b.o -o out -z unknown --verbose 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=WARN \
+# RUN:   --implicit-check-not='is up to date'
+# RUN: not ls out.incremental
+
+# WARN: warning: unknown -z value: unknown
+
+## A skipped link still writes the time trace.
+# RUN: ld.lld --incremental a.o b.o -o out --time-trace=out.time.json \
+# RUN:   --verbose 2>&1 | FileCheck %s --check-prefix=LINK
+# RUN: rm out.time.json
+# RUN: ld.lld --incremental a.o b.o -o out --time-trace=out.time.json \
+# RUN:   --verbose 2>&1 | FileCheck %s --check-prefix=SKIP
+# RUN: FileCheck %s --check-prefix=TIME < out.time.json
+
+# TIME: "traceEvents"
+
+#--- a.s
+.globl _start
+_start:
+  call b
+
+#--- b.s
+.globl b
+b:
+  ret
+
+#--- b2.s
+.globl b, b2
+b:
+b2:
+  ret
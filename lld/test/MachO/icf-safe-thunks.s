@@ -0,0 +1,102 @@
+# REQUIRES: aarch64, x86
+## Test --icf=safe_thunks: identical functions whose address is significant
+## (listed in __llvm_addrsig) keep their own address and become a branch to
+## the surviving body, while the others are folded as with --icf=all.
+
+# RUN: rm -rf %t; split-file %s %t
+# RUN: llvm-mc -filetype=obj -triple=arm64-apple-macos11.0 %t/a.s -o %t/a.o
+# RUN: %lld -arch arm64 -lSystem --icf=safe_thunks -dylib %t/a.o -o %t/a.dylib
+# RUN: llvm-nm -n %t/a.dylib | FileCheck %s --check-prefix=NM
+# RUN: llvm-objdump -d --no-show-raw-insn %t/a.dylib \
+# RUN:   | FileCheck %s --check-prefix=DIS
+
+## _func_c is not address-significant and is folded into _func_a. _func_b is
+## address-significant and keeps a distinct address.
+# NM:      [[#%x,A:]] T _func_a
+# NM-NEXT: [[#A]]     T _func_c
+# NM-NEXT: [[#%x,A+12]] T _func_b
+
+## The body of _func_b is replaced by a branch to the surviving copy.
+# DIS-LABEL: <_func_a>:
+# DIS-NEXT:    mov w0, #0x1
+# DIS-NEXT:    add w0, w0, #0x2
+# DIS-NEXT:    ret
+# DIS-LABEL: <_func_b>:
+# DIS-NEXT:    b 0x[[#%x,]] <_func_a>
+
+## Thunking functions that are no larger than a branch saves nothing, so
+## those are neither folded nor turned into thunks.
+# DIS-LABEL: <_tiny_a>:
+# DIS-NEXT:    ret
+# DIS-LABEL: <_tiny_b>:
+# DIS-NEXT:    ret
+
+## With --icf=safe, address-significant functions are not folded at all.
+# RUN: %lld -arch arm64 -lSystem --icf=safe -dylib %t/a.o -o %t/safe.dylib
+# RUN: llvm-objdump -d --no-show-raw-insn %t/safe.dylib \
+# RUN:   | FileCheck %s --check-prefix=SAFE
+
+# SAFE-LABEL: <_func_a>:
+# SAFE-NEXT:    mov w0, #0x1
+# SAFE-LABEL: <_func_b>:
+# SAFE-NEXT:    mov w0, #0x1
+
+## safe_thunks requires a target that implements the thunks.
+# RUN: llvm-mc -filetype=obj -triple=x86_64-apple-macos11.0 %t/x86.s \
+# RUN:   -o %t/x86.o
+# RUN: not %lld -lSystem --icf=safe_thunks -dylib %t/x86.o -o /dev/null 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=ERR
+
+# ERR: error: --icf=safe_thunks is only supported on arm64 targets
+
+#--- a.s
+.subsections_via_symbols
+.text
+
+.globl _func_a, _func_b, _func_c, _tiny_a, _tiny_b, _caller
+
+.p2align 2
+_func_a:
+  mov w0, #1
+  add w0, w0, #2
+  ret
+
+.p2align 2
+_func_b:
+  mov w0, #1
+  add w0, w0, #2
+  ret
+
+.p2align 2
+_func_c:
+  mov w0, #1
+  add w0, w0, #2
+  ret
+
+.p2align 2
+_tiny_a:
+  ret
+
+.p2align 2
+_tiny_b:
+  ret
+
+.p2align 2
+_caller:
+  bl _func_a
+  bl _func_b
+  bl _func_c
+  bl _tiny_a
+  bl _tiny_b
+  ret
+
+.addrsig
+.addrsig_sym _func_a
+.addrsig_sym _func_b
+.addrsig_sym _tiny_a
+.addrsig_sym _tiny_b
+
+#--- x86.s
+.globl _f
+_f:
+  ret
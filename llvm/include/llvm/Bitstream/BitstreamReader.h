@@ -16,7 +16,9 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Bitstream/BitCodes.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBufferRef.h"
@@ -350,6 +352,38 @@ struct BitstreamEntry {
   }
 };
 
+/// The entries of a block that BitstreamCursor::readBlockAhead() decoded in
+/// advance, including those of its nested blocks. A cursor can replay them
+/// instead of decoding the block again, so that the decoding of independent
+/// blocks can run on other threads than their parsing.
+class BitstreamDecodedBlock {
+  friend class BitstreamCursor;
+
+  struct DecodedEntry {
+    BitstreamEntry Entry;
+    /// The record code, or the size in words of a block.
+    unsigned CodeOrNumWords;
+    /// The operands of a record, or for a block the index of the entry
+    /// following its end.
+    size_t FirstOp;
+    size_t NumOpsOrEnd;
+    StringRef Blob;
+    bool HasBlob;
+  };
+
+  /// The first entry is the block itself and the last one is its end.
+  std::vector<DecodedEntry> Entries;
+  std::vector<uint64_t> Ops;
+
+public:
+  /// Forget the entries, but keep the storage for the next block.
+  void clear() {
+    Entries.clear();
+    Ops.clear();
+  }
+  bool empty() const { return Entries.empty(); }
+};
+
 /// This represents a position within a bitcode file, implemented on top of a
 /// SimpleBitstreamCursor.
 ///
@@ -375,6 +409,12 @@ class BitstreamCursor : SimpleBitstreamCursor {
 
   BitstreamBlockInfo *BlockInfo = nullptr;
 
+  /// The block being replayed, its next entry, and the last block entry that
+  /// advance() returned from it.
+  const BitstreamDecodedBlock *Replay = nullptr;
+  size_t ReplayNext = 0;
+  size_t ReplayBlock = 0;
+
 public:
   static const size_t MaxChunkSize = 32;
 
@@ -416,11 +456,14 @@ public:
 
   /// Advance the current bitstream, returning the next entry in the stream.
   Expected<BitstreamEntry> advance(unsigned Flags = 0) {
+    if (LLVM_UNLIKELY(Replay))
+      return advanceReplay();
+
     while (true) {
       if (AtEndOfStream())
         return BitstreamEntry::getError();
 
-      Expected<unsigned> MaybeCode = ReadCode();
+      Expected<unsigned> MaybeCode = Read(CurCodeSize);
       if (!MaybeCode)
         return MaybeCode.takeError();
       unsigned Code = MaybeCode.get();
@@ -471,7 +514,11 @@ public:
     }
   }
 
-  Expected<unsigned> ReadCode() { return Read(CurCodeSize); }
+  Expected<unsigned> ReadCode() {
+    if (LLVM_UNLIKELY(Replay))
+      return readCodeReplay();
+    return Read(CurCodeSize);
+  }
 
   // Block header:
   //    [ENTER_SUBBLOCK, blockid, newcodelen, <align4bytes>, blocklen]
@@ -482,6 +529,11 @@ public:
   /// Having read the ENTER_SUBBLOCK abbrevid and a BlockID, skip over the body
   /// of this block.
   Error SkipBlock() {
+    if (LLVM_UNLIKELY(Replay)) {
+      ReplayNext = Replay->Entries[ReplayBlock].NumOpsOrEnd;
+      return Error::success();
+    }
+
     // Read and ignore the codelen value.
     if (Expected<uint32_t> Res = ReadVBR(bitc::CodeLenWidth))
       ; // Since we are skipping this block, we don't care what code widths are
@@ -516,6 +568,9 @@ public:
   Error EnterSubBlock(unsigned BlockID, unsigned *NumWordsP = nullptr);
 
   bool ReadBlockEnd() {
+    // The end of a replayed block was already consumed by advance().
+    if (Replay)
+      return false;
     if (BlockScope.empty()) return true;
 
     // Block tail:
@@ -526,7 +581,27 @@ public:
     return false;
   }
 
+  /// Having read the ENTER_SUBBLOCK abbrevid and the \p BlockID, decode the
+  /// whole block into \p Decoded, and leave the cursor after its end. Abbrev
+  /// definitions are processed and do not appear in \p Decoded.
+  Error readBlockAhead(unsigned BlockID, BitstreamDecodedBlock &Decoded);
+
+  /// Read the block in \p Decoded instead of the bitstream until endReplay().
+  /// The block is entered with EnterSubBlock() as if the cursor was at its
+  /// start. While replaying, advance() does not return abbrev definitions,
+  /// and GetCurrentBitNo() and JumpToBit() still refer to the bitstream.
+  void startReplay(const BitstreamDecodedBlock &Decoded) {
+    assert(!Decoded.empty() && "Replaying a block that was not decoded");
+    Replay = &Decoded;
+    ReplayNext = 0;
+    ReplayBlock = 0;
+  }
+  void endReplay() { Replay = nullptr; }
+
 private:
+  Expected<BitstreamEntry> advanceReplay();
+  Expected<unsigned> readCodeReplay();
+
   void popBlockScope() {
     CurCodeSize = BlockScope.back().PrevCodeSize;
 
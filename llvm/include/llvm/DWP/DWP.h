@@ -4,6 +4,7 @@
 #include "DWPStringPool.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
@@ -54,12 +55,23 @@ struct InfoSectionUnitHeader {
   uint8_t HeaderSize = 0;
 };
 
+// An input .dwo/.dwp file opened by llvm::write, along with the contents of
+// its non-empty sections. Compressed sections have already been decompressed.
+struct DWPInput {
+  object::OwningBinary<object::ObjectFile> Obj;
+  std::vector<std::pair<StringRef, StringRef>> Sections;
+  std::deque<SmallString<32>> UncompressedSections;
+};
+
 struct CompileUnitIdentifiers {
   uint64_t Signature = 0;
   const char *Name = "";
   const char *DWOName = "";
 };
 
+// Merges the given .dwo/.dwp files into a single DWARF package. Inputs are
+// read and decompressed in parallel according to parallel::strategy; the
+// output does not depend on the number of threads used.
 Error write(MCStreamer &Out, ArrayRef<std::string> Inputs,
             bool ContinueOnCuIndexOverflow);
 
@@ -70,8 +82,7 @@ Error handleSection(
     const MCSection *StrSection, const MCSection *StrOffsetSection,
     const MCSection *TypesSection, const MCSection *CUIndexSection,
     const MCSection *TUIndexSection, const MCSection *InfoSection,
-    const object::SectionRef &Section, MCStreamer &Out,
-    std::deque<SmallString<32>> &UncompressedSections,
+    StringRef Name, StringRef Contents, MCStreamer &Out,
     uint32_t (&ContributionOffsets)[8], UnitIndexEntry &CurEntry,
     StringRef &CurStrSection, StringRef &CurStrOffsetSection,
     std::vector<StringRef> &CurTypesSection,
@@ -81,6 +92,8 @@ Error handleSection(
 
 Expected<InfoSectionUnitHeader> parseInfoSectionUnitHeader(StringRef Info);
 
+Expected<std::unique_ptr<DWPInput>> loadInput(StringRef Input);
+
 void writeStringsAndOffsets(MCStreamer &Out, DWPStringPool &Strings,
                             MCSection *StrOffsetSection,
                             StringRef CurStrSection,
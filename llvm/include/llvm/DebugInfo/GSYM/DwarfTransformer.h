@@ -13,6 +13,8 @@
 #include "llvm/DebugInfo/GSYM/ExtractRanges.h"
 #include "llvm/Support/Error.h"
 
+#include <vector>
+
 namespace llvm {
 
 class raw_ostream;
@@ -64,9 +66,8 @@ private:
   /// Handle any DIE (debug info entry) from the DWARF.
   ///
   /// This function will find all DW_TAG_subprogram DIEs that convert them into
-  /// GSYM FuntionInfo objects and add them to the GsymCreator supplied during
-  /// construction. The DIE and all its children will be recursively parsed
-  /// with calls to this function.
+  /// GSYM FuntionInfo objects and append them to \a Funcs. The DIE and all its
+  /// children will be recursively parsed with calls to this function.
   ///
   /// \param Strm The thread specific log stream for any non fatal errors and
   /// warnings. Once a thread has finished parsing an entire compile unit, all
@@ -79,7 +80,13 @@ private:
   /// information.
   ///
   /// \param Die The DWARF debug info entry to parse.
-  void handleDie(raw_ostream *Strm, CUInfo &CUI, DWARFDie Die);
+  ///
+  /// \param Funcs The compile unit specific buffer that new FunctionInfo
+  /// objects are appended to. The buffer is handed to the GsymCreator in one
+  /// call once the compile unit is done, so threads don't contend on the
+  /// GsymCreator lock for every function.
+  void handleDie(raw_ostream *Strm, CUInfo &CUI, DWARFDie Die,
+                 std::vector<FunctionInfo> &Funcs);
 
   DWARFContext &DICtx;
   GsymCreator &Gsym;
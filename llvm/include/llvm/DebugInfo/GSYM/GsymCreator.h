@@ -12,7 +12,9 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "llvm/ADT/AddressRanges.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -146,6 +148,12 @@ class GsymCreator {
   bool IsSegment = false;
   bool Finalized = false;
   bool Quiet;
+  // Function infos that are written to temporary files when there are more
+  // than SpillThreshold of them in memory. See setSpillThreshold().
+  size_t SpillThreshold = 0;
+  size_t NumSpilledFuncs = 0;
+  std::vector<std::string> SpillFiles;
+  std::string SpillError;
 
 
   /// Get the first function start address.
@@ -282,6 +290,36 @@ class GsymCreator {
                            llvm::support::endianness ByteOrder,
                            uint64_t SegmentSize) const;
 
+  /// Add a function info to the finalized function infos.
+  ///
+  /// \a Curr must not sort before the last function info in \a
+  /// FinalizedFuncs. Duplicate and overlapping function infos are removed or
+  /// merged as described in finalize().
+  void addFinalizedFunctionInfo(std::vector<FunctionInfo> &FinalizedFuncs,
+                                FunctionInfo &&Curr, raw_ostream &OS) const;
+
+  /// Spill the function infos in memory if there are more than the spill
+  /// threshold.
+  ///
+  /// Must be called with \a Mutex held. If spilling fails, all function infos
+  /// stay in memory and finalize() reports the error as a warning.
+  void spillFunctionInfosIfNeeded();
+
+  /// Sort the function infos in memory and write them to a temporary file.
+  ///
+  /// Must be called with \a Mutex held.
+  llvm::Error spillFunctionInfos();
+
+  /// Merge the spilled function infos and the function infos still in memory
+  /// into a sorted and uniqued list of function infos.
+  ///
+  /// Function infos that can no longer be merged with later ones only keep
+  /// their encoded bytes, which keeps the memory use of the final list low.
+  ///
+  /// \param OS The stream to report removed or merged function infos to.
+  /// \returns An error object that indicates success or failure of the merge.
+  llvm::Error mergeSpilledFunctionInfos(raw_ostream &OS);
+
   /// Let this creator know that this is a segment of another GsymCreator.
   ///
   /// When we have a segment, we know that function infos will be added in
@@ -293,6 +331,7 @@ class GsymCreator {
 
 public:
   GsymCreator(bool Quiet = false);
+  ~GsymCreator();
 
   /// Save a GSYM file to a stand alone file.
   ///
@@ -352,6 +391,28 @@ public:
   /// \param   FI The function info object to emplace into our functions list.
   void addFunctionInfo(FunctionInfo &&FI);
 
+  /// Add a list of function infos to this GSYM creator.
+  ///
+  /// This takes the lock once for all of the function infos, so threads that
+  /// produce function infos should collect them locally and add them in bulk.
+  ///
+  /// \param   FIs The function info objects to add to our functions list.
+  void addFunctionInfos(std::vector<FunctionInfo> &&FIs);
+
+  /// Limit the number of function infos that are kept in memory before
+  /// finalize() is called.
+  ///
+  /// Once more than \a MaxFuncs function infos have been added, they are
+  /// sorted and written to a temporary file, and finalize() merges all of
+  /// these files back together. Spilled function infos are not visited by
+  /// forEachFunctionInfo() until the creator has been finalized. If anything
+  /// was spilled, the finalized function infos only keep their encoded bytes
+  /// in FunctionInfo::EncodingCache.
+  ///
+  /// \param MaxFuncs The maximum number of function infos to keep in memory,
+  ///                 or zero to keep all function infos in memory.
+  void setSpillThreshold(size_t MaxFuncs);
+
   /// Finalize the data in the GSYM creator prior to saving the data out.
   ///
   /// Finalize must be called after all FunctionInfo objects have been added
@@ -62,6 +62,17 @@ public:
     std::string FallbackDebugPath;
     std::string DWPName;
     std::vector<std::string> DebugFileDirectory;
+    /// If not empty, ELF binaries with a build ID are symbolized from a GSYM
+    /// file cached in this directory. The GSYM file is created from the
+    /// module's DWARF and symbol table on first use, and is created again
+    /// when the binary or its debug info file changes.
+    std::string GsymCacheDir;
+    /// Pruning policy for GsymCacheDir, in the format accepted by
+    /// parseCachePruningPolicy().
+    std::string GsymCachePruningPolicy;
+    /// Number of threads used to convert DWARF into a GSYM file for
+    /// GsymCacheDir.
+    unsigned GsymCacheThreads = 1;
     size_t MaxCacheSize =
         sizeof(size_t) == 4
             ? 512 * 1024 * 1024 /* 512 MiB */
@@ -159,6 +170,16 @@ private:
   createModuleInfo(const ObjectFile *Obj, std::unique_ptr<DIContext> Context,
                    StringRef ModuleName);
 
+  /// Returns a GsymContext for the given pair of objects, backed by the GSYM
+  /// file cached in Opts.GsymCacheDir. The cache entry is keyed on the build
+  /// ID of the binary and the size and modification time of the files the
+  /// GSYM file is built from, and is created first if it does not exist yet.
+  /// Queries that GSYM cannot answer, for data addresses and locals, are
+  /// answered from the DWARF. Returns nullptr if the binary has no build ID or
+  /// the GSYM file cannot be created or read, in which case the caller should
+  /// fall back to reading the DWARF directly.
+  std::unique_ptr<DIContext> getOrCreateGsymContext(const ObjectPair &Objects);
+
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
@@ -0,0 +1,163 @@
+//===- llvm/IR/CompactModuleSummaryIndex.h - Compact index ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+/// @file
+/// A compact, read-only encoding of the global value summaries of a combined
+/// ModuleSummaryIndex, for distributed ThinLTO.
+///
+/// The encoding is a fixed header followed by columns of little-endian
+/// integers at offsets computed from the header, so that a memory-mapped file
+/// can be queried in place without building the GlobalValueSummary graph.
+/// Values are identified by their position in a GUID-sorted table, and both
+/// reference and call edges are packed arrays of these positions: a call
+/// edge takes 8 bytes instead of a std::pair<ValueInfo, CalleeInfo> in a
+/// std::vector of its own.
+///
+/// Only the global value summaries and the module table are encoded. Type
+/// identifier summaries, CFI function lists, and the type test, parameter
+/// access and memprof information of function summaries are not.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_COMPACTMODULESUMMARYINDEX_H
+#define LLVM_IR_COMPACTMODULESUMMARYINDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include <optional>
+
+namespace llvm {
+
+class raw_ostream;
+
+/// A view of a combined index in the compact format. It does not own the
+/// buffer, which must outlive it.
+class CompactModuleSummaryIndex {
+public:
+  /// The position of a value in the GUID-sorted value table.
+  using ValueID = uint32_t;
+  /// The position of a summary. The summaries of a value are consecutive.
+  using SummaryID = uint32_t;
+
+  struct Ref {
+    ValueID Value;
+    bool ReadOnly;
+    bool WriteOnly;
+  };
+
+  struct Call {
+    ValueID Callee;
+    CalleeInfo Info;
+  };
+
+  /// Check the header of \p Buffer and locate the columns in it. The contents
+  /// of the columns are not validated beyond their sizes.
+  static Expected<CompactModuleSummaryIndex> create(MemoryBufferRef Buffer);
+
+  /// Whether \p Buffer starts with the magic of the compact format.
+  static bool isCompactModuleSummaryIndex(MemoryBufferRef Buffer);
+
+  /// The flags of the index, as returned by ModuleSummaryIndex::getFlags().
+  uint64_t getIndexFlags() const { return IndexFlags; }
+
+  unsigned getNumModules() const { return ModuleIds.size(); }
+  StringRef getModulePath(unsigned Module) const {
+    return StringTable.slice(ModulePathOffsets[Module],
+                             ModulePathOffsets[Module + 1]);
+  }
+  uint64_t getModuleId(unsigned Module) const { return ModuleIds[Module]; }
+  ModuleHash getModuleHash(unsigned Module) const;
+
+  unsigned getNumValues() const { return GUIDs.size(); }
+  GlobalValue::GUID getGUID(ValueID V) const { return GUIDs[V]; }
+  /// Find the value for \p GUID with a binary search of the value table.
+  std::optional<ValueID> findValue(GlobalValue::GUID GUID) const;
+
+  unsigned getNumSummaries() const { return SummaryFlags.size(); }
+  auto summaries(ValueID V) const {
+    return seq<SummaryID>(FirstSummary[V], FirstSummary[V + 1]);
+  }
+
+  GlobalValueSummary::SummaryKind getSummaryKind(SummaryID S) const;
+  GlobalValueSummary::GVFlags getGVFlags(SummaryID S) const;
+  /// The position of the summary's module in the module table.
+  unsigned getSummaryModule(SummaryID S) const { return SummaryModules[S]; }
+  GlobalValue::GUID getOriginalName(SummaryID S) const {
+    return OriginalNames[S];
+  }
+
+  /// Function summaries only.
+  FunctionSummary::FFlags getFFlags(SummaryID S) const;
+  unsigned getInstCount(SummaryID S) const;
+  uint64_t getEntryCount(SummaryID S) const { return EntryCounts[S]; }
+
+  /// Global variable summaries only.
+  GlobalVarSummary::GVarFlags getGVarFlags(SummaryID S) const;
+
+  /// Alias summaries only. Returns std::nullopt for an alias whose aliasee
+  /// was not recorded.
+  std::optional<ValueID> getAliasee(SummaryID S) const;
+
+  uint64_t getNumRefs(SummaryID S) const {
+    return FirstRef[S + 1] - FirstRef[S];
+  }
+  Ref getRef(SummaryID S, uint64_t I) const;
+
+  /// Function summaries only.
+  uint64_t getNumCalls(SummaryID S) const {
+    return FirstCall[S + 1] - FirstCall[S];
+  }
+  Call getCall(SummaryID S, uint64_t I) const;
+
+  /// Add the summaries of \p Values to \p Index, together with their modules
+  /// and the summaries of any aliasees. Summaries that \p Index already has
+  /// for a value and module are kept.
+  void materialize(ModuleSummaryIndex &Index, ArrayRef<ValueID> Values) const;
+
+  /// Build a combined index holding all modules and summaries.
+  std::unique_ptr<ModuleSummaryIndex> materializeAll() const;
+
+private:
+  CompactModuleSummaryIndex() = default;
+
+  uint64_t IndexFlags = 0;
+  ArrayRef<support::ulittle64_t> ModuleIds;
+  /// Five words per module.
+  ArrayRef<support::ulittle32_t> ModuleHashes;
+  ArrayRef<support::ulittle32_t> ModulePathOffsets;
+  ArrayRef<support::ulittle64_t> GUIDs;
+  ArrayRef<support::ulittle32_t> FirstSummary;
+  ArrayRef<support::ulittle64_t> OriginalNames;
+  ArrayRef<support::ulittle64_t> EntryCounts;
+  ArrayRef<support::ulittle64_t> FirstRef;
+  ArrayRef<support::ulittle64_t> FirstCall;
+  /// The summary kind, GVFlags and the function or variable flags.
+  ArrayRef<support::ulittle32_t> SummaryFlags;
+  ArrayRef<support::ulittle32_t> SummaryModules;
+  /// The instruction count of functions, and the aliasee of aliases.
+  ArrayRef<support::ulittle32_t> SummaryAux;
+  /// The ValueID shifted left by two, with the read-only and write-only bits.
+  ArrayRef<support::ulittle32_t> Refs;
+  ArrayRef<support::ulittle32_t> Callees;
+  /// The hotness in the low three bits, and the relative block frequency.
+  ArrayRef<support::ulittle32_t> CalleeInfos;
+  StringRef StringTable;
+};
+
+/// Write the global value summaries and modules of the combined index
+/// \p Index to \p OS in the compact format.
+void writeCompactModuleSummaryIndex(const ModuleSummaryIndex &Index,
+                                    raw_ostream &OS);
+
+} // end namespace llvm
+
+#endif // LLVM_IR_COMPACTMODULESUMMARYINDEX_H
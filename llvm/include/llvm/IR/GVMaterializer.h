@@ -17,11 +17,13 @@
 #ifndef LLVM_IR_GVMATERIALIZER_H
 #define LLVM_IR_GVMATERIALIZER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include <vector>
 
 namespace llvm {
 
 class Error;
+class Function;
 class GlobalValue;
 class StructType;
 
@@ -36,6 +38,11 @@ public:
   ///
   virtual Error materialize(GlobalValue *GV) = 0;
 
+  /// Make sure the given functions are fully read. Materializers may read
+  /// several bodies at once.
+  ///
+  virtual Error materializeFunctions(ArrayRef<Function *> Functions);
+
   /// Make sure the entire Module has been completely read.
   ///
   virtual Error materializeModule() = 0;
@@ -536,6 +536,10 @@ public:
   /// Make sure the GlobalValue is fully read.
   llvm::Error materialize(GlobalValue *GV);
 
+  /// Make sure the given functions are fully read. The bitcode reader decodes
+  /// their bodies on several threads when -bitcode-materialize-threads allows.
+  llvm::Error materializeFunctions(ArrayRef<Function *> Functions);
+
   /// Make sure all GlobalValues in this Module are fully read and clear the
   /// Materializer.
   llvm::Error materializeAll();
@@ -237,6 +237,27 @@ public:
   ModulePassManager buildPerModuleDefaultPipeline(OptimizationLevel Level,
                                                   bool LTOPreLink = false);
 
+  /// Build the part of the per-module default optimization pipeline that has
+  /// to see the whole module, up to and including the module simplification
+  /// pipeline.
+  ///
+  /// The rest, built by \c buildPerModulePostSplitPipeline, can run on the
+  /// partitions of the module that \c SplitModule creates with locals
+  /// preserved, each in an LLVMContext and on a thread of its own. This is
+  /// how the function passes of the module optimization pipeline, such as the
+  /// vectorizers, use several cores: an LLVMContext cannot be used by more
+  /// than one thread at a time. Running both parts in sequence on one module
+  /// is equivalent to \c buildPerModuleDefaultPipeline.
+  ///
+  /// Note that \p Level cannot be `O0` here.
+  ModulePassManager buildPerModulePreSplitPipeline(OptimizationLevel Level);
+
+  /// Build the part of the per-module default optimization pipeline that runs
+  /// on each partition of a module. See \c buildPerModulePreSplitPipeline.
+  ///
+  /// Note that \p Level cannot be `O0` here.
+  ModulePassManager buildPerModulePostSplitPipeline(OptimizationLevel Level);
+
   /// Build a fat object default optimization pipeline.
   ///
   /// This builds a pipeline that runs the LTO/ThinLTO  pre-link pipeline, and
@@ -606,6 +627,13 @@ private:
 
   void addRequiredLTOPreLinkPasses(ModulePassManager &MPM);
 
+  void addPerModulePreSplitPasses(ModulePassManager &MPM,
+                                  OptimizationLevel Level,
+                                  ThinOrFullLTOPhase LTOPhase);
+  void addPerModulePostSplitPasses(ModulePassManager &MPM,
+                                   OptimizationLevel Level,
+                                   ThinOrFullLTOPhase LTOPhase);
+
   void addVectorPasses(OptimizationLevel Level, FunctionPassManager &FPM,
                        bool IsFullLTO);
 
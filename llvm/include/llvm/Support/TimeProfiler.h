@@ -86,11 +86,24 @@ class raw_pwrite_stream;
 struct TimeTraceProfiler;
 TimeTraceProfiler *getTimeTraceProfilerInstance();
 
+/// Describes what a time section is about. All fields are optional.
+struct TimeTraceMetadata {
+  std::string Detail;
+  // Source location of the described entity.
+  std::string File;
+  int Line = 0;
+
+  bool isEmpty() const { return Detail.empty() && File.empty(); }
+};
+
 /// Initialize the time trace profiler.
 /// This sets up the global \p TimeTraceProfilerInstance
 /// variable to be the profiler instance.
+/// If \p RecordCounts is set, counts passed to timeTraceAddCount() are
+/// recorded, otherwise they are ignored.
 void timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
-                                 StringRef ProcName);
+                                 StringRef ProcName,
+                                 bool RecordCounts = false);
 
 /// Cleanup the time trace profiler, if it was initialized.
 void timeTraceProfilerCleanup();
@@ -123,10 +136,18 @@ Error timeTraceProfilerWrite(StringRef PreferredFileName,
 void timeTraceProfilerBegin(StringRef Name, StringRef Detail);
 void timeTraceProfilerBegin(StringRef Name,
                             llvm::function_ref<std::string()> Detail);
+void timeTraceProfilerBegin(StringRef Name,
+                            llvm::function_ref<TimeTraceMetadata()> Metadata);
 
 /// Manually end the last time section.
 void timeTraceProfilerEnd();
 
+/// Add \p Count to the counter \p Name of the innermost open time section, if
+/// the profiler records counts. Counters are written to the "args" of the
+/// section's event. They only cover the work done directly in the section, not
+/// in sections nested in it.
+void timeTraceAddCount(StringRef Name, uint64_t Count);
+
 /// The TimeTraceScope is a helper class to call the begin and end functions
 /// of the time trace profiler.  When the object is constructed, it begins
 /// the section; and when it is destroyed, it stops it. If the time profiler
@@ -151,6 +172,11 @@ struct TimeTraceScope {
     if (getTimeTraceProfilerInstance() != nullptr)
       timeTraceProfilerBegin(Name, Detail);
   }
+  TimeTraceScope(StringRef Name,
+                 llvm::function_ref<TimeTraceMetadata()> Metadata) {
+    if (getTimeTraceProfilerInstance() != nullptr)
+      timeTraceProfilerBegin(Name, Metadata);
+  }
   ~TimeTraceScope() {
     if (getTimeTraceProfilerInstance() != nullptr)
       timeTraceProfilerEnd();
@@ -71,6 +71,8 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/ModRef.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TargetParser/Triple.h"
 #include <algorithm>
@@ -100,6 +102,12 @@ static cl::opt<bool> ExpandConstantExprs(
     cl::desc(
         "Expand constant expressions to instructions for testing purposes"));
 
+static cl::opt<unsigned> MaterializeThreads(
+    "bitcode-materialize-threads", cl::init(1), cl::Hidden,
+    cl::desc("Number of threads decoding function bodies ahead of their "
+             "materialization when several are materialized at once "
+             "(0 = all hardware threads)"));
+
 namespace {
 
 enum {
@@ -684,6 +692,7 @@ public:
   Error materializeForwardReferencedFunctions();
 
   Error materialize(GlobalValue *GV) override;
+  Error materializeFunctions(ArrayRef<Function *> Functions) override;
   Error materializeModule() override;
   std::vector<StructType *> getIdentifiedStructTypes() const override;
 
@@ -851,6 +860,10 @@ private:
   Error rememberAndSkipMetadata();
   Error typeCheckLoadStoreInst(Type *ValType, Type *PtrType);
   Error parseFunctionBody(Function *F);
+  /// Materialize \p F, parsing its body from \p Body if it was decoded
+  /// ahead of time.
+  Error materializeFunction(Function *F,
+                            const BitstreamDecodedBlock *Body = nullptr);
   Error globalCleanup();
   Error resolveGlobalAndIndirectSymbolInits();
   Error parseUseLists();
@@ -6510,7 +6523,8 @@ OutOfRecordLoop:
   // Trim the value list down to the size it was before we parsed this function.
   ValueList.shrinkTo(ModuleValueListSize);
   MDLoader->shrinkTo(ModuleMDLoaderSize);
-  std::vector<BasicBlock*>().swap(FunctionBBs);
+  // Like InstructionList, keep the storage around for the next function body.
+  FunctionBBs.clear();
   return Error::success();
 }
 
@@ -6545,9 +6559,16 @@ SyncScope::ID BitcodeReader::getDecodedSyncScopeID(unsigned Val) {
 //===----------------------------------------------------------------------===//
 
 Error BitcodeReader::materialize(GlobalValue *GV) {
-  Function *F = dyn_cast<Function>(GV);
-  // If it's not a function or is already material, ignore the request.
-  if (!F || !F->isMaterializable())
+  // If it's not a function, ignore the request.
+  if (Function *F = dyn_cast<Function>(GV))
+    return materializeFunction(F);
+  return Error::success();
+}
+
+Error BitcodeReader::materializeFunction(Function *F,
+                                         const BitstreamDecodedBlock *Body) {
+  // If it's already material, ignore the request.
+  if (!F->isMaterializable())
     return Error::success();
 
   DenseMap<Function*, uint64_t>::iterator DFII = DeferredFunctionInfo.find(F);
@@ -6562,11 +6583,19 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   if (Error Err = materializeMetadata())
     return Err;
 
-  // Move the bit stream to the saved position of the deferred function body.
-  if (Error JumpFailed = Stream.JumpToBit(DFII->second))
-    return JumpFailed;
-  if (Error Err = parseFunctionBody(F))
-    return Err;
+  if (Body) {
+    Stream.startReplay(*Body);
+    Error Err = parseFunctionBody(F);
+    Stream.endReplay();
+    if (Err)
+      return Err;
+  } else {
+    // Move the bit stream to the saved position of the deferred function body.
+    if (Error JumpFailed = Stream.JumpToBit(DFII->second))
+      return JumpFailed;
+    if (Error Err = parseFunctionBody(F))
+      return Err;
+  }
   F->setIsMaterializable(false);
 
   if (StripDebugInfo)
@@ -6642,6 +6671,78 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   return materializeForwardReferencedFunctions();
 }
 
+Error BitcodeReader::materializeFunctions(ArrayRef<Function *> Functions) {
+  ThreadPoolStrategy Strategy = hardware_concurrency(MaterializeThreads);
+  unsigned NumThreads = Strategy.compute_thread_count();
+  if (!llvm_is_multithreaded() || NumThreads < 2 || Functions.size() < 2) {
+    for (Function *F : Functions)
+      if (Error Err = materializeFunction(F))
+        return Err;
+    return Error::success();
+  }
+
+  // Only the decoding of the bitstream runs on the worker threads. Parsing a
+  // body creates values in the context and updates the value list, metadata
+  // loader and forward references of the reader, so the bodies are parsed
+  // here, in order. Locate all bodies first: this may parse the rest of the
+  // module, which the workers must not race with.
+  std::vector<std::pair<Function *, uint64_t>> Bodies;
+  for (Function *F : Functions) {
+    if (!F->isMaterializable())
+      continue;
+    auto DFII = DeferredFunctionInfo.find(F);
+    assert(DFII != DeferredFunctionInfo.end() &&
+           "Deferred function not found!");
+    if (DFII->second == 0)
+      if (Error Err = findFunctionInStream(F, DFII))
+        return Err;
+    Bodies.emplace_back(F, DFII->second);
+  }
+  if (Error Err = materializeMetadata())
+    return Err;
+  if (Bodies.empty())
+    return Error::success();
+
+  // Keep a bounded window of bodies decoded ahead. A body that fails to decode
+  // is parsed from the stream instead, which reports the error. The pool is
+  // declared last so that it finishes its tasks before the window goes away.
+  size_t Window = std::min<size_t>(4 * NumThreads, Bodies.size());
+  std::vector<BitstreamDecodedBlock> Decoded(Window);
+  std::vector<std::shared_future<bool>> Pending(Window);
+  ThreadPool Pool(Strategy);
+  ArrayRef<uint8_t> Bytes = Stream.getBitcodeBytes();
+  auto DecodeAhead = [&](size_t I) {
+    Pending[I % Window] =
+        Pool.async([this, Bytes, Bit = Bodies[I].second,
+                    &Body = Decoded[I % Window]] {
+          BitstreamCursor Cursor(Bytes);
+          Cursor.setBlockInfo(&BlockInfo);
+          if (Error Err = Cursor.JumpToBit(Bit)) {
+            consumeError(std::move(Err));
+            return false;
+          }
+          if (Error Err =
+                  Cursor.readBlockAhead(bitc::FUNCTION_BLOCK_ID, Body)) {
+            consumeError(std::move(Err));
+            return false;
+          }
+          return true;
+        });
+  };
+  for (size_t I = 0; I != Window; ++I)
+    DecodeAhead(I);
+
+  for (size_t I = 0, E = Bodies.size(); I != E; ++I) {
+    bool IsDecoded = Pending[I % Window].get();
+    if (Error Err = materializeFunction(
+            Bodies[I].first, IsDecoded ? &Decoded[I % Window] : nullptr))
+      return Err;
+    if (I + Window < E)
+      DecodeAhead(I + Window);
+  }
+  return Error::success();
+}
+
 Error BitcodeReader::materializeModule() {
   if (Error Err = materializeMetadata())
     return Err;
@@ -6649,12 +6750,12 @@ Error BitcodeReader::materializeModule() {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
-  // Iterate over the module, deserializing any functions that are still on
-  // disk.
-  for (Function &F : *TheModule) {
-    if (Error Err = materialize(&F))
-      return Err;
-  }
+  // Deserialize any functions of the module that are still on disk.
+  std::vector<Function *> Functions;
+  for (Function &F : *TheModule)
+    Functions.push_back(&F);
+  if (Error Err = materializeFunctions(Functions))
+    return Err;
   // At this point, if there are any function bodies, parse the rest of
   // the bits in the module past the last function block we have recorded
   // through either lazy scanning or the VST.
@@ -6995,8 +7096,16 @@ std::vector<FunctionSummary::EdgeTy>
 ModuleSummaryIndexBitcodeReader::makeCallList(ArrayRef<uint64_t> Record,
                                               bool IsOldProfileFormat,
                                               bool HasProfile, bool HasRelBF) {
+  // Each callee value id may be followed by profile fields. Reserve space for
+  // exactly the number of calls, rather than for the number of record fields,
+  // as the combined index can hold hundreds of millions of call edges.
+  unsigned FieldsPerCall = 1;
+  if (IsOldProfileFormat)
+    FieldsPerCall += HasProfile ? 2 : 1;
+  else if (HasProfile || HasRelBF)
+    FieldsPerCall += 1;
   std::vector<FunctionSummary::EdgeTy> Ret;
-  Ret.reserve(Record.size());
+  Ret.reserve(Record.size() / FieldsPerCall);
   for (unsigned I = 0, E = Record.size(); I != E; ++I) {
     CalleeInfo::HotnessType Hotness = CalleeInfo::HotnessType::Unknown;
     uint64_t RelBF = 0;
@@ -24,6 +24,16 @@ static Error error(const char *Message) {
 
 /// Having read the ENTER_SUBBLOCK abbrevid, enter the block.
 Error BitstreamCursor::EnterSubBlock(unsigned BlockID, unsigned *NumWordsP) {
+  if (Replay) {
+    // Nested blocks were already entered by advance(), but the replayed block
+    // itself is entered here.
+    if (ReplayNext == 0)
+      ReplayNext = 1;
+    if (NumWordsP)
+      *NumWordsP = Replay->Entries[ReplayBlock].CodeOrNumWords;
+    return Error::success();
+  }
+
   // Save the current block's state on BlockScope.
   BlockScope.push_back(Block(CurCodeSize));
   BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
@@ -94,6 +104,16 @@ static Expected<uint64_t> readAbbreviatedField(BitstreamCursor &Cursor,
 
 /// skipRecord - Read the current record and discard it.
 Expected<unsigned> BitstreamCursor::skipRecord(unsigned AbbrevID) {
+  if (Replay) {
+    if (ReplayNext == 0)
+      return error("Invalid record");
+    const BitstreamDecodedBlock::DecodedEntry &E =
+        Replay->Entries[ReplayNext - 1];
+    if (E.Entry.Kind != BitstreamEntry::Record)
+      return error("Invalid record");
+    return E.CodeOrNumWords;
+  }
+
   // Skip unabbreviated records by reading past their entries.
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     Expected<uint32_t> MaybeCode = ReadVBR(6);
@@ -214,6 +234,26 @@ Expected<unsigned> BitstreamCursor::skipRecord(unsigned AbbrevID) {
 Expected<unsigned> BitstreamCursor::readRecord(unsigned AbbrevID,
                                                SmallVectorImpl<uint64_t> &Vals,
                                                StringRef *Blob) {
+  if (Replay) {
+    if (ReplayNext == 0)
+      return error("Invalid record");
+    const BitstreamDecodedBlock::DecodedEntry &E =
+        Replay->Entries[ReplayNext - 1];
+    if (E.Entry.Kind != BitstreamEntry::Record)
+      return error("Invalid record");
+    ArrayRef<uint64_t> Ops(Replay->Ops.data() + E.FirstOp, E.NumOpsOrEnd);
+    Vals.append(Ops.begin(), Ops.end());
+    if (E.HasBlob) {
+      if (Blob) {
+        *Blob = E.Blob;
+      } else {
+        auto *UPtr = reinterpret_cast<const unsigned char *>(E.Blob.data());
+        Vals.append(UPtr, UPtr + E.Blob.size());
+      }
+    }
+    return E.CodeOrNumWords;
+  }
+
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     Expected<uint32_t> MaybeCode = ReadVBR(6);
     if (!MaybeCode)
@@ -360,6 +400,83 @@ Expected<unsigned> BitstreamCursor::readRecord(unsigned AbbrevID,
   return Code;
 }
 
+Error BitstreamCursor::readBlockAhead(unsigned BlockID,
+                                      BitstreamDecodedBlock &Decoded) {
+  using DecodedEntry = BitstreamDecodedBlock::DecodedEntry;
+  Decoded.clear();
+
+  // The entries of the blocks that are not ended yet.
+  SmallVector<size_t, 8> OpenBlocks;
+  auto Enter = [&](unsigned ID) -> Error {
+    unsigned NumWords;
+    if (Error Err = EnterSubBlock(ID, &NumWords))
+      return Err;
+    OpenBlocks.push_back(Decoded.Entries.size());
+    Decoded.Entries.push_back(DecodedEntry{BitstreamEntry::getSubBlock(ID),
+                                           NumWords, 0, 0, StringRef(),
+                                           false});
+    return Error::success();
+  };
+  if (Error Err = Enter(BlockID))
+    return Err;
+
+  SmallVector<uint64_t, 64> Vals;
+  while (!OpenBlocks.empty()) {
+    Expected<BitstreamEntry> MaybeEntry = advance();
+    if (!MaybeEntry)
+      return MaybeEntry.takeError();
+    BitstreamEntry Entry = MaybeEntry.get();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      Decoded.Entries.push_back(
+          DecodedEntry{Entry, 0, 0, 0, StringRef(), false});
+      Decoded.Entries[OpenBlocks.pop_back_val()].NumOpsOrEnd =
+          Decoded.Entries.size();
+      break;
+    case BitstreamEntry::SubBlock:
+      if (Error Err = Enter(Entry.ID))
+        return Err;
+      break;
+    case BitstreamEntry::Record: {
+      Vals.clear();
+      StringRef Blob;
+      Expected<unsigned> MaybeCode = readRecord(Entry.ID, Vals, &Blob);
+      if (!MaybeCode)
+        return MaybeCode.takeError();
+      // A blob of the stream is never null, even when it is empty.
+      Decoded.Entries.push_back(DecodedEntry{Entry, MaybeCode.get(),
+                                             Decoded.Ops.size(), Vals.size(),
+                                             Blob, Blob.data() != nullptr});
+      llvm::append_range(Decoded.Ops, Vals);
+      break;
+    }
+    }
+  }
+  return Error::success();
+}
+
+Expected<BitstreamEntry> BitstreamCursor::advanceReplay() {
+  if (ReplayNext == 0 || ReplayNext == Replay->Entries.size())
+    return BitstreamEntry::getError();
+  BitstreamEntry Entry = Replay->Entries[ReplayNext].Entry;
+  if (Entry.Kind == BitstreamEntry::SubBlock)
+    ReplayBlock = ReplayNext;
+  ++ReplayNext;
+  return Entry;
+}
+
+Expected<unsigned> BitstreamCursor::readCodeReplay() {
+  Expected<BitstreamEntry> MaybeEntry = advanceReplay();
+  if (!MaybeEntry)
+    return MaybeEntry.takeError();
+  if (MaybeEntry->Kind != BitstreamEntry::Record)
+    return error("Invalid record");
+  return MaybeEntry->ID;
+}
+
 Error BitstreamCursor::ReadAbbrevRecord() {
   auto Abbv = std::make_shared<BitCodeAbbrev>();
   Expected<uint32_t> MaybeNumOpInfo = ReadVBR(5);
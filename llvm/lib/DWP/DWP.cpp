@@ -20,7 +20,9 @@
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include <limits>
+#include <optional>
 
 using namespace llvm;
 using namespace llvm::object;
@@ -518,34 +520,13 @@ Error handleSection(
     const MCSection *StrSection, const MCSection *StrOffsetSection,
     const MCSection *TypesSection, const MCSection *CUIndexSection,
     const MCSection *TUIndexSection, const MCSection *InfoSection,
-    const SectionRef &Section, MCStreamer &Out,
-    std::deque<SmallString<32>> &UncompressedSections,
+    StringRef Name, StringRef Contents, MCStreamer &Out,
     uint32_t (&ContributionOffsets)[8], UnitIndexEntry &CurEntry,
     StringRef &CurStrSection, StringRef &CurStrOffsetSection,
     std::vector<StringRef> &CurTypesSection,
     std::vector<StringRef> &CurInfoSection, StringRef &AbbrevSection,
     StringRef &CurCUIndexSection, StringRef &CurTUIndexSection,
     std::vector<std::pair<DWARFSectionKind, uint32_t>> &SectionLength) {
-  if (Section.isBSS())
-    return Error::success();
-
-  if (Section.isVirtual())
-    return Error::success();
-
-  Expected<StringRef> NameOrErr = Section.getName();
-  if (!NameOrErr)
-    return NameOrErr.takeError();
-  StringRef Name = *NameOrErr;
-
-  Expected<StringRef> ContentsOrErr = Section.getContents();
-  if (!ContentsOrErr)
-    return ContentsOrErr.takeError();
-  StringRef Contents = *ContentsOrErr;
-
-  if (auto Err = handleCompressedSection(UncompressedSections, Section, Name,
-                                         Contents))
-    return Err;
-
   Name = Name.substr(Name.find_first_not_of("._"));
 
   auto SectionPair = KnownSections.find(Name);
@@ -582,6 +563,41 @@ Error handleSection(
   return Error::success();
 }
 
+Expected<std::unique_ptr<DWPInput>> loadInput(StringRef Input) {
+  auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
+  if (!ErrOrObj) {
+    return handleErrors(ErrOrObj.takeError(),
+                        [&](std::unique_ptr<ECError> EC) -> Error {
+                          return createFileError(Input, Error(std::move(EC)));
+                        });
+  }
+
+  auto Loaded = std::make_unique<DWPInput>();
+  Loaded->Obj = std::move(*ErrOrObj);
+
+  for (const auto &Section : Loaded->Obj.getBinary()->sections()) {
+    if (Section.isBSS() || Section.isVirtual())
+      continue;
+
+    Expected<StringRef> NameOrErr = Section.getName();
+    if (!NameOrErr)
+      return NameOrErr.takeError();
+    StringRef Name = *NameOrErr;
+
+    Expected<StringRef> ContentsOrErr = Section.getContents();
+    if (!ContentsOrErr)
+      return ContentsOrErr.takeError();
+    StringRef Contents = *ContentsOrErr;
+
+    if (auto Err = handleCompressedSection(Loaded->UncompressedSections,
+                                           Section, Name, Contents))
+      return std::move(Err);
+
+    Loaded->Sections.push_back({Name, Contents});
+  }
+  return std::move(Loaded);
+}
+
 Error write(MCStreamer &Out, ArrayRef<std::string> Inputs,
             bool ContinueOnCuIndexOverflow) {
   const auto &MCOFI = *Out.getContext().getObjectFileInfo();
@@ -616,22 +632,38 @@ Error write(MCStreamer &Out, ArrayRef<std::string> Inputs,
 
   DWPStringPool Strings(Out, StrSection);
 
-  SmallVector<OwningBinary<object::ObjectFile>, 128> Objects;
+  // Opening the inputs and decompressing their sections is independent for
+  // each file, so do it in parallel (honoring parallel::strategy). The inputs
+  // are then merged serially in command line order, which keeps the string
+  // pool, the contribution offsets and the unit indices deterministic.
+  std::vector<std::optional<Expected<std::unique_ptr<DWPInput>>>> Loaded(
+      Inputs.size());
+  parallelFor(0, Inputs.size(),
+              [&](size_t I) { Loaded[I].emplace(loadInput(Inputs[I])); });
+
+  // Report the first input that failed to load, as the serial loop did. The
+  // results of the remaining inputs still have to be checked.
+  SmallVector<std::unique_ptr<DWPInput>, 128> Objects;
   Objects.reserve(Inputs.size());
-
-  std::deque<SmallString<32>> UncompressedSections;
-
-  for (const auto &Input : Inputs) {
-    auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
-    if (!ErrOrObj) {
-      return handleErrors(ErrOrObj.takeError(),
-                          [&](std::unique_ptr<ECError> EC) -> Error {
-                            return createFileError(Input, Error(std::move(EC)));
-                          });
+  Error FirstErr = Error::success();
+  for (auto &L : Loaded) {
+    if (!*L) {
+      if (FirstErr)
+        consumeError(L->takeError());
+      else
+        FirstErr = L->takeError();
+      continue;
     }
+    Objects.push_back(std::move(**L));
+  }
+  Loaded.clear();
+  if (FirstErr)
+    return std::move(FirstErr);
 
-    auto &Obj = *ErrOrObj->getBinary();
-    Objects.push_back(std::move(*ErrOrObj));
+  for (size_t InputIdx = 0; InputIdx != Inputs.size(); ++InputIdx) {
+    const std::string &Input = Inputs[InputIdx];
+    const DWPInput &CurInput = *Objects[InputIdx];
+    auto &Obj = *CurInput.Obj.getBinary();
 
     UnitIndexEntry CurEntry = {};
 
@@ -648,14 +680,14 @@ Error write(MCStreamer &Out, ArrayRef<std::string> Inputs,
     // i.e. offset and length, of each compile/type unit to a section.
     std::vector<std::pair<DWARFSectionKind, uint32_t>> SectionLength;
 
-    for (const auto &Section : Obj.sections())
+    for (const auto &[Name, Contents] : CurInput.Sections)
       if (auto Err = handleSection(
               KnownSections, StrSection, StrOffsetSection, TypesSection,
-              CUIndexSection, TUIndexSection, InfoSection, Section, Out,
-              UncompressedSections, ContributionOffsets, CurEntry,
-              CurStrSection, CurStrOffsetSection, CurTypesSection,
-              CurInfoSection, AbbrevSection, CurCUIndexSection,
-              CurTUIndexSection, SectionLength))
+              CUIndexSection, TUIndexSection, InfoSection, Name, Contents, Out,
+              ContributionOffsets, CurEntry, CurStrSection,
+              CurStrOffsetSection, CurTypesSection, CurInfoSection,
+              AbbrevSection, CurCUIndexSection, CurTUIndexSection,
+              SectionLength))
         return Err;
 
     if (CurInfoSection.empty())
@@ -361,7 +361,8 @@ static void convertFunctionLineTable(raw_ostream *Log, CUInfo &CUI,
     FI.OptLineTable = std::nullopt;
 }
 
-void DwarfTransformer::handleDie(raw_ostream *OS, CUInfo &CUI, DWARFDie Die) {
+void DwarfTransformer::handleDie(raw_ostream *OS, CUInfo &CUI, DWARFDie Die,
+                                 std::vector<FunctionInfo> &Funcs) {
   switch (Die.getTag()) {
   case dwarf::DW_TAG_subprogram: {
     Expected<DWARFAddressRangesVector> RangesOrError = Die.getAddressRanges();
@@ -448,14 +449,14 @@ void DwarfTransformer::handleDie(raw_ostream *OS, CUInfo &CUI, DWARFDie Die) {
           FI.Inline = std::nullopt;
         }
       }
-      Gsym.addFunctionInfo(std::move(FI));
+      Funcs.emplace_back(std::move(FI));
     }
   } break;
   default:
     break;
   }
   for (DWARFDie ChildDie : Die.children())
-    handleDie(OS, CUI, ChildDie);
+    handleDie(OS, CUI, ChildDie, Funcs);
 }
 
 Error DwarfTransformer::convert(uint32_t NumThreads, raw_ostream *OS) {
@@ -483,7 +484,9 @@ Error DwarfTransformer::convert(uint32_t NumThreads, raw_ostream *OS) {
     for (const auto &CU : DICtx.compile_units()) {
       DWARFDie Die = getDie(*CU);
       CUInfo CUI(DICtx, dyn_cast<DWARFCompileUnit>(CU.get()));
-      handleDie(OS, CUI, Die);
+      std::vector<FunctionInfo> Funcs;
+      handleDie(OS, CUI, Die, Funcs);
+      Gsym.addFunctionInfos(std::move(Funcs));
     }
   } else {
     // LLVM Dwarf parser is not thread-safe and we need to parse all DWARF up
@@ -512,7 +515,12 @@ Error DwarfTransformer::convert(uint32_t NumThreads, raw_ostream *OS) {
         pool.async([this, CUI, &LogMutex, OS, Die]() mutable {
           std::string ThreadLogStorage;
           raw_string_ostream ThreadOS(ThreadLogStorage);
-          handleDie(OS ? &ThreadOS: nullptr, CUI, Die);
+          // Collect the function infos for this compile unit locally and add
+          // them with a single call to avoid taking the GsymCreator lock for
+          // every function.
+          std::vector<FunctionInfo> Funcs;
+          handleDie(OS ? &ThreadOS: nullptr, CUI, Die, Funcs);
+          Gsym.addFunctionInfos(std::move(Funcs));
           ThreadOS.flush();
           if (OS && !ThreadLogStorage.empty()) {
             // Print ThreadLogStorage lines into an actual stream under a lock
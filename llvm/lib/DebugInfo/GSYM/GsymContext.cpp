@@ -0,0 +1,174 @@
+//===-- GsymContext.cpp ---------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/GSYM/GsymContext.h"
+
+#include "llvm/DebugInfo/GSYM/GsymReader.h"
+#include "llvm/Support/Path.h"
+
+using namespace llvm;
+using namespace llvm::gsym;
+
+GsymContext::~GsymContext() = default;
+GsymContext::GsymContext(std::unique_ptr<GsymReader> Reader,
+                         std::unique_ptr<DIContext> Fallback)
+    : DIContext(CK_GSYM), Reader(std::move(Reader)),
+      Fallback(std::move(Fallback)) {}
+
+void GsymContext::dump(raw_ostream &OS, DIDumpOptions DumpOpts) {}
+
+static bool fillLineInfoFromLocation(const SourceLocation &Location,
+                                     DILineInfoSpecifier Specifier,
+                                     DILineInfo &LineInfo) {
+  // FIXME Demangle in case of DINameKind::ShortName
+  if (Specifier.FNKind != DINameKind::None) {
+    LineInfo.FunctionName = Location.Name.str();
+  }
+
+  switch (Specifier.FLIKind) {
+  case DILineInfoSpecifier::FileLineInfoKind::RelativeFilePath:
+    // We have no information to determine the relative path, so we fall back to
+    // returning the absolute path.
+  case DILineInfoSpecifier::FileLineInfoKind::RawValue:
+  case DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath:
+    if (Location.Dir.empty()) {
+      if (Location.Base.empty())
+        LineInfo.FileName = DILineInfo::BadString;
+      else
+        LineInfo.FileName = Location.Base.str();
+    } else {
+      SmallString<128> Path(Location.Dir);
+      sys::path::append(Path, Location.Base);
+      LineInfo.FileName = static_cast<std::string>(Path);
+    }
+    break;
+
+  case DILineInfoSpecifier::FileLineInfoKind::BaseNameOnly:
+    LineInfo.FileName = Location.Base.str();
+    break;
+
+  default:
+    return false;
+  }
+  LineInfo.Line = Location.Line;
+
+  // We don't have information in GSYM to fill any of the Source, Column,
+  // StartFileName or StartLine attributes.
+
+  return true;
+}
+
+DILineInfo
+GsymContext::getLineInfoForAddress(object::SectionedAddress Address,
+                                   DILineInfoSpecifier Specifier) {
+  // GSYM addresses are unique within the module, so the section index is not
+  // needed to disambiguate them.
+  auto ResultOrErr = Reader->lookup(Address.Address);
+
+  if (!ResultOrErr) {
+    consumeError(ResultOrErr.takeError());
+    return {};
+  }
+
+  // The LookupResult can contain multiple locations, the first of which is the
+  // innermost inlined function.
+  DILineInfo LineInfo;
+  LineInfo.StartAddress = ResultOrErr->FuncRange.start();
+  if (ResultOrErr->Locations.empty()) {
+    if (Specifier.FNKind != DINameKind::None)
+      LineInfo.FunctionName = ResultOrErr->FuncName.str();
+    return LineInfo;
+  }
+
+  if (!fillLineInfoFromLocation(ResultOrErr->Locations.front(), Specifier,
+                                LineInfo))
+    return {};
+  return LineInfo;
+}
+
+DILineInfo
+GsymContext::getLineInfoForDataAddress(object::SectionedAddress Address) {
+  // There's no such information in the GSYM file.
+  if (Fallback)
+    return Fallback->getLineInfoForDataAddress(Address);
+  return {};
+}
+
+DILineInfoTable
+GsymContext::getLineInfoForAddressRange(object::SectionedAddress Address,
+                                        uint64_t Size,
+                                        DILineInfoSpecifier Specifier) {
+  if (Size == 0)
+    return DILineInfoTable();
+
+  auto FuncInfoOrErr = Reader->getFunctionInfo(Address.Address);
+  if (!FuncInfoOrErr) {
+    consumeError(FuncInfoOrErr.takeError());
+    return DILineInfoTable();
+  }
+
+  DILineInfoTable Table;
+  if (FuncInfoOrErr->OptLineTable) {
+    const gsym::LineTable &LT = *FuncInfoOrErr->OptLineTable;
+    for (const gsym::LineEntry &LE : LT) {
+      if (LE.Addr < Address.Address)
+        continue;
+      if (LE.Addr >= Address.Address + Size)
+        break;
+      auto LookupResultOrErr = Reader->lookup(LE.Addr);
+      if (!LookupResultOrErr) {
+        consumeError(LookupResultOrErr.takeError());
+        continue;
+      }
+      if (LookupResultOrErr->Locations.empty())
+        continue;
+      DILineInfo LineInfo;
+      if (fillLineInfoFromLocation(LookupResultOrErr->Locations.front(),
+                                   Specifier, LineInfo))
+        Table.push_back(std::make_pair(LE.Addr, LineInfo));
+    }
+  }
+  return Table;
+}
+
+DIInliningInfo
+GsymContext::getInliningInfoForAddress(object::SectionedAddress Address,
+                                       DILineInfoSpecifier Specifier) {
+  auto ResultOrErr = Reader->lookup(Address.Address);
+
+  if (!ResultOrErr) {
+    consumeError(ResultOrErr.takeError());
+    return {};
+  }
+
+  DIInliningInfo InlineInfo;
+  for (const auto &Location : ResultOrErr->Locations) {
+    DILineInfo LineInfo;
+    LineInfo.StartAddress = ResultOrErr->FuncRange.start();
+    if (fillLineInfoFromLocation(Location, Specifier, LineInfo))
+      InlineInfo.addFrame(LineInfo);
+  }
+
+  // Without a line table, still report the function containing the address.
+  if (InlineInfo.getNumberOfFrames() == 0) {
+    DILineInfo LineInfo;
+    LineInfo.StartAddress = ResultOrErr->FuncRange.start();
+    if (Specifier.FNKind != DINameKind::None)
+      LineInfo.FunctionName = ResultOrErr->FuncName.str();
+    InlineInfo.addFrame(LineInfo);
+  }
+  return InlineInfo;
+}
+
+std::vector<DILocal>
+GsymContext::getLocalsForAddress(object::SectionedAddress Address) {
+  // There's no such information in the GSYM file.
+  if (Fallback)
+    return Fallback->getLocalsForAddress(Address);
+  return {};
+}
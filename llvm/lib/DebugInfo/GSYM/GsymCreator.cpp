@@ -10,6 +10,10 @@
 #include "llvm/DebugInfo/GSYM/Header.h"
 #include "llvm/DebugInfo/GSYM/LineTable.h"
 #include "llvm/MC/StringTableBuilder.h"
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
@@ -25,6 +29,19 @@ GsymCreator::GsymCreator(bool Quiet)
   insertFile(StringRef());
 }
 
+GsymCreator::~GsymCreator() {
+  for (const std::string &Path : SpillFiles)
+    sys::fs::remove(Path);
+}
+
+// Function infos that were merged back from spill files only keep their
+// native endian encoding. Decode them again when the full object is needed.
+static llvm::Expected<FunctionInfo>
+expandFunctionInfo(const FunctionInfo &FI) {
+  DataExtractor Data(FI.EncodingCache.str(), sys::IsLittleEndianHost, 8);
+  return FunctionInfo::decode(Data, FI.startAddress());
+}
+
 uint32_t GsymCreator::insertFile(StringRef Path, llvm::sys::path::Style Style) {
   llvm::StringRef directory = llvm::sys::path::parent_path(Path, Style);
   llvm::StringRef filename = llvm::sys::path::filename(Path, Style);
@@ -169,6 +186,18 @@ llvm::Error GsymCreator::encode(FileWriter &O) const {
 
   // Write out the address infos for each function info.
   for (const auto &FuncInfo : Funcs) {
+    // A cached encoding can only be written as is in the native byte order.
+    if (!FuncInfo.EncodingCache.empty() &&
+        O.getByteOrder() != support::endian::system_endianness()) {
+      Expected<FunctionInfo> FI = expandFunctionInfo(FuncInfo);
+      if (!FI)
+        return FI.takeError();
+      if (Expected<uint64_t> OffsetOrErr = FI->encode(O))
+        AddrInfoOffsets.push_back(OffsetOrErr.get());
+      else
+        return OffsetOrErr.takeError();
+      continue;
+    }
     if (Expected<uint64_t> OffsetOrErr = FuncInfo.encode(O))
       AddrInfoOffsets.push_back(OffsetOrErr.get());
     else
@@ -187,6 +216,62 @@ llvm::Error GsymCreator::encode(FileWriter &O) const {
   return ErrorSuccess();
 }
 
+void GsymCreator::addFinalizedFunctionInfo(
+    std::vector<FunctionInfo> &FinalizedFuncs, FunctionInfo &&Curr,
+    raw_ostream &OS) const {
+  if (FinalizedFuncs.empty()) {
+    FinalizedFuncs.emplace_back(std::move(Curr));
+    return;
+  }
+  FunctionInfo &Prev = FinalizedFuncs.back();
+  // Empty ranges won't intersect, but we still need to
+  // catch the case where we have multiple symbols at the
+  // same address and coalesce them.
+  const bool ranges_equal = Prev.Range == Curr.Range;
+  if (ranges_equal || Prev.Range.intersects(Curr.Range)) {
+    // Overlapping ranges or empty identical ranges.
+    if (ranges_equal) {
+      // Same address range. Check if one is from debug
+      // info and the other is from a symbol table. If
+      // so, then keep the one with debug info. Our
+      // sorting guarantees that entries with matching
+      // address ranges that have debug info are last in
+      // the sort.
+      if (!(Prev == Curr)) {
+        if (Prev.hasRichInfo() && Curr.hasRichInfo()) {
+          if (!Quiet) {
+            OS << "warning: same address range contains "
+                  "different debug "
+              << "info. Removing:\n"
+              << Prev << "\nIn favor of this one:\n"
+              << Curr << "\n";
+          }
+        }
+        // We want to swap the current entry with the previous since
+        // later entries with the same range always have more debug info
+        // or different debug info.
+        std::swap(Prev, Curr);
+      }
+    } else {
+      if (!Quiet) { // print warnings about overlaps
+        OS << "warning: function ranges overlap:\n"
+          << Prev << "\n"
+          << Curr << "\n";
+      }
+      FinalizedFuncs.emplace_back(std::move(Curr));
+    }
+  } else {
+    if (Prev.Range.size() == 0 && Curr.Range.contains(Prev.Range.start())) {
+      // Symbols on macOS don't have address ranges, so if the range
+      // doesn't match and the size is zero, then we replace the empty
+      // symbol function info with the current one.
+      std::swap(Prev, Curr);
+    } else {
+      FinalizedFuncs.emplace_back(std::move(Curr));
+    }
+  }
+}
+
 llvm::Error GsymCreator::finalize(llvm::raw_ostream &OS) {
   std::lock_guard<std::mutex> Guard(Mutex);
   if (Finalized)
@@ -196,6 +281,10 @@ llvm::Error GsymCreator::finalize(llvm::raw_ostream &OS) {
   // Don't let the string table indexes change by finalizing in order.
   StrTab.finalizeInOrder();
 
+  if (!SpillError.empty() && !Quiet)
+    OS << "warning: unable to spill function infos, keeping them in memory: "
+       << SpillError << "\n";
+
   // Remove duplicates function infos that have both entries from debug info
   // (DWARF or Breakpad) and entries from the SymbolTable.
   //
@@ -217,68 +306,22 @@ llvm::Error GsymCreator::finalize(llvm::raw_ostream &OS) {
   // we wouldn't find any function for range (end of Y, end of X)
   // with binary search
 
-  const auto NumBefore = Funcs.size();
+  const auto NumBefore = Funcs.size() + NumSpilledFuncs;
   // Only sort and unique if this isn't a segment. If this is a segment we
   // already finalized the main GsymCreator with all of the function infos
   // and then the already sorted and uniqued function infos were added to this
   // object.
   if (!IsSegment) {
-    if (NumBefore > 1) {
+    if (!SpillFiles.empty()) {
+      if (Error Err = mergeSpilledFunctionInfos(OS))
+        return Err;
+    } else if (NumBefore > 1) {
       // Sort function infos so we can emit sorted functions.
-      llvm::sort(Funcs);
+      llvm::parallelSort(Funcs);
       std::vector<FunctionInfo> FinalizedFuncs;
       FinalizedFuncs.reserve(Funcs.size());
-      FinalizedFuncs.emplace_back(std::move(Funcs.front()));
-      for (size_t Idx=1; Idx < NumBefore; ++Idx) {
-        FunctionInfo &Prev = FinalizedFuncs.back();
-        FunctionInfo &Curr = Funcs[Idx];
-        // Empty ranges won't intersect, but we still need to
-        // catch the case where we have multiple symbols at the
-        // same address and coalesce them.
-        const bool ranges_equal = Prev.Range == Curr.Range;
-        if (ranges_equal || Prev.Range.intersects(Curr.Range)) {
-          // Overlapping ranges or empty identical ranges.
-          if (ranges_equal) {
-            // Same address range. Check if one is from debug
-            // info and the other is from a symbol table. If
-            // so, then keep the one with debug info. Our
-            // sorting guarantees that entries with matching
-            // address ranges that have debug info are last in
-            // the sort.
-            if (!(Prev == Curr)) {
-              if (Prev.hasRichInfo() && Curr.hasRichInfo()) {
-                if (!Quiet) {
-                  OS << "warning: same address range contains "
-                        "different debug "
-                    << "info. Removing:\n"
-                    << Prev << "\nIn favor of this one:\n"
-                    << Curr << "\n";
-                }
-              }
-              // We want to swap the current entry with the previous since
-              // later entries with the same range always have more debug info
-              // or different debug info.
-              std::swap(Prev, Curr);
-            }
-          } else {
-            if (!Quiet) { // print warnings about overlaps
-              OS << "warning: function ranges overlap:\n"
-                << Prev << "\n"
-                << Curr << "\n";
-            }
-            FinalizedFuncs.emplace_back(std::move(Curr));
-          }
-        } else {
-          if (Prev.Range.size() == 0 && Curr.Range.contains(Prev.Range.start())) {
-            // Symbols on macOS don't have address ranges, so if the range
-            // doesn't match and the size is zero, then we replace the empty
-            // symbol function info with the current one.
-            std::swap(Prev, Curr);
-          } else {
-            FinalizedFuncs.emplace_back(std::move(Curr));
-          }
-        }
-      }
+      for (FunctionInfo &Curr : Funcs)
+        addFinalizedFunctionInfo(FinalizedFuncs, std::move(Curr), OS);
       std::swap(Funcs, FinalizedFuncs);
     }
     // If our last function info entry doesn't have a size and if we have valid
@@ -298,6 +341,167 @@ llvm::Error GsymCreator::finalize(llvm::raw_ostream &OS) {
   return Error::success();
 }
 
+// Each spilled function info is written as its start and end address followed
+// by the size and bytes of its native endian encoding. Invalid function infos
+// can't be encoded and are written with an encoding size of zero.
+static llvm::Expected<FunctionInfo>
+decodeSpilledFunctionInfo(DataExtractor &Data, uint64_t &Offset) {
+  if (!Data.isValidOffsetForDataOfSize(Offset, 20))
+    return createStringError(std::errc::io_error,
+        "0x%8.8" PRIx64 ": missing spilled FunctionInfo header", Offset);
+  const uint64_t Start = Data.getU64(&Offset);
+  const uint64_t End = Data.getU64(&Offset);
+  const uint32_t Length = Data.getU32(&Offset);
+  if (!Data.isValidOffsetForDataOfSize(Offset, Length))
+    return createStringError(std::errc::io_error,
+        "0x%8.8" PRIx64 ": missing spilled FunctionInfo data", Offset);
+  if (Length == 0)
+    return FunctionInfo(Start, End - Start);
+  DataExtractor FIData(Data.getData().substr(Offset, Length),
+                       Data.isLittleEndian(), Data.getAddressSize());
+  Offset += Length;
+  return FunctionInfo::decode(FIData, Start);
+}
+
+llvm::Error GsymCreator::spillFunctionInfos() {
+  llvm::parallelSort(Funcs);
+
+  SmallString<128> Path;
+  int FD;
+  if (std::error_code EC =
+          sys::fs::createTemporaryFile("gsym-spill", "tmp", FD, Path))
+    return errorCodeToError(EC);
+  raw_fd_ostream OutStrm(FD, /*shouldClose=*/true);
+  FileWriter O(OutStrm, support::endian::system_endianness());
+  for (FunctionInfo &FI : Funcs) {
+    O.writeU64(FI.startAddress());
+    O.writeU64(FI.endAddress());
+    const uint64_t Length = FI.cacheEncoding();
+    if (Length > UINT32_MAX) {
+      OutStrm.close();
+      sys::fs::remove(Path);
+      return createStringError(std::errc::invalid_argument,
+                               "FunctionInfo encoding is too large to spill");
+    }
+    O.writeU32(static_cast<uint32_t>(Length));
+    O.writeData(llvm::ArrayRef<uint8_t>(
+        (const uint8_t *)FI.EncodingCache.data(), FI.EncodingCache.size()));
+  }
+  OutStrm.close();
+  if (OutStrm.has_error()) {
+    std::error_code EC = OutStrm.error();
+    OutStrm.clear_error();
+    sys::fs::remove(Path);
+    return errorCodeToError(EC);
+  }
+
+  SpillFiles.push_back(std::string(Path));
+  NumSpilledFuncs += Funcs.size();
+  Funcs.clear();
+  Funcs.shrink_to_fit();
+  return Error::success();
+}
+
+void GsymCreator::spillFunctionInfosIfNeeded() {
+  if (SpillThreshold == 0 || Funcs.size() <= SpillThreshold)
+    return;
+  if (Error Err = spillFunctionInfos()) {
+    SpillError = toString(std::move(Err));
+    SpillThreshold = 0;
+  }
+}
+
+llvm::Error GsymCreator::mergeSpilledFunctionInfos(raw_ostream &OS) {
+  // Each spill file is a sorted run of function infos. The function infos
+  // still in memory are sorted and merged as one more run.
+  struct SpillRun {
+    std::unique_ptr<MemoryBuffer> Buffer;
+    DataExtractor Data;
+    uint64_t Offset = 0;
+  };
+  std::vector<SpillRun> Runs;
+  Runs.reserve(SpillFiles.size());
+  for (const std::string &Path : SpillFiles) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(Path, /*IsText=*/false,
+                              /*RequiresNullTerminator=*/false);
+    if (!BufferOrErr)
+      return errorCodeToError(BufferOrErr.getError());
+    DataExtractor Data((*BufferOrErr)->getBuffer(), sys::IsLittleEndianHost, 8);
+    Runs.push_back({std::move(*BufferOrErr), Data});
+  }
+  llvm::parallelSort(Funcs);
+  std::vector<FunctionInfo> InMemoryFuncs;
+  std::swap(Funcs, InMemoryFuncs);
+  size_t InMemoryIdx = 0;
+
+  // Read the next function info of run \a RunIdx, where the run after the
+  // spill files is the in memory run.
+  auto ReadNext = [&](size_t RunIdx) -> Expected<std::optional<FunctionInfo>> {
+    if (RunIdx == Runs.size()) {
+      if (InMemoryIdx == InMemoryFuncs.size())
+        return std::nullopt;
+      return std::move(InMemoryFuncs[InMemoryIdx++]);
+    }
+    SpillRun &Run = Runs[RunIdx];
+    if (Run.Offset == Run.Data.size())
+      return std::nullopt;
+    Expected<FunctionInfo> FI = decodeSpilledFunctionInfo(Run.Data, Run.Offset);
+    if (!FI)
+      return FI.takeError();
+    return std::move(*FI);
+  };
+
+  struct MergeEntry {
+    FunctionInfo FI;
+    size_t RunIdx;
+  };
+  auto Greater = [](const MergeEntry &LHS, const MergeEntry &RHS) {
+    return RHS.FI < LHS.FI;
+  };
+  std::vector<MergeEntry> Heap;
+  Heap.reserve(Runs.size() + 1);
+  for (size_t RunIdx = 0; RunIdx <= Runs.size(); ++RunIdx) {
+    Expected<std::optional<FunctionInfo>> FI = ReadNext(RunIdx);
+    if (!FI)
+      return FI.takeError();
+    if (*FI)
+      Heap.push_back({std::move(**FI), RunIdx});
+  }
+  std::make_heap(Heap.begin(), Heap.end(), Greater);
+
+  size_t NumCompacted = 0;
+  while (!Heap.empty()) {
+    std::pop_heap(Heap.begin(), Heap.end(), Greater);
+    MergeEntry Entry = std::move(Heap.back());
+    Heap.pop_back();
+    Expected<std::optional<FunctionInfo>> Next = ReadNext(Entry.RunIdx);
+    if (!Next)
+      return Next.takeError();
+    if (*Next) {
+      Heap.push_back({std::move(**Next), Entry.RunIdx});
+      std::push_heap(Heap.begin(), Heap.end(), Greater);
+    }
+    addFinalizedFunctionInfo(Funcs, std::move(Entry.FI), OS);
+    // Only the last finalized function info can still be replaced by a later
+    // one, so all others can be reduced to their encoded bytes.
+    for (; NumCompacted + 1 < Funcs.size(); ++NumCompacted) {
+      FunctionInfo &FI = Funcs[NumCompacted];
+      if (FI.cacheEncoding() == 0)
+        continue;
+      FI.OptLineTable = std::nullopt;
+      FI.Inline = std::nullopt;
+    }
+  }
+
+  Runs.clear();
+  for (const std::string &Path : SpillFiles)
+    sys::fs::remove(Path);
+  SpillFiles.clear();
+  NumSpilledFuncs = 0;
+  return Error::success();
+}
+
 uint32_t GsymCreator::copyString(const GsymCreator &SrcGC, uint32_t StrOff) {
   // String offset at zero is always the empty string, no copying needed.
   if (StrOff == 0)
@@ -335,6 +539,23 @@ uint32_t GsymCreator::insertString(StringRef S, bool Copy) {
 void GsymCreator::addFunctionInfo(FunctionInfo &&FI) {
   std::lock_guard<std::mutex> Guard(Mutex);
   Funcs.emplace_back(std::move(FI));
+  spillFunctionInfosIfNeeded();
+}
+
+void GsymCreator::addFunctionInfos(std::vector<FunctionInfo> &&FIs) {
+  std::lock_guard<std::mutex> Guard(Mutex);
+  if (Funcs.empty())
+    Funcs = std::move(FIs);
+  else
+    Funcs.insert(Funcs.end(), std::make_move_iterator(FIs.begin()),
+                 std::make_move_iterator(FIs.end()));
+  spillFunctionInfosIfNeeded();
+}
+
+void GsymCreator::setSpillThreshold(size_t MaxFuncs) {
+  std::lock_guard<std::mutex> Guard(Mutex);
+  SpillThreshold = MaxFuncs;
+  spillFunctionInfosIfNeeded();
 }
 
 void GsymCreator::forEachFunctionInfo(
@@ -357,7 +578,7 @@ void GsymCreator::forEachFunctionInfo(
 
 size_t GsymCreator::getNumFunctionInfos() const {
   std::lock_guard<std::mutex> Guard(Mutex);
-  return Funcs.size();
+  return Funcs.size() + NumSpilledFuncs;
 }
 
 bool GsymCreator::IsValidTextAddress(uint64_t Addr) const {
@@ -447,7 +668,15 @@ uint64_t GsymCreator::copyFunctionInfo(const GsymCreator &SrcGC, size_t FuncIdx)
   // To copy a function info we need to copy any files and strings over into
   // this GsymCreator and then copy the function info and update the string
   // table offsets to match the new offsets.
-  const FunctionInfo &SrcFI = SrcGC.Funcs[FuncIdx];
+  const FunctionInfo *SrcFIPtr = &SrcGC.Funcs[FuncIdx];
+  // Function infos that only kept their encoding need to be decoded so their
+  // strings and files can be copied.
+  std::optional<FunctionInfo> ExpandedFI;
+  if (!SrcFIPtr->EncodingCache.empty()) {
+    ExpandedFI = cantFail(expandFunctionInfo(*SrcFIPtr));
+    SrcFIPtr = &*ExpandedFI;
+  }
+  const FunctionInfo &SrcFI = *SrcFIPtr;
 
   FunctionInfo DstFI;
   DstFI.Range = SrcFI.Range;
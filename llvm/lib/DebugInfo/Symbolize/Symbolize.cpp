@@ -13,8 +13,14 @@
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/DebugInfo/BTF/BTFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/GSYM/DwarfTransformer.h"
+#include "llvm/DebugInfo/GSYM/GsymContext.h"
+#include "llvm/DebugInfo/GSYM/GsymCreator.h"
+#include "llvm/DebugInfo/GSYM/GsymReader.h"
+#include "llvm/DebugInfo/GSYM/ObjectFileTransformer.h"
 #include "llvm/DebugInfo/PDB/PDB.h"
 #include "llvm/DebugInfo/PDB/PDBContext.h"
 #include "llvm/DebugInfo/Symbolize/SymbolizableObjectFile.h"
@@ -25,12 +31,14 @@
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Support/CRC.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -551,6 +559,132 @@ LLVMSymbolizer::createModuleInfo(const ObjectFile *Obj,
   return InsertResult.first->second.get();
 }
 
+// Converts the DWARF in DebugObj and the symbol table of Obj into a GSYM file
+// at Path. The file is written to a temporary file first and then renamed, so
+// that concurrent symbolizers never observe a partially written cache entry.
+static Error createGsymFile(const ObjectFile &Obj, const ObjectFile &DebugObj,
+                            StringRef DWPName, unsigned NumThreads,
+                            StringRef Path) {
+  gsym::GsymCreator Gsym(/*Quiet=*/true);
+
+  // Only add functions from sections that contain instructions, see
+  // GsymCreator::SetValidTextRanges().
+  AddressRanges TextRanges;
+  for (const SectionRef &Sect : Obj.sections()) {
+    if (!Sect.isText() || Sect.getSize() == 0)
+      continue;
+    TextRanges.insert(
+        AddressRange(Sect.getAddress(), Sect.getAddress() + Sect.getSize()));
+  }
+  if (!TextRanges.empty())
+    Gsym.SetValidTextRanges(TextRanges);
+
+  std::unique_ptr<DWARFContext> DICtx = DWARFContext::create(
+      DebugObj, DWARFContext::ProcessDebugRelocations::Process, nullptr,
+      std::string(DWPName));
+  gsym::DwarfTransformer DT(*DICtx, Gsym);
+  if (Error Err = DT.convert(NumThreads, nullptr))
+    return Err;
+  if (Error Err = gsym::ObjectFileTransformer::convert(Obj, nullptr, Gsym))
+    return Err;
+  if (Error Err = Gsym.finalize(nulls()))
+    return Err;
+
+  SmallString<128> Model = sys::path::parent_path(Path);
+  // Use the "llvmcache-" prefix so that files left behind by a symbolizer that
+  // was killed are pruned as well.
+  sys::path::append(Model, "llvmcache-gsym-%%%%%%%%.tmp");
+  SmallString<128> TempPath;
+  sys::fs::createUniquePath(Model, TempPath, /*MakeAbsolute=*/false);
+  if (Error Err = Gsym.save(TempPath, Obj.isLittleEndian()
+                                          ? support::little
+                                          : support::big)) {
+    sys::fs::remove(TempPath);
+    return Err;
+  }
+  if (std::error_code EC = sys::fs::rename(TempPath, Path)) {
+    sys::fs::remove(TempPath);
+    return errorCodeToError(EC);
+  }
+  return Error::success();
+}
+
+// Returns the name of the GSYM cache entry for Obj, or an empty string if Obj
+// should not be cached. Only binaries with a build ID are cached. The build ID
+// alone is not a reliable key (it may be a fixed --build-id=0x... value, and
+// the debug info may live in a separate file), so the size and modification
+// time of every file the GSYM is built from are hashed into the name as well.
+static std::string getGsymCacheEntryName(const ObjectFile &Obj,
+                                         const ObjectFile &DebugObj,
+                                         StringRef DWPName) {
+  BuildIDRef BuildID = getBuildID(&Obj);
+  if (BuildID.empty())
+    return {};
+
+  std::string Key;
+  raw_string_ostream OS(Key);
+  auto AddFile = [&](StringRef Name) {
+    sys::fs::file_status Status;
+    if (sys::fs::status(Name, Status))
+      return false;
+    OS << Name << '\0' << Status.getSize() << '\0'
+       << Status.getLastModificationTime().time_since_epoch().count() << '\0';
+    return true;
+  };
+  if (!AddFile(Obj.getFileName()))
+    return {};
+  if (&DebugObj != &Obj && !AddFile(DebugObj.getFileName()))
+    return {};
+  std::string DWPPath =
+      DWPName.empty() ? (DebugObj.getFileName() + ".dwp").str() : DWPName.str();
+  if (sys::fs::exists(DWPPath) && !AddFile(DWPPath))
+    return {};
+
+  // Use the "llvmcache-" prefix so that the entries are subject to pruning.
+  return "llvmcache-gsym-" + toHex(BuildID, /*LowerCase=*/true) + "-" +
+         utohexstr(xxh3_64bits(OS.str()), /*LowerCase=*/true);
+}
+
+std::unique_ptr<DIContext>
+LLVMSymbolizer::getOrCreateGsymContext(const ObjectPair &Objects) {
+  std::string EntryName =
+      getGsymCacheEntryName(*Objects.first, *Objects.second, Opts.DWPName);
+  if (EntryName.empty())
+    return nullptr;
+
+  SmallString<128> Path(Opts.GsymCacheDir);
+  sys::path::append(Path, EntryName);
+
+  if (!sys::fs::exists(Path)) {
+    if (sys::fs::create_directories(Opts.GsymCacheDir))
+      return nullptr;
+    if (Error Err = createGsymFile(*Objects.first, *Objects.second,
+                                   Opts.DWPName, Opts.GsymCacheThreads, Path)) {
+      consumeError(std::move(Err));
+      return nullptr;
+    }
+    Expected<CachePruningPolicy> PolicyOrErr =
+        parseCachePruningPolicy(Opts.GsymCachePruningPolicy);
+    if (PolicyOrErr)
+      llvm::pruneCache(Opts.GsymCacheDir, *PolicyOrErr);
+    else
+      consumeError(PolicyOrErr.takeError());
+  }
+
+  Expected<gsym::GsymReader> ReaderOrErr = gsym::GsymReader::openFile(Path);
+  if (!ReaderOrErr) {
+    consumeError(ReaderOrErr.takeError());
+    return nullptr;
+  }
+  // GSYM has no information about data and locals, so those queries go to the
+  // DWARF. Creating the DWARF context does not parse anything yet.
+  return std::make_unique<gsym::GsymContext>(
+      std::make_unique<gsym::GsymReader>(std::move(*ReaderOrErr)),
+      DWARFContext::create(*Objects.second,
+                           DWARFContext::ProcessDebugRelocations::Process,
+                           nullptr, Opts.DWPName));
+}
+
 Expected<SymbolizableModule *>
 LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   std::string BinaryName = ModuleName;
@@ -601,6 +735,8 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       Context.reset(new PDBContext(*CoffObject, std::move(Session)));
     }
   }
+  if (!Context && !Opts.GsymCacheDir.empty())
+    Context = getOrCreateGsymContext(Objects);
   if (!Context)
     Context = DWARFContext::create(
         *Objects.second, DWARFContext::ProcessDebugRelocations::Process,
@@ -0,0 +1,452 @@
+//===-- CompactModuleSummaryIndex.cpp - Compact summary index -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the writer and the reader of the compact summary index
+// format.
+//
+// The file starts with the header below. It is followed by these columns, in
+// this order, each starting at a multiple of 8 bytes from the start of the
+// file:
+//
+//   uint64_t ModuleIds[NumModules]
+//   uint32_t ModuleHashes[NumModules * 5]
+//   uint32_t ModulePathOffsets[NumModules + 1]  (into the string table)
+//   uint64_t GUIDs[NumValues]                   (sorted)
+//   uint32_t FirstSummary[NumValues + 1]
+//   uint64_t OriginalNames[NumSummaries]
+//   uint64_t EntryCounts[NumSummaries]
+//   uint64_t FirstRef[NumSummaries + 1]
+//   uint64_t FirstCall[NumSummaries + 1]
+//   uint32_t SummaryFlags[NumSummaries]
+//   uint32_t SummaryModules[NumSummaries]
+//   uint32_t SummaryAux[NumSummaries]
+//   uint32_t Refs[NumRefs]
+//   uint32_t Callees[NumCalls]
+//   uint32_t CalleeInfos[NumCalls]
+//   char StringTable[StringTableSize]
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/CompactModuleSummaryIndex.h"
+#include "llvm/Support/Alignment.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static constexpr StringLiteral Magic = "LCSI";
+static constexpr uint32_t Version = 1;
+
+namespace {
+struct Header {
+  char Magic[4];
+  support::ulittle32_t Version;
+  support::ulittle64_t IndexFlags;
+  support::ulittle32_t NumModules;
+  support::ulittle32_t NumValues;
+  support::ulittle32_t NumSummaries;
+  support::ulittle32_t Reserved;
+  support::ulittle64_t NumRefs;
+  support::ulittle64_t NumCalls;
+  support::ulittle64_t StringTableSize;
+};
+} // end anonymous namespace
+
+// Layout of the SummaryFlags column.
+static constexpr unsigned KindShift = 10;
+static constexpr unsigned KindFlagsShift = 16;
+
+// Refs hold a ValueID and two access bits.
+static constexpr uint32_t RefReadOnly = 1;
+static constexpr uint32_t RefWriteOnly = 2;
+static constexpr unsigned RefValueShift = 2;
+static constexpr uint32_t MaxValues = UINT32_MAX >> RefValueShift;
+
+// SummaryAux of an alias whose aliasee was not recorded.
+static constexpr uint32_t NoAliasee = UINT32_MAX;
+
+static uint32_t encodeGVFlags(GlobalValueSummary::GVFlags Flags) {
+  return Flags.Linkage | Flags.Visibility << 4 |
+         Flags.NotEligibleToImport << 6 | Flags.Live << 7 |
+         Flags.DSOLocal << 8 | Flags.CanAutoHide << 9;
+}
+
+static uint32_t encodeFFlags(FunctionSummary::FFlags Flags) {
+  return Flags.ReadNone | Flags.ReadOnly << 1 | Flags.NoRecurse << 2 |
+         Flags.ReturnDoesNotAlias << 3 | Flags.NoInline << 4 |
+         Flags.AlwaysInline << 5 | Flags.NoUnwind << 6 | Flags.MayThrow << 7 |
+         Flags.HasUnknownCall << 8 | Flags.MustBeUnreachable << 9;
+}
+
+static uint32_t encodeGVarFlags(GlobalVarSummary::GVarFlags Flags) {
+  return Flags.MaybeReadOnly | Flags.MaybeWriteOnly << 1 |
+         Flags.Constant << 2 | Flags.VCallVisibility << 3;
+}
+
+void llvm::writeCompactModuleSummaryIndex(const ModuleSummaryIndex &Index,
+                                          raw_ostream &OS) {
+  // Sort modules and values so that the output does not depend on the order
+  // of the hash tables in the index.
+  std::vector<const ModuleSummaryIndex::ModuleInfo *> Modules;
+  for (const auto &Module : Index.modulePaths())
+    Modules.push_back(&Module);
+  llvm::sort(Modules, [](const ModuleSummaryIndex::ModuleInfo *LHS,
+                         const ModuleSummaryIndex::ModuleInfo *RHS) {
+    return LHS->first() < RHS->first();
+  });
+  StringMap<uint32_t> ModuleIndices;
+  std::vector<uint64_t> ModuleIds;
+  std::vector<uint32_t> ModuleHashes;
+  std::vector<uint32_t> ModulePathOffsets = {0};
+  std::string StringTable;
+  for (const ModuleSummaryIndex::ModuleInfo *Module : Modules) {
+    ModuleIndices[Module->first()] = ModuleIds.size();
+    ModuleIds.push_back(Module->second.first);
+    llvm::append_range(ModuleHashes, Module->second.second);
+    StringTable += Module->first();
+    ModulePathOffsets.push_back(StringTable.size());
+  }
+
+  std::vector<GlobalValue::GUID> GUIDs;
+  for (const auto &Value : Index)
+    GUIDs.push_back(Value.first);
+  llvm::sort(GUIDs);
+  if (GUIDs.size() > MaxValues)
+    report_fatal_error("too many values for the compact summary index");
+  auto GetValueID = [&](ValueInfo VI) -> uint32_t {
+    return llvm::lower_bound(GUIDs, VI.getGUID()) - GUIDs.begin();
+  };
+
+  std::vector<uint32_t> FirstSummary = {0};
+  std::vector<uint64_t> OriginalNames, EntryCounts;
+  std::vector<uint64_t> FirstRef = {0}, FirstCall = {0};
+  std::vector<uint32_t> SummaryFlags, SummaryModules, SummaryAux;
+  std::vector<uint32_t> Refs, Callees, CalleeInfos;
+  for (GlobalValue::GUID GUID : GUIDs) {
+    for (const auto &Summary : Index.getValueInfo(GUID).getSummaryList()) {
+      uint32_t Flags = encodeGVFlags(Summary->flags()) |
+                       Summary->getSummaryKind() << KindShift;
+      uint32_t Aux = 0;
+      uint64_t EntryCount = 0;
+      if (const auto *FS = dyn_cast<FunctionSummary>(Summary.get())) {
+        Flags |= encodeFFlags(FS->fflags()) << KindFlagsShift;
+        Aux = FS->instCount();
+        EntryCount = FS->entryCount();
+        for (const FunctionSummary::EdgeTy &Edge : FS->calls()) {
+          Callees.push_back(GetValueID(Edge.first));
+          CalleeInfos.push_back(Edge.second.Hotness |
+                                uint32_t(Edge.second.RelBlockFreq) << 3);
+        }
+      } else if (const auto *GVS = dyn_cast<GlobalVarSummary>(Summary.get())) {
+        Flags |= encodeGVarFlags(GVS->varflags()) << KindFlagsShift;
+      } else {
+        const auto *AS = cast<AliasSummary>(Summary.get());
+        Aux = AS->hasAliasee() ? GetValueID(AS->getAliaseeVI()) : NoAliasee;
+      }
+      for (ValueInfo Ref : Summary->refs())
+        Refs.push_back(GetValueID(Ref) << RefValueShift |
+                       (Ref.isReadOnly() ? RefReadOnly : 0) |
+                       (Ref.isWriteOnly() ? RefWriteOnly : 0));
+
+      OriginalNames.push_back(Summary->getOriginalName());
+      EntryCounts.push_back(EntryCount);
+      FirstRef.push_back(Refs.size());
+      FirstCall.push_back(Callees.size());
+      SummaryFlags.push_back(Flags);
+      SummaryModules.push_back(ModuleIndices.lookup(Summary->modulePath()));
+      SummaryAux.push_back(Aux);
+    }
+    FirstSummary.push_back(SummaryFlags.size());
+  }
+
+  uint64_t Start = OS.tell();
+  support::endian::Writer W(OS, support::little);
+  OS << Magic;
+  W.write<uint32_t>(Version);
+  W.write<uint64_t>(Index.getFlags());
+  W.write<uint32_t>(ModuleIds.size());
+  W.write<uint32_t>(GUIDs.size());
+  W.write<uint32_t>(SummaryFlags.size());
+  W.write<uint32_t>(0);
+  W.write<uint64_t>(Refs.size());
+  W.write<uint64_t>(Callees.size());
+  W.write<uint64_t>(StringTable.size());
+
+  auto WriteColumn = [&](const auto &Column) {
+    OS.write_zeros(offsetToAlignment(OS.tell() - Start, Align(8)));
+    for (auto Value : Column)
+      W.write(Value);
+  };
+  WriteColumn(ModuleIds);
+  WriteColumn(ModuleHashes);
+  WriteColumn(ModulePathOffsets);
+  WriteColumn(GUIDs);
+  WriteColumn(FirstSummary);
+  WriteColumn(OriginalNames);
+  WriteColumn(EntryCounts);
+  WriteColumn(FirstRef);
+  WriteColumn(FirstCall);
+  WriteColumn(SummaryFlags);
+  WriteColumn(SummaryModules);
+  WriteColumn(SummaryAux);
+  WriteColumn(Refs);
+  WriteColumn(Callees);
+  WriteColumn(CalleeInfos);
+  OS.write_zeros(offsetToAlignment(OS.tell() - Start, Align(8)));
+  OS << StringTable;
+}
+
+bool CompactModuleSummaryIndex::isCompactModuleSummaryIndex(
+    MemoryBufferRef Buffer) {
+  return Buffer.getBuffer().starts_with(Magic);
+}
+
+Expected<CompactModuleSummaryIndex>
+CompactModuleSummaryIndex::create(MemoryBufferRef Buffer) {
+  StringRef Data = Buffer.getBuffer();
+  if (Data.size() < sizeof(Header) || !isCompactModuleSummaryIndex(Buffer))
+    return createStringError(std::errc::invalid_argument,
+                             "not a compact summary index");
+  const auto *H = reinterpret_cast<const Header *>(Data.data());
+  if (H->Version != Version)
+    return createStringError(std::errc::invalid_argument,
+                             "unsupported compact summary index version %u",
+                             uint32_t(H->Version));
+
+  CompactModuleSummaryIndex Index;
+  Index.IndexFlags = H->IndexFlags;
+  uint64_t Offset = sizeof(Header);
+  auto Take = [&](auto &Column, uint64_t Size) {
+    using T = typename std::remove_reference_t<decltype(Column)>::value_type;
+    Offset = alignTo(Offset, Align(8));
+    if (Offset > Data.size() || Size > (Data.size() - Offset) / sizeof(T))
+      return false;
+    Column = ArrayRef(reinterpret_cast<const T *>(Data.data() + Offset), Size);
+    Offset += Size * sizeof(T);
+    return true;
+  };
+  uint64_t NumModules = H->NumModules, NumValues = H->NumValues,
+           NumSummaries = H->NumSummaries;
+  ArrayRef<char> StringTable;
+  if (!Take(Index.ModuleIds, NumModules) ||
+      !Take(Index.ModuleHashes, NumModules * 5) ||
+      !Take(Index.ModulePathOffsets, NumModules + 1) ||
+      !Take(Index.GUIDs, NumValues) ||
+      !Take(Index.FirstSummary, NumValues + 1) ||
+      !Take(Index.OriginalNames, NumSummaries) ||
+      !Take(Index.EntryCounts, NumSummaries) ||
+      !Take(Index.FirstRef, NumSummaries + 1) ||
+      !Take(Index.FirstCall, NumSummaries + 1) ||
+      !Take(Index.SummaryFlags, NumSummaries) ||
+      !Take(Index.SummaryModules, NumSummaries) ||
+      !Take(Index.SummaryAux, NumSummaries) ||
+      !Take(Index.Refs, H->NumRefs) || !Take(Index.Callees, H->NumCalls) ||
+      !Take(Index.CalleeInfos, H->NumCalls) ||
+      !Take(StringTable, H->StringTableSize))
+    return createStringError(std::errc::invalid_argument,
+                             "truncated compact summary index");
+  Index.StringTable = StringRef(StringTable.data(), StringTable.size());
+
+  // The ends of the offset columns must match the sizes in the header.
+  if (Index.ModulePathOffsets.back() != H->StringTableSize ||
+      Index.FirstSummary.back() != NumSummaries ||
+      Index.FirstRef.back() != H->NumRefs ||
+      Index.FirstCall.back() != H->NumCalls)
+    return createStringError(std::errc::invalid_argument,
+                             "malformed compact summary index");
+  return Index;
+}
+
+ModuleHash CompactModuleSummaryIndex::getModuleHash(unsigned Module) const {
+  ModuleHash Hash;
+  for (unsigned I = 0; I != Hash.size(); ++I)
+    Hash[I] = ModuleHashes[Module * Hash.size() + I];
+  return Hash;
+}
+
+std::optional<CompactModuleSummaryIndex::ValueID>
+CompactModuleSummaryIndex::findValue(GlobalValue::GUID GUID) const {
+  auto It = llvm::lower_bound(GUIDs, GUID);
+  if (It == GUIDs.end() || *It != GUID)
+    return std::nullopt;
+  return It - GUIDs.begin();
+}
+
+GlobalValueSummary::SummaryKind
+CompactModuleSummaryIndex::getSummaryKind(SummaryID S) const {
+  return GlobalValueSummary::SummaryKind(SummaryFlags[S] >> KindShift & 3);
+}
+
+GlobalValueSummary::GVFlags
+CompactModuleSummaryIndex::getGVFlags(SummaryID S) const {
+  uint32_t Flags = SummaryFlags[S];
+  return GlobalValueSummary::GVFlags(
+      GlobalValue::LinkageTypes(Flags & 0xf),
+      GlobalValue::VisibilityTypes(Flags >> 4 & 3),
+      /*NotEligibleToImport=*/Flags >> 6 & 1, /*Live=*/Flags >> 7 & 1,
+      /*IsLocal=*/Flags >> 8 & 1, /*CanAutoHide=*/Flags >> 9 & 1);
+}
+
+FunctionSummary::FFlags
+CompactModuleSummaryIndex::getFFlags(SummaryID S) const {
+  assert(getSummaryKind(S) == GlobalValueSummary::FunctionKind);
+  uint32_t Flags = SummaryFlags[S] >> KindFlagsShift;
+  FunctionSummary::FFlags FFlags = {};
+  FFlags.ReadNone = Flags & 1;
+  FFlags.ReadOnly = Flags >> 1 & 1;
+  FFlags.NoRecurse = Flags >> 2 & 1;
+  FFlags.ReturnDoesNotAlias = Flags >> 3 & 1;
+  FFlags.NoInline = Flags >> 4 & 1;
+  FFlags.AlwaysInline = Flags >> 5 & 1;
+  FFlags.NoUnwind = Flags >> 6 & 1;
+  FFlags.MayThrow = Flags >> 7 & 1;
+  FFlags.HasUnknownCall = Flags >> 8 & 1;
+  FFlags.MustBeUnreachable = Flags >> 9 & 1;
+  return FFlags;
+}
+
+unsigned CompactModuleSummaryIndex::getInstCount(SummaryID S) const {
+  assert(getSummaryKind(S) == GlobalValueSummary::FunctionKind);
+  return SummaryAux[S];
+}
+
+GlobalVarSummary::GVarFlags
+CompactModuleSummaryIndex::getGVarFlags(SummaryID S) const {
+  assert(getSummaryKind(S) == GlobalValueSummary::GlobalVarKind);
+  uint32_t Flags = SummaryFlags[S] >> KindFlagsShift;
+  return GlobalVarSummary::GVarFlags(
+      /*ReadOnly=*/Flags & 1, /*WriteOnly=*/Flags >> 1 & 1,
+      /*Constant=*/Flags >> 2 & 1,
+      GlobalObject::VCallVisibility(Flags >> 3 & 3));
+}
+
+std::optional<CompactModuleSummaryIndex::ValueID>
+CompactModuleSummaryIndex::getAliasee(SummaryID S) const {
+  if (getSummaryKind(S) != GlobalValueSummary::AliasKind ||
+      SummaryAux[S] == NoAliasee)
+    return std::nullopt;
+  return SummaryAux[S];
+}
+
+CompactModuleSummaryIndex::Ref
+CompactModuleSummaryIndex::getRef(SummaryID S, uint64_t I) const {
+  assert(I < getNumRefs(S) && "reference out of range");
+  uint32_t Raw = Refs[FirstRef[S] + I];
+  return {Raw >> RefValueShift, bool(Raw & RefReadOnly),
+          bool(Raw & RefWriteOnly)};
+}
+
+CompactModuleSummaryIndex::Call
+CompactModuleSummaryIndex::getCall(SummaryID S, uint64_t I) const {
+  assert(I < getNumCalls(S) && "call out of range");
+  uint64_t Pos = FirstCall[S] + I;
+  uint32_t Info = CalleeInfos[Pos];
+  return {Callees[Pos],
+          CalleeInfo(CalleeInfo::HotnessType(Info & 7), Info >> 3)};
+}
+
+void CompactModuleSummaryIndex::materialize(ModuleSummaryIndex &Index,
+                                            ArrayRef<ValueID> Values) const {
+  // An alias summary points to the summary of its aliasee in the same module.
+  std::vector<ValueID> Worklist(Values.begin(), Values.end());
+  for (ValueID V : Values)
+    for (SummaryID S : summaries(V))
+      if (std::optional<ValueID> Aliasee = getAliasee(S))
+        Worklist.push_back(*Aliasee);
+  llvm::sort(Worklist);
+  Worklist.erase(std::unique(Worklist.begin(), Worklist.end()), Worklist.end());
+
+  auto GetValueInfo = [&](ValueID V) {
+    return Index.getOrInsertValueInfo(getGUID(V));
+  };
+  auto GetModulePath = [&](SummaryID S) {
+    unsigned Module = getSummaryModule(S);
+    return Index
+        .addModule(getModulePath(Module), getModuleId(Module),
+                   getModuleHash(Module))
+        ->first();
+  };
+
+  SmallVector<std::pair<AliasSummary *, SummaryID>, 0> Aliases;
+  for (ValueID V : Worklist) {
+    ValueInfo VI = GetValueInfo(V);
+    for (SummaryID S : summaries(V)) {
+      StringRef ModulePath = GetModulePath(S);
+      if (Index.findSummaryInModule(VI, ModulePath))
+        continue;
+
+      std::vector<ValueInfo> SummaryRefs;
+      SummaryRefs.reserve(getNumRefs(S));
+      for (uint64_t I = 0, E = getNumRefs(S); I != E; ++I) {
+        Ref R = getRef(S, I);
+        ValueInfo RefVI = GetValueInfo(R.Value);
+        if (R.ReadOnly)
+          RefVI.setReadOnly();
+        if (R.WriteOnly)
+          RefVI.setWriteOnly();
+        SummaryRefs.push_back(RefVI);
+      }
+
+      std::unique_ptr<GlobalValueSummary> Summary;
+      switch (getSummaryKind(S)) {
+      case GlobalValueSummary::FunctionKind: {
+        std::vector<FunctionSummary::EdgeTy> Calls;
+        Calls.reserve(getNumCalls(S));
+        for (uint64_t I = 0, E = getNumCalls(S); I != E; ++I) {
+          Call C = getCall(S, I);
+          Calls.push_back({GetValueInfo(C.Callee), C.Info});
+        }
+        Summary = std::make_unique<FunctionSummary>(
+            getGVFlags(S), getInstCount(S), getFFlags(S), getEntryCount(S),
+            std::move(SummaryRefs), std::move(Calls),
+            std::vector<GlobalValue::GUID>(),
+            std::vector<FunctionSummary::VFuncId>(),
+            std::vector<FunctionSummary::VFuncId>(),
+            std::vector<FunctionSummary::ConstVCall>(),
+            std::vector<FunctionSummary::ConstVCall>(),
+            std::vector<FunctionSummary::ParamAccess>(),
+            std::vector<CallsiteInfo>(), std::vector<AllocInfo>());
+        break;
+      }
+      case GlobalValueSummary::GlobalVarKind:
+        Summary = std::make_unique<GlobalVarSummary>(
+            getGVFlags(S), getGVarFlags(S), std::move(SummaryRefs));
+        break;
+      case GlobalValueSummary::AliasKind: {
+        auto AS = std::make_unique<AliasSummary>(getGVFlags(S));
+        Aliases.push_back({AS.get(), S});
+        Summary = std::move(AS);
+        break;
+      }
+      }
+      Summary->setModulePath(ModulePath);
+      Summary->setOriginalName(getOriginalName(S));
+      Index.addGlobalValueSummary(VI, std::move(Summary));
+    }
+  }
+
+  for (auto [AS, S] : Aliases) {
+    std::optional<ValueID> Aliasee = getAliasee(S);
+    if (!Aliasee)
+      continue;
+    ValueInfo AliaseeVI = GetValueInfo(*Aliasee);
+    AS->setAliasee(AliaseeVI,
+                   Index.findSummaryInModule(AliaseeVI, AS->modulePath()));
+  }
+}
+
+std::unique_ptr<ModuleSummaryIndex>
+CompactModuleSummaryIndex::materializeAll() const {
+  auto Index = std::make_unique<ModuleSummaryIndex>(/*HaveGVs=*/false);
+  Index->setFlags(IndexFlags);
+  for (unsigned Module = 0, E = getNumModules(); Module != E; ++Module)
+    Index->addModule(getModulePath(Module), getModuleId(Module),
+                     getModuleHash(Module));
+  materialize(*Index, to_vector(seq<ValueID>(0, getNumValues())));
+  return Index;
+}
@@ -12,6 +12,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/GVMaterializer.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/Error.h"
 using namespace llvm;
 
 GVMaterializer::~GVMaterializer() = default;
+
+Error GVMaterializer::materializeFunctions(ArrayRef<Function *> Functions) {
+  for (Function *F : Functions)
+    if (Error Err = materialize(F))
+      return Err;
+  return Error::success();
+}
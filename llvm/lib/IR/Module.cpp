@@ -443,6 +443,13 @@ Error Module::materialize(GlobalValue *GV) {
   return Materializer->materialize(GV);
 }
 
+Error Module::materializeFunctions(ArrayRef<Function *> Functions) {
+  if (!Materializer)
+    return Error::success();
+
+  return Materializer->materializeFunctions(Functions);
+}
+
 Error Module::materializeAll() {
   if (!Materializer)
     return Error::success();
@@ -31,6 +31,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Memory.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -39,6 +40,7 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <system_error>
 #include <utility>
@@ -217,9 +219,15 @@ static bool isCompressable(const SectionBase &Sec) {
          StringRef(Sec.Name).startswith(".debug");
 }
 
+// Replace the sections for which \p ShouldReplace returns true with the ones
+// returned by \p AddSection, which also receives the position of the section
+// among those being replaced. \p Prepare, if set, is called with the list of
+// sections to replace before any of them is added.
 static Error replaceDebugSections(
     Object &Obj, function_ref<bool(const SectionBase &)> ShouldReplace,
-    function_ref<Expected<SectionBase *>(const SectionBase *)> AddSection) {
+    function_ref<Expected<SectionBase *>(const SectionBase *, size_t)>
+        AddSection,
+    function_ref<void(ArrayRef<SectionBase *>)> Prepare = nullptr) {
   // Build a list of the debug sections we are going to replace.
   // We can't call `AddSection` while iterating over sections,
   // because it would mutate the sections array.
@@ -228,10 +236,13 @@ static Error replaceDebugSections(
     if (ShouldReplace(Sec))
       ToReplace.push_back(&Sec);
 
+  if (Prepare)
+    Prepare(ToReplace);
+
   // Build a mapping from original section to a new one.
   DenseMap<SectionBase *, SectionBase *> FromTo;
-  for (SectionBase *S : ToReplace) {
-    Expected<SectionBase *> NewSection = AddSection(S);
+  for (auto [I, S] : enumerate(ToReplace)) {
+    Expected<SectionBase *> NewSection = AddSection(S, I);
     if (!NewSection)
       return NewSection.takeError();
 
@@ -522,18 +533,29 @@ static Error replaceAndRemoveSections(const CommonConfig &Config,
     return E;
 
   if (Config.CompressionType != DebugCompressionType::None) {
+    // Compression dominates the run time for large inputs and each section is
+    // compressed independently, so compress all of them in parallel first and
+    // only add the resulting sections to the object serially.
+    std::vector<std::optional<CompressedSection>> Compressed;
     if (Error Err = replaceDebugSections(
             Obj, isCompressable,
-            [&Config, &Obj](const SectionBase *S) -> Expected<SectionBase *> {
+            [&](const SectionBase *, size_t I) -> Expected<SectionBase *> {
               return &Obj.addSection<CompressedSection>(
-                  CompressedSection(*S, Config.CompressionType, Obj.Is64Bits));
+                  std::move(*Compressed[I]));
+            },
+            [&](ArrayRef<SectionBase *> ToCompress) {
+              Compressed.resize(ToCompress.size());
+              parallelFor(0, ToCompress.size(), [&](size_t I) {
+                Compressed[I].emplace(*ToCompress[I], Config.CompressionType,
+                                      Obj.Is64Bits);
+              });
             }))
       return Err;
   } else if (Config.DecompressDebugSections) {
     if (Error Err = replaceDebugSections(
             Obj,
             [](const SectionBase &S) { return isa<CompressedSection>(&S); },
-            [&Obj](const SectionBase *S) {
+            [&Obj](const SectionBase *S, size_t) {
               const CompressedSection *CS = cast<CompressedSection>(S);
               return &Obj.addSection<DecompressedSection>(*CS);
             }))
@@ -20,6 +20,7 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include <algorithm>
 #include <cstddef>
@@ -2071,15 +2072,20 @@ template <class ELFT> void ELFWriter<ELFT>::writeShdrs() {
 }
 
 template <class ELFT> Error ELFWriter<ELFT>::writeSectionData() {
+  // Segments are responsible for writing their contents, so only write the
+  // section data if the section is not in a segment. Note that this renders
+  // sections in segments effectively immutable.
+  SmallVector<const SectionBase *, 0> ToWrite;
   for (SectionBase &Sec : Obj.sections())
-    // Segments are responsible for writing their contents, so only write the
-    // section data if the section is not in a segment. Note that this renders
-    // sections in segments effectively immutable.
     if (Sec.ParentSegment == nullptr)
-      if (Error Err = Sec.accept(*SecWriter))
-        return Err;
+      ToWrite.push_back(&Sec);
 
-  return Error::success();
+  // Every section is written to its own range of the pre-sized output buffer,
+  // so the sections can be written in parallel. This matters most for
+  // DecompressedSection, which decompresses its contents while being written.
+  return parallelForEachError(ToWrite, [&](const SectionBase *Sec) {
+    return Sec->accept(*SecWriter);
+  });
 }
 
 template <class ELFT> void ELFWriter<ELFT>::writeSegmentData() {
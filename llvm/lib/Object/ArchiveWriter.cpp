@@ -30,12 +30,14 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <cerrno>
 #include <map>
+#include <optional>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
 #include <unistd.h>
@@ -331,6 +333,16 @@ struct MemberData {
   std::string Header;
   StringRef Data;
   StringRef Padding;
+  bool Is64Bit = false;
+};
+
+// The archive symbols of one member, read independently of all other members
+// so that members can be parsed in parallel.
+struct MemberSymbols {
+  std::vector<std::string> Names;
+  bool IsSymbolic = false;
+  bool IsEC = false;
+  bool Is64Bit = false;
 };
 } // namespace
 
@@ -496,23 +508,6 @@ getSymbolicFile(MemoryBufferRef Buf, LLVMContext &Context) {
   }
 }
 
-static Expected<bool> is64BitSymbolicFile(const StringRef &ObjStringRef) {
-  MemoryBufferRef ObjMbf(ObjStringRef, "");
-  // In the scenario when LLVMContext is populated SymbolicFile will contain a
-  // reference to it, thus SymbolicFile should be destroyed first.
-  LLVMContext Context;
-  Expected<std::unique_ptr<SymbolicFile>> ObjOrErr =
-      getSymbolicFile(ObjMbf, Context);
-  if (!ObjOrErr)
-    return ObjOrErr.takeError();
-
-  // Treat non-symbolic file types as not 64-bits.
-  if (!*ObjOrErr)
-    return false;
-
-  return (*ObjOrErr)->is64Bit();
-}
-
 static void writeSymbolTable(raw_ostream &Out, object::Archive::Kind Kind,
                              bool Deterministic, ArrayRef<MemberData> Members,
                              StringRef StringTable, uint64_t MembersOffset,
@@ -539,13 +534,7 @@ static void writeSymbolTable(raw_ostream &Out, object::Archive::Kind Kind,
   uint64_t Pos = MembersOffset;
   for (const MemberData &M : Members) {
     if (isAIXBigArchive(Kind)) {
-      Expected<bool> Is64BitOrErr = is64BitSymbolicFile(M.Data);
-      // If there is an error, the error will have been emitted when
-      // 'computeMemberData' called the 'getSymbol' function, so don't need to
-      // handle it here.
-      if (!Is64BitOrErr)
-        cantFail(Is64BitOrErr.takeError());
-      if (*Is64BitOrErr != Is64Bit) {
+      if (M.Is64Bit != Is64Bit) {
         Pos += M.Header.size() + M.Data.size() + M.Padding.size();
         continue;
       }
@@ -629,14 +618,13 @@ static bool isECObject(object::SymbolicFile &Obj) {
   return false;
 }
 
-static Expected<std::vector<unsigned>>
-getSymbols(MemoryBufferRef Buf, uint16_t Index, raw_ostream &SymNames,
-           SymMap *SymMap, bool &HasObject) {
+static Expected<MemberSymbols> readMemberSymbols(MemoryBufferRef Buf,
+                                                 bool NeedECInfo) {
   // In the scenario when LLVMContext is populated SymbolicFile will contain a
   // reference to it, thus SymbolicFile should be destroyed first.
   LLVMContext Context;
 
-  std::vector<unsigned> Ret;
+  MemberSymbols Ret;
   Expected<std::unique_ptr<SymbolicFile>> ObjOrErr =
       getSymbolicFile(Buf, Context);
   if (!ObjOrErr)
@@ -648,31 +636,72 @@ getSymbols(MemoryBufferRef Buf, uint16_t Index, raw_ostream &SymNames,
 
   std::unique_ptr<object::SymbolicFile> Obj = std::move(*ObjOrErr);
 
-  std::map<std::string, uint16_t> *Map = nullptr;
-  if (SymMap)
-    Map = SymMap->UseECMap && isECObject(*Obj) ? &SymMap->ECMap : &SymMap->Map;
-  HasObject = true;
+  Ret.IsSymbolic = true;
+  Ret.IsEC = NeedECInfo && isECObject(*Obj);
+  Ret.Is64Bit = Obj->is64Bit();
   for (const object::BasicSymbolRef &S : Obj->symbols()) {
     if (!isArchiveSymbol(S))
       continue;
+    std::string Name;
+    raw_string_ostream NameStream(Name);
+    if (Error E = S.printName(NameStream))
+      return std::move(E);
+    Ret.Names.push_back(std::move(Name));
+  }
+  return Ret;
+}
+
+// Parse all members in parallel. Each member is parsed with its own
+// LLVMContext, so this is safe for bitcode members as well. Errors are
+// reported for the first failing member in member order, so diagnostics don't
+// depend on scheduling.
+static Expected<std::vector<MemberSymbols>>
+readAllMemberSymbols(ArrayRef<NewArchiveMember> Members, bool NeedECInfo) {
+  std::vector<std::optional<Expected<MemberSymbols>>> Results(Members.size());
+  parallelFor(0, Members.size(), [&](size_t I) {
+    Results[I].emplace(
+        readMemberSymbols(Members[I].Buf->getMemBufferRef(), NeedECInfo));
+  });
+
+  std::vector<MemberSymbols> Ret;
+  Ret.reserve(Members.size());
+  Error Err = Error::success();
+  for (size_t I = 0, E = Members.size(); I != E; ++I) {
+    Expected<MemberSymbols> &SymbolsOrErr = *Results[I];
+    if (!SymbolsOrErr) {
+      if (!Err)
+        Err = createFileError(Members[I].MemberName, SymbolsOrErr.takeError());
+      else
+        consumeError(SymbolsOrErr.takeError());
+      continue;
+    }
+    Ret.push_back(std::move(*SymbolsOrErr));
+  }
+  if (Err)
+    return std::move(Err);
+  return std::move(Ret);
+}
+
+// Add the symbols of the member at \p Index to the symbol table. This has to be
+// done in member order as the first definition of a symbol wins.
+static std::vector<unsigned> addMemberSymbols(const MemberSymbols &Symbols,
+                                              uint16_t Index,
+                                              raw_ostream &SymNames,
+                                              SymMap *SymMap) {
+  std::vector<unsigned> Ret;
+  std::map<std::string, uint16_t> *Map = nullptr;
+  if (SymMap)
+    Map = SymMap->UseECMap && Symbols.IsEC ? &SymMap->ECMap : &SymMap->Map;
+  for (const std::string &Name : Symbols.Names) {
     if (Map) {
-      std::string Name;
-      raw_string_ostream NameStream(Name);
-      if (Error E = S.printName(NameStream))
-        return std::move(E);
       if (Map->find(Name) != Map->end())
         continue; // ignore duplicated symbol
       (*Map)[Name] = Index;
-      if (Map == &SymMap->Map) {
-        Ret.push_back(SymNames.tell());
-        SymNames << Name << '\0';
-      }
-    } else {
-      Ret.push_back(SymNames.tell());
-      if (Error E = S.printName(SymNames))
-        return std::move(E);
-      SymNames << '\0';
+      if (Map != &SymMap->Map)
+        continue;
     }
+    Ret.push_back(SymNames.tell());
+    SymNames << Name << '\0';
   }
   return Ret;
 }
@@ -745,19 +774,28 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
       Entry.second = Entry.second > 1 ? 1 : 0;
   }
 
+  // Parsing the members is the expensive part of building the symbol table,
+  // so do it up front in parallel.
+  std::vector<MemberSymbols> MembersSymbols;
+  if (NeedSymbols) {
+    Expected<std::vector<MemberSymbols>> SymbolsOrErr =
+        readAllMemberSymbols(NewMembers, SymMap && SymMap->UseECMap);
+    if (!SymbolsOrErr)
+      return SymbolsOrErr.takeError();
+    MembersSymbols = std::move(*SymbolsOrErr);
+  }
+
   // The big archive format needs to know the offset of the previous member
   // header.
   uint64_t PrevOffset = 0;
-  uint16_t Index = 0;
-  for (const NewArchiveMember &M : NewMembers) {
+  for (size_t I = 0, E = NewMembers.size(); I != E; ++I) {
+    const NewArchiveMember &M = NewMembers[I];
     std::string Header;
     raw_string_ostream Out(Header);
 
     MemoryBufferRef Buf = M.Buf->getMemBufferRef();
     StringRef Data = Thin ? "" : Buf.getBuffer();
 
-    Index++;
-
     // ld64 expects the members to be 8-byte aligned for 64-bit content and at
     // least 4-byte aligned for 32-bit content.  Opt for the larger encoding
     // uniformly.  This matches the behaviour with cctools and ensures that ld64
@@ -796,16 +834,20 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
     Out.flush();
 
     std::vector<unsigned> Symbols;
+    bool Is64Bit = false;
     if (NeedSymbols) {
-      Expected<std::vector<unsigned>> SymbolsOrErr =
-          getSymbols(Buf, Index, SymNames, SymMap, HasObject);
-      if (!SymbolsOrErr)
-        return createFileError(M.MemberName, SymbolsOrErr.takeError());
-      Symbols = std::move(*SymbolsOrErr);
+      const MemberSymbols &MemberSyms = MembersSymbols[I];
+      // The COFF symbol map stores 1-based member numbers in 16 bits; archives
+      // with more members than that never get a symbol map.
+      Symbols = addMemberSymbols(MemberSyms, static_cast<uint16_t>(I + 1),
+                                 SymNames, SymMap);
+      HasObject |= MemberSyms.IsSymbolic;
+      Is64Bit = MemberSyms.Is64Bit;
     }
 
     Pos += Header.size() + Data.size() + Padding.size();
-    Ret.push_back({std::move(Symbols), std::move(Header), Data, Padding});
+    Ret.push_back(
+        {std::move(Symbols), std::move(Header), Data, Padding, Is64Bit});
   }
   // If there are no symbols, emit an empty symbol table, to satisfy Solaris
   // tools, older versions of which expect a symbol table in a non-empty
@@ -910,14 +952,8 @@ static Error writeArchiveToStream(raw_ostream &Out,
     // symbols; the second global symbol table does the same for 64-bit file
     // members. As a big archive can have both 32-bit and 64-bit file members,
     // we need to know the number of symbols in each symbol table individually.
-    if (isAIXBigArchive(Kind) && WriteSymtab) {
-      Expected<bool> Is64BitOrErr = is64BitSymbolicFile(M.Data);
-      if (Error E = Is64BitOrErr.takeError())
-        return E;
-
-      if (!*Is64BitOrErr)
-        NumSyms32 += M.Symbols.size();
-    }
+    if (isAIXBigArchive(Kind) && WriteSymtab && !M.Is64Bit)
+      NumSyms32 += M.Symbols.size();
   }
 
   std::optional<uint64_t> HeadersSize;
@@ -1017,21 +1053,15 @@ static Error writeArchiveToStream(raw_ostream &Out,
     raw_svector_ostream SymNames32(SymNamesBuf32);
     raw_svector_ostream SymNames64(SymNamesBuf64);
 
-    if (WriteSymtab && NumSyms)
-      // Generate the symbol names for the members.
-      for (const NewArchiveMember &M : NewMembers) {
-        MemoryBufferRef Buf = M.Buf->getMemBufferRef();
-        Expected<bool> Is64BitOrErr = is64BitSymbolicFile(Buf.getBuffer());
-        if (!Is64BitOrErr)
-          return Is64BitOrErr.takeError();
-
-        bool HasObject;
-        Expected<std::vector<unsigned>> SymbolsOrErr =
-            getSymbols(Buf, 0, *Is64BitOrErr ? SymNames64 : SymNames32, nullptr,
-                       HasObject);
-        if (!SymbolsOrErr)
-          return SymbolsOrErr.takeError();
-      }
+    if (WriteSymtab && NumSyms) {
+      // Split the symbol names collected by computeMemberData into the 32-bit
+      // and 64-bit tables. Big archives have no symbol map, so every symbol of
+      // a member was added to SymNamesBuf and no member has to be parsed again.
+      for (const MemberData &M : Data)
+        for (unsigned StringOffset : M.Symbols)
+          (M.Is64Bit ? SymNames64 : SymNames32)
+              << StringRef(SymNamesBuf.data() + StringOffset) << '\0';
+    }
 
     uint64_t MemberTableEndOffset =
         LastMemberEndOffset +
@@ -1437,14 +1437,9 @@ PassBuilder::buildModuleOptimizationPipeline(OptimizationLevel Level,
   return MPM;
 }
 
-ModulePassManager
-PassBuilder::buildPerModuleDefaultPipeline(OptimizationLevel Level,
-                                           bool LTOPreLink) {
-  if (Level == OptimizationLevel::O0)
-    return buildO0DefaultPipeline(Level, LTOPreLink);
-
-  ModulePassManager MPM;
-
+void PassBuilder::addPerModulePreSplitPasses(ModulePassManager &MPM,
+                                             OptimizationLevel Level,
+                                             ThinOrFullLTOPhase LTOPhase) {
   // Convert @llvm.global.annotations to !annotation metadata.
   MPM.addPass(Annotation2MetadataPass());
 
@@ -1457,12 +1452,13 @@ PassBuilder::buildPerModuleDefaultPipeline(OptimizationLevel Level,
   // Apply module pipeline start EP callback.
   invokePipelineStartEPCallbacks(MPM, Level);
 
-  const ThinOrFullLTOPhase LTOPhase = LTOPreLink
-                                          ? ThinOrFullLTOPhase::FullLTOPreLink
-                                          : ThinOrFullLTOPhase::None;
   // Add the core simplification pipeline.
   MPM.addPass(buildModuleSimplificationPipeline(Level, LTOPhase));
+}
 
+void PassBuilder::addPerModulePostSplitPasses(ModulePassManager &MPM,
+                                              OptimizationLevel Level,
+                                              ThinOrFullLTOPhase LTOPhase) {
   // Now add the optimization pipeline.
   MPM.addPass(buildModuleOptimizationPipeline(Level, LTOPhase));
 
@@ -1472,12 +1468,42 @@ PassBuilder::buildPerModuleDefaultPipeline(OptimizationLevel Level,
 
   // Emit annotation remarks.
   addAnnotationRemarksPass(MPM);
+}
+
+ModulePassManager
+PassBuilder::buildPerModuleDefaultPipeline(OptimizationLevel Level,
+                                           bool LTOPreLink) {
+  if (Level == OptimizationLevel::O0)
+    return buildO0DefaultPipeline(Level, LTOPreLink);
+
+  ModulePassManager MPM;
+  const ThinOrFullLTOPhase LTOPhase = LTOPreLink
+                                          ? ThinOrFullLTOPhase::FullLTOPreLink
+                                          : ThinOrFullLTOPhase::None;
+  addPerModulePreSplitPasses(MPM, Level, LTOPhase);
+  addPerModulePostSplitPasses(MPM, Level, LTOPhase);
 
   if (LTOPreLink)
     addRequiredLTOPreLinkPasses(MPM);
   return MPM;
 }
 
+ModulePassManager
+PassBuilder::buildPerModulePreSplitPipeline(OptimizationLevel Level) {
+  assert(Level != OptimizationLevel::O0 && "Must request optimizations!");
+  ModulePassManager MPM;
+  addPerModulePreSplitPasses(MPM, Level, ThinOrFullLTOPhase::None);
+  return MPM;
+}
+
+ModulePassManager
+PassBuilder::buildPerModulePostSplitPipeline(OptimizationLevel Level) {
+  assert(Level != OptimizationLevel::O0 && "Must request optimizations!");
+  ModulePassManager MPM;
+  addPerModulePostSplitPasses(MPM, Level, ThinOrFullLTOPhase::None);
+  return MPM;
+}
+
 ModulePassManager
 PassBuilder::buildFatLTODefaultPipeline(OptimizationLevel Level, bool ThinLTO,
                                         bool EmitSummary) {
@@ -11,7 +11,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/Path.h"
@@ -69,12 +71,14 @@ struct TimeTraceProfilerEntry {
   const TimePointType Start;
   TimePointType End;
   const std::string Name;
-  const std::string Detail;
+  const TimeTraceMetadata Metadata;
+  // Counters added by timeTraceAddCount(), usually very few.
+  SmallVector<std::pair<std::string, uint64_t>, 0> Counts;
 
   TimeTraceProfilerEntry(TimePointType &&S, TimePointType &&E, std::string &&N,
-                         std::string &&Dt)
+                         TimeTraceMetadata &&Mt)
       : Start(std::move(S)), End(std::move(E)), Name(std::move(N)),
-        Detail(std::move(Dt)) {}
+        Metadata(std::move(Mt)) {}
 
   // Calculate timings for FlameGraph. Cast time points to microsecond precision
   // rather than casting duration. This avoids truncation issues causing inner
@@ -95,16 +99,38 @@ struct TimeTraceProfilerEntry {
 } // anonymous namespace
 
 struct llvm::TimeTraceProfiler {
-  TimeTraceProfiler(unsigned TimeTraceGranularity = 0, StringRef ProcName = "")
+  TimeTraceProfiler(unsigned TimeTraceGranularity = 0, StringRef ProcName = "",
+                    bool RecordCounts = false)
       : BeginningOfTime(system_clock::now()), StartTime(ClockType::now()),
         ProcName(ProcName), Pid(sys::Process::getProcessId()),
-        Tid(llvm::get_threadid()), TimeTraceGranularity(TimeTraceGranularity) {
+        Tid(llvm::get_threadid()), TimeTraceGranularity(TimeTraceGranularity),
+        RecordCounts(RecordCounts) {
     llvm::get_thread_name(ThreadName);
   }
 
   void begin(std::string Name, llvm::function_ref<std::string()> Detail) {
+    TimeTraceMetadata Metadata;
+    Metadata.Detail = Detail();
     Stack.emplace_back(ClockType::now(), TimePointType(), std::move(Name),
-                       Detail());
+                       std::move(Metadata));
+  }
+
+  void begin(std::string Name,
+             llvm::function_ref<TimeTraceMetadata()> Metadata) {
+    Stack.emplace_back(ClockType::now(), TimePointType(), std::move(Name),
+                       Metadata());
+  }
+
+  void addCount(StringRef Name, uint64_t Count) {
+    if (!RecordCounts || Stack.empty())
+      return;
+    auto &Counts = Stack.back().Counts;
+    auto It =
+        llvm::find_if(Counts, [&](const auto &C) { return C.first == Name; });
+    if (It != Counts.end())
+      It->second += Count;
+    else
+      Counts.emplace_back(std::string(Name), Count);
   }
 
   void end() {
@@ -172,8 +198,18 @@ struct llvm::TimeTraceProfiler {
         J.attribute("ts", StartUs);
         J.attribute("dur", DurUs);
         J.attribute("name", E.Name);
-        if (!E.Detail.empty()) {
-          J.attributeObject("args", [&] { J.attribute("detail", E.Detail); });
+        if (!E.Metadata.isEmpty() || !E.Counts.empty()) {
+          J.attributeObject("args", [&] {
+            if (!E.Metadata.Detail.empty())
+              J.attribute("detail", E.Metadata.Detail);
+            if (!E.Metadata.File.empty()) {
+              J.attribute("file", E.Metadata.File);
+              if (E.Metadata.Line > 0)
+                J.attribute("line", E.Metadata.Line);
+            }
+            for (const auto &[Name, Count] : E.Counts)
+              J.attribute(Name, int64_t(Count));
+          });
         }
       });
     };
@@ -283,14 +319,18 @@ struct llvm::TimeTraceProfiler {
 
   // Minimum time granularity (in microseconds)
   const unsigned TimeTraceGranularity;
+
+  // Whether counts passed to timeTraceAddCount() are recorded.
+  const bool RecordCounts;
 };
 
 void llvm::timeTraceProfilerInitialize(unsigned TimeTraceGranularity,
-                                       StringRef ProcName) {
+                                       StringRef ProcName, bool RecordCounts) {
   assert(TimeTraceProfilerInstance == nullptr &&
          "Profiler should not be initialized");
-  TimeTraceProfilerInstance = new TimeTraceProfiler(
-      TimeTraceGranularity, llvm::sys::path::filename(ProcName));
+  TimeTraceProfilerInstance =
+      new TimeTraceProfiler(TimeTraceGranularity,
+                            llvm::sys::path::filename(ProcName), RecordCounts);
 }
 
 // Removes all TimeTraceProfilerInstances.
@@ -353,7 +393,18 @@ void llvm::timeTraceProfilerBegin(StringRef Name,
     TimeTraceProfilerInstance->begin(std::string(Name), Detail);
 }
 
+void llvm::timeTraceProfilerBegin(
+    StringRef Name, llvm::function_ref<TimeTraceMetadata()> Metadata) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->begin(std::string(Name), Metadata);
+}
+
 void llvm::timeTraceProfilerEnd() {
   if (TimeTraceProfilerInstance != nullptr)
     TimeTraceProfilerInstance->end();
 }
+
+void llvm::timeTraceAddCount(StringRef Name, uint64_t Count) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->addCount(Name, Count);
+}
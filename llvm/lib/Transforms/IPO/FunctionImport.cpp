@@ -39,13 +39,16 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO/Internalize.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/FunctionImportUtils.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
+#include <atomic>
 #include <cassert>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <system_error>
@@ -406,7 +409,7 @@ static void computeImportForFunction(
     DenseMap<StringRef, FunctionImporter::ExportSetTy> *ExportLists,
     FunctionImporter::ImportThresholdsTy &ImportThresholds) {
   GVImporter.onImportingSummary(Summary);
-  static int ImportCount = 0;
+  static std::atomic<int> ImportCount(0);
   for (const auto &Edge : Summary.calls()) {
     ValueInfo VI = Edge.first;
     LLVM_DEBUG(dbgs() << " edge -> " << VI << " Threshold:" << Threshold
@@ -716,22 +719,78 @@ void llvm::ComputeCrossModuleImport(
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
         isPrevailing,
     DenseMap<StringRef, FunctionImporter::ImportMapTy> &ImportLists,
-    DenseMap<StringRef, FunctionImporter::ExportSetTy> &ExportLists) {
-  // For each module that has function defined, compute the import/export lists.
+    DenseMap<StringRef, FunctionImporter::ExportSetTy> &ExportLists,
+    ThreadPoolStrategy Parallelism) {
+  // Create the import list of every module up front, so that the workers below
+  // only look up existing entries.
+  std::vector<StringRef> ModulePaths;
+  ModulePaths.reserve(ModuleToDefinedGVSummaries.size());
   for (const auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
-    auto &ImportList = ImportLists[DefinedGVSummaries.first];
-    LLVM_DEBUG(dbgs() << "Computing import for Module '"
-                      << DefinedGVSummaries.first << "'\n");
-    ComputeImportForModule(DefinedGVSummaries.second, isPrevailing, Index,
-                           DefinedGVSummaries.first, ImportList, &ExportLists);
+    ImportLists[DefinedGVSummaries.first];
+    ModulePaths.push_back(DefinedGVSummaries.first);
+  }
+
+  // The -import-cutoff limit counts imports across all modules, so it is only
+  // reproducible when the modules are processed one after the other. The same
+  // goes for the order of -print-import-failures output.
+  if (ImportCutoff >= 0 || PrintImportFailures)
+    Parallelism = hardware_concurrency(1);
+  unsigned NumWorkers = std::min<size_t>(Parallelism.compute_thread_count(),
+                                         ModulePaths.size());
+  std::optional<ThreadPool> Pool;
+  if (NumWorkers > 1) {
+    Parallelism.ThreadsRequested = NumWorkers;
+    Pool.emplace(Parallelism);
   }
 
+  // Call Fn(I, Worker) for every I in [0, N), spread over the workers.
+  auto ForEach = [&](size_t N, function_ref<void(size_t, unsigned)> Fn) {
+    if (!Pool) {
+      for (size_t I = 0; I != N; ++I)
+        Fn(I, 0);
+      return;
+    }
+    std::atomic<size_t> Next(0);
+    for (unsigned Worker = 0; Worker != NumWorkers; ++Worker)
+      Pool->async([&, Worker] {
+        for (size_t I = Next++; I < N; I = Next++)
+          Fn(I, Worker);
+      });
+    Pool->wait();
+  };
+
+  // For each module that has function defined, compute the import/export lists.
+  // The imports of a module only depend on the index, so the modules are
+  // processed concurrently. Each worker collects the exports it causes in its
+  // own map, which are merged once all modules are done.
+  std::vector<DenseMap<StringRef, FunctionImporter::ExportSetTy>> WorkerExports(
+      Pool ? NumWorkers : 0);
+  ForEach(ModulePaths.size(), [&](size_t I, unsigned Worker) {
+    StringRef ModulePath = ModulePaths[I];
+    LLVM_DEBUG(dbgs() << "Computing import for Module '" << ModulePath
+                      << "'\n");
+    ComputeImportForModule(ModuleToDefinedGVSummaries.find(ModulePath)->second,
+                           isPrevailing, Index, ModulePath,
+                           ImportLists.find(ModulePath)->second,
+                           Pool ? &WorkerExports[Worker] : &ExportLists);
+  });
+  for (auto &Exports : WorkerExports)
+    for (auto &ELI : Exports)
+      ExportLists[ELI.first].insert(ELI.second.begin(), ELI.second.end());
+
   // When computing imports we only added the variables and functions being
   // imported to the export list. We also need to mark any references and calls
   // they make as exported as well. We do this here, as it is more efficient
   // since we may import the same values multiple times into different modules
-  // during the import computation.
-  for (auto &ELI : ExportLists) {
+  // during the import computation. Every module's export list is extended
+  // independently of the others.
+  std::vector<DenseMap<StringRef, FunctionImporter::ExportSetTy>::value_type *>
+      ExportEntries;
+  ExportEntries.reserve(ExportLists.size());
+  for (auto &ELI : ExportLists)
+    ExportEntries.push_back(&ELI);
+  ForEach(ExportEntries.size(), [&](size_t I, unsigned) {
+    auto &ELI = *ExportEntries[I];
     FunctionImporter::ExportSetTy NewExports;
     const auto &DefinedGVSummaries =
         ModuleToDefinedGVSummaries.lookup(ELI.first);
@@ -775,7 +834,7 @@ void llvm::ComputeCrossModuleImport(
         ++EI;
     }
     ELI.second.insert(NewExports.begin(), NewExports.end());
-  }
+  });
 
   assert(checkVariableImport(Index, ImportLists, ExportLists));
 #ifndef NDEBUG
@@ -0,0 +1,63 @@
+;; Check that llvm-link -import reads the source module the way the ThinLTO
+;; backends do: its metadata is loaded on demand, and ODR-identified composite
+;; types come in as declarations. Regular links and -disable-lazy-loading
+;; still load the full type definitions.
+
+; RUN: rm -rf %t && split-file %s %t
+; RUN: opt -module-summary %t/main.ll -o %t/main.bc
+; RUN: opt -module-summary %t/foo.ll -o %t/foo.bc
+; RUN: llvm-lto -thinlto -o %t/index %t/main.bc %t/foo.bc
+
+; RUN: llvm-link %t/main.bc -summary-index=%t/index.thinlto.bc \
+; RUN:   -import=foo:%t/foo.bc -S | FileCheck %s --check-prefix=IMPORT
+; RUN: llvm-link %t/main.bc -summary-index=%t/index.thinlto.bc \
+; RUN:   -import=foo:%t/foo.bc -disable-lazy-loading -S \
+; RUN:   | FileCheck %s --check-prefix=FULL
+; RUN: llvm-link %t/main.bc %t/foo.bc -S | FileCheck %s --check-prefix=FULL
+
+; IMPORT:     define available_externally void @foo() !dbg
+; IMPORT:     !DICompositeType(tag: DW_TAG_structure_type, name: "S",
+; IMPORT-SAME:  flags: DIFlagFwdDecl, identifier: "_ZTS1S")
+; IMPORT-NOT: DW_TAG_member
+
+; FULL:      define {{.*}}void @foo() !dbg
+; FULL:      !DICompositeType(tag: DW_TAG_structure_type, name: "S",
+; FULL-SAME:   elements: ![[ELEMENTS:[0-9]+]], identifier: "_ZTS1S")
+; FULL:      ![[ELEMENTS]] = !{![[MEMBER:[0-9]+]]}
+; FULL:      ![[MEMBER]] = !DIDerivedType(tag: DW_TAG_member, name: "x"
+
+;--- main.ll
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @main() {
+  call void @foo()
+  ret i32 0
+}
+
+declare void @foo()
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 2, !"Debug Info Version", i32 3}
+
+;--- foo.ll
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() !dbg !5 {
+  ret void, !dbg !10
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, emissionKind: FullDebug)
+!1 = !DIFile(filename: "foo.cpp", directory: "/src")
+!2 = !{i32 2, !"Debug Info Version", i32 3}
+!3 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!4 = !DISubroutineType(types: !{null, !6})
+!5 = distinct !DISubprogram(name: "foo", linkageName: "_Z3foo1S", scope: !1, file: !1, line: 3, type: !4, scopeLine: 3, spFlags: DISPFlagDefinition, unit: !0)
+!6 = distinct !DICompositeType(tag: DW_TAG_structure_type, name: "S", file: !1, line: 1, size: 32, elements: !7, identifier: "_ZTS1S")
+!7 = !{!8}
+!8 = !DIDerivedType(tag: DW_TAG_member, name: "x", scope: !6, file: !1, line: 1, baseType: !3, size: 32)
+!10 = !DILocation(line: 3, column: 1, scope: !5)
@@ -0,0 +1,40 @@
+;; Check that a ThinLink can write the combined index in the compact format,
+;; and that the backend stages import from it like from the bitcode index.
+
+; RUN: rm -rf %t && split-file %s %t
+; RUN: opt -module-summary %t/main.ll -o %t/main.bc
+; RUN: opt -module-summary %t/foo.ll -o %t/foo.bc
+; RUN: llvm-lto -thinlto-action=thinlink -thinlto-compact-index \
+; RUN:   -o %t/index.compact %t/main.bc %t/foo.bc
+; RUN: llvm-lto -thinlto-action=thinlink -o %t/index.bc %t/main.bc %t/foo.bc
+; RUN: head -c 4 %t/index.compact | FileCheck %s --check-prefix=MAGIC
+
+; RUN: llvm-lto -thinlto-action=import -thinlto-index=%t/index.compact \
+; RUN:   %t/main.bc -o %t/main.compact.bc
+; RUN: llvm-lto -thinlto-action=import -thinlto-index=%t/index.bc \
+; RUN:   %t/main.bc -o %t/main.imported.bc
+; RUN: llvm-dis %t/main.compact.bc -o - | FileCheck %s
+; RUN: llvm-dis %t/main.imported.bc -o - | FileCheck %s
+
+; MAGIC: LCSI
+
+; CHECK: define available_externally i32 @foo()
+
+;--- main.ll
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare i32 @foo()
+
+define i32 @main() {
+  %r = call i32 @foo()
+  ret i32 %r
+}
+
+;--- foo.ll
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @foo() {
+  ret i32 42
+}
@@ -10,6 +10,7 @@
 // package files).
 //
 //===----------------------------------------------------------------------===//
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/DWP/DWP.h"
 #include "llvm/DWP/DWPError.h"
 #include "llvm/DWP/DWPStringPool.h"
@@ -30,6 +31,7 @@
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/LLVMDriver.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include <optional>
@@ -144,6 +146,15 @@ int llvm_dwp_main(int argc, char **argv, const llvm::ToolContext &) {
   OutputFilename = Args.getLastArgValue(OPT_outputFileName, "");
   ContinueOnCuIndexOverflow = Args.hasArg(OPT_continueOnCuIndexOverflow);
 
+  if (const llvm::opt::Arg *A = Args.getLastArg(OPT_threads)) {
+    unsigned Threads = 0;
+    if (!llvm::to_integer(A->getValue(), Threads, 0) || Threads == 0)
+      return error(Twine("expected a positive integer, but got '") +
+                       A->getValue() + "'",
+                   A->getSpelling());
+    parallel::strategy = hardware_concurrency(Threads);
+  }
+
   for (const llvm::opt::Arg *A : Args.filtered(OPT_execFileNames))
     ExecFilenames.emplace_back(A->getValue());
 
@@ -22,10 +22,12 @@
 #include "llvm/Support/LLVMDriver.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TargetParser/Triple.h"
 #include <algorithm>
@@ -91,6 +93,7 @@ static std::string OutputFilename;
 static bool Verify;
 static unsigned NumThreads;
 static uint64_t SegmentSize;
+static uint64_t SpillThreshold;
 static bool Quiet;
 static std::vector<uint64_t> LookupAddresses;
 static bool LookupAddressesFromStdin;
@@ -159,6 +162,15 @@ static void parseArgs(int argc, char **argv) {
     }
   }
 
+  if (const llvm::opt::Arg *A = Args.getLastArg(OPT_spill_threshold_EQ)) {
+    StringRef S{A->getValue()};
+    if (!llvm::to_integer(S, SpillThreshold, 0)) {
+      llvm::errs() << ToolName << ": for the --spill-threshold option: '" << S
+                   << "' value invalid for uint argument!\n";
+      std::exit(1);
+    }
+  }
+
   Quiet = Args.hasArg(OPT_quiet);
 
   for (const llvm::opt::Arg *A : Args.filtered(OPT_address_EQ)) {
@@ -313,7 +325,13 @@ static llvm::Error handleObjectFile(ObjectFile &Obj,
   // when they aren't desired.
   raw_ostream *LogOS = Quiet ? nullptr : &outs();
 
+  // Sorting function infos in GsymCreator uses the parallel algorithms, so
+  // limit them to the same number of threads.
+  parallel::strategy = hardware_concurrency(ThreadCount);
+
   GsymCreator Gsym(Quiet);
+  if (SpillThreshold > 0)
+    Gsym.setSpillThreshold(SpillThreshold);
 
   // See if we can figure out the base address for a given object file, and if
   // we can, then set the base address to use to this value. This will ease
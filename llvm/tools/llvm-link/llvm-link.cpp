@@ -134,19 +134,36 @@ static ExitOnError ExitOnErr;
 // Read the specified bitcode file in and return it. This routine searches the
 // link path for the specified file to try to find it...
 //
+// If IsImporting is set, the module is a source of function imports. Like in
+// the ThinLTO backends, its module level metadata is then only indexed, and
+// loaded on demand for the imported functions.
 static std::unique_ptr<Module> loadFile(const char *argv0,
                                         std::unique_ptr<MemoryBuffer> Buffer,
                                         LLVMContext &Context,
-                                        bool MaterializeMetadata = true) {
+                                        bool MaterializeMetadata = true,
+                                        bool IsImporting = false) {
   SMDiagnostic Err;
   if (Verbose)
     errs() << "Loading '" << Buffer->getBufferIdentifier() << "'\n";
   std::unique_ptr<Module> Result;
-  if (DisableLazyLoad)
+  if (DisableLazyLoad) {
     Result = parseIR(*Buffer, Err, Context);
-  else
+  } else if (IsImporting &&
+             isBitcode((const unsigned char *)Buffer->getBufferStart(),
+                       (const unsigned char *)Buffer->getBufferEnd())) {
+    std::string Identifier = Buffer->getBufferIdentifier().str();
+    Expected<std::unique_ptr<Module>> MOrErr = getOwningLazyBitcodeModule(
+        std::move(Buffer), Context, /*ShouldLazyLoadMetadata=*/true,
+        /*IsImporting=*/true);
+    if (MOrErr)
+      Result = std::move(*MOrErr);
+    else
+      Err = SMDiagnostic(Identifier, SourceMgr::DK_Error,
+                         toString(MOrErr.takeError()));
+  } else {
     Result =
         getLazyIRModule(std::move(Buffer), Err, Context, !MaterializeMetadata);
+  }
 
   if (!Result) {
     Err.print(argv0, errs());
@@ -319,7 +336,11 @@ static bool importFunctions(const char *argv0, Module &DestModule) {
                                     const std::string &Identifier) {
     std::unique_ptr<MemoryBuffer> Buffer =
         ExitOnErr(errorOrToExpected(MemoryBuffer::getFileOrSTDIN(Identifier)));
-    return loadFile(argv0, std::move(Buffer), DestModule.getContext(), false);
+    // Composite types are imported as declarations, which relies on the
+    // definitions being uniqued by their ODR identifier.
+    LLVMContext &Context = DestModule.getContext();
+    return loadFile(argv0, std::move(Buffer), Context, false,
+                    Context.isODRUniquingDebugTypes());
   };
 
   ModuleLazyLoaderCache ModuleLoaderCache(ModuleLoader);
@@ -22,6 +22,7 @@
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/IR/CompactModuleSummaryIndex.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
@@ -140,6 +141,12 @@ static cl::opt<std::string>
                           "to perform the promotion and/or importing."),
                  cl::cat(LTOCategory));
 
+static cl::opt<bool> ThinLTOCompactIndex(
+    "thinlto-compact-index", cl::init(false),
+    cl::desc("Write the index produced by a ThinLink in the compact format, "
+             "which only holds the global value summaries."),
+    cl::cat(LTOCategory));
+
 static cl::opt<std::string> ThinLTOPrefixReplace(
     "thinlto-prefix-replace",
     cl::desc("Control where files for distributed backends are "
@@ -552,7 +559,12 @@ std::unique_ptr<ModuleSummaryIndex> loadCombinedIndex() {
     report_fatal_error("Missing -thinlto-index for ThinLTO promotion stage");
   ExitOnError ExitOnErr("llvm-lto: error loading file '" + ThinLTOIndex +
                         "': ");
-  return ExitOnErr(getModuleSummaryIndexForFile(ThinLTOIndex));
+  std::unique_ptr<MemoryBuffer> Buffer = ExitOnErr(
+      errorOrToExpected(MemoryBuffer::getFileOrSTDIN(ThinLTOIndex)));
+  if (CompactModuleSummaryIndex::isCompactModuleSummaryIndex(*Buffer))
+    return ExitOnErr(CompactModuleSummaryIndex::create(*Buffer))
+        .materializeAll();
+  return ExitOnErr(getModuleSummaryIndex(*Buffer));
 }
 
 static std::unique_ptr<lto::InputFile> loadInputFile(MemoryBufferRef Buffer) {
@@ -658,7 +670,10 @@ private:
     std::error_code EC;
     raw_fd_ostream OS(OutputFilename, EC, sys::fs::OpenFlags::OF_None);
     error(EC, "error opening the file '" + OutputFilename + "'");
-    writeIndexToFile(*CombinedIndex, OS);
+    if (ThinLTOCompactIndex)
+      writeCompactModuleSummaryIndex(*CombinedIndex, OS);
+    else
+      writeIndexToFile(*CombinedIndex, OS);
   }
 
   /// Load the combined index from disk, then compute and generate
@@ -45,6 +45,7 @@
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/LLVMDriver.h"
 #include "llvm/Support/Memory.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
@@ -249,11 +250,25 @@ int llvm_objcopy_main(int argc, char **argv, const llvm::ToolContext &) {
                           WithColor::error(errs(), ToolName));
     return 1;
   }
-  for (ConfigManager &ConfigMgr : DriverConfig->CopyConfigs) {
-    if (Error E = executeObjcopy(ConfigMgr)) {
+  if (DriverConfig->CopyConfigs.size() == 1) {
+    if (Error E = executeObjcopy(DriverConfig->CopyConfigs.front())) {
       logAllUnhandledErrors(std::move(E), WithColor::error(errs(), ToolName));
       return 1;
     }
+    return 0;
+  }
+
+  // llvm-strip may be given many input files, each of which is processed
+  // independently of the others, so handle them concurrently. Unlike the
+  // serial loop, a failing input does not stop the others from being
+  // processed; every failure is reported, in command line order.
+  if (Error E = parallelForEachError(
+          DriverConfig->CopyConfigs,
+          [](ConfigManager &ConfigMgr) { return executeObjcopy(ConfigMgr); })) {
+    handleAllErrors(std::move(E), [&](const ErrorInfoBase &EI) {
+      WithColor::error(errs(), ToolName) << EI.message() << '\n';
+    });
+    return 1;
   }
 
   return 0;
@@ -15,7 +15,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "Opts.inc"
+#include "llvm/ADT/FunctionExtras.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "llvm/DebugInfo/Symbolize/DIPrinter.h"
@@ -30,12 +32,15 @@
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/COM.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -211,26 +216,40 @@ static bool parseCommand(StringRef BinaryName, bool IsAddr2Line,
   return !Offset.getAsInteger(IsAddr2Line ? 16 : 0, ModuleOffset);
 }
 
+// Symbolization results are printed through a deferred action so that batch
+// mode can compute them on worker threads and print them in input order.
+using PrintAction = unique_function<void(DIPrinter &)>;
+
 template <typename T>
-void executeCommand(StringRef ModuleName, const T &ModuleSpec, Command Cmd,
-                    uint64_t Offset, uint64_t AdjustVMA, bool ShouldInline,
-                    OutputStyle Style, LLVMSymbolizer &Symbolizer,
-                    DIPrinter &Printer) {
+static PrintAction deferPrint(StringRef ModuleName, uint64_t Offset,
+                              Expected<T> ResOrErr) {
+  return [ModuleName = ModuleName.str(), Offset,
+          ResOrErr = std::move(ResOrErr)](DIPrinter &Printer) mutable {
+    Request SymRequest = {ModuleName, Offset};
+    print(SymRequest, ResOrErr, Printer);
+  };
+}
+
+template <typename T>
+PrintAction executeCommand(StringRef ModuleName, const T &ModuleSpec,
+                           Command Cmd, uint64_t Offset, uint64_t AdjustVMA,
+                           bool ShouldInline, OutputStyle Style,
+                           LLVMSymbolizer &Symbolizer) {
   uint64_t AdjustedOffset = Offset - AdjustVMA;
   object::SectionedAddress Address = {AdjustedOffset,
                                       object::SectionedAddress::UndefSection};
-  Request SymRequest = {ModuleName, Offset};
+  PrintAction Action;
   if (Cmd == Command::Data) {
     Expected<DIGlobal> ResOrErr = Symbolizer.symbolizeData(ModuleSpec, Address);
-    print(SymRequest, ResOrErr, Printer);
+    Action = deferPrint(ModuleName, Offset, std::move(ResOrErr));
   } else if (Cmd == Command::Frame) {
     Expected<std::vector<DILocal>> ResOrErr =
         Symbolizer.symbolizeFrame(ModuleSpec, Address);
-    print(SymRequest, ResOrErr, Printer);
+    Action = deferPrint(ModuleName, Offset, std::move(ResOrErr));
   } else if (ShouldInline) {
     Expected<DIInliningInfo> ResOrErr =
         Symbolizer.symbolizeInlinedCode(ModuleSpec, Address);
-    print(SymRequest, ResOrErr, Printer);
+    Action = deferPrint(ModuleName, Offset, std::move(ResOrErr));
   } else if (Style == OutputStyle::GNU) {
     // With PrintFunctions == FunctionNameKind::LinkageName (default)
     // and UseSymbolTable == true (also default), Symbolizer.symbolizeCode()
@@ -245,13 +264,65 @@ void executeCommand(StringRef ModuleName, const T &ModuleSpec, Command Cmd,
             ? Expected<DILineInfo>(ResOrErr.takeError())
             : ((ResOrErr->getNumberOfFrames() == 0) ? DILineInfo()
                                                     : ResOrErr->getFrame(0));
-    print(SymRequest, Res0OrErr, Printer);
+    Action = deferPrint(ModuleName, Offset, std::move(Res0OrErr));
   } else {
     Expected<DILineInfo> ResOrErr =
         Symbolizer.symbolizeCode(ModuleSpec, Address);
-    print(SymRequest, ResOrErr, Printer);
+    Action = deferPrint(ModuleName, Offset, std::move(ResOrErr));
   }
   Symbolizer.pruneCache();
+  return Action;
+}
+
+// A single line of input, parsed.
+struct ParsedInput {
+  std::string InputString;
+  bool IsValid = false;
+  Command Cmd = Command::Code;
+  std::string ModuleName;
+  object::BuildID BuildID;
+  uint64_t Offset = 0;
+
+  // The name of the module the input refers to, either as a path or as a hex
+  // build ID.
+  std::string getModuleKey() const {
+    return BuildID.empty() ? ModuleName : toHex(BuildID);
+  }
+};
+
+static ParsedInput parseInput(const opt::InputArgList &Args,
+                              object::BuildIDRef IncomingBuildID,
+                              bool IsAddr2Line, StringRef InputString) {
+  ParsedInput Input;
+  Input.InputString = InputString.str();
+  Input.BuildID.assign(IncomingBuildID.begin(), IncomingBuildID.end());
+  Input.IsValid = parseCommand(Args.getLastArgValue(OPT_obj_EQ), IsAddr2Line,
+                               InputString, Input.Cmd, Input.ModuleName,
+                               Input.BuildID, Input.Offset);
+  return Input;
+}
+
+// This runs on the worker threads of symbolizeBatch, so it must not look up
+// arguments: that claims them, which writes to the shared argument list.
+static PrintAction symbolizeParsedInput(const ParsedInput &Input,
+                                        uint64_t AdjustVMA, bool ShouldInline,
+                                        OutputStyle Style,
+                                        LLVMSymbolizer &Symbolizer) {
+  if (!Input.IsValid) {
+    return [ModuleName = Input.ModuleName,
+            InputString = Input.InputString](DIPrinter &Printer) {
+      Printer.printInvalidCommand({ModuleName, std::nullopt}, InputString);
+    };
+  }
+  if (!Input.BuildID.empty()) {
+    assert(Input.ModuleName.empty());
+    std::string BuildIDStr = toHex(Input.BuildID);
+    return executeCommand(BuildIDStr, Input.BuildID, Input.Cmd, Input.Offset,
+                          AdjustVMA, ShouldInline, Style, Symbolizer);
+  }
+  return executeCommand(Input.ModuleName, Input.ModuleName, Input.Cmd,
+                        Input.Offset, AdjustVMA, ShouldInline, Style,
+                        Symbolizer);
 }
 
 static void symbolizeInput(const opt::InputArgList &Args,
@@ -259,27 +330,92 @@ static void symbolizeInput(const opt::InputArgList &Args,
                            uint64_t AdjustVMA, bool IsAddr2Line,
                            OutputStyle Style, StringRef InputString,
                            LLVMSymbolizer &Symbolizer, DIPrinter &Printer) {
-  Command Cmd;
-  std::string ModuleName;
-  object::BuildID BuildID(IncomingBuildID.begin(), IncomingBuildID.end());
-  uint64_t Offset = 0;
-  if (!parseCommand(Args.getLastArgValue(OPT_obj_EQ), IsAddr2Line,
-                    StringRef(InputString), Cmd, ModuleName, BuildID, Offset)) {
-    Printer.printInvalidCommand({ModuleName, std::nullopt}, InputString);
-    return;
+  ParsedInput Input =
+      parseInput(Args, IncomingBuildID, IsAddr2Line, InputString);
+  if (Input.IsValid && !Input.BuildID.empty() &&
+      !Args.hasArg(OPT_no_debuginfod))
+    enableDebuginfod(Symbolizer, Args);
+  bool ShouldInline = Args.hasFlag(OPT_inlines, OPT_no_inlines, !IsAddr2Line);
+  symbolizeParsedInput(Input, AdjustVMA, ShouldInline, Style,
+                       Symbolizer)(Printer);
+}
+
+// Symbolizes all of Inputs using up to Threads worker threads and prints the
+// results in input order.
+//
+// LLVMSymbolizer and the DWARF contexts it caches are not thread-safe, so
+// rather than sharing one symbolizer, the modules are distributed over a set
+// of shards, each owning its own LLVMSymbolizer. All requests for the same
+// module go to the same shard, so every module is still loaded and parsed only
+// once, while different modules are loaded and queried concurrently. As a
+// consequence, the requests for a single module (e.g. with --obj) are all
+// handled by one thread.
+//
+// The first shard, which handles the first module, reuses \p MainSymbolizer,
+// which may already have loaded the --obj module.
+static void symbolizeBatch(const opt::InputArgList &Args,
+                           object::BuildIDRef IncomingBuildID,
+                           uint64_t AdjustVMA, bool IsAddr2Line,
+                           OutputStyle Style, ArrayRef<std::string> Inputs,
+                           const LLVMSymbolizer::Options &Opts,
+                           LLVMSymbolizer &MainSymbolizer, bool UseDebuginfod,
+                           unsigned Threads, DIPrinter &Printer) {
+  std::vector<ParsedInput> Parsed;
+  Parsed.reserve(Inputs.size());
+  for (StringRef InputString : Inputs)
+    Parsed.push_back(
+        parseInput(Args, IncomingBuildID, IsAddr2Line, InputString));
+
+  // Assign modules to shards round-robin in order of first appearance.
+  StringMap<unsigned> ShardForModule;
+  std::vector<std::vector<size_t>> ShardInputs(Threads);
+  bool NeedsDebuginfod = UseDebuginfod;
+  for (size_t I = 0, E = Parsed.size(); I != E; ++I) {
+    const ParsedInput &Input = Parsed[I];
+    if (Input.IsValid && !Input.BuildID.empty() &&
+        !Args.hasArg(OPT_no_debuginfod))
+      NeedsDebuginfod = true;
+    unsigned Shard =
+        ShardForModule
+            .try_emplace(Input.getModuleKey(), ShardForModule.size() % Threads)
+            .first->second;
+    ShardInputs[Shard].push_back(I);
   }
+
+  if (NeedsDebuginfod)
+    HTTPClient::initialize();
+
   bool ShouldInline = Args.hasFlag(OPT_inlines, OPT_no_inlines, !IsAddr2Line);
-  if (!BuildID.empty()) {
-    assert(ModuleName.empty());
-    if (!Args.hasArg(OPT_no_debuginfod))
-      enableDebuginfod(Symbolizer, Args);
-    std::string BuildIDStr = toHex(BuildID);
-    executeCommand(BuildIDStr, BuildID, Cmd, Offset, AdjustVMA, ShouldInline,
-                   Style, Symbolizer, Printer);
-  } else {
-    executeCommand(ModuleName, ModuleName, Cmd, Offset, AdjustVMA, ShouldInline,
-                   Style, Symbolizer, Printer);
+
+  // The caller has already split the binary cache budget in Opts between the
+  // shards.
+  std::vector<PrintAction> Actions(Parsed.size());
+  std::vector<std::unique_ptr<LLVMSymbolizer>> ShardSymbolizers(Threads);
+  {
+    ThreadPool Pool(hardware_concurrency(Threads));
+    for (unsigned Shard = 0; Shard != Threads; ++Shard) {
+      ArrayRef<size_t> Indices = ShardInputs[Shard];
+      if (Indices.empty())
+        continue;
+      LLVMSymbolizer *Symbolizer = &MainSymbolizer;
+      if (Shard != 0) {
+        ShardSymbolizers[Shard] = std::make_unique<LLVMSymbolizer>(Opts);
+        Symbolizer = ShardSymbolizers[Shard].get();
+      }
+      if (NeedsDebuginfod)
+        Symbolizer->setBuildIDFetcher(std::make_unique<DebuginfodFetcher>(
+            Args.getAllArgValues(OPT_debug_file_directory_EQ)));
+      Pool.async([&, Indices, Symbolizer] {
+        for (size_t I : Indices)
+          Actions[I] = symbolizeParsedInput(Parsed[I], AdjustVMA,
+                                            ShouldInline, Style, *Symbolizer);
+      });
+    }
+    Pool.wait();
   }
+
+  for (PrintAction &Action : Actions)
+    Action(Printer);
 }
 
 static void printHelp(StringRef ToolName, const SymbolizerOptTable &Tbl,
@@ -413,6 +549,17 @@ int main(int argc, char **argv) {
   Opts.DWPName = Args.getLastArgValue(OPT_dwp_EQ).str();
   Opts.FallbackDebugPath =
       Args.getLastArgValue(OPT_fallback_debug_path_EQ).str();
+  Opts.GsymCacheDir = Args.getLastArgValue(OPT_gsym_cache_dir_EQ).str();
+  Opts.GsymCachePruningPolicy =
+      Args.getLastArgValue(OPT_gsym_cache_policy_EQ).str();
+  if (Expected<CachePruningPolicy> Policy =
+          parseCachePruningPolicy(Opts.GsymCachePruningPolicy);
+      !Policy) {
+    WithColor::error(errs(), ToolName)
+        << "invalid --gsym-cache-policy: " << toString(Policy.takeError())
+        << '\n';
+    return 1;
+  }
   Opts.PrintFunctions = decideHowToPrintFunctions(Args, IsAddr2Line);
   parseIntArg(Args, OPT_print_source_context_lines_EQ,
               Config.SourceContextLines);
@@ -444,6 +591,18 @@ int main(int argc, char **argv) {
     }
   }
 
+  unsigned Threads = 1;
+  if (Args.hasArg(OPT_threads_EQ)) {
+    parseIntArg(Args, OPT_threads_EQ, Threads);
+    if (Threads == 0)
+      Threads = hardware_concurrency().compute_thread_count();
+  }
+  // In batch mode every shard has its own symbolizer; split the binary cache
+  // budget between them.
+  if (Threads > 1)
+    Opts.MaxCacheSize = std::max<size_t>(Opts.MaxCacheSize / Threads, 1);
+  Opts.GsymCacheThreads = Threads;
+
   LLVMSymbolizer Symbolizer(Opts);
 
   if (Args.hasFlag(OPT_debuginfod, OPT_no_debuginfod, canUseDebuginfod()))
@@ -493,6 +652,30 @@ int main(int argc, char **argv) {
   }
 
   std::vector<std::string> InputAddresses = Args.getAllArgValues(OPT_INPUT);
+  if (Threads > 1) {
+    // In batch mode all of the input has to be known up front, so read
+    // standard input to the end before symbolizing anything.
+    bool FromStdin = InputAddresses.empty();
+    if (FromStdin) {
+      std::string InputString;
+      while (std::getline(std::cin, InputString)) {
+        llvm::erase_if(InputString,
+                       [](char c) { return c == '\r' || c == '\n'; });
+        InputAddresses.push_back(std::move(InputString));
+      }
+    } else {
+      Printer->listBegin();
+    }
+    symbolizeBatch(Args, BuildID, AdjustVMA, IsAddr2Line, Style,
+                   InputAddresses, Opts, Symbolizer,
+                   Args.hasFlag(OPT_debuginfod, OPT_no_debuginfod,
+                                canUseDebuginfod()),
+                   Threads, *Printer);
+    if (!FromStdin)
+      Printer->listEnd();
+    return 0;
+  }
+
   if (InputAddresses.empty()) {
     const int kMaxInputStringLength = 1024;
     char InputString[kMaxInputStringLength];
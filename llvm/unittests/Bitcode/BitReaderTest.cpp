@@ -18,6 +18,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -258,6 +259,71 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+// Tests that decoding the function bodies ahead on several threads reads the
+// same module as decoding them one after the other.
+TEST(BitReaderTest, MaterializeFunctionsInParallel) {
+  const unsigned NumFunctions = 32;
+  std::string Assembly = "@table = constant ptr blockaddress(@f0, %bb)\n"
+                         "@slot = global ptr null\n";
+  for (unsigned I = 0; I != NumFunctions; ++I) {
+    std::string N = std::to_string(I);
+    std::string Callee = std::to_string((I + 1) % NumFunctions);
+    Assembly += "define i32 @f" + N + "(i32 %x) {\n" +
+                "entry:\n" +
+                "  %sum = add i32 %x, " + N + "\n" +
+                "  %cmp = icmp eq i32 %sum, 0, !md !{!\"f" + N + "\"}\n" +
+                "  br i1 %cmp, label %bb, label %exit\n" +
+                "bb:\n" +
+                "  %r = call i32 @f" + Callee + "(i32 %sum)\n" +
+                "  br label %exit\n" +
+                "exit:\n" +
+                "  %p = phi i32 [ %sum, %entry ], [ %r, %bb ]\n" +
+                "  store ptr blockaddress(@f1, %bb), ptr @slot\n" +
+                "  ret i32 %p\n" +
+                "}\n";
+  }
+  SmallString<1024> Mem;
+  {
+    LLVMContext Context;
+    writeModuleToBuffer(parseAssembly(Context, Assembly.c_str()), Mem);
+  }
+
+  auto *Threads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions(cl::SubCommand::getTopLevel())
+          .lookup("bitcode-materialize-threads"));
+  ASSERT_NE(Threads, nullptr);
+  auto Read = [&](unsigned NumThreads) {
+    Threads->setValue(NumThreads);
+    LLVMContext Context;
+    std::unique_ptr<Module> M =
+        cantFail(parseBitcodeFile(MemoryBufferRef(Mem.str(), "test"), Context));
+    EXPECT_FALSE(verifyModule(*M, &dbgs()));
+    std::string Printed;
+    raw_string_ostream OS(Printed);
+    M->print(OS, nullptr);
+    return Printed;
+  };
+  std::string Serial = Read(1);
+  std::string Parallel = Read(4);
+  Threads->setValue(1);
+  EXPECT_EQ(Serial, Parallel);
+
+  // Materialize a subset of the functions.
+  Threads->setValue(4);
+  LLVMContext Context;
+  std::unique_ptr<Module> M = cantFail(
+      getLazyBitcodeModule(MemoryBufferRef(Mem.str(), "test"), Context));
+  EXPECT_FALSE(M->materializeFunctions(
+      {M->getFunction("f20"), M->getFunction("f30"), M->getFunction("f31")}));
+  Threads->setValue(1);
+  EXPECT_FALSE(M->getFunction("f20")->empty());
+  EXPECT_FALSE(M->getFunction("f31")->empty());
+  // Pulled in through blockaddress.
+  EXPECT_FALSE(M->getFunction("f1")->empty());
+  EXPECT_TRUE(M->getFunction("f21")->empty());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+}
+
 // Helper function to convert type metadata to a string for testing
 static std::string mdToString(Metadata *MD) {
   std::string S;
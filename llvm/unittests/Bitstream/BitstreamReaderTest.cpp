@@ -151,6 +151,88 @@ TEST(BitstreamReaderTest, readRecordWithBlobWhileStreaming) {
   }
 }
 
+TEST(BitstreamReaderTest, readBlockAheadAndReplay) {
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  const unsigned NestedID = BlockID + 1;
+
+  SmallVector<char, 1> Buffer;
+  {
+    BitstreamWriter Stream(Buffer);
+    Stream.EnterSubblock(BlockID, 3);
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(2));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned AbbrevID = Stream.EmitAbbrev(std::move(Abbrev));
+    unsigned Record[] = {2};
+    Stream.EmitRecordWithBlob(AbbrevID, ArrayRef(Record), StringRef("blob"));
+    Stream.EnterSubblock(NestedID, 3);
+    Stream.EmitRecord(3, ArrayRef<unsigned>({4, 5, 6}));
+    Stream.ExitBlock();
+    Stream.EnterSubblock(NestedID, 3);
+    Stream.EmitRecord(7, ArrayRef<unsigned>({8}));
+    Stream.ExitBlock();
+    Stream.EmitRecord(1, ArrayRef<unsigned>({42}));
+    Stream.ExitBlock();
+  }
+  ArrayRef<uint8_t> Bytes((const uint8_t *)Buffer.begin(), Buffer.size());
+
+  BitstreamCursor Stream(Bytes);
+  Expected<BitstreamEntry> MaybeEntry = Stream.advance();
+  ASSERT_TRUE((bool)MaybeEntry);
+  ASSERT_EQ(BitstreamEntry::SubBlock, MaybeEntry->Kind);
+  ASSERT_EQ(BlockID, MaybeEntry->ID);
+  BitstreamDecodedBlock Decoded;
+  ASSERT_FALSE(Stream.readBlockAhead(BlockID, Decoded));
+  EXPECT_TRUE(Stream.AtEndOfStream());
+
+  auto ExpectRecord = [](BitstreamCursor &Cursor, unsigned Code,
+                         ArrayRef<uint64_t> Ops, StringRef *Blob = nullptr) {
+    Expected<BitstreamEntry> MaybeEntry = Cursor.advance();
+    ASSERT_TRUE((bool)MaybeEntry);
+    ASSERT_EQ(BitstreamEntry::Record, MaybeEntry->Kind);
+    SmallVector<uint64_t, 4> Record;
+    Expected<unsigned> MaybeCode =
+        Cursor.readRecord(MaybeEntry->ID, Record, Blob);
+    ASSERT_TRUE((bool)MaybeCode);
+    EXPECT_EQ(Code, MaybeCode.get());
+    EXPECT_EQ(Ops, ArrayRef(Record));
+  };
+  auto ExpectEntry = [](BitstreamCursor &Cursor, unsigned Kind) {
+    Expected<BitstreamEntry> MaybeEntry = Cursor.advance();
+    ASSERT_TRUE((bool)MaybeEntry);
+    EXPECT_EQ(Kind, MaybeEntry->Kind);
+  };
+
+  // The replayed block reads like the stream, with blobs unpacked into the
+  // record when no blob is asked for.
+  BitstreamCursor Cursor(Bytes);
+  Cursor.startReplay(Decoded);
+  unsigned NumWords = 0;
+  ASSERT_FALSE(Cursor.EnterSubBlock(BlockID, &NumWords));
+  EXPECT_NE(0u, NumWords);
+  ExpectRecord(Cursor, 2, {'b', 'l', 'o', 'b'});
+  ExpectEntry(Cursor, BitstreamEntry::SubBlock);
+  ASSERT_FALSE(Cursor.SkipBlock());
+  ExpectEntry(Cursor, BitstreamEntry::SubBlock);
+  ASSERT_FALSE(Cursor.EnterSubBlock(NestedID));
+  ExpectRecord(Cursor, 7, {8});
+  ExpectEntry(Cursor, BitstreamEntry::EndBlock);
+  ExpectRecord(Cursor, 1, {42});
+  ExpectEntry(Cursor, BitstreamEntry::EndBlock);
+  ExpectEntry(Cursor, BitstreamEntry::Error);
+  Cursor.endReplay();
+
+  Cursor.startReplay(Decoded);
+  ASSERT_FALSE(Cursor.EnterSubBlock(BlockID));
+  StringRef Blob;
+  ExpectRecord(Cursor, 2, {}, &Blob);
+  EXPECT_EQ("blob", Blob);
+  ExpectEntry(Cursor, BitstreamEntry::SubBlock);
+  ASSERT_FALSE(Cursor.EnterSubBlock(NestedID));
+  ExpectRecord(Cursor, 3, {4, 5, 6});
+  Cursor.endReplay();
+}
+
 TEST(BitstreamReaderTest, shortRead) {
   uint8_t Bytes[] = {8, 7, 6, 5, 4, 3, 2, 1};
   for (unsigned I = 1; I != 8; ++I) {
@@ -14,6 +14,7 @@
 #include "llvm/DebugInfo/GSYM/FileEntry.h"
 #include "llvm/DebugInfo/GSYM/FileWriter.h"
 #include "llvm/DebugInfo/GSYM/FunctionInfo.h"
+#include "llvm/DebugInfo/GSYM/GsymContext.h"
 #include "llvm/DebugInfo/GSYM/GsymCreator.h"
 #include "llvm/DebugInfo/GSYM/GsymReader.h"
 #include "llvm/DebugInfo/GSYM/Header.h"
@@ -3545,3 +3546,121 @@ TEST(GSYMTest, TestFinalizeForLineTables) {
   StringRef FuncName2 = GR->getString(ExpFI2->Name);
   EXPECT_EQ(FuncName2, "bar");
 }
+
+TEST(GSYMTest, TestGsymContext) {
+  // Test that GsymContext answers DIContext queries from a GSYM file,
+  // including inlined frames.
+  GsymCreator GC;
+  FunctionInfo FI(0x1000, 0x100, GC.insertString("main"));
+  const auto ByteOrder = support::endian::system_endianness();
+  FI.OptLineTable = LineTable();
+  const uint32_t MainFileIndex = GC.insertFile("/tmp/main.c");
+  const uint32_t FooFileIndex = GC.insertFile("/tmp/foo.h");
+  FI.OptLineTable->push(LineEntry(0x1000, MainFileIndex, 5));
+  FI.OptLineTable->push(LineEntry(0x1010, FooFileIndex, 10));
+  FI.OptLineTable->push(LineEntry(0x1020, MainFileIndex, 8));
+  FI.Inline = InlineInfo();
+  FI.Inline->Name = GC.insertString("inline1");
+  FI.Inline->CallFile = MainFileIndex;
+  FI.Inline->CallLine = 6;
+  FI.Inline->Ranges.insert(AddressRange(0x1010, 0x1020));
+  GC.addFunctionInfo(std::move(FI));
+  ASSERT_THAT_ERROR(GC.finalize(llvm::nulls()), Succeeded());
+  SmallString<512> Str;
+  raw_svector_ostream OutStrm(Str);
+  FileWriter FW(OutStrm, ByteOrder);
+  ASSERT_THAT_ERROR(GC.encode(FW), Succeeded());
+  Expected<GsymReader> GR = GsymReader::copyBuffer(OutStrm.str());
+  ASSERT_THAT_EXPECTED(GR, Succeeded());
+
+  GsymContext Ctx(std::make_unique<GsymReader>(std::move(*GR)));
+  DILineInfoSpecifier Spec(
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      DILineInfoSpecifier::FunctionNameKind::LinkageName);
+
+  DILineInfo LI = Ctx.getLineInfoForAddress({0x1004}, Spec);
+  EXPECT_EQ(LI.FunctionName, "main");
+  EXPECT_EQ(LI.FileName, "/tmp/main.c");
+  EXPECT_EQ(LI.Line, 5u);
+  EXPECT_EQ(LI.StartAddress, 0x1000u);
+
+  // The innermost frame is reported for a plain line info query.
+  LI = Ctx.getLineInfoForAddress({0x1010}, Spec);
+  EXPECT_EQ(LI.FunctionName, "inline1");
+  EXPECT_EQ(LI.FileName, "/tmp/foo.h");
+  EXPECT_EQ(LI.Line, 10u);
+
+  DIInliningInfo II = Ctx.getInliningInfoForAddress({0x1010}, Spec);
+  ASSERT_EQ(II.getNumberOfFrames(), 2u);
+  EXPECT_EQ(II.getFrame(0).FunctionName, "inline1");
+  EXPECT_EQ(II.getFrame(0).Line, 10u);
+  EXPECT_EQ(II.getFrame(1).FunctionName, "main");
+  EXPECT_EQ(II.getFrame(1).FileName, "/tmp/main.c");
+  EXPECT_EQ(II.getFrame(1).Line, 6u);
+
+  DILineInfoSpecifier BaseNameSpec(
+      DILineInfoSpecifier::FileLineInfoKind::BaseNameOnly,
+      DILineInfoSpecifier::FunctionNameKind::None);
+  LI = Ctx.getLineInfoForAddress({0x1020}, BaseNameSpec);
+  EXPECT_EQ(LI.FunctionName, DILineInfo::BadString);
+  EXPECT_EQ(LI.FileName, "main.c");
+  EXPECT_EQ(LI.Line, 8u);
+
+  // Addresses outside of any function produce empty results.
+  LI = Ctx.getLineInfoForAddress({0x2000}, Spec);
+  EXPECT_EQ(LI.FileName, DILineInfo::BadString);
+  EXPECT_EQ(Ctx.getInliningInfoForAddress({0x2000}, Spec).getNumberOfFrames(),
+            0u);
+}
+
+TEST(GSYMTest, TestGsymCreatorSpill) {
+  // Test that spilling function infos to disk produces the same GSYM data as
+  // keeping all function infos in memory, including for the non native byte
+  // order and after removing duplicate symbol table entries.
+  auto AddFunctions = [](GsymCreator &GC) {
+    const uint32_t FileIdx = GC.insertFile("/tmp/main.c");
+    std::vector<FunctionInfo> FIs;
+    // Add the functions in reverse order so every spill file needs sorting.
+    for (uint64_t I = 8; I > 0; --I) {
+      const uint64_t Addr = 0x1000 + I * 0x100;
+      FunctionInfo FI(Addr, 0x100, GC.insertString("func" + std::to_string(I)));
+      FI.OptLineTable = LineTable();
+      FI.OptLineTable->push(LineEntry(Addr, FileIdx, I * 10));
+      FI.OptLineTable->push(LineEntry(Addr + 0x10, FileIdx, I * 10 + 1));
+      FIs.push_back(std::move(FI));
+      // Add a symbol table entry for the same range that must be removed.
+      GC.addFunctionInfo(FunctionInfo(Addr, 0x100, FIs.back().Name));
+    }
+    GC.addFunctionInfos(std::move(FIs));
+  };
+  GsymCreator InMemoryGC;
+  AddFunctions(InMemoryGC);
+  ASSERT_THAT_ERROR(InMemoryGC.finalize(llvm::nulls()), Succeeded());
+
+  GsymCreator SpillGC;
+  SpillGC.setSpillThreshold(3);
+  AddFunctions(SpillGC);
+  EXPECT_EQ(SpillGC.getNumFunctionInfos(), 16u);
+  ASSERT_THAT_ERROR(SpillGC.finalize(llvm::nulls()), Succeeded());
+  EXPECT_EQ(SpillGC.getNumFunctionInfos(), 8u);
+
+  for (auto ByteOrder : {llvm::support::little, llvm::support::big}) {
+    SmallString<1024> InMemoryStr;
+    raw_svector_ostream InMemoryStrm(InMemoryStr);
+    FileWriter InMemoryFW(InMemoryStrm, ByteOrder);
+    ASSERT_THAT_ERROR(InMemoryGC.encode(InMemoryFW), Succeeded());
+    SmallString<1024> SpillStr;
+    raw_svector_ostream SpillStrm(SpillStr);
+    FileWriter SpillFW(SpillStrm, ByteOrder);
+    ASSERT_THAT_ERROR(SpillGC.encode(SpillFW), Succeeded());
+    EXPECT_EQ(InMemoryStr, SpillStr);
+
+    Expected<GsymReader> GR = GsymReader::copyBuffer(SpillStrm.str());
+    ASSERT_THAT_EXPECTED(GR, Succeeded());
+    auto LR = GR->lookup(0x1310);
+    ASSERT_THAT_EXPECTED(LR, Succeeded());
+    EXPECT_EQ(LR->FuncName, "func3");
+    ASSERT_EQ(LR->Locations.size(), 1u);
+    EXPECT_EQ(LR->Locations[0].Line, 31u);
+  }
+}
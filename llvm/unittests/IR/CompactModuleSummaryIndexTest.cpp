@@ -0,0 +1,186 @@
+//===- CompactModuleSummaryIndexTest.cpp - Compact summary index tests ----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/CompactModuleSummaryIndex.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+static std::unique_ptr<ModuleSummaryIndex> makeLLVMIndex(const char *Summary) {
+  SMDiagnostic Err;
+  std::unique_ptr<ModuleSummaryIndex> Index =
+      parseSummaryIndexAssemblyString(Summary, Err);
+  if (!Index)
+    Err.print("CompactModuleSummaryIndexTest", errs());
+  return Index;
+}
+
+static const char *Summary = R"Summary(
+^0 = module: (path: "b.o", hash: (1, 2, 3, 4, 5))
+^1 = module: (path: "a.o", hash: (6, 7, 8, 9, 10))
+^2 = gv: (guid: 30, summaries: (function: (module: ^0, flags: (linkage: external, live: 1), insts: 7, funcFlags: (readNone: 0, readOnly: 0, noRecurse: 1, returnDoesNotAlias: 0, noInline: 1, alwaysInline: 0, noUnwind: 1, mayThrow: 0, hasUnknownCall: 0, mustBeUnreachable: 0), calls: ((callee: ^3, hotness: hot), (callee: ^5, relbf: 256)), refs: (readonly ^4))))
+^3 = gv: (guid: 10, summaries: (function: (module: ^1, flags: (linkage: linkonce_odr, notEligibleToImport: 1), insts: 2), function: (module: ^0, flags: (linkage: linkonce_odr), insts: 3)))
+^4 = gv: (guid: 20, summaries: (variable: (module: ^0, flags: (linkage: internal, dsoLocal: 1), varFlags: (readonly: 1, writeonly: 0, constant: 1), refs: (writeonly ^5))))
+^5 = gv: (guid: 40, summaries: (function: (module: ^1, flags: (linkage: external), insts: 1)))
+^6 = gv: (guid: 50, summaries: (alias: (module: ^1, flags: (linkage: external), aliasee: ^5)))
+)Summary";
+
+class CompactModuleSummaryIndexTest : public testing::Test {
+protected:
+  void SetUp() override {
+    Index = makeLLVMIndex(Summary);
+    ASSERT_NE(Index, nullptr);
+    raw_string_ostream OS(Buffer);
+    writeCompactModuleSummaryIndex(*Index, OS);
+    OS.flush();
+  }
+
+  CompactModuleSummaryIndex read() {
+    return cantFail(
+        CompactModuleSummaryIndex::create(MemoryBufferRef(Buffer, "index")));
+  }
+
+  std::unique_ptr<ModuleSummaryIndex> Index;
+  std::string Buffer;
+};
+
+TEST_F(CompactModuleSummaryIndexTest, Query) {
+  CompactModuleSummaryIndex Compact = read();
+  EXPECT_EQ(Compact.getIndexFlags(), Index->getFlags());
+
+  // Modules are sorted by path.
+  ASSERT_EQ(Compact.getNumModules(), 2u);
+  EXPECT_EQ(Compact.getModulePath(0), "a.o");
+  EXPECT_EQ(Compact.getModulePath(1), "b.o");
+  EXPECT_EQ(Compact.getModuleId(1), Index->getModuleId("b.o"));
+  EXPECT_EQ(Compact.getModuleHash(1), (ModuleHash{{1, 2, 3, 4, 5}}));
+
+  ASSERT_EQ(Compact.getNumValues(), 5u);
+  EXPECT_EQ(Compact.getNumSummaries(), 6u);
+  EXPECT_FALSE(Compact.findValue(15));
+  std::optional<CompactModuleSummaryIndex::ValueID> Caller =
+      Compact.findValue(30);
+  ASSERT_TRUE(Caller);
+  EXPECT_EQ(Compact.getGUID(*Caller), 30u);
+
+  auto Summaries = Compact.summaries(*Caller);
+  ASSERT_EQ(Summaries.size(), 1u);
+  CompactModuleSummaryIndex::SummaryID S = *Summaries.begin();
+  EXPECT_EQ(Compact.getSummaryKind(S), GlobalValueSummary::FunctionKind);
+  EXPECT_EQ(Compact.getModulePath(Compact.getSummaryModule(S)), "b.o");
+  EXPECT_EQ(Compact.getGVFlags(S).Linkage, GlobalValue::ExternalLinkage);
+  EXPECT_TRUE(Compact.getGVFlags(S).Live);
+  EXPECT_EQ(Compact.getInstCount(S), 7u);
+  EXPECT_TRUE(Compact.getFFlags(S).NoRecurse);
+  EXPECT_TRUE(Compact.getFFlags(S).NoInline);
+  EXPECT_FALSE(Compact.getFFlags(S).ReadNone);
+
+  ASSERT_EQ(Compact.getNumCalls(S), 2u);
+  CompactModuleSummaryIndex::Call Call = Compact.getCall(S, 0);
+  EXPECT_EQ(Compact.getGUID(Call.Callee), 10u);
+  EXPECT_EQ(Call.Info.getHotness(), CalleeInfo::HotnessType::Hot);
+  Call = Compact.getCall(S, 1);
+  EXPECT_EQ(Compact.getGUID(Call.Callee), 40u);
+  EXPECT_EQ(Call.Info.RelBlockFreq, 256u);
+
+  ASSERT_EQ(Compact.getNumRefs(S), 1u);
+  CompactModuleSummaryIndex::Ref Ref = Compact.getRef(S, 0);
+  EXPECT_EQ(Compact.getGUID(Ref.Value), 20u);
+  EXPECT_TRUE(Ref.ReadOnly);
+  EXPECT_FALSE(Ref.WriteOnly);
+
+  // Both copies of a linkonce_odr function are kept.
+  EXPECT_EQ(Compact.summaries(*Compact.findValue(10)).size(), 2u);
+
+  CompactModuleSummaryIndex::SummaryID Var =
+      *Compact.summaries(*Compact.findValue(20)).begin();
+  EXPECT_EQ(Compact.getSummaryKind(Var), GlobalValueSummary::GlobalVarKind);
+  EXPECT_TRUE(Compact.getGVarFlags(Var).MaybeReadOnly);
+  EXPECT_TRUE(Compact.getGVarFlags(Var).Constant);
+  EXPECT_TRUE(Compact.getGVFlags(Var).DSOLocal);
+  ASSERT_EQ(Compact.getNumRefs(Var), 1u);
+  EXPECT_TRUE(Compact.getRef(Var, 0).WriteOnly);
+
+  CompactModuleSummaryIndex::SummaryID Alias =
+      *Compact.summaries(*Compact.findValue(50)).begin();
+  EXPECT_EQ(Compact.getSummaryKind(Alias), GlobalValueSummary::AliasKind);
+  std::optional<CompactModuleSummaryIndex::ValueID> Aliasee =
+      Compact.getAliasee(Alias);
+  ASSERT_TRUE(Aliasee);
+  EXPECT_EQ(Compact.getGUID(*Aliasee), 40u);
+}
+
+TEST_F(CompactModuleSummaryIndexTest, MaterializeAll) {
+  std::unique_ptr<ModuleSummaryIndex> Materialized = read().materializeAll();
+  EXPECT_EQ(Materialized->getFlags(), Index->getFlags());
+  EXPECT_EQ(Materialized->modulePaths().size(), 2u);
+  EXPECT_EQ(Materialized->getModuleHash("a.o"), Index->getModuleHash("a.o"));
+
+  for (const auto &[GUID, Info] : *Index) {
+    ValueInfo VI = Materialized->getValueInfo(GUID);
+    ASSERT_TRUE(VI);
+    ASSERT_EQ(VI.getSummaryList().size(), Info.SummaryList.size());
+    for (const auto &Original : Info.SummaryList) {
+      GlobalValueSummary *Summary =
+          Materialized->findSummaryInModule(VI, Original->modulePath());
+      ASSERT_NE(Summary, nullptr);
+      EXPECT_EQ(Summary->getSummaryKind(), Original->getSummaryKind());
+      EXPECT_EQ(Summary->linkage(), Original->linkage());
+      EXPECT_EQ(Summary->refs().size(), Original->refs().size());
+      if (auto *FS = dyn_cast<FunctionSummary>(Summary)) {
+        auto *OriginalFS = cast<FunctionSummary>(Original.get());
+        EXPECT_EQ(FS->instCount(), OriginalFS->instCount());
+        ASSERT_EQ(FS->calls().size(), OriginalFS->calls().size());
+        for (auto [Call, OriginalCall] :
+             zip(FS->calls(), OriginalFS->calls())) {
+          EXPECT_EQ(Call.first.getGUID(), OriginalCall.first.getGUID());
+          EXPECT_EQ(Call.second.getHotness(), OriginalCall.second.getHotness());
+        }
+      }
+    }
+  }
+
+  auto *Alias = cast<AliasSummary>(Materialized->getGlobalValueSummary(50));
+  ASSERT_TRUE(Alias->hasAliasee());
+  EXPECT_EQ(Alias->getAliaseeGUID(), 40u);
+}
+
+TEST_F(CompactModuleSummaryIndexTest, MaterializeSubset) {
+  CompactModuleSummaryIndex Compact = read();
+  ModuleSummaryIndex Subset(/*HaveGVs=*/false);
+  Compact.materialize(Subset, {*Compact.findValue(30), *Compact.findValue(50)});
+
+  // The aliasee comes along with the alias, but callees and references only
+  // get a value without summaries.
+  EXPECT_EQ(Subset.getValueInfo(30).getSummaryList().size(), 1u);
+  EXPECT_EQ(Subset.getValueInfo(50).getSummaryList().size(), 1u);
+  EXPECT_EQ(Subset.getValueInfo(40).getSummaryList().size(), 1u);
+  ASSERT_TRUE(Subset.getValueInfo(10));
+  EXPECT_TRUE(Subset.getValueInfo(10).getSummaryList().empty());
+  EXPECT_EQ(Subset.modulePaths().size(), 2u);
+
+  // Materializing again does not duplicate summaries.
+  Compact.materialize(Subset, {*Compact.findValue(30)});
+  EXPECT_EQ(Subset.getValueInfo(30).getSummaryList().size(), 1u);
+}
+
+TEST_F(CompactModuleSummaryIndexTest, Malformed) {
+  EXPECT_THAT_EXPECTED(
+      CompactModuleSummaryIndex::create(MemoryBufferRef("BC\xC0\xDE", "bc")),
+      FailedWithMessage("not a compact summary index"));
+  EXPECT_THAT_EXPECTED(CompactModuleSummaryIndex::create(MemoryBufferRef(
+                           StringRef(Buffer).drop_back(), "truncated")),
+                       FailedWithMessage("truncated compact summary index"));
+}
+
+} // end anonymous namespace
@@ -1307,4 +1307,40 @@ TEST_F(ModuleCallbacksTest, ParseTopLevelPipeline) {
   ASSERT_THAT_ERROR(PB.parsePassPipeline(PM, PipelineText), Failed())
       << "Pipeline was: " << PipelineText;
 }
+
+TEST(PassBuilderSplitPipelineTest, ExtensionPointsRunOnce) {
+  PassBuilder PB;
+  unsigned PipelineStartCalls = 0, OptimizerLastCalls = 0;
+  PB.registerPipelineStartEPCallback(
+      [&](ModulePassManager &, OptimizationLevel) { ++PipelineStartCalls; });
+  PB.registerOptimizerLastEPCallback(
+      [&](ModulePassManager &, OptimizationLevel) { ++OptimizerLastCalls; });
+
+  PB.buildPerModulePreSplitPipeline(OptimizationLevel::O2);
+  EXPECT_EQ(1u, PipelineStartCalls);
+  EXPECT_EQ(0u, OptimizerLastCalls);
+
+  PB.buildPerModulePostSplitPipeline(OptimizationLevel::O2);
+  EXPECT_EQ(1u, PipelineStartCalls);
+  EXPECT_EQ(1u, OptimizerLastCalls);
+}
+
+TEST(PassBuilderSplitPipelineTest, SplitPipelineMatchesDefault) {
+  auto PrintPipeline = [](ModulePassManager MPM) {
+    std::string Pipeline;
+    raw_string_ostream OS(Pipeline);
+    MPM.printPipeline(OS, [](StringRef ClassName) { return ClassName; });
+    return Pipeline;
+  };
+
+  for (OptimizationLevel Level :
+       {OptimizationLevel::O1, OptimizationLevel::O2, OptimizationLevel::O3,
+        OptimizationLevel::Os, OptimizationLevel::Oz}) {
+    PassBuilder PB;
+    std::string Split =
+        PrintPipeline(PB.buildPerModulePreSplitPipeline(Level)) + "," +
+        PrintPipeline(PB.buildPerModulePostSplitPipeline(Level));
+    EXPECT_EQ(PrintPipeline(PB.buildPerModuleDefaultPipeline(Level)), Split);
+  }
+}
 } // end anonymous namespace
@@ -8,11 +8,14 @@
 
 #include "llvm/ObjCopy/ObjCopy.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ObjCopy/ConfigManager.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/ObjectYAML/yaml2obj.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Testing/Support/Error.h"
 #include "gtest/gtest.h"
 
@@ -396,3 +399,53 @@ TEST(RemoveSectionByPattern, Wasm) {
       SimpleFileWasmYAML, [](const Binary &File) { return File.isWasm(); },
       "text*", "text");
 }
+
+TEST(CompressSections, ParallelMatchesSerial) {
+  SCOPED_TRACE("CompressSectionsParallelMatchesSerial");
+
+  if (!compression::zlib::isAvailable())
+    GTEST_SKIP();
+
+  // Enough debug sections to keep several threads busy.
+  std::string Yaml = R"(
+--- !ELF
+FileHeader:
+  Class:    ELFCLASS64
+  Data:     ELFDATA2LSB
+  Type:     ET_REL
+Sections:
+)";
+  for (unsigned I = 0; I != 64; ++I) {
+    std::string Byte = utohexstr(I, /*LowerCase=*/false, /*Width=*/2);
+    Yaml += "  - Name:    .debug_" + std::to_string(I) + "\n";
+    Yaml += "    Type:    SHT_PROGBITS\n";
+    std::string Content;
+    for (unsigned J = 0; J != 256 + I; ++J)
+      Content += J % 3 ? Byte : "00";
+    Yaml += "    Content: '" + Content + "'\n";
+  }
+
+  SmallVector<char> Storage;
+  Expected<std::unique_ptr<ObjectFile>> Obj =
+      createObjectFileFromYamlDescription(
+          Yaml.c_str(), Storage,
+          [](const Binary &File) { return File.isELF(); });
+  ASSERT_THAT_EXPECTED(Obj, Succeeded());
+
+  auto Compress = [&](unsigned Threads, SmallVector<char> &Out) {
+    parallel::strategy = hardware_concurrency(Threads);
+    ConfigManager Config;
+    Config.Common.OutputFilename = "a.out";
+    Config.Common.CompressionType = DebugCompressionType::Zlib;
+    raw_svector_ostream OS(Out);
+    return objcopy::executeObjcopyOnBinary(Config, **Obj, OS);
+  };
+
+  SmallVector<char> Serial, Parallel;
+  ASSERT_THAT_ERROR(Compress(1, Serial), Succeeded());
+  ASSERT_THAT_ERROR(Compress(4, Parallel), Succeeded());
+  parallel::strategy = hardware_concurrency();
+
+  EXPECT_EQ(StringRef(Serial.data(), Serial.size()),
+            StringRef(Parallel.data(), Parallel.size()));
+}
@@ -0,0 +1,62 @@
+//===- FunctionImportTest.cpp - Unit tests for ThinLTO import lists -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// Four modules whose functions call each other in a cycle, so that every
+// module imports from and exports to the others.
+const char *IndexAssembly = R"(
+^0 = module: (path: "a", hash: (0, 0, 0, 0, 0))
+^1 = module: (path: "b", hash: (0, 0, 0, 0, 0))
+^2 = module: (path: "c", hash: (0, 0, 0, 0, 0))
+^3 = module: (path: "d", hash: (0, 0, 0, 0, 0))
+^4 = gv: (guid: 1, summaries: (function: (module: ^0, flags: (linkage: external, visibility: default, notEligibleToImport: 0, live: 1, dsoLocal: 1, canAutoHide: 0), insts: 1, calls: ((callee: ^5)))))
+^5 = gv: (guid: 2, summaries: (function: (module: ^1, flags: (linkage: external, visibility: default, notEligibleToImport: 0, live: 1, dsoLocal: 1, canAutoHide: 0), insts: 1, calls: ((callee: ^6)))))
+^6 = gv: (guid: 3, summaries: (function: (module: ^2, flags: (linkage: external, visibility: default, notEligibleToImport: 0, live: 1, dsoLocal: 1, canAutoHide: 0), insts: 1, calls: ((callee: ^7)))))
+^7 = gv: (guid: 4, summaries: (function: (module: ^3, flags: (linkage: external, visibility: default, notEligibleToImport: 0, live: 1, dsoLocal: 1, canAutoHide: 0), insts: 1, calls: ((callee: ^4)))))
+)";
+
+TEST(FunctionImportTest, ParallelCrossModuleImportMatchesSerial) {
+  SMDiagnostic Err;
+  std::unique_ptr<ModuleSummaryIndex> Index =
+      parseSummaryIndexAssemblyString(IndexAssembly, Err);
+  ASSERT_TRUE(Index) << Err.getMessage();
+
+  DenseMap<StringRef, GVSummaryMapTy> ModuleToDefinedGVSummaries;
+  Index->collectDefinedGVSummariesPerModule(ModuleToDefinedGVSummaries);
+  auto IsPrevailing = [](GlobalValue::GUID, const GlobalValueSummary *) {
+    return true;
+  };
+
+  DenseMap<StringRef, FunctionImporter::ImportMapTy> SerialImports;
+  DenseMap<StringRef, FunctionImporter::ExportSetTy> SerialExports;
+  ComputeCrossModuleImport(*Index, ModuleToDefinedGVSummaries, IsPrevailing,
+                           SerialImports, SerialExports);
+
+  DenseMap<StringRef, FunctionImporter::ImportMapTy> ParallelImports;
+  DenseMap<StringRef, FunctionImporter::ExportSetTy> ParallelExports;
+  ComputeCrossModuleImport(*Index, ModuleToDefinedGVSummaries, IsPrevailing,
+                           ParallelImports, ParallelExports,
+                           hardware_concurrency(4));
+
+  EXPECT_EQ(SerialImports.size(), 4u);
+  EXPECT_EQ(SerialImports["a"]["b"].count(2), 1u);
+  EXPECT_EQ(SerialExports["b"].count(Index->getValueInfo(2)), 1u);
+  EXPECT_TRUE(SerialImports == ParallelImports);
+  EXPECT_TRUE(SerialExports == ParallelExports);
+}
+
+} // end anonymous namespace